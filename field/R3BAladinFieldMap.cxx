@@ -24,11 +24,15 @@
 #include "TArrayI.h"
 #include "TFile.h"
 #include "TMath.h"
+#include "TSystem.h"
 #include <assert.h>
+#include <vector>
 
 #include "FairLogger.h"
 
 #include "R3BAladinFieldMap.h"
+#include "R3BFieldBatch.h"
+#include "R3BFieldMapFile.h"
 
 // Local Macros
 #define SQR(x) ((x) * (x))
@@ -61,11 +65,42 @@ map_fields_ALADiN R3BAladinFieldMap::gMapIField;
 
 coords_ALADiN R3BAladinFieldMap::gCoords[2];
 Bool_t R3BAladinFieldMap::gInitialized = kFALSE;
+TString R3BAladinFieldMap::gCacheDir;
+
+namespace
+{
+    TString AsciiMapFileName(const TString& mapDir, Int_t current)
+    {
+        return mapDir + TString::Format("ala_%04d.dat", current);
+    }
+
+    // Per user cache directory, outside of the source tree
+    TString DefaultCacheDirectory()
+    {
+        TString dir = gSystem->Getenv("XDG_CACHE_HOME");
+        if (dir.Length() == 0 && gSystem->Getenv("HOME"))
+        {
+            dir = TString(gSystem->Getenv("HOME")) + "/.cache";
+        }
+        if (dir.Length() == 0)
+        {
+            dir = gSystem->TempDirectory();
+        }
+        return dir + "/r3broot";
+    }
+} // namespace
+
+// Grid of the two measurement boxes, and the box coordinate of node 0 in the ASCII maps
+const Int_t R3BAladinFieldMap::kGridSize[2][3] = { { 90, 19, 21 }, { 85, 19, 17 } };
+const Int_t R3BAladinFieldMap::kGridOffset[2][3] = { { 1, -2, 0 }, { 1, -2, 1 } };
 
 R3BAladinFieldMap::R3BAladinFieldMap()
     : fBx(NULL)
     , fBy(NULL)
     , fBz(NULL)
+    , fCurField(NULL)
+    , fTricubic(kFALSE)
+    , fTricubicCacheCells(kTricubicCacheCells)
 {
     fType = 1;
 }
@@ -75,6 +110,9 @@ R3BAladinFieldMap::R3BAladinFieldMap(const char* mapName, const char* fileType)
     , fBx(NULL)
     , fBy(NULL)
     , fBz(NULL)
+    , fCurField(NULL)
+    , fTricubic(kFALSE)
+    , fTricubicCacheCells(kTricubicCacheCells)
 {
     fType = 1;
 }
@@ -83,6 +121,9 @@ R3BAladinFieldMap::R3BAladinFieldMap(R3BFieldPar* fieldPar)
     : fBx(NULL)
     , fBy(NULL)
     , fBz(NULL)
+    , fCurField(NULL)
+    , fTricubic(kFALSE)
+    , fTricubicCacheCells(kTricubicCacheCells)
 {
     fType = 1;
     fCurrent = fieldPar->GetCurrent();
@@ -100,14 +141,13 @@ R3BAladinFieldMap::~R3BAladinFieldMap()
         delete fBz;
 }
 // -----------   Intialisation   ------------------------------------------
-void R3BAladinFieldMap::Init()
+void R3BAladinFieldMap::InitMaps()
 {
-
+    // The reference maps and the box coordinates are shared by all instances,
+    // they are read only once per process.
     if (gInitialized)
         return;
 
-    gFringeField = kTRUE;
-
     af_box[0][0].SetXYZ(123.300, 0.00, -10.0);
     af_box[0][1].SetXYZ(-123.224, 0.00, -10.0);
     af_box[1][0].SetXYZ(123.300, 0.00, 10.0);
@@ -161,130 +201,304 @@ void R3BAladinFieldMap::Init()
     measured_I.AddAt(2300, 7);
     measured_I.AddAt(2500, 8);
 
+    TString dir = getenv("VMCWORKDIR");
+    TString mapDir = dir + "/field/magField/Aladin/newmap/";
+    if (gCacheDir.Length() == 0)
+    {
+        gCacheDir = DefaultCacheDirectory();
+    }
+
     for (unsigned int i = 0; i < measured_I.GetSize(); i++)
     {
-        FILE* fin;
-        Char_t filename[256];
-        sprintf(filename, "ala_%04d.dat", measured_I[i]);
-        TString mapName(filename);
-        TString dir = getenv("VMCWORKDIR");
-        TString fMapFileName = dir + "/field/magField/Aladin/newmap/" + mapName;
-        LOG(INFO) << "R3BAladinFieldMap opening Field Map file : " << fMapFileName;
+        fields_ALADiN* field = new fields_ALADiN;
+
+        if (!ReadCachedMap(mapDir, measured_I[i], field))
+        {
+            if (!ReadAsciiMap(mapDir, measured_I[i], field))
+            {
+                delete field;
+                continue;
+            }
+            WriteCachedMap(mapDir, measured_I[i], field);
+        }
+
+        gMapIFieldOrig.insert(map_fields_ALADiN::value_type(measured_I[i], field));
+    }
+
+    // Init has been called
+    gInitialized = kTRUE;
+}
+
+void R3BAladinFieldMap::Init()
+{
+    InitMaps();
+
+    gFringeField = kTRUE;
+
+    // Has to ben changed somehow using
+    // parameters here
+    // <DB> check me !!
+    Double_t DistanceToTarget = 350.0; // cm
+    // Double_t Correction = -117.5; // cm
+    // Double_t Correction = -350.5; // cm
+    Double_t Correction = -95.0; // cm
+    // Double_t Glad_angle = +7.3; // degree
+    Double_t Glad_angle = -7.0; // degree
+    Double_t DistanceFromtargetToAladinCenter = DistanceToTarget + Correction;
+    // Transformations inverse
+    gRot = new TRotation();
+    gRot->RotateY(-1. * Glad_angle);
+    gTrans = new TVector3(0.0, 0.0, -1. * DistanceFromtargetToAladinCenter);
+
+    LOG(INFO) << "R3BAladinFieldMap::Init() called";
+    InitField();
+    InitTricubicCache();
+}
+
+Bool_t R3BAladinFieldMap::ReadAsciiMap(const TString& mapDir, Int_t current, fields_ALADiN* field)
+{
+    FILE* fin;
+    Char_t filename[256];
+    char str[200];
+    sprintf(filename, "ala_%04d.dat", current);
+    TString fMapFileName = AsciiMapFileName(mapDir, current);
+    LOG(INFO) << "R3BAladinFieldMap opening Field Map file : " << fMapFileName;
 
-        fin = fopen(fMapFileName, "r");
+    fin = fopen(fMapFileName, "r");
 
-        if (!fin)
+    if (!fin)
+    {
+        LOG(ERROR) << "Failure opening field map : " << fMapFileName;
+        return kFALSE;
+    }
+
+    for (int j = 0; j < 3; j++)
+    {
+        for (int rl = 0; rl < 2; rl++)
         {
-            LOG(ERROR) << "Failure opening field map : " << fMapFileName;
+            for (int k = 0; k < 3; k++)
+            {
+                field->f[rl][j]._np[k] = kGridSize[rl][k];
+            }
+            field->f[rl][j].init();
         }
+    }
 
-        // free(fMapFileName.Data());
+    for (int line = 0; !feof(fin); line++)
+    {
+        int I, rl, ixyz[3];
+        float bxyz[3], bdummy;
+
+        int n = fscanf(fin,
+                       " %d %d %d %d %d %f %f %f %f\n",
+                       &I,
+                       &rl,
+                       &ixyz[2],
+                       &ixyz[1],
+                       &ixyz[0],
+                       &bxyz[0],
+                       &bxyz[1],
+                       &bxyz[2],
+                       &bdummy);
+
+        if (n != 9)
+            LOG(ERROR) << "Failure parsing field from map: " << filename << " @ line: % " << line;
+
+        if (I != current)
+            LOG(ERROR) << "Wrong current " << I << " when parsing field from map " << filename << " @ line: " << line;
+
+        if (rl != 0 && rl != 1)
+            LOG(ERROR) << "Wrong box " << rl << " when parsing field from map " << filename << " @line: " << line;
 
-        fields_ALADiN* field = new fields_ALADiN;
+        for (int j = 0; j < 3; j++)
+        {
+            ixyz[j] -= kGridOffset[rl][j];
+
+            if (ixyz[j] < 0 || ixyz[j] >= field->f[rl][0]._np[j])
+            {
+                sprintf(str,
+                        "Wrong coordinate(%d) (%d -> %d) >= %d when parsing field from map %s, line? %d.",
+                        j,
+                        ixyz[j] + kGridOffset[rl][j],
+                        ixyz[j],
+                        field->f[rl][0]._np[j],
+                        filename,
+                        line);
+                LOG(ERROR) << str;
+            }
+        }
 
         for (int j = 0; j < 3; j++)
         {
-            field->f[0][j]._np[0] = 90; //  1 .. 90
-            field->f[0][j]._np[1] = 19; // -2 .. 16
-            field->f[0][j]._np[2] = 21; //  0 .. 20
-            field->f[0][j].init();
-            field->f[1][j]._np[0] = 85; //  1 .. 85
-            field->f[1][j]._np[1] = 19; // -2 .. 16
-            field->f[1][j]._np[2] = 17; //  1 .. 17
-            field->f[1][j].init();
+            field->f[rl][j].set_data_pt(ixyz[0], ixyz[1], ixyz[2], bxyz[j]);
         }
+    }
 
-        static const int off[2][3] = { { 1, -2, 0 }, { 1, -2, 1 } };
+    fclose(fin);
 
-        for (int line = 0; !feof(fin); line++)
+    for (int j = 0; j < 3; j++)
+    {
+        for (int rl = 0; rl < 2; rl++)
         {
-            int I, rl, ixyz[3];
-            float bxyz[3], bdummy;
-
-            int n = fscanf(fin,
-                           " %d %d %d %d %d %f %f %f %f\n",
-                           &I,
-                           &rl,
-                           &ixyz[2],
-                           &ixyz[1],
-                           &ixyz[0],
-                           &bxyz[0],
-                           &bxyz[1],
-                           &bxyz[2],
-                           &bdummy);
-
-            if (n != 9)
-                LOG(ERROR) << "Failure parsing field from map: " << filename << " @ line: % " << line;
-
-            if (I != measured_I[i])
-                LOG(ERROR) << "Wrong current " << I << " when parsing field from map " << filename
-                           << " @ line: " << line;
-
-            if (rl != 0 && rl != 1)
-                LOG(ERROR) << "Wrong box " << rl << " when parsing field from map " << filename << " @line: " << line;
-
-            for (int j = 0; j < 3; j++)
+            while (field->f[rl][j].expand())
             {
-                ixyz[j] -= off[rl][j];
-
-                if (ixyz[j] < 0 || ixyz[j] >= field->f[rl][0]._np[j])
-                {
-                    sprintf(str,
-                            "Wrong coordinate(%d) (%d -> %d) >= %d when parsing field from map %s, line? %d.",
-                            j,
-                            ixyz[j] + off[rl][j],
-                            ixyz[j],
-                            field->f[rl][0]._np[j],
-                            filename,
-                            line);
-                    LOG(ERROR) << str;
-                }
+                // expand as long as there are nodes to be expanded
             }
+        }
+    }
 
-            for (int j = 0; j < 3; j++)
+    LOG(INFO) << "R3BAladinFieldMap: Reading field map: " << filename;
+    return kTRUE;
+}
+
+TString R3BAladinFieldMap::CachedMapFileName(Int_t current, Int_t rl)
+{
+    return gCacheDir + TString::Format("/ala_%04d_%d.bin", current, rl);
+}
+
+Bool_t R3BAladinFieldMap::ReadCachedMap(const TString& mapDir, Int_t current, fields_ALADiN* field)
+{
+    // Without the ASCII map the cache is all there is
+    Long64_t srcSize = 0, srcTime = 0;
+    const Bool_t haveSource = R3BFieldMapFile::GetSourceStamp(AsciiMapFileName(mapDir, current), srcSize, srcTime);
+
+    for (Int_t rl = 0; rl < 2; rl++)
+    {
+        TString fileName = CachedMapFileName(current, rl);
+        if (gSystem->AccessPathName(fileName))
+        {
+            return kFALSE;
+        }
+
+        R3BFieldMapFile file;
+        if (!file.Open(fileName))
+        {
+            return kFALSE;
+        }
+
+        const R3BFieldMapFile::Header& header = file.GetHeader();
+        if (header.nComponents != 3 || header.n[0] != kGridSize[rl][0] || header.n[1] != kGridSize[rl][1] ||
+            header.n[2] != kGridSize[rl][2])
+        {
+            LOG(WARNING) << "R3BAladinFieldMap: Ignoring cached map " << fileName << " with unexpected grid";
+            return kFALSE;
+        }
+        if (haveSource && (header.srcSize != srcSize || header.srcTime != srcTime))
+        {
+            LOG(INFO) << "R3BAladinFieldMap: Cached map " << fileName << " is outdated, rebuilding it";
+            return kFALSE;
+        }
+
+        // The cache holds the expanded map, interleaved (Bx,By,Bz) per node
+        const Float_t* data = file.GetData();
+        for (Int_t j = 0; j < 3; j++)
+        {
+            R3BFieldInterp& f = field->f[rl][j];
+            for (Int_t k = 0; k < 3; k++)
             {
-                field->f[rl][j].set_data_pt(ixyz[0], ixyz[1], ixyz[2], bxyz[j]);
+                f._np[k] = kGridSize[rl][k];
+            }
+            f.init();
+            for (Int_t i = 0; i < f._n; i++)
+            {
+                f._data[i] = data[3 * i + j];
             }
         }
 
-        fclose(fin);
+        LOG(INFO) << "R3BAladinFieldMap: Reading cached field map: " << fileName;
+    }
 
-        for (int j = 0; j < 3; j++)
+    return kTRUE;
+}
+
+void R3BAladinFieldMap::WriteCachedMap(const TString& mapDir, Int_t current, const fields_ALADiN* field)
+{
+    Long64_t srcSize = 0, srcTime = 0;
+    R3BFieldMapFile::GetSourceStamp(AsciiMapFileName(mapDir, current), srcSize, srcTime);
+
+    if (gSystem->AccessPathName(gCacheDir) && gSystem->mkdir(gCacheDir, kTRUE) != 0)
+    {
+        LOG(WARNING) << "R3BAladinFieldMap: Could not create the field map cache directory " << gCacheDir;
+        return;
+    }
+
+    for (Int_t rl = 0; rl < 2; rl++)
+    {
+        const R3BFieldInterp* f = field->f[rl];
+
+        // Grid positions in measurement box units, as in the ASCII maps
+        Int_t n[3];
+        Double_t min[3], max[3];
+        for (Int_t k = 0; k < 3; k++)
+        {
+            n[k] = f[0]._np[k];
+            min[k] = kGridOffset[rl][k];
+            max[k] = kGridOffset[rl][k] + n[k] - 1;
+        }
+
+        std::vector<Float_t> data(3 * f[0]._n);
+        for (Int_t i = 0; i < f[0]._n; i++)
         {
-            for (int rl = 0; rl < 2; rl++)
+            for (Int_t j = 0; j < 3; j++)
             {
-                while (field->f[rl][j].expand())
-                {
-                    // expand as long as there are nodes to be expanded
-                }
+                data[3 * i + j] = f[j]._data[i];
             }
         }
 
-        gMapIFieldOrig.insert(map_fields_ALADiN::value_type(measured_I[i], field));
+        // Write under a temporary name, so that concurrent jobs never map a partial file
+        TString fileName = CachedMapFileName(current, rl);
+        TString tmpName = fileName + TString::Format(".%d", gSystem->GetPid());
+        R3BFieldMapFile::Header header = R3BFieldMapFile::MakeHeader(1, 3, n, min, max);
+        header.srcSize = srcSize;
+        header.srcTime = srcTime;
+        if (!R3BFieldMapFile::Write(tmpName, header, data.data()) || gSystem->Rename(tmpName, fileName) != 0)
+        {
+            LOG(WARNING) << "R3BAladinFieldMap: Could not write field map cache " << fileName;
+            gSystem->Unlink(tmpName);
+            return;
+        }
 
-        LOG(INFO) << "R3BAladinFieldMap: Reading field map: " << filename;
+        LOG(INFO) << "R3BAladinFieldMap: Wrote field map cache " << fileName;
     }
+}
 
-    // Has to ben changed somehow using
-    // parameters here
-    // <DB> check me !!
-    Double_t DistanceToTarget = 350.0; // cm
-    // Double_t Correction = -117.5; // cm
-    // Double_t Correction = -350.5; // cm
-    Double_t Correction = -95.0; // cm
-    // Double_t Glad_angle = +7.3; // degree
-    Double_t Glad_angle = -7.0; // degree
-    Double_t DistanceFromtargetToAladinCenter = DistanceToTarget + Correction;
-    // Transformations inverse
-    gRot = new TRotation();
-    gRot->RotateY(-1. * Glad_angle);
-    gTrans = new TVector3(0.0, 0.0, -1. * DistanceFromtargetToAladinCenter);
+void R3BAladinFieldMap::SetCacheDirectory(const char* dir) { gCacheDir = dir; }
 
-    LOG(INFO) << "R3BAladinFieldMap::Init() called";
-    InitField();
+void R3BAladinFieldMap::SetCurrent(Double_t aCurrent)
+{
+    fCurrent = aCurrent;
 
-    // Init has been called
-    gInitialized = kTRUE;
+    // Switch to the (memoized) field of the new current if the maps are already loaded
+    if (gInitialized)
+    {
+        InitField();
+        InitTricubicCache();
+    }
+}
+
+void R3BAladinFieldMap::SetTricubic(Bool_t tricubic, Int_t cacheCells)
+{
+    fTricubic = tricubic;
+    fTricubicCacheCells = cacheCells;
+
+    if (gInitialized)
+    {
+        InitTricubicCache();
+    }
+}
+
+void R3BAladinFieldMap::InitTricubicCache()
+{
+    if (!fCurField)
+        return;
+
+    for (Int_t rl = 0; rl < 2; rl++)
+    {
+        for (Int_t j = 0; j < 3; j++)
+        {
+            fCurField->f[rl][j].set_interp3_cache(fTricubic ? fTricubicCacheCells : 0);
+        }
+    }
 }
 
 void R3BAladinFieldMap::CalcFieldDiv(R3BFieldInterp f[3], double d[3])
@@ -392,35 +606,49 @@ void R3BAladinFieldMap::InitField()
 
     // If no interpolation found, then we need to create a new one
 
+    if (gMapIFieldOrig.empty())
+    {
+        LOG(ERROR) << "R3BAladinFieldMap: No ALADiN reference field maps loaded.";
+        return;
+    }
+
     map_fields_ALADiN::iterator iter1;
     map_fields_ALADiN::iterator iter2;
 
     iter2 = gMapIFieldOrig.lower_bound(current);
 
-    if (iter2 == gMapIFieldOrig.end())
-    {
-        // Too high current requested...  Extrapolate
-        --iter2;
-    }
+    fCurField = new fields_ALADiN;
+
+    if (!fCurField)
+        LOG(DEBUG) << "R3BAladinFieldMap: ALADiN field interpolation, memory allocation failure.";
 
-    iter1 = iter2;
+    double w1, w2;
 
     if (iter2 == gMapIFieldOrig.begin())
     {
-        LOG(ERROR) << "R3BAladinFieldMap: Cannot interpolate ALADiN field for current " << current << " A, too low.";
+        // Below the lowest reference current the yoke is far from saturation,
+        // scale the lowest map linearly with the current
+        iter1 = iter2;
+        w1 = current / iter1->first;
+        w2 = 0;
     }
-    --iter1;
-
-    // printf ("# Interpolate ALADiN %7.1f A (%7.1f A, %7.1f A)\n",
-    //        current,iter1->first,iter2->first);
+    else
+    {
+        if (iter2 == gMapIFieldOrig.end())
+        {
+            // Too high current requested...  Extrapolate
+            --iter2;
+        }
 
-    fCurField = new fields_ALADiN;
+        iter1 = iter2;
+        --iter1;
 
-    if (!fCurField)
-        LOG(DEBUG) << "R3BAladinFieldMap: ALADiN field interpolation, memory allocation failure.";
+        w2 = (current - iter1->first) / (iter2->first - iter1->first);
+        w1 = 1 - w2;
+    }
 
-    double w2 = (current - iter1->first) / (iter2->first - iter1->first);
-    double w1 = 1 - w2;
+    // printf ("# Interpolate ALADiN %7.1f A (%7.1f A, %7.1f A)\n",
+    //        current,iter1->first,iter2->first);
 
     for (int rl = 0; rl < 2; rl++)
         for (int j = 0; j < 3; j++)
@@ -585,7 +813,10 @@ void R3BAladinFieldMap::GetFieldValue(const Double_t point[3], Double_t* bField)
             // printf (" -I- Interpolation parameters ---->> 0:%2d/%7.5f",
             //         ic[0],dc[0]);
 
-            Bbi[i] = fCurField->f[rl][i].interp(ic, dc);
+            if (fTricubic)
+                Bbi[i] = fCurField->f[rl][i].interp3(ic, dc);
+            else
+                Bbi[i] = fCurField->f[rl][i].interp(ic, dc);
         }
 
         // The field must be rotated into the ALADiN FRAME (from the box
@@ -650,6 +881,157 @@ void R3BAladinFieldMap::GetFieldValue(const Double_t point[3], Double_t* bField)
     return;
 }
 
+// Same as GetFieldValue, with the grid look-up of a block of points
+// separated from the (branch free) trilinear interpolation
+void R3BAladinFieldMap::GetFieldValues(Int_t n, const Double_t* points, Double_t* bFields)
+{
+    if (fTricubic)
+    {
+        for (Int_t k = 0; k < n; k++)
+        {
+            GetFieldValue(points + 3 * k, bFields + 3 * k);
+        }
+        return;
+    }
+
+    using R3BFieldBatch::kBlockSize;
+
+    // Magnet placement, see GetFieldValue
+    const Double_t DistanceToTarget = 350.0; // cm
+    const Double_t Correction = -95.0;       // cm
+    const Double_t Magnet_angle = -7.0;      // degree
+    const Double_t angle = -1. * Magnet_angle * TMath::Pi() / 180.;
+    const Double_t sina = TMath::Sin(angle);
+    const Double_t cosa = TMath::Cos(angle);
+
+    static const double box_grid_off[2][5] = {
+        { 140. - 1 * 3, 139. - 1 * 3, 138. - 1 * 3, 19. + 2 * 3, 66. },
+        { 125. - 1 * 3, 124. - 1 * 3, 123. - 1 * 3, 19. + 2 * 3, 6. - 1 * 4 }
+    };
+
+    // Per point: magnet coordinates
+    Double_t cx[kBlockSize], cy[kBlockSize], cz[kBlockSize];
+    // Per point and box: position, weight and interpolation coordinates
+    Double_t boxx[kBlockSize], w[kBlockSize], wsum[kBlockSize];
+    Bool_t valid[kBlockSize];
+    Double_t dc[3][kBlockSize];
+    Int_t ic[3][kBlockSize];
+    // Per point and component: cell corner and steps in the R3BFieldInterp grid
+    Int_t node[kBlockSize], sx[kBlockSize], sy[kBlockSize], sz[kBlockSize];
+    Double_t Bbi[3][kBlockSize];
+    Double_t Bi[3][kBlockSize];
+
+    for (Int_t first = 0; first < n; first += kBlockSize)
+    {
+        const Int_t m = TMath::Min(kBlockSize, n - first);
+        const Double_t* p = points + 3 * first;
+        Double_t* out = bFields + 3 * first;
+
+        for (Int_t k = 0; k < m; k++)
+        {
+            const Double_t zt = p[3 * k + 2] - (DistanceToTarget + Correction);
+            cx[k] = zt * sina + p[3 * k] * cosa;
+            cy[k] = p[3 * k + 1];
+            cz[k] = zt * cosa - p[3 * k] * sina;
+            wsum[k] = 0.;
+            Bi[0][k] = Bi[1][k] = Bi[2][k] = 0.;
+        }
+
+        for (int rl = 0; rl < 2; rl++)
+        {
+            const coords_ALADiN& co = gCoords[rl];
+            for (Int_t k = 0; k < m; k++)
+            {
+                // swap axis, move to origin at pt and rotate into the box system
+                const double boxxp = cz[k] - co.fMag_pt[0].X();
+                const double boxy = cy[k] - co.fMag_pt[0].Y();
+                const double boxzp = -cx[k] - co.fMag_pt[0].Z();
+                boxx[k] = co.fCosa * boxxp - co.fSina * boxzp + co.fBox_pt[0].X();
+                const double boxz = co.fSina * boxxp + co.fCosa * boxzp + co.fBox_pt[0].Z();
+
+                dc[1][k] = (boxy + co.fBox_pt[0].Y() + box_grid_off[rl][3]) * (1 / 3.);
+                dc[2][k] = (boxz + box_grid_off[rl][4]) * (1 / 4.);
+                ic[1][k] = (int)floor(dc[1][k]);
+                dc[1][k] -= ic[1][k];
+                ic[2][k] = (int)floor(dc[2][k]);
+                dc[2][k] -= ic[2][k];
+
+                w[k] = 1.;
+                valid[k] = TMath::Abs(cz[k]) <= 160.;
+                if (rl == 0)
+                {
+                    if (ic[2][k] > 21)
+                        valid[k] = kFALSE;
+                    else if (ic[2][k] > 20)
+                        w[k] = 1 - dc[2][k];
+                }
+                else
+                {
+                    if (ic[2][k] < -1)
+                        valid[k] = kFALSE;
+                    else if (ic[2][k] < 0)
+                        w[k] = dc[2][k];
+                }
+                if (valid[k])
+                    wsum[k] += w[k];
+            }
+
+            for (int i = 0; i < 3; i++)
+            {
+                const R3BFieldInterp& f = fCurField->f[rl][i];
+                for (Int_t k = 0; k < m; k++)
+                {
+                    dc[0][k] = (boxx[k] + box_grid_off[rl][i]) * (1 / 3.);
+                    ic[0][k] = (int)floor(dc[0][k]);
+                    dc[0][k] -= ic[0][k];
+
+                    // Clamp to the grid border like R3BFieldInterp::interp
+                    Int_t lo[3], step[3];
+                    for (int j = 0; j < 3; j++)
+                    {
+                        lo[j] = TMath::Min(TMath::Max(ic[j][k], 0), f._max_ic[j]);
+                        step[j] = TMath::Min(TMath::Max(ic[j][k] + 1, 0), f._max_ic[j]) - lo[j];
+                    }
+                    node[k] = lo[0] * f._m1 + lo[1] * f._m2 + lo[2];
+                    sx[k] = step[0] * f._m1;
+                    sy[k] = step[1] * f._m2;
+                    sz[k] = step[2];
+                }
+                R3BFieldBatch::Trilinear(m, f._data, node, sx, sy, sz, dc[0], dc[1], dc[2], Bbi[i]);
+            }
+
+            // Rotate from the box frame into the ALADiN frame
+            for (Int_t k = 0; k < m; k++)
+            {
+                const Double_t wk = valid[k] ? w[k] : 0.;
+                const Double_t b0 = valid[k] ? Bbi[0][k] : 0.;
+                const Double_t b1 = valid[k] ? Bbi[1][k] : 0.;
+                const Double_t b2 = valid[k] ? Bbi[2][k] : 0.;
+                Bi[0][k] += wk * (co.fCosa * b0 + co.fSina * b2);
+                Bi[1][k] += wk * b1;
+                Bi[2][k] += wk * (co.fSina * b0 - co.fCosa * b2);
+            }
+        }
+
+        for (Int_t k = 0; k < m; k++)
+        {
+            const Double_t z_abs = TMath::Abs(cz[k]);
+            Double_t wsuminv = 0.;
+            if (wsum[k] != 0.)
+                wsuminv = fFieldSign / wsum[k];
+            if ((z_abs > 120.0) && (z_abs <= 160.))
+                wsuminv *= 0.025 * (160. - z_abs);
+            if (z_abs > 160.)
+                wsuminv = 0.;
+
+            // swap field like in GetFieldValue [kGauss]
+            out[3 * k + 2] = -1. * Bi[0][k] * wsuminv * 10.;
+            out[3 * k + 1] = -1. * Bi[1][k] * wsuminv * 10.;
+            out[3 * k] = +1. * Bi[2][k] * wsuminv * 10.;
+        }
+    }
+}
+
 //-------------------------- Standard R3BROOT API ----------------------//
 Double_t R3BAladinFieldMap::GetBx(Double_t x, Double_t y, Double_t z) { return 0.; }
 Double_t R3BAladinFieldMap::GetBy(Double_t x, Double_t y, Double_t z) { return 0.; }
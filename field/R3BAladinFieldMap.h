@@ -80,6 +80,13 @@ class R3BAladinFieldMap : public FairField
     /** Main GetField function */
     virtual void GetFieldValue(const Double_t point[3], Double_t* bField);
 
+    /** Batch GetField function
+     ** @param n        Number of points
+     ** @param points   Point coordinates (global), n consecutive (x,y,z) triples [cm]
+     ** @param bFields  (return) Field components, n consecutive (Bx,By,Bz) triples [kG]
+     **/
+    virtual void GetFieldValues(Int_t n, const Double_t* points, Double_t* bFields);
+
     /** Get the field components at a certain point
      ** @param x,y,z     Point coordinates (global) [cm]
      ** @value Bx,By,Bz  Field components [kG]
@@ -151,13 +158,43 @@ class R3BAladinFieldMap : public FairField
     /** Screen output **/
     virtual void Print(Option_t* option = "") const;
 
-    /** Set Current **/
-
-    void SetCurrent(Double_t aCurrent) { fCurrent = aCurrent; }
+    /** Set Current
+     ** After Init the field for the new current is taken from the per-current cache,
+     ** or built once from the neighbouring reference maps.
+     **/
+    void SetCurrent(Double_t aCurrent);
     Double_t GetCurrent() { return fCurrent; }
     void SetFringeField(Bool_t set) { gFringeField = set; }
 
+    /** Use the smoother tricubic interpolation (R3BFieldInterp::interp3) instead of the trilinear one.
+     ** The polynomial coefficients of the last cacheCells cells of each component are kept, such that
+     ** repeated evaluation in the same cells (e.g. the Runge-Kutta sub-steps) is cheap.
+     **/
+    void SetTricubic(Bool_t tricubic, Int_t cacheCells = kTricubicCacheCells);
+    Bool_t GetTricubic() const { return fTricubic; }
+
+    /** Directory of the binary reference map cache (default: $XDG_CACHE_HOME/r3broot, else
+     ** $HOME/.cache/r3broot, else the temporary directory)
+     **/
+    static void SetCacheDirectory(const char* dir);
+
   protected:
+    /** Read the reference maps once per process, from the binary cache if available **/
+    void InitMaps();
+
+    /** Size the tricubic coefficient caches of the current field (none for trilinear) **/
+    void InitTricubicCache();
+
+    /** Parse and expand the ASCII reference map of one current **/
+    static Bool_t ReadAsciiMap(const TString& mapDir, Int_t current, fields_ALADiN* field);
+
+    /** Binary cache of the expanded reference maps, one file per current and box. The cache
+     ** is only used if size and modification time of the ASCII map match the ones stored in it.
+     **/
+    static TString CachedMapFileName(Int_t current, Int_t rl);
+    static Bool_t ReadCachedMap(const TString& mapDir, Int_t current, fields_ALADiN* field);
+    static void WriteCachedMap(const TString& mapDir, Int_t current, const fields_ALADiN* field);
+
     /** Reset the field parameters and data **/
     void Reset();
 
@@ -216,10 +253,18 @@ class R3BAladinFieldMap : public FairField
 
     static coords_ALADiN gCoords[2]; //!
     static Bool_t gInitialized;      //!
+    static TString gCacheDir;        //!
+
+    static const Int_t kGridSize[2][3];
+    static const Int_t kGridOffset[2][3];
+
+    static const Int_t kTricubicCacheCells = 1024;
 
-    fields_ALADiN* fCurField; //!
-    Double_t fCurrent;        //!
-    Double_t fFieldSign;      //!
+    fields_ALADiN* fCurField;  //!
+    Bool_t fTricubic;          //!
+    Int_t fTricubicCacheCells; //!
+    Double_t fCurrent;         //!
+    Double_t fFieldSign;       //!
 
     TVector3 af_box[2][2]; //!
     TVector3 af_mag[2][2]; //!
@@ -0,0 +1,93 @@
+/******************************************************************************
+ *   Copyright (C) 2019 GSI Helmholtzzentrum für Schwerionenforschung GmbH    *
+ *   Copyright (C) 2019 Members of R3B Collaboration                          *
+ *                                                                            *
+ *             This software is distributed under the terms of the            *
+ *                 GNU General Public Licence (GPL) version 3,                *
+ *                    copied verbatim in the file "LICENSE".                  *
+ *                                                                            *
+ * In applying this license GSI does not waive the privileges and immunities  *
+ * granted to it by virtue of its status as an Intergovernmental Organization *
+ * or submit itself to any jurisdiction.                                      *
+ ******************************************************************************/
+
+#ifndef R3BFIELDBATCH_H
+#define R3BFIELDBATCH_H 1
+
+#include "Rtypes.h"
+
+// Helpers for the GetFieldValues batch interface of the grid field maps.
+// Points are handled in blocks: first the cell of every point in the
+// block is located, then each field component is interpolated for the
+// whole block in a loop without branches, which the compiler can turn
+// into gathers and packed arithmetic.
+
+namespace R3BFieldBatch
+{
+    /** Number of points located and interpolated together **/
+    const Int_t kBlockSize = 64;
+
+    /** Trilinear interpolation of one grid component for a block of points
+     ** @param n         Number of points
+     ** @param data      Grid values
+     ** @param node      Index of the lower cell corner in data, per point
+     ** @param sx,sy,sz  Index step to the upper cell corner along x,y,z
+     ** @param dx,dy,dz  Relative distance from the lower corner [cell units], per point
+     ** @param out       (return) Interpolated values, per point
+     **/
+    template <typename T>
+    inline void Trilinear(Int_t n,
+                          const T* data,
+                          const Int_t* node,
+                          Int_t sx,
+                          Int_t sy,
+                          Int_t sz,
+                          const Double_t* dx,
+                          const Double_t* dy,
+                          const Double_t* dz,
+                          Double_t* out)
+    {
+        for (Int_t i = 0; i < n; i++)
+        {
+            const T* b = data + node[i];
+            const Double_t c00 = b[0] + (b[sx] - b[0]) * dx[i];
+            const Double_t c10 = b[sy] + (b[sx + sy] - b[sy]) * dx[i];
+            const Double_t c01 = b[sz] + (b[sx + sz] - b[sz]) * dx[i];
+            const Double_t c11 = b[sy + sz] + (b[sx + sy + sz] - b[sy + sz]) * dx[i];
+            const Double_t c0 = c00 + (c10 - c00) * dy[i];
+            const Double_t c1 = c01 + (c11 - c01) * dy[i];
+            out[i] = c0 + (c1 - c0) * dz[i];
+        }
+    }
+
+    /** Same as above, with per-point index steps (e.g. zero steps for points clamped to the grid border) **/
+    template <typename T>
+    inline void Trilinear(Int_t n,
+                          const T* data,
+                          const Int_t* node,
+                          const Int_t* sx,
+                          const Int_t* sy,
+                          const Int_t* sz,
+                          const Double_t* dx,
+                          const Double_t* dy,
+                          const Double_t* dz,
+                          Double_t* out)
+    {
+        for (Int_t i = 0; i < n; i++)
+        {
+            const T* b = data + node[i];
+            const Int_t x = sx[i];
+            const Int_t y = sy[i];
+            const Int_t z = sz[i];
+            const Double_t c00 = b[0] + (b[x] - b[0]) * dx[i];
+            const Double_t c10 = b[y] + (b[x + y] - b[y]) * dx[i];
+            const Double_t c01 = b[z] + (b[x + z] - b[z]) * dx[i];
+            const Double_t c11 = b[y + z] + (b[x + y + z] - b[y + z]) * dx[i];
+            const Double_t c0 = c00 + (c10 - c00) * dy[i];
+            const Double_t c1 = c01 + (c11 - c01) * dy[i];
+            out[i] = c0 + (c1 - c0) * dz[i];
+        }
+    }
+} // namespace R3BFieldBatch
+
+#endif
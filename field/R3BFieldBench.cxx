@@ -0,0 +1,270 @@
+/******************************************************************************
+ *   Copyright (C) 2019 GSI Helmholtzzentrum für Schwerionenforschung GmbH    *
+ *   Copyright (C) 2019 Members of R3B Collaboration                          *
+ *                                                                            *
+ *             This software is distributed under the terms of the            *
+ *                 GNU General Public Licence (GPL) version 3,                *
+ *                    copied verbatim in the file "LICENSE".                  *
+ *                                                                            *
+ * In applying this license GSI does not waive the privileges and immunities  *
+ * granted to it by virtue of its status as an Intergovernmental Organization *
+ * or submit itself to any jurisdiction.                                      *
+ ******************************************************************************/
+
+// Field evaluation benchmark: evaluations per second of the field maps for
+// different query patterns, as reference numbers for field map changes.
+//
+//   r3bfieldbench [-n points] [-r repetitions] [glad map (.dat or .bin)]
+//
+// Patterns:
+//   random    uniformly distributed points in the map volume
+//   line      consecutive points 0.5 cm apart on straight lines from the target
+//   track     the positions at which a 4th order Runge-Kutta propagation of
+//             fragments from the target evaluates the field (1 cm steps)
+//
+// The GLAD map is measured if a map file is given (trilinear, scalar and
+// batch calls); the ALADiN map if $VMCWORKDIR is set (trilinear and tricubic).
+
+#include "FairField.h"
+#include "R3BAladinFieldMap.h"
+#include "R3BGladFieldMap.h"
+
+#include "TMath.h"
+#include "TRandom3.h"
+#include "TString.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+namespace
+{
+    // Consecutive (x,y,z) triples [cm]
+    typedef std::vector<Double_t> Points;
+
+    // Volume in which the query points are generated [cm]
+    struct Region
+    {
+        Double_t min[3];
+        Double_t max[3];
+    };
+
+    Points RandomPoints(const Region& region, Int_t n, TRandom& rnd)
+    {
+        Points points(3 * n);
+        for (Int_t i = 0; i < n; i++)
+        {
+            for (Int_t j = 0; j < 3; j++)
+            {
+                points[3 * i + j] = rnd.Uniform(region.min[j], region.max[j]);
+            }
+        }
+        return points;
+    }
+
+    // Random directions from the target, stepping through the region along z
+    Points LinePoints(const Region& region, Int_t n, TRandom& rnd)
+    {
+        const Double_t step = 0.5;
+        Points points;
+        points.reserve(3 * n);
+        while ((Int_t)points.size() < 3 * n)
+        {
+            const Double_t tx = rnd.Uniform(-0.1, 0.1);
+            const Double_t ty = rnd.Uniform(-0.05, 0.05);
+            for (Double_t z = region.min[2]; z < region.max[2] && (Int_t)points.size() < 3 * n; z += step)
+            {
+                points.push_back(tx * z);
+                points.push_back(ty * z);
+                points.push_back(z);
+            }
+        }
+        return points;
+    }
+
+    // Derivative of (x, y, z, ux, uy, uz) along the path for the curvature kappa = q / p [1 / (kG cm)]
+    void Derivative(FairField* field, Double_t kappa, const Double_t s[6], Double_t ds[6], Points& points)
+    {
+        Double_t b[3];
+        field->GetFieldValue(s, b);
+        points.insert(points.end(), s, s + 3);
+        ds[0] = s[3];
+        ds[1] = s[4];
+        ds[2] = s[5];
+        ds[3] = kappa * (s[4] * b[2] - s[5] * b[1]);
+        ds[4] = kappa * (s[5] * b[0] - s[3] * b[2]);
+        ds[5] = kappa * (s[3] * b[1] - s[4] * b[0]);
+    }
+
+    // Fragments with 2 - 8 GeV/c per charge unit from the target through the region
+    Points TrackPoints(FairField* field, const Region& region, Int_t n, TRandom& rnd)
+    {
+        const Double_t c = 2.99792458e-4; // GeV/c per kG cm
+        const Double_t h = 1.;            // cm
+        Points points;
+        points.reserve(3 * n + 12);
+        while ((Int_t)points.size() < 3 * n)
+        {
+            const Double_t kappa = c / rnd.Uniform(2., 8.);
+            const Double_t tx = rnd.Uniform(-0.05, 0.05);
+            const Double_t ty = rnd.Uniform(-0.02, 0.02);
+            const Double_t norm = 1. / TMath::Sqrt(1. + tx * tx + ty * ty);
+            Double_t s[6] = { 0., 0., 0., tx * norm, ty * norm, norm };
+
+            while (s[2] < region.max[2] && (Int_t)points.size() < 3 * n)
+            {
+                Double_t k1[6], k2[6], k3[6], k4[6], t[6];
+                Derivative(field, kappa, s, k1, points);
+                for (Int_t i = 0; i < 6; i++)
+                    t[i] = s[i] + 0.5 * h * k1[i];
+                Derivative(field, kappa, t, k2, points);
+                for (Int_t i = 0; i < 6; i++)
+                    t[i] = s[i] + 0.5 * h * k2[i];
+                Derivative(field, kappa, t, k3, points);
+                for (Int_t i = 0; i < 6; i++)
+                    t[i] = s[i] + h * k3[i];
+                Derivative(field, kappa, t, k4, points);
+                for (Int_t i = 0; i < 6; i++)
+                    s[i] += h / 6. * (k1[i] + 2. * k2[i] + 2. * k3[i] + k4[i]);
+            }
+        }
+        points.resize(3 * n);
+        return points;
+    }
+
+    // FairField has no batch interface, hence the concrete map type
+    template <typename T>
+    void Measure(const char* map,
+                 const char* method,
+                 const char* pattern,
+                 T* field,
+                 const Points& points,
+                 Int_t repetitions,
+                 Bool_t batch)
+    {
+        const Int_t n = points.size() / 3;
+        std::vector<Double_t> b(points.size());
+        Double_t sum = 0.;
+
+        const auto start = std::chrono::steady_clock::now();
+        for (Int_t r = 0; r < repetitions; r++)
+        {
+            if (batch)
+            {
+                field->GetFieldValues(n, points.data(), b.data());
+            }
+            else
+            {
+                for (Int_t i = 0; i < n; i++)
+                {
+                    field->GetFieldValue(&points[3 * i], &b[3 * i]);
+                }
+            }
+        }
+        const auto stop = std::chrono::steady_clock::now();
+
+        for (Int_t i = 0; i < n; i++)
+        {
+            sum += b[3 * i + 1];
+        }
+
+        const Double_t seconds = std::chrono::duration<Double_t>(stop - start).count();
+        const Double_t rate = seconds > 0. ? Double_t(n) * repetitions / seconds : 0.;
+        printf("%-8s %-18s %-8s %10.2f Mevals/s %8.1f ns/eval  (checksum %g)\n",
+               map,
+               method,
+               pattern,
+               rate * 1.e-6,
+               rate > 0. ? 1.e9 / rate : 0.,
+               sum);
+    }
+
+    template <typename T>
+    void MeasurePatterns(const char* map,
+                         const char* method,
+                         T* field,
+                         const Region& region,
+                         Int_t n,
+                         Int_t repetitions,
+                         Bool_t batch)
+    {
+        TRandom3 rnd(4357);
+        Measure(map, method, "random", field, RandomPoints(region, n, rnd), repetitions, batch);
+        Measure(map, method, "line", field, LinePoints(region, n, rnd), repetitions, batch);
+        Measure(map, method, "track", field, TrackPoints(field, region, n, rnd), repetitions, batch);
+    }
+} // namespace
+
+int main(int argc, char** argv)
+{
+    Int_t n = 100000;
+    Int_t repetitions = 20;
+    const char* gladMap = NULL;
+
+    for (Int_t i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "-n") == 0 && i + 1 < argc)
+        {
+            n = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "-r") == 0 && i + 1 < argc)
+        {
+            repetitions = atoi(argv[++i]);
+        }
+        else if (argv[i][0] != '-' && gladMap == NULL)
+        {
+            gladMap = argv[i];
+        }
+        else
+        {
+            fprintf(stderr, "Usage: %s [-n points] [-r repetitions] [glad map (.dat or .bin)]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    if (n <= 0 || repetitions <= 0)
+    {
+        fprintf(stderr, "Number of points and repetitions must be positive\n");
+        return 1;
+    }
+
+    if (gladMap)
+    {
+        R3BGladFieldMap glad;
+        glad.SetFileName(gladMap);
+        glad.Init();
+
+        // Local map volume around the magnet position, both halves of symmetric maps
+        const Double_t xmax = TMath::Max(TMath::Abs(glad.GetXmin()), TMath::Abs(glad.GetXmax()));
+        const Double_t ymax = TMath::Max(TMath::Abs(glad.GetYmin()), TMath::Abs(glad.GetYmax()));
+        const Region region = { { -xmax, -ymax, glad.GetPositionZ() + glad.GetZmin() },
+                                { xmax, ymax, glad.GetPositionZ() + glad.GetZmax() } };
+
+        MeasurePatterns("GLAD", "trilinear", &glad, region, n, repetitions, kFALSE);
+        MeasurePatterns("GLAD", "trilinear batch", &glad, region, n, repetitions, kTRUE);
+    }
+
+    if (getenv("VMCWORKDIR"))
+    {
+        R3BAladinFieldMap aladin;
+        aladin.SetScale(1.);
+        aladin.SetCurrent(2500.);
+        aladin.Init();
+
+        // ALADiN measurement boxes, see R3BAladinFieldMap::GetFieldValue
+        const Region region = { { -60., -25., 135. }, { 60., 25., 375. } };
+
+        MeasurePatterns("ALADiN", "trilinear", &aladin, region, n, repetitions, kFALSE);
+        MeasurePatterns("ALADiN", "trilinear batch", &aladin, region, n, repetitions, kTRUE);
+        aladin.SetTricubic(kTRUE);
+        MeasurePatterns("ALADiN", "tricubic", &aladin, region, n, repetitions, kFALSE);
+    }
+    else
+    {
+        printf("VMCWORKDIR not set, skipping the ALADiN map\n");
+    }
+
+    return 0;
+}
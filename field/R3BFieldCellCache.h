@@ -0,0 +1,43 @@
+/******************************************************************************
+ *   Copyright (C) 2019 GSI Helmholtzzentrum für Schwerionenforschung GmbH    *
+ *   Copyright (C) 2019 Members of R3B Collaboration                          *
+ *                                                                            *
+ *             This software is distributed under the terms of the            *
+ *                 GNU General Public Licence (GPL) version 3,                *
+ *                    copied verbatim in the file "LICENSE".                  *
+ *                                                                            *
+ * In applying this license GSI does not waive the privileges and immunities  *
+ * granted to it by virtue of its status as an Intergovernmental Organization *
+ * or submit itself to any jurisdiction.                                      *
+ ******************************************************************************/
+
+#ifndef R3BFIELDCELLCACHE_H
+#define R3BFIELDCELLCACHE_H 1
+
+#include "Rtypes.h"
+#include <atomic>
+
+// Last grid cell used by a field map on one thread.
+//
+// Consecutive field calls during propagation mostly land in the same
+// cell.  A map keeps one thread_local cache with the index of that cell
+// and the position of its lower corner in the local map frame, such that
+// a hit needs neither the bounds checks nor the divisions to find the
+// cell.  Each map gets a new id from NewId() whenever its grid changes;
+// a cache filled by another map or an older grid never matches.
+
+struct R3BFieldCellCache
+{
+    ULong64_t fId;       // id of the map that filled the cache, 0 = empty
+    Int_t fNode;         // node index of the lower cell corner
+    Double_t fOrigin[3]; // local position of the lower cell corner [cm]
+
+    /** Unique non-zero id for a map grid **/
+    static ULong64_t NewId()
+    {
+        static std::atomic<ULong64_t> lastId(0);
+        return ++lastId;
+    }
+};
+
+#endif // R3BFIELDCELLCACHE_H
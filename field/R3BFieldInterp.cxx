@@ -14,6 +14,7 @@
 #include "R3BFieldInterp.h"
 #include <iostream>
 #include <math.h>
+#include <vector>
 
 using namespace std;
 
@@ -37,6 +38,7 @@ void R3BFieldInterp::interpolate(const R3BFieldInterp& s1, double w1, const R3BF
 
 void R3BFieldInterp::init()
 {
+    clear_interp3_cache();
 
     for (int i = 0; i < 3; i++)
     {
@@ -60,6 +62,8 @@ void R3BFieldInterp::init()
 
 bool R3BFieldInterp::expand()
 {
+    clear_interp3_cache();
+
     bool expanded = false;
 
     for (int i0 = 0; i0 < _np[0]; i0++)
@@ -211,11 +215,135 @@ inline double interp3_factors_mul(double v[4], double p1, double p2, double p3)
     return s;
 }
 
+inline double interp3_poly(const double f[4], double x) { return ((f[3] * x + f[2]) * x + f[1]) * x + f[0]; }
+
 struct interp3_cell
 {
     double _f[4][4][4];
 };
 
+// Coefficient cache of interp3.  Cells are identified by their lower
+// corner, clamped to [-2,_np] in each direction (beyond that all
+// stencil points are clamped to the boundary, i.e. the cell is the
+// same).  The key table maps each cell to its slot, the slots form a
+// doubly linked list in order of use.
+
+struct interp3_cache
+{
+    int _nk[3];
+    int _max_cells;
+    std::vector<int> _slot;   // per cell key: slot or -1
+    std::vector<int> _key;    // per slot: cell key
+    std::vector<int> _prev;   // per slot: more recently used slot
+    std::vector<int> _next;   // per slot: less recently used slot
+    std::vector<interp3_cell> _cell;
+    int _head, _tail;
+};
+
+R3BFieldInterp::~R3BFieldInterp()
+{
+    clear_interp3_cache();
+    free(_data);
+}
+
+void R3BFieldInterp::clear_interp3_cache()
+{
+    delete _cache3;
+    _cache3 = NULL;
+}
+
+void R3BFieldInterp::set_interp3_cache(int max_cells)
+{
+    clear_interp3_cache();
+
+    if (max_cells <= 0 || _n == 0)
+        return;
+
+    _cache3 = new interp3_cache;
+
+    int nkeys = 1;
+    for (int i = 0; i < 3; i++)
+    {
+        _cache3->_nk[i] = _np[i] + 3;
+        nkeys *= _cache3->_nk[i];
+    }
+
+    if (max_cells > nkeys)
+        max_cells = nkeys;
+
+    _cache3->_max_cells = max_cells;
+    _cache3->_slot.assign(nkeys, -1);
+    _cache3->_key.reserve(max_cells);
+    _cache3->_prev.reserve(max_cells);
+    _cache3->_next.reserve(max_cells);
+    _cache3->_cell.reserve(max_cells);
+    _cache3->_head = -1;
+    _cache3->_tail = -1;
+}
+
+int R3BFieldInterp::fill_interp3_cell(int key, int icj[3][4])
+{
+    interp3_cache& cache = *_cache3;
+    int slot;
+
+    if ((int)cache._cell.size() < cache._max_cells)
+    {
+        slot = cache._cell.size();
+        cache._cell.push_back(interp3_cell());
+        cache._key.push_back(key);
+        cache._prev.push_back(-1);
+        cache._next.push_back(-1);
+    }
+    else
+    {
+        // Reuse the least recently used cell
+        slot = cache._tail;
+        cache._slot[cache._key[slot]] = -1;
+        cache._tail = cache._prev[slot];
+        if (cache._tail >= 0)
+            cache._next[cache._tail] = -1;
+        else
+            cache._head = -1;
+        cache._key[slot] = key;
+    }
+    cache._slot[key] = slot;
+
+    // Factors along the 3rd, then the 2nd and the 1st component:
+    // v = sum _f[a][b][c] * dc[0]^a * dc[1]^b * dc[2]^c
+
+    interp3_cell& c = cache._cell[slot];
+    double v[4];
+
+    for (int i0 = 0; i0 < 4; i0++)
+        for (int i1 = 0; i1 < 4; i1++)
+        {
+            int offset = icj[0][i0] * _m1 + icj[1][i1] * _m2;
+
+            for (int i2 = 0; i2 < 4; i2++)
+                v[i2] = _data[offset + icj[2][i2]];
+
+            interp3_factors(v[0], v[1], v[2], v[3], c._f[i0][i1]);
+        }
+
+    for (int i0 = 0; i0 < 4; i0++)
+        for (int i2 = 0; i2 < 4; i2++)
+        {
+            interp3_factors(c._f[i0][0][i2], c._f[i0][1][i2], c._f[i0][2][i2], c._f[i0][3][i2], v);
+            for (int i1 = 0; i1 < 4; i1++)
+                c._f[i0][i1][i2] = v[i1];
+        }
+
+    for (int i1 = 0; i1 < 4; i1++)
+        for (int i2 = 0; i2 < 4; i2++)
+        {
+            interp3_factors(c._f[0][i1][i2], c._f[1][i1][i2], c._f[2][i1][i2], c._f[3][i1][i2], v);
+            for (int i0 = 0; i0 < 4; i0++)
+                c._f[i0][i1][i2] = v[i0];
+        }
+
+    return slot;
+}
+
 double R3BFieldInterp::interp3(int ic[3], double dc[3] /*,int &outside*/)
 {
     // Make field interpolation that also takes neighbouring cells into
@@ -254,45 +382,72 @@ double R3BFieldInterp::interp3(int ic[3], double dc[3] /*,int &outside*/)
 
     for (int i = 0; i < 3; i++)
     {
-        icj[i][0] = ic[0] - 1;
-        icj[i][1] = ic[0];
-        icj[i][2] = ic[0] + 1;
-        icj[i][3] = ic[0] + 2;
-
-        if (icj[i][0] < 0)
-        {
-            icj[i][0] = 0;
-        }
-        if (icj[i][1] < 0)
-        {
-            icj[i][1] = 0; /*outside |= outside_mark; */
-        }
-        if (icj[i][2] < 0)
+        for (int j = 0; j < 4; j++)
         {
-            icj[i][2] = 0;
+            icj[i][j] = ic[i] - 1 + j;
+
+            if (icj[i][j] < 0)
+            {
+                icj[i][j] = 0; /*outside |= outside_mark; */
+            }
+            /*outside_mark <<= 1;*/
+            if (icj[i][j] > _max_ic[i])
+            {
+                icj[i][j] = _max_ic[i]; /*outside |= outside_mark; */
+            }
+            /*outside_mark <<= 1;*/
         }
-        if (icj[i][3] < 0)
+    }
+
+    if (_cache3)
+    {
+        interp3_cache& cache = *_cache3;
+
+        int key = 0;
+        for (int i = 0; i < 3; i++)
         {
-            icj[i][3] = 0;
+            int k = ic[i] < -2 ? -2 : ic[i] > _np[i] ? _np[i] : ic[i];
+            key = key * cache._nk[i] + k + 2;
         }
-        /*outside_mark <<= 1;*/
-        if (icj[i][0] > _max_ic[i])
+
+        int slot = cache._slot[key];
+
+        if (slot < 0)
         {
-            icj[i][0] = _max_ic[i];
+            slot = fill_interp3_cell(key, icj);
         }
-        if (icj[i][1] > _max_ic[i])
+        else if (slot != cache._head)
         {
-            icj[i][1] = _max_ic[i]; /*outside |= outside_mark; */
+            // Unlink, to be reinserted as most recently used
+            cache._next[cache._prev[slot]] = cache._next[slot];
+            if (cache._next[slot] >= 0)
+                cache._prev[cache._next[slot]] = cache._prev[slot];
+            else
+                cache._tail = cache._prev[slot];
         }
-        if (icj[i][2] > _max_ic[i])
+
+        if (slot != cache._head)
         {
-            icj[i][2] = _max_ic[i];
+            cache._prev[slot] = -1;
+            cache._next[slot] = cache._head;
+            if (cache._head >= 0)
+                cache._prev[cache._head] = slot;
+            cache._head = slot;
+            if (cache._tail < 0)
+                cache._tail = slot;
         }
-        if (icj[i][3] > _max_ic[i])
+
+        const interp3_cell& c = cache._cell[slot];
+
+        double f0[4];
+        for (int i0 = 0; i0 < 4; i0++)
         {
-            icj[i][3] = _max_ic[i];
+            double f1[4];
+            for (int i1 = 0; i1 < 4; i1++)
+                f1[i1] = interp3_poly(c._f[i0][i1], dc[2]);
+            f0[i0] = interp3_poly(f1, dc[1]);
         }
-        /*outside_mark <<= 1;*/
+        return interp3_poly(f0, dc[0]);
     }
 
     // First we get the values for the box.  That is to get 4x4x4 = 64 values.
@@ -314,20 +469,14 @@ double R3BFieldInterp::interp3(int ic[3], double dc[3] /*,int &outside*/)
             interp3_factors(v[0], v[1], v[2], v[3], ip3c._f[i0][i1]);
         }
 
-    // First we cook down the 4x4x4 values to 4x4 by multiplying with the first set
-    // of powers (of 3rd component)
+    // First we cook down the 4x4x4 values to 4x4 by evaluating the
+    // polynomials in the 3rd component
 
     double ip2s[4][4];
 
-    {
-        double p1 = dc[2];
-        double p2 = dc[2] * dc[2];
-        double p3 = dc[2] * p2;
-
-        for (int i0 = 0; i0 < 4; i0++)
-            for (int i1 = 0; i1 < 4; i1++)
-                ip2s[i0][i1] = interp3_factors_mul(ip3c._f[i0][i1], p1, p2, p3);
-    }
+    for (int i0 = 0; i0 < 4; i0++)
+        for (int i1 = 0; i1 < 4; i1++)
+            ip2s[i0][i1] = interp3_poly(ip3c._f[i0][i1], dc[2]);
 
     double ip1l[4];
 
@@ -20,6 +20,12 @@
 // interpolation.  When given a point outside the valid map: produce
 // values as at the boundary at that point, i.e.  give a continous
 // value outside.  But not where and in what direction it went wrong.
+//
+// The tricubic interp3 can keep the polynomial coefficients of the
+// cells it has evaluated (see set_interp3_cache), such that repeated
+// evaluations in the same cell only cost the polynomial evaluation.
+
+struct interp3_cache;
 
 class R3BFieldInterp
 {
@@ -29,12 +35,13 @@ class R3BFieldInterp
         , _m2(0)
         , _n(0)
         , _data(NULL)
+        , _cache3(NULL)
     {
         for (int i = 0; i < 3; i++)
             _np[i] = 0;
     }
 
-    ~R3BFieldInterp() { free(_data); }
+    ~R3BFieldInterp();
 
   private:
     const R3BFieldInterp& operator=(const R3BFieldInterp&);
@@ -52,6 +59,20 @@ class R3BFieldInterp
 
     double interp3(int ic[3], double dc[3] /*,int &outside*/);
 
+    // Keep the tricubic coefficients of up to max_cells cells, least
+    // recently used cells are dropped first.  With max_cells covering
+    // the whole map no cell is ever dropped.  0 disables the cache.
+    // The cache is dropped by init(), interpolate() and expand(); data
+    // modified with set_data_pt() afterwards requires a new call.
+    // Not thread safe, as evaluation updates the cache.
+    void set_interp3_cache(int max_cells);
+
+  private:
+    void clear_interp3_cache();
+    int fill_interp3_cell(int key, int icj[3][4]);
+
+    interp3_cache* _cache3;
+
   public:
     int _np[3];
     int _max_ic[3]; // _max_ic[i] = _np[i] - 1
@@ -28,6 +28,8 @@
 
 // Includes from CBMROOT
 #include "R3BFieldMap.h"
+#include "R3BFieldBatch.h"
+#include "R3BFieldCellCache.h"
 //#include "R3BFieldMapCreator.h"
 #include "R3BFieldMapData.h"
 #include "R3BFieldPar.h"
@@ -43,8 +45,12 @@ using std::setw;
 using std::showpoint;
 using TMath::Nint;
 
+// Last grid cell used by GetFieldValue on this thread
+static thread_local R3BFieldCellCache gMapCell;
+
 // -------------   Default constructor  ----------------------------------
 R3BFieldMap::R3BFieldMap()
+    : fCellCacheId(R3BFieldCellCache::NewId())
 {
     // do nothing ..
 }
@@ -53,6 +59,7 @@ R3BFieldMap::R3BFieldMap()
 // -------------   Standard constructor   ---------------------------------
 R3BFieldMap::R3BFieldMap(const char* mapName, const char* fileType)
     : FairField(mapName)
+    , fCellCacheId(R3BFieldCellCache::NewId())
 {
     // empty ctor
 }
@@ -60,6 +67,7 @@ R3BFieldMap::R3BFieldMap(const char* mapName, const char* fileType)
 // ------------------------------------------------------------------------
 R3BFieldMap::R3BFieldMap(Int_t type, Bool_t verbosity)
     : FairField("R3Bmap")
+    , fCellCacheId(R3BFieldCellCache::NewId())
 {
 
     // specific to R3B to be consistent  with the geometry of the Aladin Magnet
@@ -214,9 +222,6 @@ void R3BFieldMap::GetFieldValue(const Double_t point[3], Double_t* bField)
     if (typeField == 0 || typeField == 1 || typeField == 3)
     {
 
-        // local
-        TArrayI* linesArray = new TArrayI(8);
-
         // local to global
         TVector3 localPoint(point[0], point[1], point[2]);
 
@@ -228,8 +233,15 @@ void R3BFieldMap::GetFieldValue(const Double_t point[3], Double_t* bField)
         localPoint = localPoint + (*gTrans); // First translation
         localPoint.Transform(*gRot);
 
+        // Consecutive calls mostly stay in the same grid cell, which is then not searched again
+        R3BFieldCellCache& cell = gMapCell;
+        Double_t t = (localPoint.X() - cell.fOrigin[0]) / gridStep;
+        Double_t u = (localPoint.Y() - cell.fOrigin[1]) / gridStep;
+        Double_t v = (localPoint.Z() - cell.fOrigin[2]) / gridStep;
+        Bool_t inCell = cell.fId == fCellCacheId && t >= 0. && t < 1. && u >= 0. && u < 1. && v >= 0. && v < 1.;
+
         // test area
-        if (localPoint.X() >= initialX && localPoint.Y() >= initialY && localPoint.Z() >= initialZ &&
+        if (!inCell && localPoint.X() >= initialX && localPoint.Y() >= initialY && localPoint.Z() >= initialZ &&
             localPoint.X() <= initialX + ((stepsInX - 1) * gridStep) &&
             localPoint.Y() <= initialY + ((stepsInY - 1) * gridStep) &&
             localPoint.Z() <= initialZ + ((stepsInZ - 1) * gridStep))
@@ -240,45 +252,28 @@ void R3BFieldMap::GetFieldValue(const Double_t point[3], Double_t* bField)
             //        localPoint.Y() << " : " <<  localPoint.Z()
             //       << endl;
 
-            Int_t returnValue = GetLinesArrayForPosition(&localPoint, linesArray);
+            TArrayI linesArray(8);
+            Int_t returnValue = GetLinesArrayForPosition(&localPoint, &linesArray);
 
             if (!returnValue)
             {
                 TVector3 vertexReferenceInGrid;
-                Int_t linpos = linesArray->At(0);
+                Int_t linpos = linesArray.At(0);
                 if (GetPositionForLine(linpos, &vertexReferenceInGrid))
                 {
                     cout << "-E-R3BFieldMap Line out of bound " << endl;
                 }
                 else
                 {
-                    Double_t t = (localPoint.X() - vertexReferenceInGrid.X()) / (gridStep);
-                    Double_t u = (localPoint.Y() - vertexReferenceInGrid.Y()) / (gridStep);
-                    Double_t v = (localPoint.Z() - vertexReferenceInGrid.Z()) / (gridStep);
-
-                    Bfield[0] = (1 - t) * (1 - u) * (1 - v) * Bxfield[linesArray->At(0)] +
-                                t * (1 - u) * (1 - v) * Bxfield[linesArray->At(1)] +
-                                t * u * (1 - v) * Bxfield[linesArray->At(2)] + t * u * v * Bxfield[linesArray->At(3)] +
-                                (1 - t) * u * (1 - v) * Bxfield[linesArray->At(4)] +
-                                (1 - t) * u * v * Bxfield[linesArray->At(5)] +
-                                (1 - t) * (1 - u) * v * Bxfield[linesArray->At(6)] +
-                                t * (1 - u) * v * Bxfield[linesArray->At(7)];
-
-                    Bfield[1] = (1 - t) * (1 - u) * (1 - v) * Byfield[linesArray->At(0)] +
-                                t * (1 - u) * (1 - v) * Byfield[linesArray->At(1)] +
-                                t * u * (1 - v) * Byfield[linesArray->At(2)] + t * u * v * Byfield[linesArray->At(3)] +
-                                (1 - t) * u * (1 - v) * Byfield[linesArray->At(4)] +
-                                (1 - t) * u * v * Byfield[linesArray->At(5)] +
-                                (1 - t) * (1 - u) * v * Byfield[linesArray->At(6)] +
-                                t * (1 - u) * v * Byfield[linesArray->At(7)];
-
-                    Bfield[2] = (1 - t) * (1 - u) * (1 - v) * Bzfield[linesArray->At(0)] +
-                                t * (1 - u) * (1 - v) * Bzfield[linesArray->At(1)] +
-                                t * u * (1 - v) * Bzfield[linesArray->At(2)] + t * u * v * Bzfield[linesArray->At(3)] +
-                                (1 - t) * u * (1 - v) * Bzfield[linesArray->At(4)] +
-                                (1 - t) * u * v * Bzfield[linesArray->At(5)] +
-                                (1 - t) * (1 - u) * v * Bzfield[linesArray->At(6)] +
-                                t * (1 - u) * v * Bzfield[linesArray->At(7)];
+                    cell.fId = fCellCacheId;
+                    cell.fNode = linpos;
+                    cell.fOrigin[0] = vertexReferenceInGrid.X();
+                    cell.fOrigin[1] = vertexReferenceInGrid.Y();
+                    cell.fOrigin[2] = vertexReferenceInGrid.Z();
+                    t = (localPoint.X() - cell.fOrigin[0]) / gridStep;
+                    u = (localPoint.Y() - cell.fOrigin[1]) / gridStep;
+                    v = (localPoint.Z() - cell.fOrigin[2]) / gridStep;
+                    inCell = kTRUE;
                 }
 
             } //! returnValue
@@ -288,9 +283,9 @@ void R3BFieldMap::GetFieldValue(const Double_t point[3], Double_t* bField)
                 cout << "-I- R3BFieldMap Point "
                      << " is just in one grid point!" << endl;
 
-                Bfield[0] = Bxfield[linesArray->At(0)];
-                Bfield[1] = Byfield[linesArray->At(0)];
-                Bfield[2] = Bzfield[linesArray->At(0)];
+                Bfield[0] = Bxfield[linesArray.At(0)];
+                Bfield[1] = Byfield[linesArray.At(0)];
+                Bfield[2] = Bzfield[linesArray.At(0)];
             } // returnValue ==1
 
             else
@@ -305,7 +300,7 @@ void R3BFieldMap::GetFieldValue(const Double_t point[3], Double_t* bField)
             } // whatever other cases
         }     //! outside of field area
 
-        else
+        else if (!inCell)
         {
             // cout << "-E- in R3BFieldMap::GetFieldValue(): Point "
             //       << " is outside the map field!" << endl;
@@ -314,16 +309,26 @@ void R3BFieldMap::GetFieldValue(const Double_t point[3], Double_t* bField)
             Bfield[1] = 0;
             Bfield[2] = 0;
         }
-        // Reset heap memory
 
-        if (linesArray)
+        if (inCell)
         {
-            delete linesArray;
-            linesArray = NULL;
+            // Corners in the order of GetLinesArrayForPosition
+            const Int_t l0 = cell.fNode;
+            const Int_t l1 = l0 + stepsInY * stepsInZ;
+            const Int_t l2 = l1 + stepsInZ;
+            const Int_t l4 = l0 + stepsInZ;
+            const Int_t lines[8] = { l0, l1, l2, l2 + 1, l4, l4 + 1, l0 + 1, l1 + 1 };
+            const Double_t* field[3] = { Bxfield, Byfield, Bzfield };
+
+            for (Int_t i = 0; i < 3; i++)
+            {
+                const Double_t* B = field[i];
+                Bfield[i] = (1 - t) * (1 - u) * (1 - v) * B[lines[0]] + t * (1 - u) * (1 - v) * B[lines[1]] +
+                            t * u * (1 - v) * B[lines[2]] + t * u * v * B[lines[3]] +
+                            (1 - t) * u * (1 - v) * B[lines[4]] + (1 - t) * u * v * B[lines[5]] +
+                            (1 - t) * (1 - u) * v * B[lines[6]] + t * (1 - u) * v * B[lines[7]];
+            }
         }
-
-        // linesArray
-        // localPoint;
     }
     else if (typeField == 2)
     {
@@ -339,8 +344,95 @@ void R3BFieldMap::GetFieldValue(const Double_t point[3], Double_t* bField)
     bField[2] = Bfield[2] * fScale;
 }
 
+// ------------------------------------------------------------------------
+//    Batch version of GetFieldValue: the grid cells of a block of points
+//    are located first, then the components are interpolated together
+// ------------------------------------------------------------------------
+void R3BFieldMap::GetFieldValues(Int_t n, const Double_t* points, Double_t* bFields)
+{
+    using R3BFieldBatch::kBlockSize;
+
+    if (typeField == 2)
+    {
+        for (Int_t i = 0; i < n; i++)
+        {
+            bFields[3 * i] = 0.;
+            bFields[3 * i + 1] = -1. * 10. * fScale; // kGauss
+            bFields[3 * i + 2] = 0.;
+        }
+        return;
+    }
+    if (!(typeField == 0 || typeField == 1 || typeField == 3))
+    {
+        for (Int_t i = 0; i < 3 * n; i++)
+        {
+            bFields[i] = 0.;
+        }
+        return;
+    }
+
+    const Int_t sz = 1;
+    const Int_t sy = stepsInZ;
+    const Int_t sx = stepsInY * stepsInZ;
+    const Double_t xMax = initialX + ((stepsInX - 1) * gridStep);
+    const Double_t yMax = initialY + ((stepsInY - 1) * gridStep);
+    const Double_t zMax = initialZ + ((stepsInZ - 1) * gridStep);
+
+    Int_t node[kBlockSize];
+    Double_t t[kBlockSize];
+    Double_t u[kBlockSize];
+    Double_t v[kBlockSize];
+    Double_t inside[kBlockSize];
+    Double_t b[kBlockSize];
+
+    for (Int_t first = 0; first < n; first += kBlockSize)
+    {
+        const Int_t m = TMath::Min(kBlockSize, n - first);
+        const Double_t* p = points + 3 * first;
+        Double_t* out = bFields + 3 * first;
+
+        for (Int_t i = 0; i < m; i++)
+        {
+            TVector3 localPoint(p[3 * i], p[3 * i + 1], p[3 * i + 2]);
+            localPoint = localPoint + (*gTrans);
+            localPoint.Transform(*gRot);
+
+            node[i] = 0;
+            t[i] = u[i] = v[i] = 0.;
+            inside[i] = 0.;
+            if (localPoint.X() >= initialX && localPoint.Y() >= initialY && localPoint.Z() >= initialZ &&
+                localPoint.X() <= xMax && localPoint.Y() <= yMax && localPoint.Z() <= zMax)
+            {
+                // Points on the upper border use the last cell with a relative distance of 1
+                const Double_t fx = (localPoint.X() - initialX) / gridStep;
+                const Double_t fy = (localPoint.Y() - initialY) / gridStep;
+                const Double_t fz = (localPoint.Z() - initialZ) / gridStep;
+                const Int_t ix = TMath::Min((Int_t)fx, stepsInX - 2);
+                const Int_t iy = TMath::Min((Int_t)fy, stepsInY - 2);
+                const Int_t iz = TMath::Min((Int_t)fz, stepsInZ - 2);
+                node[i] = ix * sx + iy * sy + iz;
+                t[i] = fx - ix;
+                u[i] = fy - iy;
+                v[i] = fz - iz;
+                inside[i] = fScale;
+            }
+        }
+
+        const Double_t* fields[3] = { Bxfield, Byfield, Bzfield };
+        for (Int_t comp = 0; comp < 3; comp++)
+        {
+            R3BFieldBatch::Trilinear(m, fields[comp], node, sx, sy, sz, t, u, v, b);
+            for (Int_t i = 0; i < m; i++)
+            {
+                out[3 * i + comp] = inside[i] * b[i];
+            }
+        }
+    }
+}
+
 // ------------   Constructor from R3BFieldPar   --------------------------
 R3BFieldMap::R3BFieldMap(R3BFieldPar* fieldPar)
+    : fCellCacheId(R3BFieldCellCache::NewId())
 {
 
     /*
@@ -67,6 +67,8 @@ class R3BFieldMap : public FairField
     virtual void Print(Option_t* option = "") const;
     /** Main GetField function */
     virtual void GetFieldValue(const Double_t point[3], Double_t* bField);
+    /** Get the field at n points, given and returned as consecutive (x,y,z) triples */
+    virtual void GetFieldValues(Int_t n, const Double_t* points, Double_t* bFields);
 
     void SetVerbose(Bool_t verbosity) { fVerbose = verbosity; }
 
@@ -111,6 +113,8 @@ class R3BFieldMap : public FairField
     TRotation* gRot;  //!
     TVector3* gTrans; //!
 
+    ULong64_t fCellCacheId; //! id of the grid for the per-thread cell cache
+
     Bool_t fVerbose;
 
     ClassDef(R3BFieldMap, 1)
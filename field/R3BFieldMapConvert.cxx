@@ -0,0 +1,77 @@
+/******************************************************************************
+ *   Copyright (C) 2019 GSI Helmholtzzentrum für Schwerionenforschung GmbH    *
+ *   Copyright (C) 2019 Members of R3B Collaboration                          *
+ *                                                                            *
+ *             This software is distributed under the terms of the            *
+ *                 GNU General Public Licence (GPL) version 3,                *
+ *                    copied verbatim in the file "LICENSE".                  *
+ *                                                                            *
+ * In applying this license GSI does not waive the privileges and immunities  *
+ * granted to it by virtue of its status as an Intergovernmental Organization *
+ * or submit itself to any jurisdiction.                                      *
+ ******************************************************************************/
+
+// Converts an ASCII GLAD field map into the binary format of R3BFieldMapFile,
+// which R3BGladFieldMap maps into memory instead of parsing the text file:
+//
+//   r3bfieldmapconvert <input.dat> [output.bin]
+//
+// Without an output name, the extension of the input is replaced by ".bin".
+// Maps in $VMCWORKDIR/field/magField/R3B/ with a ".bin" next to the ".dat"
+// are picked up automatically by R3BGladFieldMap(R3BFieldPar*). The ".bin"
+// records size and modification time of the ".dat"; if the ".dat" changes,
+// the ASCII map is used again until the map is converted anew.
+
+#include "R3BFieldMapFile.h"
+#include "R3BGladFieldMap.h"
+
+#include "TString.h"
+
+#include <iostream>
+
+int main(int argc, char** argv)
+{
+    if (argc < 2 || argc > 3)
+    {
+        std::cerr << "Usage: " << argv[0] << " <input.dat> [output.bin]" << std::endl;
+        return 1;
+    }
+
+    const TString input = argv[1];
+    TString output;
+    if (argc == 3)
+    {
+        output = argv[2];
+    }
+    else
+    {
+        output = input;
+        if (output.EndsWith(".dat"))
+        {
+            output.Remove(output.Length() - 4);
+        }
+        output += ".bin";
+    }
+
+    if (!input.EndsWith(".dat"))
+    {
+        std::cerr << "Input " << input << " is not an ASCII field map (.dat)" << std::endl;
+        return 1;
+    }
+
+    R3BGladFieldMap map;
+    map.SetFileName(input);
+    map.Init();
+    map.WriteBinaryFile(output);
+
+    R3BFieldMapFile check;
+    if (!check.Open(output))
+    {
+        std::cerr << "Could not read back " << output << std::endl;
+        return 1;
+    }
+    const R3BFieldMapFile::Header& header = check.GetHeader();
+    std::cout << "Wrote " << output << ": " << header.n[0] << " x " << header.n[1] << " x " << header.n[2]
+              << " nodes, " << header.nComponents << " components" << std::endl;
+    return 0;
+}
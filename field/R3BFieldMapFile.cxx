@@ -0,0 +1,198 @@
+/******************************************************************************
+ *   Copyright (C) 2019 GSI Helmholtzzentrum für Schwerionenforschung GmbH    *
+ *   Copyright (C) 2019 Members of R3B Collaboration                          *
+ *                                                                            *
+ *             This software is distributed under the terms of the            *
+ *                 GNU General Public Licence (GPL) version 3,                *
+ *                    copied verbatim in the file "LICENSE".                  *
+ *                                                                            *
+ * In applying this license GSI does not waive the privileges and immunities  *
+ * granted to it by virtue of its status as an Intergovernmental Organization *
+ * or submit itself to any jurisdiction.                                      *
+ ******************************************************************************/
+
+#include "R3BFieldMapFile.h"
+
+#include "FairLogger.h"
+
+#include <cstring>
+#include <fcntl.h>
+#include <fstream>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+
+namespace
+{
+    const char kMagic[8] = "R3BFMAP";
+
+    // Field values start on a cache line boundary
+    const UInt_t kDataAlignment = 64;
+} // namespace
+
+R3BFieldMapFile::R3BFieldMapFile()
+    : fMapping(nullptr)
+    , fSize(0)
+    , fHeader(nullptr)
+    , fData(nullptr)
+{
+}
+
+R3BFieldMapFile::~R3BFieldMapFile() { Close(); }
+
+Bool_t R3BFieldMapFile::Open(const char* fileName)
+{
+    Close();
+
+    const int fd = open(fileName, O_RDONLY);
+    if (fd < 0)
+    {
+        LOG(ERROR) << "R3BFieldMapFile: Could not open " << fileName;
+        return kFALSE;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size < (off_t)sizeof(Header))
+    {
+        LOG(ERROR) << "R3BFieldMapFile: " << fileName << " is too short for a field map";
+        close(fd);
+        return kFALSE;
+    }
+
+    void* mapping = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (mapping == MAP_FAILED)
+    {
+        LOG(ERROR) << "R3BFieldMapFile: Could not map " << fileName << " into memory";
+        return kFALSE;
+    }
+
+    fMapping = mapping;
+    fSize = st.st_size;
+    fHeader = (const Header*)fMapping;
+
+    if (std::memcmp(fHeader->magic, kMagic, sizeof(kMagic)) != 0)
+    {
+        LOG(ERROR) << "R3BFieldMapFile: " << fileName << " is not a binary field map";
+        Close();
+        return kFALSE;
+    }
+    if (fHeader->version == 1)
+    {
+        // Files before the source stamp was added: its place holds the zero padding, but do not rely on it
+        std::memcpy(&fHeaderCopy, fHeader, sizeof(Header));
+        fHeaderCopy.srcSize = 0;
+        fHeaderCopy.srcTime = 0;
+        fHeader = &fHeaderCopy;
+    }
+    else if (fHeader->version != kVersion)
+    {
+        LOG(ERROR) << "R3BFieldMapFile: " << fileName << " has unsupported version " << fHeader->version
+                   << " (expected " << kVersion << ")";
+        Close();
+        return kFALSE;
+    }
+    if (fHeader->n[0] < 2 || fHeader->n[1] < 2 || fHeader->n[2] < 2 || fHeader->nComponents < 1 ||
+        fHeader->headerSize < sizeof(Header) ||
+        fHeader->headerSize + GetNValues() * sizeof(Float_t) > fSize)
+    {
+        LOG(ERROR) << "R3BFieldMapFile: " << fileName << " has an inconsistent header or is truncated";
+        Close();
+        return kFALSE;
+    }
+
+    fData = (const Float_t*)((const char*)fMapping + fHeader->headerSize);
+    return kTRUE;
+}
+
+void R3BFieldMapFile::Close()
+{
+    if (fMapping != nullptr)
+    {
+        munmap(fMapping, fSize);
+    }
+    fMapping = nullptr;
+    fSize = 0;
+    fHeader = nullptr;
+    fData = nullptr;
+}
+
+Long64_t R3BFieldMapFile::GetNValues() const
+{
+    if (fHeader == nullptr)
+    {
+        return 0;
+    }
+    return (Long64_t)fHeader->n[0] * fHeader->n[1] * fHeader->n[2] * fHeader->nComponents;
+}
+
+R3BFieldMapFile::Header R3BFieldMapFile::MakeHeader(Int_t type,
+                                                    Int_t nComponents,
+                                                    const Int_t n[3],
+                                                    const Double_t min[3],
+                                                    const Double_t max[3])
+{
+    Header header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, kMagic, sizeof(kMagic));
+    header.version = kVersion;
+    header.headerSize = ((sizeof(Header) + kDataAlignment - 1) / kDataAlignment) * kDataAlignment;
+    header.type = type;
+    header.nComponents = nComponents;
+    for (Int_t i = 0; i < 3; i++)
+    {
+        header.n[i] = n[i];
+        header.min[i] = min[i];
+        header.max[i] = max[i];
+    }
+    return header;
+}
+
+Bool_t R3BFieldMapFile::Write(const char* fileName, const Header& header, const Float_t* data)
+{
+    std::ofstream out(fileName, std::ios::binary | std::ios::trunc);
+    if (!out.is_open())
+    {
+        LOG(ERROR) << "R3BFieldMapFile: Could not open " << fileName << " for writing";
+        return kFALSE;
+    }
+
+    out.write((const char*)&header, sizeof(Header));
+    const std::vector<char> padding(header.headerSize - sizeof(Header), 0);
+    out.write(padding.data(), padding.size());
+
+    const Long64_t nValues = (Long64_t)header.n[0] * header.n[1] * header.n[2] * header.nComponents;
+    out.write((const char*)data, nValues * sizeof(Float_t));
+    out.close();
+
+    if (!out)
+    {
+        LOG(ERROR) << "R3BFieldMapFile: Error writing " << fileName;
+        return kFALSE;
+    }
+    return kTRUE;
+}
+
+Bool_t R3BFieldMapFile::IsBinaryFile(const char* fileName)
+{
+    std::ifstream in(fileName, std::ios::binary);
+    char magic[sizeof(kMagic)];
+    if (!in.read(magic, sizeof(magic)))
+    {
+        return kFALSE;
+    }
+    return std::memcmp(magic, kMagic, sizeof(kMagic)) == 0;
+}
+
+Bool_t R3BFieldMapFile::GetSourceStamp(const char* fileName, Long64_t& size, Long64_t& time)
+{
+    struct stat st;
+    if (stat(fileName, &st) != 0)
+    {
+        return kFALSE;
+    }
+    size = st.st_size;
+    time = st.st_mtime;
+    return kTRUE;
+}
@@ -0,0 +1,95 @@
+/******************************************************************************
+ *   Copyright (C) 2019 GSI Helmholtzzentrum für Schwerionenforschung GmbH    *
+ *   Copyright (C) 2019 Members of R3B Collaboration                          *
+ *                                                                            *
+ *             This software is distributed under the terms of the            *
+ *                 GNU General Public Licence (GPL) version 3,                *
+ *                    copied verbatim in the file "LICENSE".                  *
+ *                                                                            *
+ * In applying this license GSI does not waive the privileges and immunities  *
+ * granted to it by virtue of its status as an Intergovernmental Organization *
+ * or submit itself to any jurisdiction.                                      *
+ ******************************************************************************/
+
+#ifndef R3BFIELDMAPFILE_H
+#define R3BFIELDMAPFILE_H 1
+
+#include "Rtypes.h"
+#include <cstddef>
+
+// Binary field map file, read through a read-only shared memory mapping.
+// All jobs on a node that use the same map file share its pages.
+//
+// Layout (native byte order, version 2):
+//   Header       : magic "R3BFMAP", version, header size, map type,
+//                  number of components, the grid specification and
+//                  optionally size and modification time of the source
+//                  (not present in version 1, read as unknown)
+//   Field values : Float_t, interleaved components per grid node,
+//                  node index ix * ny * nz + iy * nz + iz,
+//                  starting at byte offset headerSize
+
+class R3BFieldMapFile
+{
+  public:
+    static const UInt_t kVersion = 2;
+
+    struct Header
+    {
+        char magic[8];      // "R3BFMAP"
+        UInt_t version;     // format version
+        UInt_t headerSize;  // offset of the field values in bytes
+        Int_t type;         // map symmetry type (1 = nosym, 2 = sym2, 3 = sym3)
+        Int_t nComponents;  // field values per grid node
+        Int_t n[3];         // number of grid nodes in x, y, z
+        Int_t reserved;     // zero
+        Double_t min[3];    // position of the first grid node in x, y, z [cm]
+        Double_t max[3];    // position of the last grid node in x, y, z [cm]
+        Long64_t srcSize;   // size of the file the map was converted from [bytes], 0 if unknown
+        Long64_t srcTime;   // modification time of that file [s since the epoch], 0 if unknown
+    };
+
+    R3BFieldMapFile();
+    ~R3BFieldMapFile();
+
+    /** Map a binary field map file into memory. Returns kFALSE on errors. **/
+    Bool_t Open(const char* fileName);
+
+    /** Release the mapping **/
+    void Close();
+
+    Bool_t IsOpen() const { return fData != nullptr; }
+    const Header& GetHeader() const { return *fHeader; }
+    const Float_t* GetData() const { return fData; }
+    Long64_t GetNValues() const;
+
+    /** Fill the header for a grid with n[i] nodes from min[i] to max[i] **/
+    static Header MakeHeader(Int_t type,
+                             Int_t nComponents,
+                             const Int_t n[3],
+                             const Double_t min[3],
+                             const Double_t max[3]);
+
+    /** Write a map, data holds header.nComponents values per grid node. Returns kFALSE on errors. **/
+    static Bool_t Write(const char* fileName, const Header& header, const Float_t* data);
+
+    /** Check whether a file starts with the binary map magic **/
+    static Bool_t IsBinaryFile(const char* fileName);
+
+    /** Size and modification time of the file a map is converted from, as stored in the header.
+     ** Returns kFALSE if the file does not exist.
+     **/
+    static Bool_t GetSourceStamp(const char* fileName, Long64_t& size, Long64_t& time);
+
+  private:
+    R3BFieldMapFile(const R3BFieldMapFile&);
+    const R3BFieldMapFile& operator=(const R3BFieldMapFile&);
+
+    void* fMapping;
+    size_t fSize;
+    Header fHeaderCopy; // header of a version 1 file, without the source stamp
+    const Header* fHeader;
+    const Float_t* fData;
+};
+
+#endif // R3BFIELDMAPFILE_H
@@ -0,0 +1,117 @@
+/******************************************************************************
+ *   Copyright (C) 2019 GSI Helmholtzzentrum für Schwerionenforschung GmbH    *
+ *   Copyright (C) 2019 Members of R3B Collaboration                          *
+ *                                                                            *
+ *             This software is distributed under the terms of the            *
+ *                 GNU General Public Licence (GPL) version 3,                *
+ *                    copied verbatim in the file "LICENSE".                  *
+ *                                                                            *
+ * In applying this license GSI does not waive the privileges and immunities  *
+ * granted to it by virtue of its status as an Intergovernmental Organization *
+ * or submit itself to any jurisdiction.                                      *
+ ******************************************************************************/
+
+#include "R3BFieldPackedGrid.h"
+
+#include <algorithm>
+#include <cmath>
+
+R3BFieldPackedGrid::R3BFieldPackedGrid()
+    : fEncoding(kHalf)
+    , fNNodes(0)
+{
+}
+
+void R3BFieldPackedGrid::Pack(EEncoding encoding, Int_t nNodes, const Float_t* data)
+{
+    fEncoding = encoding;
+    fNNodes = nNodes;
+    std::vector<UShort_t>().swap(fHalf);
+    std::vector<Short_t>().swap(fShort);
+    std::vector<Float_t>().swap(fScales);
+
+    if (encoding == kHalf)
+    {
+        fHalf.resize(3 * nNodes);
+        for (Int_t i = 0; i < 3 * nNodes; i++)
+        {
+            fHalf[i] = FloatToHalf(data[i]);
+        }
+        return;
+    }
+
+    const Int_t nBlocks = (nNodes + kBlockNodes - 1) / kBlockNodes;
+    fShort.resize(3 * nNodes);
+    fScales.resize(3 * nBlocks);
+    for (Int_t block = 0; block < nBlocks; block++)
+    {
+        const Int_t first = block * kBlockNodes;
+        const Int_t last = std::min(first + kBlockNodes, nNodes);
+        for (Int_t comp = 0; comp < 3; comp++)
+        {
+            Float_t maxAbs = 0.;
+            for (Int_t node = first; node < last; node++)
+            {
+                maxAbs = std::max(maxAbs, std::fabs(data[3 * node + comp]));
+            }
+            const Float_t scale = maxAbs > 0. ? maxAbs / 32767.f : 1.f;
+            fScales[3 * block + comp] = scale;
+            for (Int_t node = first; node < last; node++)
+            {
+                fShort[3 * node + comp] = (Short_t)std::lround(data[3 * node + comp] / scale);
+            }
+        }
+    }
+}
+
+size_t R3BFieldPackedGrid::GetMemorySize() const
+{
+    return fHalf.size() * sizeof(UShort_t) + fShort.size() * sizeof(Short_t) + fScales.size() * sizeof(Float_t);
+}
+
+UShort_t R3BFieldPackedGrid::FloatToHalf(Float_t value)
+{
+    UInt_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    const UShort_t sign = (bits >> 16) & 0x8000;
+    const Int_t exponent = (Int_t)((bits >> 23) & 0xff) - 127 + 15;
+    UInt_t mantissa = bits & 0x7fffff;
+
+    if (((bits >> 23) & 0xff) == 0xff)
+    {
+        // Inf or NaN
+        return sign | 0x7c00 | (mantissa ? 0x200 : 0);
+    }
+    if (exponent >= 0x1f)
+    {
+        // Too large: infinity
+        return sign | 0x7c00;
+    }
+    if (exponent <= 0)
+    {
+        // Subnormal or zero
+        if (exponent < -10)
+        {
+            return sign;
+        }
+        mantissa |= 0x800000;
+        const Int_t shift = 14 - exponent;
+        UInt_t half = mantissa >> shift;
+        const UInt_t rest = mantissa & ((1u << shift) - 1);
+        const UInt_t halfway = 1u << (shift - 1);
+        if (rest > halfway || (rest == halfway && (half & 1)))
+        {
+            half++;
+        }
+        return sign | half;
+    }
+
+    // Normal number, round to nearest even
+    UInt_t half = ((UInt_t)exponent << 10) | (mantissa >> 13);
+    const UInt_t rest = mantissa & 0x1fff;
+    if (rest > 0x1000 || (rest == 0x1000 && (half & 1)))
+    {
+        half++; // may carry into the exponent, which is the correct rounding
+    }
+    return sign | half;
+}
@@ -0,0 +1,104 @@
+/******************************************************************************
+ *   Copyright (C) 2019 GSI Helmholtzzentrum für Schwerionenforschung GmbH    *
+ *   Copyright (C) 2019 Members of R3B Collaboration                          *
+ *                                                                            *
+ *             This software is distributed under the terms of the            *
+ *                 GNU General Public Licence (GPL) version 3,                *
+ *                    copied verbatim in the file "LICENSE".                  *
+ *                                                                            *
+ * In applying this license GSI does not waive the privileges and immunities  *
+ * granted to it by virtue of its status as an Intergovernmental Organization *
+ * or submit itself to any jurisdiction.                                      *
+ ******************************************************************************/
+
+#ifndef R3BFIELDPACKEDGRID_H
+#define R3BFIELDPACKEDGRID_H 1
+
+#include "Rtypes.h"
+#include <cstring>
+#include <vector>
+
+// Reduced precision storage of a three component field grid.
+// Values are kept in 16 bit, either as IEEE half precision floats or as
+// integers with one scale factor per component and block of consecutive
+// grid nodes. Decoding happens on access, i.e. in the interpolation.
+
+class R3BFieldPackedGrid
+{
+  public:
+    enum EEncoding
+    {
+        kHalf,       // IEEE 754 binary16
+        kScaledShort // Short_t times a per block scale
+    };
+
+    /** Number of consecutive grid nodes sharing a scale factor **/
+    static const Int_t kBlockNodes = 64;
+
+    R3BFieldPackedGrid();
+
+    /** Pack nNodes nodes of (Bx, By, Bz) **/
+    void Pack(EEncoding encoding, Int_t nNodes, const Float_t* data);
+
+    /** Decode the field components of a grid node **/
+    inline void Get(Int_t node, Float_t b[3]) const
+    {
+        const Int_t i = 3 * node;
+        if (fEncoding == kHalf)
+        {
+            b[0] = HalfToFloat(fHalf[i]);
+            b[1] = HalfToFloat(fHalf[i + 1]);
+            b[2] = HalfToFloat(fHalf[i + 2]);
+        }
+        else
+        {
+            const Float_t* scale = &fScales[3 * (node / kBlockNodes)];
+            b[0] = fShort[i] * scale[0];
+            b[1] = fShort[i + 1] * scale[1];
+            b[2] = fShort[i + 2] * scale[2];
+        }
+    }
+
+    EEncoding GetEncoding() const { return fEncoding; }
+    Int_t GetNNodes() const { return fNNodes; }
+
+    /** Memory used by the packed values and scales in bytes **/
+    size_t GetMemorySize() const;
+
+    static UShort_t FloatToHalf(Float_t value);
+
+    static inline Float_t HalfToFloat(UShort_t h)
+    {
+        const UInt_t sign = (UInt_t)(h & 0x8000) << 16;
+        const UInt_t exponent = (h >> 10) & 0x1f;
+        const UInt_t mantissa = h & 0x3ff;
+        UInt_t bits;
+        if (exponent == 0)
+        {
+            // Zero or subnormal: mantissa * 2^-24
+            Float_t value = mantissa * (1.f / 16777216.f);
+            std::memcpy(&bits, &value, sizeof(bits));
+            bits |= sign;
+        }
+        else if (exponent == 0x1f)
+        {
+            bits = sign | 0x7f800000 | (mantissa << 13);
+        }
+        else
+        {
+            bits = sign | ((exponent + 112) << 23) | (mantissa << 13);
+        }
+        Float_t result;
+        std::memcpy(&result, &bits, sizeof(result));
+        return result;
+    }
+
+  private:
+    EEncoding fEncoding;
+    Int_t fNNodes;
+    std::vector<UShort_t> fHalf;
+    std::vector<Short_t> fShort;
+    std::vector<Float_t> fScales;
+};
+
+#endif // R3BFIELDPACKEDGRID_H
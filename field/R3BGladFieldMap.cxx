@@ -17,11 +17,15 @@
 #include <iostream>
 
 // Includes from ROOT
-#include "TArrayF.h"
 #include "TFile.h"
 #include "TMath.h"
 
 #include "R3BGladFieldMap.h"
+#include "R3BFieldBatch.h"
+#include "R3BFieldCellCache.h"
+#include "R3BFieldMapFile.h"
+#include "R3BFieldPackedGrid.h"
+#include "TSystem.h"
 
 using std::cerr;
 using std::cout;
@@ -34,6 +38,38 @@ using std::setw;
 using std::showpoint;
 using TMath::Nint;
 
+// Last grid cell used by GetFieldValue on this thread
+static thread_local R3BFieldCellCache gGladCell;
+
+namespace
+{
+    // Whether a binary map has been converted from the ASCII map as it is now. Without the ASCII
+    // map, the binary map is all there is.
+    Bool_t IsBinaryMapCurrent(const TString& binName, const TString& datName)
+    {
+        Long64_t srcSize = 0, srcTime = 0;
+        if (!R3BFieldMapFile::GetSourceStamp(datName, srcSize, srcTime))
+        {
+            return kTRUE;
+        }
+
+        R3BFieldMapFile file;
+        if (!file.Open(binName))
+        {
+            LOG(WARNING) << "R3BGladFieldMap: Using " << datName << " instead of the unreadable " << binName;
+            return kFALSE;
+        }
+        const R3BFieldMapFile::Header& header = file.GetHeader();
+        if (header.srcSize != srcSize || header.srcTime != srcTime)
+        {
+            LOG(WARNING) << "R3BGladFieldMap: " << binName << " was not converted from the current " << datName
+                         << ", using the ASCII map. Run r3bfieldmapconvert to update it.";
+            return kFALSE;
+        }
+        return kTRUE;
+    }
+} // namespace
+
 // -------------   Default constructor  ----------------------------------
 R3BGladFieldMap::R3BGladFieldMap()
 {
@@ -43,7 +79,16 @@ R3BGladFieldMap::R3BGladFieldMap()
     fXstep = fYstep = fZstep = 0.;
     fNx = fNy = fNz = 0;
     fScale = 1.;
-    fBx = fBy = fBz = NULL;
+    fCosY = 1.;
+    fSinY = 0.;
+    fData = NULL;
+    fMapFile = NULL;
+    fPacked = NULL;
+    fStorage = kFloat32;
+    fMirrorX = fMirrorY = kFALSE;
+    fSymmetryTolerance = 1.e-3;
+    fInvXstep = fInvYstep = fInvZstep = 0.;
+    fCellCacheId = R3BFieldCellCache::NewId();
     fPosX = fPosY = fPosZ = 0.;
     fName = "";
     fFileName = "";
@@ -61,12 +106,23 @@ R3BGladFieldMap::R3BGladFieldMap(const char* mapName, const char* fileType)
     fXstep = fYstep = fZstep = 0.;
     fNx = fNy = fNz = 0;
     fScale = 1.;
-    fBx = fBy = fBz = NULL;
+    fCosY = 1.;
+    fSinY = 0.;
+    fData = NULL;
+    fMapFile = NULL;
+    fPacked = NULL;
+    fStorage = kFloat32;
+    fMirrorX = fMirrorY = kFALSE;
+    fSymmetryTolerance = 1.e-3;
+    fInvXstep = fInvYstep = fInvZstep = 0.;
+    fCellCacheId = R3BFieldCellCache::NewId();
     fName = mapName;
     TString dir = getenv("VMCWORKDIR");
     fFileName = dir + "/field/magField/R3B/" + mapName;
     if (fileType[0] == 'R')
         fFileName += ".root";
+    else if (fileType[0] == 'B')
+        fFileName += ".bin";
     else
         fFileName += ".dat";
     fType = 1;
@@ -83,7 +139,16 @@ R3BGladFieldMap::R3BGladFieldMap(R3BFieldPar* fieldPar)
     fXstep = fYstep = fZstep = 0.;
     fNx = fNy = fNz = 0;
     fScale = 1.;
-    fBx = fBy = fBz = NULL;
+    fCosY = 1.;
+    fSinY = 0.;
+    fData = NULL;
+    fMapFile = NULL;
+    fPacked = NULL;
+    fStorage = kFloat32;
+    fMirrorX = fMirrorY = kFALSE;
+    fSymmetryTolerance = 1.e-3;
+    fInvXstep = fInvYstep = fInvZstep = 0.;
+    fCellCacheId = R3BFieldCellCache::NewId();
     if (!fieldPar)
     {
         cerr << "-W- R3BGladFieldConst::R3BGladFieldMap: empty parameter container!" << endl;
@@ -100,7 +165,11 @@ R3BGladFieldMap::R3BGladFieldMap(R3BFieldPar* fieldPar)
         fScale = fieldPar->GetScale();
         TString dir = getenv("VMCWORKDIR");
         fFileName = dir + "/field/magField/R3B/" + fName;
-        fFileName += ".dat";
+        // Prefer the binary version of the map if it has been created from the current ASCII map
+        if (!gSystem->AccessPathName(fFileName + ".bin") && IsBinaryMapCurrent(fFileName + ".bin", fFileName + ".dat"))
+            fFileName += ".bin";
+        else
+            fFileName += ".dat";
         // fType = fieldPar->GetType();
     }
 }
@@ -108,12 +177,10 @@ R3BGladFieldMap::R3BGladFieldMap(R3BFieldPar* fieldPar)
 // ------------   Destructor   --------------------------------------------
 R3BGladFieldMap::~R3BGladFieldMap()
 {
-    if (fBx)
-        delete fBx;
-    if (fBy)
-        delete fBy;
-    if (fBz)
-        delete fBz;
+    if (fMapFile)
+        delete fMapFile;
+    if (fPacked)
+        delete fPacked;
 }
 // ------------------------------------------------------------------------
 
@@ -125,138 +192,308 @@ void R3BGladFieldMap::Init()
     fPosZ = 163.4;
     fYAngle = -14.;
     gTrans = new TVector3(-fPosX, -fPosY, -fPosZ);
+    fCosY = TMath::Cos(-fYAngle * TMath::DegToRad());
+    fSinY = TMath::Sin(-fYAngle * TMath::DegToRad());
     //  if      (fFileName.EndsWith(".root")) ReadRootFile(fFileName, fName);
     if (fFileName.EndsWith(".dat"))
         ReadAsciiFile(fFileName);
+    else if (fFileName.EndsWith(".bin"))
+        ReadBinaryFile(fFileName);
     else
     {
         cerr << "-E- R3BGladFieldMap::Init: No proper file name defined! (" << fFileName << ")" << endl;
         LOG(fatal) << "Init: No proper file name";
     }
+    Compress();
 }
 // ------------------------------------------------------------------------
 
 // -----------   Get x component of the field   ---------------------------
 Double_t R3BGladFieldMap::GetBx(Double_t x, Double_t y, Double_t z)
 {
+    const Double_t point[3] = { x, y, z };
+    Double_t bField[3];
+    GetFieldValue(point, bField);
+    return bField[0];
+}
+// ------------------------------------------------------------------------
 
-    // cout << "-I- get Bx called " << endl;
-    // transform to local coordinates
-    // local to global
-    TVector3 localPoint(x, y, z);
-
-    localPoint = localPoint + (*gTrans);
-    localPoint.RotateY(-fYAngle * TMath::DegToRad());
+// -----------   Get y component of the field   ---------------------------
+Double_t R3BGladFieldMap::GetBy(Double_t x, Double_t y, Double_t z)
+{
+    const Double_t point[3] = { x, y, z };
+    Double_t bField[3];
+    GetFieldValue(point, bField);
+    return bField[1];
+}
+// ------------------------------------------------------------------------
 
-    Int_t ix = 0;
-    Int_t iy = 0;
-    Int_t iz = 0;
-    Double_t dx = 0.;
-    Double_t dy = 0.;
-    Double_t dz = 0.;
+// -----------   Get z component of the field   ---------------------------
+Double_t R3BGladFieldMap::GetBz(Double_t x, Double_t y, Double_t z)
+{
+    const Double_t point[3] = { x, y, z };
+    Double_t bField[3];
+    GetFieldValue(point, bField);
+    return bField[2];
+}
+// ------------------------------------------------------------------------
 
-    if (IsInside(localPoint.X(), localPoint.Y(), localPoint.Z(), ix, iy, iz, dx, dy, dz))
+// -----------   Get all field components   -------------------------------
+void R3BGladFieldMap::GetFieldValue(const Double_t point[3], Double_t* bField)
+{
+    Double_t xl, yl, zl;
+    Double_t hx = 1.;
+    Double_t hy = 1.;
+    ToLocal(point, xl, yl, zl, hx, hy);
+
+    // Consecutive calls mostly stay in the same grid cell, which is then not searched again.
+    // The conditions are combined without short-circuit, as a single branch.
+    R3BFieldCellCache& cell = gGladCell;
+    Double_t dx = (xl - cell.fOrigin[0]) * fInvXstep;
+    Double_t dy = (yl - cell.fOrigin[1]) * fInvYstep;
+    Double_t dz = (zl - cell.fOrigin[2]) * fInvZstep;
+    if ((cell.fId != fCellCacheId) | !((dx >= 0.) & (dx < 1.) & (dy >= 0.) & (dy < 1.) & (dz >= 0.) & (dz < 1.)))
     {
+        Int_t ix, iy, iz;
+        if (!FindCell(xl, yl, zl, ix, iy, iz))
+        {
+            bField[0] = bField[1] = bField[2] = 0.;
+            return;
+        }
+        cell.fId = fCellCacheId;
+        cell.fNode = ix * fNy * fNz + iy * fNz + iz;
+        cell.fOrigin[0] = fXmin + ix * fXstep;
+        cell.fOrigin[1] = fYmin + iy * fYstep;
+        cell.fOrigin[2] = fZmin + iz * fZstep;
+        dx = (xl - cell.fOrigin[0]) * fInvXstep;
+        dy = (yl - cell.fOrigin[1]) * fInvYstep;
+        dz = (zl - cell.fOrigin[2]) * fInvZstep;
+    }
 
-        // Get Bx field values at grid cell corners
-        fHa[0][0][0] = fBx->At(ix * fNy * fNz + iy * fNz + iz);
-        fHa[1][0][0] = fBx->At((ix + 1) * fNy * fNz + iy * fNz + iz);
-        fHa[0][1][0] = fBx->At(ix * fNy * fNz + (iy + 1) * fNz + iz);
-        fHa[1][1][0] = fBx->At((ix + 1) * fNy * fNz + (iy + 1) * fNz + iz);
-        fHa[0][0][1] = fBx->At(ix * fNy * fNz + iy * fNz + (iz + 1));
-        fHa[1][0][1] = fBx->At((ix + 1) * fNy * fNz + iy * fNz + (iz + 1));
-        fHa[0][1][1] = fBx->At(ix * fNy * fNz + (iy + 1) * fNz + (iz + 1));
-        fHa[1][1][1] = fBx->At((ix + 1) * fNy * fNz + (iy + 1) * fNz + (iz + 1));
-
-        // Return interpolated field value
-        Double_t val = Interpolate(dx, dy, dz);
-        // cout << " (X) interpolated " << val << endl;
-        return (val);
+    Double_t b[3];
+    if (fPacked)
+    {
+        InterpolatePacked(cell.fNode, dx, dy, dz, b);
     }
+    else
+    {
+        InterpolateFloat(3 * cell.fNode, dx, dy, dz, b);
+    }
+
+    // Parity of the field components on the mirrored half of a symmetric map
+    b[0] *= hx * hy;
+    b[2] *= hy;
 
-    return 0.;
+    // Rotate the field by fYAngle and convert T -> kG
+    const Double_t factor = fScale * 10.;
+    bField[0] = factor * (fCosY * b[0] - fSinY * b[2]);
+    bField[1] = factor * b[1];
+    bField[2] = factor * (fSinY * b[0] + fCosY * b[2]);
 }
 // ------------------------------------------------------------------------
 
-// -----------   Get y component of the field   ---------------------------
-Double_t R3BGladFieldMap::GetBy(Double_t x, Double_t y, Double_t z)
+// -----------   Trilinear interpolation of float values   ----------------
+void R3BGladFieldMap::InterpolateFloat(Int_t node, Double_t dx, Double_t dy, Double_t dz, Double_t* b) const
 {
+    // Corners of the grid cell, (Bx, By, Bz) are adjacent for each node
+    const Int_t sz = 3;
+    const Int_t sy = 3 * fNz;
+    const Int_t sx = 3 * fNy * fNz;
+    const Float_t* b000 = fData + node;
+    const Float_t* b100 = b000 + sx;
+    const Float_t* b010 = b000 + sy;
+    const Float_t* b110 = b000 + sx + sy;
+    const Float_t* b001 = b000 + sz;
+    const Float_t* b101 = b000 + sx + sz;
+    const Float_t* b011 = b000 + sy + sz;
+    const Float_t* b111 = b000 + sx + sy + sz;
+
+    for (Int_t i = 0; i < 3; i++)
+    {
+        // Interpolate in x coordinate
+        const Double_t c00 = b000[i] + (b100[i] - b000[i]) * dx;
+        const Double_t c10 = b010[i] + (b110[i] - b010[i]) * dx;
+        const Double_t c01 = b001[i] + (b101[i] - b001[i]) * dx;
+        const Double_t c11 = b011[i] + (b111[i] - b011[i]) * dx;
+
+        // Interpolate in y coordinate
+        const Double_t c0 = c00 + (c10 - c00) * dy;
+        const Double_t c1 = c01 + (c11 - c01) * dy;
+
+        // Interpolate in z coordinate
+        b[i] = c0 + (c1 - c0) * dz;
+    }
+}
+// ------------------------------------------------------------------------
 
-    // transform to local coordinates
-    // local to global
-    TVector3 localPoint(x, y, z);
+// -----------   Trilinear interpolation of packed values   ---------------
+void R3BGladFieldMap::InterpolatePacked(Int_t node, Double_t dx, Double_t dy, Double_t dz, Double_t* b) const
+{
+    // Decode the cell corners, index [x][y][z]
+    const Int_t sy = fNz;
+    const Int_t sx = fNy * fNz;
+    Float_t c[2][2][2][3];
+    fPacked->Get(node, c[0][0][0]);
+    fPacked->Get(node + sx, c[1][0][0]);
+    fPacked->Get(node + sy, c[0][1][0]);
+    fPacked->Get(node + sx + sy, c[1][1][0]);
+    fPacked->Get(node + 1, c[0][0][1]);
+    fPacked->Get(node + sx + 1, c[1][0][1]);
+    fPacked->Get(node + sy + 1, c[0][1][1]);
+    fPacked->Get(node + sx + sy + 1, c[1][1][1]);
+
+    for (Int_t i = 0; i < 3; i++)
+    {
+        const Double_t c00 = c[0][0][0][i] + (c[1][0][0][i] - c[0][0][0][i]) * dx;
+        const Double_t c10 = c[0][1][0][i] + (c[1][1][0][i] - c[0][1][0][i]) * dx;
+        const Double_t c01 = c[0][0][1][i] + (c[1][0][1][i] - c[0][0][1][i]) * dx;
+        const Double_t c11 = c[0][1][1][i] + (c[1][1][1][i] - c[0][1][1][i]) * dx;
+        const Double_t c0 = c00 + (c10 - c00) * dy;
+        const Double_t c1 = c01 + (c11 - c01) * dy;
+        b[i] = c0 + (c1 - c0) * dz;
+    }
+}
+// ------------------------------------------------------------------------
 
-    localPoint = localPoint + (*gTrans);
-    localPoint.RotateY(-fYAngle * TMath::DegToRad());
+// -----------   Get the field for many points   --------------------------
+void R3BGladFieldMap::GetFieldValues(Int_t n, const Double_t* points, Double_t* bFields)
+{
+    using R3BFieldBatch::kBlockSize;
 
-    Int_t ix = 0;
-    Int_t iy = 0;
-    Int_t iz = 0;
-    Double_t dx = 0.;
-    Double_t dy = 0.;
-    Double_t dz = 0.;
+    if (!fData)
+    {
+        // Packed maps are decoded point by point
+        for (Int_t i = 0; i < n; i++)
+        {
+            if (fPacked)
+            {
+                GetFieldValue(points + 3 * i, bFields + 3 * i);
+            }
+            else
+            {
+                bFields[3 * i] = bFields[3 * i + 1] = bFields[3 * i + 2] = 0.;
+            }
+        }
+        return;
+    }
 
-    if (IsInside(localPoint.X(), localPoint.Y(), localPoint.Z(), ix, iy, iz, dx, dy, dz))
+    const Int_t sz = 3;
+    const Int_t sy = 3 * fNz;
+    const Int_t sx = 3 * fNy * fNz;
+
+    Int_t node[kBlockSize];
+    Double_t dx[kBlockSize];
+    Double_t dy[kBlockSize];
+    Double_t dz[kBlockSize];
+    Double_t inside[kBlockSize];
+    Double_t hx[kBlockSize];
+    Double_t hy[kBlockSize];
+    Double_t b[3][kBlockSize];
+    const Double_t factor = fScale * 10.;
+
+    for (Int_t first = 0; first < n; first += kBlockSize)
     {
+        const Int_t m = TMath::Min(kBlockSize, n - first);
+        const Double_t* p = points + 3 * first;
+        Double_t* out = bFields + 3 * first;
 
-        // Get By field values at grid cell corners
-        fHa[0][0][0] = fBy->At(ix * fNy * fNz + iy * fNz + iz);
-        fHa[1][0][0] = fBy->At((ix + 1) * fNy * fNz + iy * fNz + iz);
-        fHa[0][1][0] = fBy->At(ix * fNy * fNz + (iy + 1) * fNz + iz);
-        fHa[1][1][0] = fBy->At((ix + 1) * fNy * fNz + (iy + 1) * fNz + iz);
-        fHa[0][0][1] = fBy->At(ix * fNy * fNz + iy * fNz + (iz + 1));
-        fHa[1][0][1] = fBy->At((ix + 1) * fNy * fNz + iy * fNz + (iz + 1));
-        fHa[0][1][1] = fBy->At(ix * fNy * fNz + (iy + 1) * fNz + (iz + 1));
-        fHa[1][1][1] = fBy->At((ix + 1) * fNy * fNz + (iy + 1) * fNz + (iz + 1));
+        // Points outside the map are interpolated in the first cell and masked
+        for (Int_t i = 0; i < m; i++)
+        {
+            node[i] = 0;
+            dx[i] = dy[i] = dz[i] = 0.;
+            hx[i] = hy[i] = 1.;
+            inside[i] = Locate(p + 3 * i, node[i], dx[i], dy[i], dz[i], hx[i], hy[i]) ? factor : 0.;
+        }
 
-        // Return interpolated field value
-        Double_t val = Interpolate(dx, dy, dz);
-        // cout << " (Y) interpolated " << val << endl;
-        return (val);
-    }
+        for (Int_t comp = 0; comp < 3; comp++)
+        {
+            R3BFieldBatch::Trilinear(m, fData + comp, node, sx, sy, sz, dx, dy, dz, b[comp]);
+        }
 
-    return 0.;
+        // Apply the parity on mirrored halves, rotate the field by fYAngle and convert T -> kG
+        for (Int_t i = 0; i < m; i++)
+        {
+            const Double_t bx = hx[i] * hy[i] * b[0][i];
+            const Double_t bz = hy[i] * b[2][i];
+            out[3 * i] = inside[i] * (fCosY * bx - fSinY * bz);
+            out[3 * i + 1] = inside[i] * b[1][i];
+            out[3 * i + 2] = inside[i] * (fSinY * bx + fCosY * bz);
+        }
+    }
 }
 // ------------------------------------------------------------------------
 
-// -----------   Get z component of the field   ---------------------------
-Double_t R3BGladFieldMap::GetBz(Double_t x, Double_t y, Double_t z)
+// -----------   Transform to local system   -------------------------------
+void R3BGladFieldMap::ToLocal(const Double_t point[3],
+                              Double_t& xl,
+                              Double_t& yl,
+                              Double_t& zl,
+                              Double_t& hx,
+                              Double_t& hy) const
 {
+    // Same as TVector3::RotateY(-fYAngle) after the translation
+    const Double_t xt = point[0] + gTrans->X();
+    const Double_t yt = point[1] + gTrans->Y();
+    const Double_t zt = point[2] + gTrans->Z();
+    xl = fSinY * zt + fCosY * xt;
+    yl = yt;
+    zl = fCosY * zt - fSinY * xt;
+
+    // Symmetric maps only hold the half with non-negative coordinates
+    hx = hy = 1.;
+    if (fMirrorX && xl < 0.)
+    {
+        xl = -xl;
+        hx = -1.;
+    }
+    if (fMirrorY && yl < 0.)
+    {
+        yl = -yl;
+        hy = -1.;
+    }
+}
+// ------------------------------------------------------------------------
 
-    Int_t ix = 0;
-    Int_t iy = 0;
-    Int_t iz = 0;
-    Double_t dx = 0.;
-    Double_t dy = 0.;
-    Double_t dz = 0.;
+// -----------   Find the grid cell of a local point   --------------------
+Bool_t R3BGladFieldMap::FindCell(Double_t xl, Double_t yl, Double_t zl, Int_t& ix, Int_t& iy, Int_t& iz) const
+{
+    if (!(xl >= fXmin && xl < fXmax && yl >= fYmin && yl < fYmax && zl >= fZmin && zl < fZmax))
+    {
+        return kFALSE;
+    }
 
-    // transform to local coordinates
-    // local to global
-    TVector3 localPoint(x, y, z);
+    // Rounding may put a point just below the upper edge into the next cell
+    ix = TMath::Min(Int_t((xl - fXmin) / fXstep), fNx - 2);
+    iy = TMath::Min(Int_t((yl - fYmin) / fYstep), fNy - 2);
+    iz = TMath::Min(Int_t((zl - fZmin) / fZstep), fNz - 2);
+    return kTRUE;
+}
+// ------------------------------------------------------------------------
 
-    localPoint = localPoint + (*gTrans);
-    localPoint.RotateY(-fYAngle * TMath::DegToRad());
+// -----------   Transform to local system and find grid cell   -----------
+Bool_t R3BGladFieldMap::Locate(const Double_t point[3],
+                               Int_t& node,
+                               Double_t& dx,
+                               Double_t& dy,
+                               Double_t& dz,
+                               Double_t& hx,
+                               Double_t& hy) const
+{
+    Double_t xl, yl, zl;
+    ToLocal(point, xl, yl, zl, hx, hy);
 
-    if (IsInside(localPoint.X(), localPoint.Y(), localPoint.Z(), ix, iy, iz, dx, dy, dz))
+    Int_t ix, iy, iz;
+    if (!FindCell(xl, yl, zl, ix, iy, iz))
     {
-
-        // Get Bz field values at grid cell corners
-        fHa[0][0][0] = fBz->At(ix * fNy * fNz + iy * fNz + iz);
-        fHa[1][0][0] = fBz->At((ix + 1) * fNy * fNz + iy * fNz + iz);
-        fHa[0][1][0] = fBz->At(ix * fNy * fNz + (iy + 1) * fNz + iz);
-        fHa[1][1][0] = fBz->At((ix + 1) * fNy * fNz + (iy + 1) * fNz + iz);
-        fHa[0][0][1] = fBz->At(ix * fNy * fNz + iy * fNz + (iz + 1));
-        fHa[1][0][1] = fBz->At((ix + 1) * fNy * fNz + iy * fNz + (iz + 1));
-        fHa[0][1][1] = fBz->At(ix * fNy * fNz + (iy + 1) * fNz + (iz + 1));
-        fHa[1][1][1] = fBz->At((ix + 1) * fNy * fNz + (iy + 1) * fNz + (iz + 1));
-
-        // Return interpolated field value
-        Double_t val = Interpolate(dx, dy, dz);
-        // cout << " (Z) interpolated " << val << endl;
-        return (val);
+        return kFALSE;
     }
 
-    return 0.;
+    dx = (xl - fXmin) / fXstep - Double_t(ix);
+    dy = (yl - fYmin) / fYstep - Double_t(iy);
+    dz = (zl - fZmin) / fZstep - Double_t(iz);
+    node = 3 * (ix * fNy * fNz + iy * fNz + iz);
+    return kTRUE;
 }
 // ------------------------------------------------------------------------
 
@@ -305,6 +542,12 @@ Bool_t R3BGladFieldMap::IsInside(Double_t x,
 void R3BGladFieldMap::WriteAsciiFile(const char* fileName)
 {
 
+    if (!fData || fMirrorX || fMirrorY)
+    {
+        cerr << "-E- R3BGladFieldMap::WriteAsciiFile: Only full maps in float storage can be written" << endl;
+        return;
+    }
+
     // Open file
     cout << "-I- R3BGladFieldMap: Writing field map to ASCII file " << fileName << endl;
     ofstream mapFile(fileName);
@@ -323,12 +566,11 @@ void R3BGladFieldMap::WriteAsciiFile(const char* fileName)
         mapFile << "sym2" << endl;
     if (fType == 3)
         mapFile << "sym3" << endl;
-    mapFile << fXmin << " " << fXmax << " " << fNx << endl;
-    mapFile << fYmin << " " << fYmax << " " << fNy << endl;
-    mapFile << fZmin << " " << fZmax << " " << fNz << endl;
+    mapFile << fXmin << " " << fXmax << " " << fNx - 1 << endl;
+    mapFile << fYmin << " " << fYmax << " " << fNy - 1 << endl;
+    mapFile << fZmin << " " << fZmax << " " << fNz - 1 << endl;
 
-    // Write field values
-    Double_t factor = 10. * fScale; // Takes out scaling and converts kG->T
+    // Write grid positions and field values in T, in the same format as read by ReadAsciiFile
     cout << right;
     Int_t nTot = fNx * fNy * fNz;
     cout << "-I- R3BGladFieldMap: " << fNx * fNy * fNz << " entries to write... " << setw(3) << 0 << " % ";
@@ -348,8 +590,8 @@ void R3BGladFieldMap::WriteAsciiFile(const char* fileName)
                     Double_t perc = TMath::Nint(100. * index / nTot);
                     cout << "\b\b\b\b\b\b" << setw(3) << perc << " % " << flush;
                 }
-                mapFile << fBx->At(index) / factor << " " << fBy->At(index) / factor << " " << fBz->At(index) / factor
-                        << endl;
+                mapFile << fXmin + ix * fXstep << " " << fYmin + iy * fYstep << " " << fZmin + iz * fZstep << " "
+                        << fData[3 * index] << " " << fData[3 * index + 1] << " " << fData[3 * index + 2] << endl;
             } // z-Loop
         }     // y-Loop
     }         // x-Loop
@@ -358,6 +600,32 @@ void R3BGladFieldMap::WriteAsciiFile(const char* fileName)
 }
 // ------------------------------------------------------------------------
 
+// ----------   Write the map to a binary file   --------------------------
+void R3BGladFieldMap::WriteBinaryFile(const char* fileName) const
+{
+    if (!fData || fMirrorX || fMirrorY)
+    {
+        LOG(ERROR) << "R3BGladFieldMap::WriteBinaryFile: Only full maps in float storage can be written";
+        return;
+    }
+
+    LOG(INFO) << "R3BGladFieldMap: Writing field map to binary file " << fileName;
+    const Int_t n[3] = { fNx, fNy, fNz };
+    const Double_t min[3] = { fXmin, fYmin, fZmin };
+    const Double_t max[3] = { fXmax, fYmax, fZmax };
+    R3BFieldMapFile::Header header = R3BFieldMapFile::MakeHeader(fType, 3, n, min, max);
+    // Stamp the map with the ASCII file it was read from, such that an outdated binary map is ignored
+    if (fFileName.EndsWith(".dat"))
+    {
+        R3BFieldMapFile::GetSourceStamp(fFileName, header.srcSize, header.srcTime);
+    }
+    if (!R3BFieldMapFile::Write(fileName, header, fData))
+    {
+        LOG(ERROR) << "R3BGladFieldMap::WriteBinaryFile: Could not write " << fileName;
+    }
+}
+// ------------------------------------------------------------------------
+
 // -------   Write field map to a ROOT file   -----------------------------
 /*
 void R3BGladFieldMap::WriteRootFile(const char* fileName,
@@ -430,20 +698,19 @@ void R3BGladFieldMap::Reset()
     fXstep = fYstep = fZstep = 0.;
     fNx = fNy = fNz = 0;
     fScale = 1.;
-    if (fBx)
-    {
-        delete fBx;
-        fBx = NULL;
-    }
-    if (fBy)
+    fInvXstep = fInvYstep = fInvZstep = 0.;
+    fCellCacheId = R3BFieldCellCache::NewId();
+    fB.clear();
+    fData = NULL;
+    if (fMapFile)
     {
-        delete fBy;
-        fBy = NULL;
+        delete fMapFile;
+        fMapFile = NULL;
     }
-    if (fBz)
+    if (fPacked)
     {
-        delete fBz;
-        fBz = NULL;
+        delete fPacked;
+        fPacked = NULL;
     }
 }
 // ------------------------------------------------------------------------
@@ -492,12 +759,10 @@ void R3BGladFieldMap::ReadAsciiFile(const char* fileName)
     fNx += 1;
     fNy += 1;
     fNz += 1;
-    fBx = new TArrayF(fNx * fNy * fNz);
-    fBy = new TArrayF(fNx * fNy * fNz);
-    fBz = new TArrayF(fNx * fNy * fNz);
+    fB.assign(3 * fNx * fNy * fNz, 0.);
+    fData = fB.data();
 
-    // Read the field values
-    Double_t factor = fScale * 10.; // Factor 10 for T -> kG
+    // Read the field values, kept in T in the map frame
     cout << right;
     Int_t nTot = fNx * fNy * fNz;
     cout << "-I- R3BGladFieldMap: " << nTot << " entries to read... " << setw(3) << 0 << " % ";
@@ -530,12 +795,12 @@ void R3BGladFieldMap::ReadAsciiFile(const char* fileName)
                 Int_t index1 = Int_t((x - fXmin) / fXstep) * fNy * fNz + Int_t((y - fYmin) / fYstep) * fNz +
                                Int_t((z - fZmin) / fZstep);
 
-                TVector3 B(bx, by, bz);
-                B.RotateY(fYAngle * TMath::DegToRad());
-
-                fBx->AddAt(factor * B.X(), index1);
-                fBy->AddAt(factor * B.Y(), index1);
-                fBz->AddAt(factor * B.Z(), index1);
+                if (index1 >= 0 && index1 < nTot)
+                {
+                    fB[3 * index1] = bx;
+                    fB[3 * index1 + 1] = by;
+                    fB[3 * index1 + 2] = bz;
+                }
                 // ------------------------------------------------------------------------------------------
 
                 //  cout << "-I- " << bx << " : " << by << " : "  << bz  << " : " << endl;
@@ -554,10 +819,176 @@ void R3BGladFieldMap::ReadAsciiFile(const char* fileName)
     cout << "   " << index + 1 << " read" << endl;
 
     mapFile.close();
+    GridChanged();
     //  exit(0);
 }
 // ------------------------------------------------------------------------
 
+// -----   Read field map from binary file (private)   --------------------
+void R3BGladFieldMap::ReadBinaryFile(const char* fileName)
+{
+    LOG(INFO) << "R3BGladFieldMap: Mapping binary field map " << fileName;
+    if (fMapFile)
+        delete fMapFile;
+    fMapFile = new R3BFieldMapFile();
+    if (!fMapFile->Open(fileName))
+    {
+        LOG(fatal) << "ReadBinaryFile: Could not read " << fileName;
+    }
+
+    const R3BFieldMapFile::Header& header = fMapFile->GetHeader();
+    if (header.type != fType || header.nComponents != 3)
+    {
+        LOG(fatal) << "ReadBinaryFile: Incompatible map in " << fileName << ": type " << header.type << " with "
+                   << header.nComponents << " components, expected type " << fType << " with 3 components";
+    }
+
+    fNx = header.n[0];
+    fNy = header.n[1];
+    fNz = header.n[2];
+    fXmin = header.min[0];
+    fYmin = header.min[1];
+    fZmin = header.min[2];
+    fXmax = header.max[0];
+    fYmax = header.max[1];
+    fZmax = header.max[2];
+    fXstep = (fXmax - fXmin) / Double_t(fNx - 1);
+    fYstep = (fYmax - fYmin) / Double_t(fNy - 1);
+    fZstep = (fZmax - fZmin) / Double_t(fNz - 1);
+
+    fB.clear();
+    fData = fMapFile->GetData();
+    GridChanged();
+}
+// ------------------------------------------------------------------------
+
+// -----   Apply the symmetry and storage options (private)   -------------
+void R3BGladFieldMap::Compress()
+{
+    const size_t sizeBefore = 3 * (size_t)fNx * fNy * fNz * sizeof(Float_t);
+
+    if (fMirrorX)
+        fMirrorX = Fold(0);
+    if (fMirrorY)
+        fMirrorY = Fold(1);
+
+    if (fStorage != kFloat32 && fData)
+    {
+        if (fPacked)
+            delete fPacked;
+        fPacked = new R3BFieldPackedGrid();
+        fPacked->Pack(fStorage == kFloat16 ? R3BFieldPackedGrid::kHalf : R3BFieldPackedGrid::kScaledShort,
+                      fNx * fNy * fNz,
+                      fData);
+
+        // Release the float values
+        std::vector<Float_t>().swap(fB);
+        if (fMapFile)
+        {
+            delete fMapFile;
+            fMapFile = NULL;
+        }
+        fData = NULL;
+    }
+
+    if (fMirrorX || fMirrorY || fPacked)
+    {
+        static const char* const storageNames[] = { "float32", "float16", "scaled int16" };
+        const size_t sizeAfter = fPacked ? fPacked->GetMemorySize() : 3 * (size_t)fNx * fNy * fNz * sizeof(Float_t);
+        LOG(INFO) << "R3BGladFieldMap: Field storage reduced from " << sizeBefore / 1024 << " kB to "
+                  << sizeAfter / 1024 << " kB (mirror x: " << fMirrorX << ", mirror y: " << fMirrorY
+                  << ", storage: " << storageNames[fStorage] << ")";
+    }
+    GridChanged();
+}
+// ------------------------------------------------------------------------
+
+// -----   Invalidate the cell caches of all threads (private)   ----------
+void R3BGladFieldMap::GridChanged()
+{
+    fInvXstep = 1. / fXstep;
+    fInvYstep = 1. / fYstep;
+    fInvZstep = 1. / fZstep;
+    fCellCacheId = R3BFieldCellCache::NewId();
+}
+// ------------------------------------------------------------------------
+
+// -----   Keep one half of a map symmetric in x or y (private)   ---------
+Bool_t R3BGladFieldMap::Fold(Int_t axis)
+{
+    const char* name = axis == 0 ? "x" : "y";
+    Int_t n[3] = { fNx, fNy, fNz };
+    Double_t& lo = axis == 0 ? fXmin : fYmin;
+    const Double_t hi = axis == 0 ? fXmax : fYmax;
+    const Double_t step = axis == 0 ? fXstep : fYstep;
+
+    // The mirror plane has to be the central grid plane
+    if (!fData || n[axis] % 2 == 0 || TMath::Abs(lo + hi) > 1.e-6 * step)
+    {
+        LOG(ERROR) << "R3BGladFieldMap: Grid is not symmetric in " << name << ", keeping the full map";
+        return kFALSE;
+    }
+    const Int_t i0 = (n[axis] - 1) / 2;
+
+    // Bx is odd and By is even under both mirrors, Bz is even in x and odd in y
+    const Double_t parity[2][3] = { { -1., 1., 1. }, { -1., 1., -1. } };
+
+    // Check the field against its mirror image
+    Double_t maxField = 0.;
+    Double_t maxDeviation = 0.;
+    Int_t i[3];
+    for (i[0] = 0; i[0] < n[0]; i[0]++)
+        for (i[1] = 0; i[1] < n[1]; i[1]++)
+            for (i[2] = 0; i[2] < n[2]; i[2]++)
+            {
+                Int_t m[3] = { i[0], i[1], i[2] };
+                m[axis] = n[axis] - 1 - i[axis];
+                const Float_t* b = fData + 3 * (i[0] * n[1] * n[2] + i[1] * n[2] + i[2]);
+                const Float_t* bm = fData + 3 * (m[0] * n[1] * n[2] + m[1] * n[2] + m[2]);
+                for (Int_t c = 0; c < 3; c++)
+                {
+                    maxField = TMath::Max(maxField, TMath::Abs(b[c]));
+                    maxDeviation = TMath::Max(maxDeviation, TMath::Abs(b[c] - parity[axis][c] * bm[c]));
+                }
+            }
+    if (maxDeviation > fSymmetryTolerance * maxField)
+    {
+        LOG(ERROR) << "R3BGladFieldMap: Field is not symmetric in " << name << " (deviation " << maxDeviation
+                   << " T of " << maxField << " T), keeping the full map";
+        return kFALSE;
+    }
+
+    // Keep the nodes with non-negative coordinate
+    Int_t k[3] = { n[0], n[1], n[2] };
+    k[axis] = n[axis] - i0;
+    std::vector<Float_t> folded(3 * (size_t)k[0] * k[1] * k[2]);
+    for (i[0] = 0; i[0] < k[0]; i[0]++)
+        for (i[1] = 0; i[1] < k[1]; i[1]++)
+            for (i[2] = 0; i[2] < k[2]; i[2]++)
+            {
+                Int_t src[3] = { i[0], i[1], i[2] };
+                src[axis] += i0;
+                const Float_t* b = fData + 3 * (src[0] * n[1] * n[2] + src[1] * n[2] + src[2]);
+                Float_t* f = &folded[3 * (i[0] * k[1] * k[2] + i[1] * k[2] + i[2])];
+                f[0] = b[0];
+                f[1] = b[1];
+                f[2] = b[2];
+            }
+
+    fB.swap(folded);
+    fData = fB.data();
+    if (fMapFile)
+    {
+        delete fMapFile;
+        fMapFile = NULL;
+    }
+    fNx = k[0];
+    fNy = k[1];
+    lo = 0.;
+    return kTRUE;
+}
+// ------------------------------------------------------------------------
+
 // -------------   Read field map from ROOT file (private)  ---------------
 /*
 void R3BGladFieldMap::ReadRootFile(const char* fileName,
@@ -653,23 +1084,4 @@ void R3BGladFieldMap::SetField(const R3BGladFieldMapData* data) {
 }
 */
 
-// ------------   Interpolation in a grid cell (private)  -----------------
-Double_t R3BGladFieldMap::Interpolate(Double_t dx, Double_t dy, Double_t dz)
-{
-
-    // Interpolate in x coordinate
-    fHb[0][0] = fHa[0][0][0] + (fHa[1][0][0] - fHa[0][0][0]) * dx;
-    fHb[1][0] = fHa[0][1][0] + (fHa[1][1][0] - fHa[0][1][0]) * dx;
-    fHb[0][1] = fHa[0][0][1] + (fHa[1][0][1] - fHa[0][0][1]) * dx;
-    fHb[1][1] = fHa[0][1][1] + (fHa[1][1][1] - fHa[0][1][1]) * dx;
-
-    // Interpolate in y coordinate
-    fHc[0] = fHb[0][0] + (fHb[1][0] - fHb[0][0]) * dy;
-    fHc[1] = fHb[0][1] + (fHb[1][1] - fHb[0][1]) * dy;
-
-    // Interpolate in z coordinate
-    return fHc[0] + (fHc[1] - fHc[0]) * dz;
-}
-// ------------------------------------------------------------------------
-
 ClassImp(R3BGladFieldMap)
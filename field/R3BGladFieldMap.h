@@ -19,18 +19,29 @@
 #include "TRotation.h"
 #include "TVector3.h"
 
-class TArrayF;
+#include <vector>
+
+class R3BFieldMapFile;
+class R3BFieldPackedGrid;
 
 class R3BGladFieldMap : public FairField
 {
 
   public:
+    /** Storage of the field values **/
+    enum EStorage
+    {
+        kFloat32,    // float per component (default)
+        kFloat16,    // IEEE half precision per component
+        kScaledInt16 // 16 bit integer per component with a scale per block of nodes
+    };
+
     /** Default constructor **/
     R3BGladFieldMap();
 
     /** Standard constructor
      ** @param name       Name of field map
-     ** @param fileType   R = ROOT file, A = ASCII
+     ** @param fileType   R = ROOT file, A = ASCII, B = binary
      **/
     R3BGladFieldMap(const char* mapName, const char* fileType = "A");
 
@@ -54,6 +65,20 @@ class R3BGladFieldMap : public FairField
     virtual Double_t GetBy(Double_t x, Double_t y, Double_t z);
     virtual Double_t GetBz(Double_t x, Double_t y, Double_t z);
 
+    /** Get all three field components at a certain point in one call.
+     ** The point is transformed and located in the grid only once.
+     ** @param point   Point coordinates (global) [cm]
+     ** @param bField  (return) Field components Bx,By,Bz [kG]
+     **/
+    virtual void GetFieldValue(const Double_t point[3], Double_t* bField);
+
+    /** Get the field at many points at once
+     ** @param n        Number of points
+     ** @param points   Point coordinates (global), n consecutive (x,y,z) triples [cm]
+     ** @param bFields  (return) Field components, n consecutive (Bx,By,Bz) triples [kG]
+     **/
+    virtual void GetFieldValues(Int_t n, const Double_t* points, Double_t* bFields);
+
     /** Determine whether a point is inside the field map
      ** @param x,y,z              Point coordinates (global) [cm]
      ** @param ix,iy,iz (return)  Grid cell
@@ -73,6 +98,11 @@ class R3BGladFieldMap : public FairField
     /** Write the field map to an ASCII file **/
     void WriteAsciiFile(const char* fileName);
 
+    /** Write the field map to a binary file (see R3BFieldMapFile), which
+     ** Init() maps into memory instead of parsing the ASCII file
+     **/
+    void WriteBinaryFile(const char* fileName) const;
+
     /** Write field map data to a ROOT file **/
     // void WriteRootFile(const char* fileName, const char* mapName);
 
@@ -82,6 +112,24 @@ class R3BGladFieldMap : public FairField
     /** Set a global field scaling factor **/
     virtual void SetScale(Double_t factor) { fScale = factor; }
 
+    /** Reduced precision storage of the field values, decoded in the
+     ** interpolation. Has to be set before Init().
+     **/
+    void SetStorage(EStorage storage) { fStorage = storage; }
+
+    /** Keep only the half of the map with x >= 0 and/or y >= 0 (local system).
+     ** The other half is obtained by mirroring: Bx is odd in x and y, By is even
+     ** in x and y, Bz is even in x and odd in y. Applied in Init() only if the
+     ** map fulfils the symmetry within tolerance * max|B|, and before the
+     ** storage option. Has to be set before Init().
+     **/
+    void SetSymmetry(Bool_t mirrorX, Bool_t mirrorY, Double_t tolerance = 1.e-3)
+    {
+        fMirrorX = mirrorX;
+        fMirrorY = mirrorY;
+        fSymmetryTolerance = tolerance;
+    }
+
     /** Accessors to field parameters in local coordinate system **/
     Double_t GetXmin() const { return fXmin; }
     Double_t GetYmin() const { return fYmin; }
@@ -107,13 +155,14 @@ class R3BGladFieldMap : public FairField
     /** Accessor to global scaling factor  **/
     Double_t GetScale() const { return fScale; }
 
-    /** Accessors to the field value arrays **/
-    TArrayF* GetBx() const { return fBx; }
-    TArrayF* GetBy() const { return fBy; }
-    TArrayF* GetBz() const { return fBz; }
+    /** Accessor to the field values as on file, interleaved as (Bx, By, Bz) per grid
+     ** node with node index ix * fNy * fNz + iy * fNz + iz [T, map frame]
+     **/
+    const Float_t* GetFieldData() const { return fData; }
 
     /** Accessor to field map file **/
     const char* GetFileName() { return fFileName.Data(); }
+    void SetFileName(const char* fileName) { fFileName = fileName; }
 
     /** Screen output **/
     virtual void Print(Option_t* option = "") const;
@@ -125,16 +174,59 @@ class R3BGladFieldMap : public FairField
     /** Read the field map from an ASCII file **/
     void ReadAsciiFile(const char* fileName);
 
+    /** Map the field map from a binary file **/
+    void ReadBinaryFile(const char* fileName);
+
+    /** Apply the symmetry and storage options after reading **/
+    void Compress();
+
+    /** Reduce the grid to the half with non-negative coordinate along axis (0 = x, 1 = y)
+     ** @value kTRUE if the map is symmetric and has been folded
+     **/
+    Bool_t Fold(Int_t axis);
+
+    /** Update the inverse grid steps and invalidate the per-thread cell caches after a grid change **/
+    void GridChanged();
+
     /** Read field map from a ROOT file **/
     // void ReadRootFile(const char* fileName, const char* mapName);
 
     /** Set field parameters and data **/
     // void SetField(const R3BGladFieldMapData* data);
 
-    /** Get field values by interpolation of the grid.
+    /** Transform a global point into the local system, folding it onto the stored half of a symmetric map
+     ** @param xl,yl,zl  (return) Local coordinates [cm]
+     ** @param hx,hy     (return) -1 if the point is on the mirrored half in x (y), else 1
+     **/
+    void ToLocal(const Double_t point[3], Double_t& xl, Double_t& yl, Double_t& zl, Double_t& hx, Double_t& hy) const;
+
+    /** Find the grid cell of a local point
+     ** @param ix,iy,iz  (return) Index of the lower cell corner
+     ** @value kTRUE if inside map, else kFALSE
+     **/
+    Bool_t FindCell(Double_t xl, Double_t yl, Double_t zl, Int_t& ix, Int_t& iy, Int_t& iz) const;
+
+    /** Transform a global point into the local system and locate its grid cell.
+     ** @param node      (return) Offset of the lower cell corner in fData
+     ** @param dx,dy,dz  (return) Relative distance from grid point [cell units]
+     ** @param hx,hy     (return) -1 if the point is on the mirrored half in x (y), else 1
+     ** @value kTRUE if inside map, else kFALSE
+     **/
+    Bool_t Locate(const Double_t point[3],
+                  Int_t& node,
+                  Double_t& dx,
+                  Double_t& dy,
+                  Double_t& dz,
+                  Double_t& hx,
+                  Double_t& hy) const;
+
+    /** Interpolate the field values [T, map frame] in a grid cell
+     ** @param node      Offset of the lower cell corner in fData (float) or node index (packed)
      ** @param dx,dy,dz  Relative distance from grid point [cell units]
+     ** @param b         (return) Bx, By, Bz
      **/
-    Double_t Interpolate(Double_t dx, Double_t dy, Double_t dz);
+    void InterpolateFloat(Int_t node, Double_t dx, Double_t dy, Double_t dz, Double_t* b) const;
+    void InterpolatePacked(Int_t node, Double_t dx, Double_t dy, Double_t dz, Double_t* b) const;
 
     /** Map file name **/
     TString fFileName;
@@ -156,16 +248,33 @@ class R3BGladFieldMap : public FairField
     /** Number of grid points  **/
     Int_t fNx, fNy, fNz; //
 
-    /** Arrays with the field values  **/
-    TArrayF* fBx; //!
-    TArrayF* fBy; //!
-    TArrayF* fBz; //!
+    /** Field values [T], interleaved (Bx, By, Bz) per grid node in the map frame.
+     ** fData points to fB for ASCII maps or into the mapping of a binary map.
+     **/
+    std::vector<Float_t> fB;   //!
+    const Float_t* fData;      //!
+    R3BFieldMapFile* fMapFile; //!
 
-    /** Variables for temporary storage
-     ** Used in the very frequently called method GetFieldValue  **/
-    Double_t fHa[2][2][2]; //! Field at corners of a grid cell
-    Double_t fHb[2][2];    //! Interpolated field (2-dim)
-    Double_t fHc[2];       //! Interpolated field (1-dim)
+    /** Reduced precision field values, replaces fData if used **/
+    R3BFieldPackedGrid* fPacked; //!
+    Int_t fStorage;              //!
+
+    /** Symmetry planes of the stored map **/
+    Bool_t fMirrorX;             //!
+    Bool_t fMirrorY;             //!
+    Double_t fSymmetryTolerance; //!
+
+    /** Cosine and sine of the global to local rotation (-fYAngle), also used
+     ** to rotate the field back into the global frame
+     **/
+    Double_t fCosY; //!
+    Double_t fSinY; //!
+
+    /** Inverse grid steps and the id of the current grid for the per-thread cell cache **/
+    Double_t fInvXstep;     //!
+    Double_t fInvYstep;     //!
+    Double_t fInvZstep;     //!
+    ULong64_t fCellCacheId; //!
 
     /** local transformation
      **/
@@ -0,0 +1,88 @@
+/******************************************************************************
+ *   Copyright (C) 2019 GSI Helmholtzzentrum für Schwerionenforschung GmbH    *
+ *   Copyright (C) 2019 Members of R3B Collaboration                          *
+ *                                                                            *
+ *             This software is distributed under the terms of the            *
+ *                 GNU General Public Licence (GPL) version 3,                *
+ *                    copied verbatim in the file "LICENSE".                  *
+ *                                                                            *
+ * In applying this license GSI does not waive the privileges and immunities  *
+ * granted to it by virtue of its status as an Intergovernmental Organization *
+ * or submit itself to any jurisdiction.                                      *
+ ******************************************************************************/
+
+#ifndef GLADTESTMAP_H
+#define GLADTESTMAP_H 1
+
+#include "Rtypes.h"
+#include "TString.h"
+#include "TSystem.h"
+
+#include <fstream>
+
+// Small synthetic GLAD field map for the field unit tests, written as an
+// ASCII map to the temporary directory. The field [T] has the parities of
+// the real magnet (Bx odd in x and y, By even, Bz even in x and odd in y)
+// unless asymmetric is set, which adds a term linear in x to By. For
+// comparisons with analytic trajectories, a uniform map can be written too.
+
+namespace GladTestMap
+{
+    const Double_t kMin[3] = { -50., -20., -100. };
+    const Double_t kMax[3] = { 50., 20., 100. };
+    const Int_t kSteps[3] = { 20, 8, 40 };
+
+    inline void Field(Double_t x, Double_t y, Double_t z, Bool_t asymmetric, Double_t b[3])
+    {
+        const Double_t profile = 1. / (1. + z * z / 3600.);
+        b[0] = 4.e-5 * x * y * profile;
+        b[1] = (1.5 + 2.e-4 * x * x - 5.e-4 * y * y) * profile + (asymmetric ? 2.e-3 * x : 0.);
+        b[2] = 1.e-3 * y * (1. + 1.e-3 * x * x) * z / 100.;
+    }
+
+    /** Write a map of field(x, y, z, b) on the grid and return the file name **/
+    template <class F>
+    inline TString WriteField(const char* name, F field)
+    {
+        const TString fileName = TString::Format("%s/%s_%d.dat", gSystem->TempDirectory(), name, gSystem->GetPid());
+        std::ofstream out(fileName.Data());
+        out.precision(9);
+        out << "nosym\n";
+        for (Int_t k = 0; k < 3; k++)
+        {
+            out << kMin[k] << " " << kMax[k] << " " << kSteps[k] << "\n";
+        }
+        for (Int_t ix = 0; ix <= kSteps[0]; ix++)
+            for (Int_t iy = 0; iy <= kSteps[1]; iy++)
+                for (Int_t iz = 0; iz <= kSteps[2]; iz++)
+                {
+                    const Double_t x = kMin[0] + ix * (kMax[0] - kMin[0]) / kSteps[0];
+                    const Double_t y = kMin[1] + iy * (kMax[1] - kMin[1]) / kSteps[1];
+                    const Double_t z = kMin[2] + iz * (kMax[2] - kMin[2]) / kSteps[2];
+                    Double_t b[3];
+                    field(x, y, z, b);
+                    out << x << " " << y << " " << z << " " << b[0] << " " << b[1] << " " << b[2] << "\n";
+                }
+        return fileName;
+    }
+
+    /** Write the map and return the file name **/
+    inline TString Write(const char* name, Bool_t asymmetric = kFALSE)
+    {
+        return WriteField(name, [asymmetric](Double_t x, Double_t y, Double_t z, Double_t* b) {
+            Field(x, y, z, asymmetric, b);
+        });
+    }
+
+    /** Write a map with the uniform field (0, by, 0) [T] and return the file name **/
+    inline TString WriteUniform(const char* name, Double_t by)
+    {
+        return WriteField(name, [by](Double_t, Double_t, Double_t, Double_t* b) {
+            b[0] = 0.;
+            b[1] = by;
+            b[2] = 0.;
+        });
+    }
+} // namespace GladTestMap
+
+#endif // GLADTESTMAP_H
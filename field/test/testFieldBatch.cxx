@@ -0,0 +1,169 @@
+/******************************************************************************
+ *   Copyright (C) 2019 GSI Helmholtzzentrum für Schwerionenforschung GmbH    *
+ *   Copyright (C) 2019 Members of R3B Collaboration                          *
+ *                                                                            *
+ *             This software is distributed under the terms of the            *
+ *                 GNU General Public Licence (GPL) version 3,                *
+ *                    copied verbatim in the file "LICENSE".                  *
+ *                                                                            *
+ * In applying this license GSI does not waive the privileges and immunities  *
+ * granted to it by virtue of its status as an Intergovernmental Organization *
+ * or submit itself to any jurisdiction.                                      *
+ ******************************************************************************/
+
+#include "GladTestMap.h"
+#include "R3BAladinFieldMap.h"
+#include "R3BFieldMap.h"
+#include "R3BGladFieldMap.h"
+#include "TMath.h"
+#include "TSystem.h"
+#include "gtest/gtest.h"
+
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+// GetFieldValues has to return the same field as GetFieldValue point by point,
+// inside the maps, outside and on (within rounding of) the map borders.
+
+namespace
+{
+    const Double_t kTolerance = 1.e-9; // kG
+
+    // Rotation by angle [deg] around y and shift along z, as used for the magnet placements
+    void ToGlobal(Double_t angle, Double_t zCentre, const Double_t local[3], Double_t* point)
+    {
+        const Double_t c = TMath::Cos(angle * TMath::DegToRad());
+        const Double_t s = TMath::Sin(angle * TMath::DegToRad());
+        point[0] = c * local[0] - s * local[2];
+        point[1] = local[1];
+        point[2] = s * local[0] + c * local[2] + zCentre;
+    }
+
+    // Random local points in the box widened by margin on each side, then points with one, two
+    // or three coordinates on the box faces
+    std::vector<Double_t> MakePoints(Double_t angle,
+                                     Double_t zCentre,
+                                     const Double_t min[3],
+                                     const Double_t max[3],
+                                     Double_t margin,
+                                     Int_t n)
+    {
+        std::mt19937 gen(1234);
+        std::uniform_real_distribution<Double_t> uniform(0., 1.);
+        std::vector<Double_t> points;
+        Double_t local[3], point[3];
+
+        for (Int_t i = 0; i < n; i++)
+        {
+            for (Int_t k = 0; k < 3; k++)
+            {
+                local[k] = min[k] - margin + (max[k] - min[k] + 2. * margin) * uniform(gen);
+            }
+            ToGlobal(angle, zCentre, local, point);
+            points.insert(points.end(), point, point + 3);
+        }
+
+        for (Int_t i = 0; i < n; i++)
+        {
+            for (Int_t k = 0; k < 3; k++)
+            {
+                local[k] = min[k] + (max[k] - min[k]) * uniform(gen);
+                if (uniform(gen) < 0.5)
+                {
+                    local[k] = uniform(gen) < 0.5 ? min[k] : max[k];
+                }
+            }
+            ToGlobal(angle, zCentre, local, point);
+            points.insert(points.end(), point, point + 3);
+        }
+        return points;
+    }
+
+    template <typename T>
+    void ExpectSameField(T& field, const std::vector<Double_t>& points)
+    {
+        const Int_t n = points.size() / 3;
+        std::vector<Double_t> batch(3 * n);
+        field.GetFieldValues(n, points.data(), batch.data());
+
+        Int_t nonZero = 0;
+        for (Int_t i = 0; i < n; i++)
+        {
+            Double_t b[3];
+            field.GetFieldValue(&points[3 * i], b);
+            for (Int_t k = 0; k < 3; k++)
+            {
+                ASSERT_NEAR(batch[3 * i + k], b[k], kTolerance)
+                    << "point " << i << " (" << points[3 * i] << ", " << points[3 * i + 1] << ", "
+                    << points[3 * i + 2] << "), component " << k;
+            }
+            if (b[1] != 0.)
+                nonZero++;
+        }
+
+        // Make sure the points actually probe the map
+        EXPECT_GT(nonZero, n / 10);
+        EXPECT_LT(nonZero, n);
+    }
+
+    TEST(testFieldBatch, GladMap)
+    {
+        const TString fileName = GladTestMap::Write("testFieldBatch");
+        R3BGladFieldMap glad;
+        glad.SetFileName(fileName);
+        glad.Init();
+        gSystem->Unlink(fileName);
+
+        const Double_t min[3] = { glad.GetXmin(), glad.GetYmin(), glad.GetZmin() };
+        const Double_t max[3] = { glad.GetXmax(), glad.GetYmax(), glad.GetZmax() };
+        ExpectSameField(glad, MakePoints(-glad.GetYAngle(), glad.GetPositionZ(), min, max, 20., 20000));
+    }
+
+    TEST(testFieldBatch, GladMapMirrored)
+    {
+        const TString fileName = GladTestMap::Write("testFieldBatchMirrored");
+        R3BGladFieldMap glad;
+        glad.SetFileName(fileName);
+        glad.SetSymmetry(kTRUE, kTRUE);
+        glad.Init();
+        gSystem->Unlink(fileName);
+
+        const Double_t min[3] = { -glad.GetXmax(), -glad.GetYmax(), glad.GetZmin() };
+        const Double_t max[3] = { glad.GetXmax(), glad.GetYmax(), glad.GetZmax() };
+        ExpectSameField(glad, MakePoints(-glad.GetYAngle(), glad.GetPositionZ(), min, max, 20., 20000));
+    }
+
+    TEST(testFieldBatch, R3BFieldMap)
+    {
+        // ALADiN map compiled into R3BFieldMap: 5 cm grid, 7 deg, centred at z = 255 cm
+        R3BFieldMap field(0);
+        field.SetScale(1.);
+        const Double_t min[3] = { -65., -25., -125. };
+        const Double_t max[3] = { 65., 25., 125. };
+        ExpectSameField(field, MakePoints(7., 255., min, max, 20., 20000));
+    }
+
+    TEST(testFieldBatch, AladinFieldMap)
+    {
+        if (!getenv("VMCWORKDIR"))
+        {
+            FAIL() << "VMCWORKDIR has to point to the source directory for the ALADiN reference maps";
+        }
+
+        R3BAladinFieldMap::SetCacheDirectory(gSystem->TempDirectory());
+        R3BAladinFieldMap aladin;
+        aladin.SetScale(1.);
+        aladin.SetCurrent(2200.);
+        aladin.Init();
+
+        // Measurement boxes and the fringe field cut at |z| = 160 cm (magnet frame)
+        const Double_t min[3] = { -60., -25., -160. };
+        const Double_t max[3] = { 60., 29., 160. };
+        ExpectSameField(aladin, MakePoints(7., 255., min, max, 20., 20000));
+
+        // Reference map without interpolation in the current
+        aladin.SetCurrent(2500.);
+        ExpectSameField(aladin, MakePoints(7., 255., min, max, 20., 5000));
+    }
+} // namespace
@@ -0,0 +1,114 @@
+/******************************************************************************
+ *   Copyright (C) 2019 GSI Helmholtzzentrum für Schwerionenforschung GmbH    *
+ *   Copyright (C) 2019 Members of R3B Collaboration                          *
+ *                                                                            *
+ *             This software is distributed under the terms of the            *
+ *                 GNU General Public Licence (GPL) version 3,                *
+ *                    copied verbatim in the file "LICENSE".                  *
+ *                                                                            *
+ * In applying this license GSI does not waive the privileges and immunities  *
+ * granted to it by virtue of its status as an Intergovernmental Organization *
+ * or submit itself to any jurisdiction.                                      *
+ ******************************************************************************/
+
+#include "GladTestMap.h"
+#include "R3BFieldMapFile.h"
+#include "R3BGladFieldMap.h"
+#include "TSystem.h"
+#include "gtest/gtest.h"
+
+// A binary GLAD map records the ASCII map it was converted from, and gives the same field.
+
+namespace
+{
+    TEST(testFieldMapFile, BinaryMapIsStampedWithItsSource)
+    {
+        const TString asciiName = GladTestMap::Write("testFieldMapFileStamp");
+        TString binaryName = asciiName;
+        binaryName.Remove(binaryName.Length() - 4);
+        binaryName += ".bin";
+
+        R3BGladFieldMap glad;
+        glad.SetFileName(asciiName);
+        glad.Init();
+        glad.WriteBinaryFile(binaryName);
+
+        Long64_t srcSize = 0, srcTime = 0;
+        ASSERT_TRUE(R3BFieldMapFile::GetSourceStamp(asciiName, srcSize, srcTime));
+        EXPECT_GT(srcSize, 0);
+
+        R3BFieldMapFile file;
+        ASSERT_TRUE(file.Open(binaryName));
+        EXPECT_EQ(file.GetHeader().version, R3BFieldMapFile::kVersion);
+        EXPECT_EQ(file.GetHeader().srcSize, srcSize);
+        EXPECT_EQ(file.GetHeader().srcTime, srcTime);
+        file.Close();
+
+        gSystem->Unlink(asciiName);
+        gSystem->Unlink(binaryName);
+
+        EXPECT_FALSE(R3BFieldMapFile::GetSourceStamp(asciiName, srcSize, srcTime));
+    }
+
+    TEST(testFieldMapFile, BinaryMapGivesTheSameField)
+    {
+        const TString asciiName = GladTestMap::Write("testFieldMapFileField");
+        TString binaryName = asciiName;
+        binaryName.Remove(binaryName.Length() - 4);
+        binaryName += ".bin";
+
+        R3BGladFieldMap ascii;
+        ascii.SetFileName(asciiName);
+        ascii.Init();
+        ascii.WriteBinaryFile(binaryName);
+
+        R3BGladFieldMap binary;
+        binary.SetFileName(binaryName);
+        binary.Init();
+
+        gSystem->Unlink(asciiName);
+        gSystem->Unlink(binaryName);
+
+        for (Double_t x = -40.; x <= 40.; x += 7.)
+            for (Double_t z = 80.; z <= 240.; z += 9.)
+            {
+                const Double_t point[3] = { x, 3.3, z };
+                Double_t b1[3], b2[3];
+                ascii.GetFieldValue(point, b1);
+                binary.GetFieldValue(point, b2);
+                for (Int_t k = 0; k < 3; k++)
+                {
+                    EXPECT_EQ(b1[k], b2[k]);
+                }
+            }
+    }
+
+    TEST(testFieldMapFile, VersionOneHasNoStamp)
+    {
+        const TString fileName =
+            TString::Format("%s/testFieldMapFileVersion_%d.bin", gSystem->TempDirectory(), gSystem->GetPid());
+        const Int_t n[3] = { 2, 2, 2 };
+        const Double_t min[3] = { 0., 0., 0. };
+        const Double_t max[3] = { 1., 1., 1. };
+        const Float_t data[24] = { 0. };
+
+        R3BFieldMapFile::Header header = R3BFieldMapFile::MakeHeader(1, 3, n, min, max);
+        header.version = 1;
+        header.srcSize = 1234;
+        header.srcTime = 5678;
+        ASSERT_TRUE(R3BFieldMapFile::Write(fileName, header, data));
+
+        R3BFieldMapFile file;
+        ASSERT_TRUE(file.Open(fileName));
+        EXPECT_EQ(file.GetHeader().srcSize, 0);
+        EXPECT_EQ(file.GetHeader().srcTime, 0);
+        EXPECT_EQ(file.GetHeader().n[2], 2);
+        file.Close();
+
+        header.version = R3BFieldMapFile::kVersion + 1;
+        ASSERT_TRUE(R3BFieldMapFile::Write(fileName, header, data));
+        EXPECT_FALSE(file.Open(fileName));
+
+        gSystem->Unlink(fileName);
+    }
+} // namespace
@@ -0,0 +1,217 @@
+/******************************************************************************
+ *   Copyright (C) 2019 GSI Helmholtzzentrum für Schwerionenforschung GmbH    *
+ *   Copyright (C) 2019 Members of R3B Collaboration                          *
+ *                                                                            *
+ *             This software is distributed under the terms of the            *
+ *                 GNU General Public Licence (GPL) version 3,                *
+ *                    copied verbatim in the file "LICENSE".                  *
+ *                                                                            *
+ * In applying this license GSI does not waive the privileges and immunities  *
+ * granted to it by virtue of its status as an Intergovernmental Organization *
+ * or submit itself to any jurisdiction.                                      *
+ ******************************************************************************/
+
+#include "GladTestMap.h"
+#include "R3BFieldPackedGrid.h"
+#include "R3BGladFieldMap.h"
+#include "TMath.h"
+#include "TSystem.h"
+#include "gtest/gtest.h"
+
+#include <cmath>
+#include <random>
+#include <vector>
+
+namespace
+{
+    // Random field values with magnitudes from 1e-5 to 5 T and both signs
+    std::vector<Float_t> RandomField(Int_t nNodes)
+    {
+        std::mt19937 gen(42);
+        std::uniform_real_distribution<Double_t> exponent(-5., TMath::Log10(5.));
+        std::uniform_real_distribution<Double_t> sign(-1., 1.);
+        std::vector<Float_t> data(3 * nNodes);
+        for (auto& b : data)
+        {
+            b = (sign(gen) < 0. ? -1. : 1.) * TMath::Power(10., exponent(gen));
+        }
+        return data;
+    }
+
+    // Random global points covering both halves of the test map and some margin
+    std::vector<Double_t> RandomPoints(const R3BGladFieldMap& glad, Int_t n)
+    {
+        std::mt19937 gen(7);
+        std::uniform_real_distribution<Double_t> x(-60., 60.);
+        std::uniform_real_distribution<Double_t> y(-25., 25.);
+        std::uniform_real_distribution<Double_t> z(-110., 110.);
+        std::vector<Double_t> points(3 * n);
+        for (Int_t i = 0; i < n; i++)
+        {
+            points[3 * i] = x(gen);
+            points[3 * i + 1] = y(gen);
+            points[3 * i + 2] = glad.GetPositionZ() + z(gen);
+        }
+        return points;
+    }
+
+    void InitMap(R3BGladFieldMap& glad, const TString& fileName)
+    {
+        glad.SetFileName(fileName);
+        glad.Init();
+    }
+
+    // Largest difference of the field components of two maps [kG]
+    Double_t MaxDifference(R3BGladFieldMap& a, R3BGladFieldMap& b, const std::vector<Double_t>& points)
+    {
+        Double_t maxDiff = 0.;
+        for (size_t i = 0; i < points.size(); i += 3)
+        {
+            Double_t ba[3], bb[3];
+            a.GetFieldValue(&points[i], ba);
+            b.GetFieldValue(&points[i], bb);
+            for (Int_t k = 0; k < 3; k++)
+            {
+                maxDiff = TMath::Max(maxDiff, TMath::Abs(ba[k] - bb[k]));
+            }
+        }
+        return maxDiff;
+    }
+
+    TEST(testFieldPackedGrid, HalfPrecisionError)
+    {
+        const Int_t nNodes = 10000;
+        const std::vector<Float_t> data = RandomField(nNodes);
+        R3BFieldPackedGrid grid;
+        grid.Pack(R3BFieldPackedGrid::kHalf, nNodes, data.data());
+        EXPECT_EQ(grid.GetMemorySize(), 3 * nNodes * sizeof(UShort_t));
+
+        for (Int_t node = 0; node < nNodes; node++)
+        {
+            Float_t b[3];
+            grid.Get(node, b);
+            for (Int_t k = 0; k < 3; k++)
+            {
+                // Half the spacing of the 11 bit significand, or of the subnormals below 2^-14
+                const Double_t v = data[3 * node + k];
+                const Double_t bound = TMath::Max(TMath::Abs(v) * std::ldexp(1., -11), std::ldexp(1., -25));
+                ASSERT_LE(TMath::Abs(b[k] - v), bound) << "node " << node << ", value " << v;
+            }
+        }
+
+        // Values representable in half precision are kept exactly
+        const Float_t exact[] = { 0.f, 1.f, -2.5f, 0.125f, 65504.f, -std::ldexp(1.f, -24) };
+        for (const Float_t v : exact)
+        {
+            EXPECT_EQ(R3BFieldPackedGrid::HalfToFloat(R3BFieldPackedGrid::FloatToHalf(v)), v);
+        }
+    }
+
+    TEST(testFieldPackedGrid, ScaledShortError)
+    {
+        // Not a multiple of the block size, such that the last block is partial
+        const Int_t nNodes = 10 * R3BFieldPackedGrid::kBlockNodes + 17;
+        const std::vector<Float_t> data = RandomField(nNodes);
+        R3BFieldPackedGrid grid;
+        grid.Pack(R3BFieldPackedGrid::kScaledShort, nNodes, data.data());
+
+        for (Int_t first = 0; first < nNodes; first += R3BFieldPackedGrid::kBlockNodes)
+        {
+            const Int_t last = TMath::Min(first + R3BFieldPackedGrid::kBlockNodes, nNodes);
+            for (Int_t k = 0; k < 3; k++)
+            {
+                Double_t maxAbs = 0.;
+                for (Int_t node = first; node < last; node++)
+                {
+                    maxAbs = TMath::Max(maxAbs, (Double_t)TMath::Abs(data[3 * node + k]));
+                }
+
+                // Half a quantisation step of the block, plus the float rounding of the decoding
+                const Double_t bound = maxAbs / 65534. + 1.e-7 * maxAbs;
+                for (Int_t node = first; node < last; node++)
+                {
+                    Float_t b[3];
+                    grid.Get(node, b);
+                    ASSERT_LE(TMath::Abs(b[k] - data[3 * node + k]), bound) << "node " << node << ", component " << k;
+                }
+            }
+        }
+    }
+
+    TEST(testFieldPackedGrid, PackedMapError)
+    {
+        const TString fileName = GladTestMap::Write("testFieldPackedGrid");
+        R3BGladFieldMap full;
+        InitMap(full, fileName);
+
+        Double_t maxField = 0.;
+        const Int_t nValues = 3 * full.GetNx() * full.GetNy() * full.GetNz();
+        for (Int_t i = 0; i < nValues; i++)
+        {
+            maxField = TMath::Max(maxField, (Double_t)TMath::Abs(full.GetFieldData()[i]));
+        }
+
+        // The interpolation is a convex combination of the nodes, the rotation into the
+        // global frame adds at most a factor sqrt(2), T -> kG a factor 10
+        const std::vector<Double_t> points = RandomPoints(full, 20000);
+        const Double_t factor = 10. * TMath::Sqrt(2.);
+
+        R3BGladFieldMap half;
+        half.SetStorage(R3BGladFieldMap::kFloat16);
+        InitMap(half, fileName);
+        EXPECT_TRUE(half.GetFieldData() == NULL);
+        const Double_t halfError = MaxDifference(full, half, points);
+        EXPECT_GT(halfError, 0.);
+        EXPECT_LE(halfError, factor * maxField * std::ldexp(1., -11));
+
+        R3BGladFieldMap scaled;
+        scaled.SetStorage(R3BGladFieldMap::kScaledInt16);
+        InitMap(scaled, fileName);
+        const Double_t scaledError = MaxDifference(full, scaled, points);
+        EXPECT_GT(scaledError, 0.);
+        EXPECT_LE(scaledError, factor * maxField * (1. / 65534. + 1.e-7));
+
+        gSystem->Unlink(fileName);
+    }
+
+    // Folding keeps the grid nodes of one half, the mirrored half is obtained with the parities
+    // {-1, 1, 1} in x and {-1, 1, -1} in y, which has to reproduce the full map everywhere
+    TEST(testFieldPackedGrid, FoldedLookup)
+    {
+        const TString fileName = GladTestMap::Write("testFieldFold");
+        R3BGladFieldMap full;
+        InitMap(full, fileName);
+        const std::vector<Double_t> points = RandomPoints(full, 20000);
+
+        const Bool_t mirror[3][2] = { { kTRUE, kFALSE }, { kFALSE, kTRUE }, { kTRUE, kTRUE } };
+        for (Int_t m = 0; m < 3; m++)
+        {
+            R3BGladFieldMap folded;
+            folded.SetSymmetry(mirror[m][0], mirror[m][1]);
+            InitMap(folded, fileName);
+
+            EXPECT_EQ(folded.GetNx(), mirror[m][0] ? (full.GetNx() + 1) / 2 : full.GetNx());
+            EXPECT_EQ(folded.GetNy(), mirror[m][1] ? (full.GetNy() + 1) / 2 : full.GetNy());
+            EXPECT_NEAR(MaxDifference(full, folded, points), 0., 1.e-9) << "mirror x " << mirror[m][0] << ", y "
+                                                                         << mirror[m][1];
+        }
+        gSystem->Unlink(fileName);
+    }
+
+    TEST(testFieldPackedGrid, AsymmetricMapNotFolded)
+    {
+        const TString fileName = GladTestMap::Write("testFieldNoFold", kTRUE);
+        R3BGladFieldMap full;
+        InitMap(full, fileName);
+
+        R3BGladFieldMap folded;
+        folded.SetSymmetry(kTRUE, kTRUE);
+        InitMap(folded, fileName);
+        gSystem->Unlink(fileName);
+
+        // By is not even in x: only the y half is dropped
+        EXPECT_EQ(folded.GetNx(), full.GetNx());
+        EXPECT_EQ(folded.GetNy(), (full.GetNy() + 1) / 2);
+        EXPECT_NEAR(MaxDifference(full, folded, RandomPoints(full, 20000)), 0., 1.e-9);
+    }
+} // namespace
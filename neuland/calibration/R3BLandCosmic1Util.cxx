@@ -12,9 +12,15 @@
  ******************************************************************************/
 
 #include "R3BLandCosmic1Util.h"
+#include "ParallelFor.h"
+#include <algorithm>
+#include <cmath>
 
 #define uint UInt_t
 
+// Below this number of rows per thread, the matrix products are not worth spreading over threads
+#define SSPLLQ_MIN_ROWS_PER_THREAD 4096
+
 void sparse_linear_least_squares_mult(long mode, dvec* x, dvec* y, void* data)
 {
     sparse_linear_least_squares* A = (sparse_linear_least_squares*)data;
@@ -241,6 +247,56 @@ bool sparse_linear_least_squares::solve(bool verbose)
     return true;
 }
 
+void sspllq_csr::build(const std::vector<sspllq_pair_sync>& pairs, UInt_t num_vars, bool transpose)
+{
+    clear();
+
+    if (!transpose)
+    {
+        // Each pair is one row with two entries
+        _row_start.resize(pairs.size() + 1);
+        _col.resize(2 * pairs.size());
+        _coeff.resize(2 * pairs.size());
+
+        for (uint r = 0; r < pairs.size(); r++)
+        {
+            _row_start[r] = 2 * r;
+            _col[2 * r] = pairs[r]._ind1;
+            _coeff[2 * r] = pairs[r]._coeff1;
+            _col[2 * r + 1] = pairs[r]._ind2;
+            _coeff[2 * r + 1] = pairs[r]._coeff2;
+        }
+        _row_start[pairs.size()] = 2 * pairs.size();
+        return;
+    }
+
+    // Count the entries per variable, then fill in order of the pairs, such that
+    // the accumulation order in each row is the same as when looping over the pairs
+    _row_start.assign(num_vars + 1, 0);
+    for (uint r = 0; r < pairs.size(); r++)
+    {
+        _row_start[pairs[r]._ind1 + 1]++;
+        _row_start[pairs[r]._ind2 + 1]++;
+    }
+    for (uint c = 0; c < num_vars; c++)
+        _row_start[c + 1] += _row_start[c];
+
+    _col.resize(_row_start[num_vars]);
+    _coeff.resize(_row_start[num_vars]);
+
+    std::vector<UInt_t> fill(_row_start.begin(), _row_start.end() - 1);
+    for (uint r = 0; r < pairs.size(); r++)
+    {
+        UInt_t k1 = fill[pairs[r]._ind1]++;
+        _col[k1] = r;
+        _coeff[k1] = pairs[r]._coeff1;
+
+        UInt_t k2 = fill[pairs[r]._ind2]++;
+        _col[k2] = r;
+        _coeff[k2] = pairs[r]._coeff2;
+    }
+}
+
 void sparse_sync_pair_llq::add_sync_pair(int ind1, double coeff1, int ind2, double coeff2, double rhs)
 {
     sspllq_pair_sync d;
@@ -478,6 +534,11 @@ bool sparse_sync_pair_llq::solve(uint max_vars, bool add_eqn_for_each_set)
         _pair_data[r]._coeff2 *= scaling[_pair_data[r]._ind2];
     }
 
+    // Compressed storage of the system and its transpose for the products
+
+    _rows.build(_pair_data, next_index, false);
+    _cols.build(_pair_data, next_index, true);
+
     // Now we're ready to invoke the solver.
 
     // First set the sizes up (this allocates arrays, etc)
@@ -507,13 +568,59 @@ bool sparse_sync_pair_llq::solve(uint max_vars, bool add_eqn_for_each_set)
     for (i = 0; i < next_index; i++)
         _in->sol_vec->elements[i] = 0.0;
 
+    // LSQR itself always starts from zero.  With a good initial guess x0
+    // (e.g. the previous calibration), we instead solve A*dx = b - A*x0 and
+    // add x0 afterwards.  The tolerance on the residual is loosened such that
+    // the absolute accuracy is the same as when starting from zero, which is
+    // where the saving in iterations comes from.
+
+    std::vector<double> x0(next_index, 0.0);
+    bool have_x0 = false;
+
+    for (i = 0; i < _initial_guess.size() && i < vars; i++)
+    {
+        if (variable_index[i] != (uint)-1 && std::isfinite(_initial_guess[i]))
+        {
+            x0[variable_index[i]] = _initial_guess[i] / scaling[variable_index[i]];
+            have_x0 = true;
+        }
+    }
+
+    // Threads for all matrix products of this solve, started once instead of for every LSQR iteration.
+    // Small systems are done in the calling thread.
+    Neuland::ParallelForPool pool(_pair_data.size() >= 2 * SSPLLQ_MIN_ROWS_PER_THREAD ? _num_threads : 1);
+    _pool = &pool;
+
+    // Residual tolerance relative to |b|.  Warm started, LSQR sees the right hand side
+    // r0 = b - A*x0 instead, so the relative tolerance is scaled by |b|/|r0| to keep the
+    // same absolute accuracy (capped at 0.5, and never tightened).
+    double rel_rhs_err = 1.0e-10;
+
+    if (have_x0)
+    {
+        double b_norm = dvec_norm2(_in->rhs_vec);
+
+        dvec x0_vec;
+        x0_vec.length = next_index;
+        x0_vec.elements = x0.data();
+
+        dvec_scale((-1.0), _in->rhs_vec);
+        mult_forw(&x0_vec, _in->rhs_vec);
+        dvec_scale((-1.0), _in->rhs_vec);
+
+        double r0_norm = dvec_norm2(_in->rhs_vec);
+
+        if (r0_norm > 0 && r0_norm < b_norm)
+            rel_rhs_err = std::min(0.5, rel_rhs_err * b_norm / r0_norm);
+    }
+
     // Select solution parameters
 
     _in->num_rows = _pair_data.size();
     _in->num_cols = next_index;
     _in->damp_val = 0.0;        // we want damping (i.e. in this case average of all solution vars = 0)
     _in->rel_mat_err = 1.0e-10; // TODO: these should be set to something reasonable
-    _in->rel_rhs_err = 1.0e-10; // TODO: these should be set to something reasonable
+    _in->rel_rhs_err = rel_rhs_err;
     _in->cond_lim = 0.0;        // 10.0 * act_mat_cond_num;
     _in->max_iter = _in->num_rows + _in->num_cols + 50;
 
@@ -521,6 +628,8 @@ bool sparse_sync_pair_llq::solve(uint max_vars, bool add_eqn_for_each_set)
 
     sparse_linear_least_squares::solve();
 
+    _pool = NULL;
+
     // Now we need to get the solution out.  This means
     // to reverse the re-indexing operation, and to perform
     // the scaling.
@@ -534,7 +643,7 @@ bool sparse_sync_pair_llq::solve(uint max_vars, bool add_eqn_for_each_set)
         {
             int j = variable_index[i];
 
-            double val = _out->sol_vec->elements[j];
+            double val = _out->sol_vec->elements[j] + x0[j];
             double std_err = _out->std_err_vec->elements[j];
             double scale = scaling[j];
 
@@ -545,34 +654,62 @@ bool sparse_sync_pair_llq::solve(uint max_vars, bool add_eqn_for_each_set)
 
     release();
 
+    _rows.clear();
+    _cols.clear();
+
     return true;
 }
 
+// y = y + A*x.  Every row (pair) only writes its own element of y, so the
+// rows can be split over threads.
+
 void sparse_sync_pair_llq::mult_forw(dvec* vx, dvec* vy)
 {
-    uint r;
-
-    double* x = vx->elements;
+    const double* x = vx->elements;
     double* y = vy->elements;
 
-    for (r = 0; r < _pair_data.size(); r++)
-        *(y++) += (x[_pair_data[r]._ind1] * _pair_data[r]._coeff1) + (x[_pair_data[r]._ind2] * _pair_data[r]._coeff2);
+    const UInt_t* row_start = _rows._row_start.data();
+    const UInt_t* col = _rows._col.data();
+    const double* coeff = _rows._coeff.data();
+
+    auto rows = [&](size_t begin, size_t end) {
+        for (size_t r = begin; r < end; r++)
+        {
+            double sum = 0;
+            for (UInt_t k = row_start[r]; k < row_start[r + 1]; k++)
+                sum += x[col[k]] * coeff[k];
+            y[r] += sum;
+        }
+    };
+
+    if (_pool)
+        _pool->Run(_pair_data.size(), rows, SSPLLQ_MIN_ROWS_PER_THREAD);
+    else
+        Neuland::ParallelFor(_pair_data.size(), _num_threads, rows, SSPLLQ_MIN_ROWS_PER_THREAD);
 }
 
+// x = x + A^T*y.  Done on the transposed storage, such that every thread
+// writes to its own range of x, without any need for locking.
+
 void sparse_sync_pair_llq::mult_backw(dvec* vx, dvec* vy)
 {
-    uint r;
-
     double* x = vx->elements;
-    double* y = vy->elements;
+    const double* y = vy->elements;
 
-    for (r = 0; r < _pair_data.size(); r++)
-    {
-        x[_pair_data[r]._ind1] += (*y) * _pair_data[r]._coeff1;
-        x[_pair_data[r]._ind2] += (*y) * _pair_data[r]._coeff2;
+    const UInt_t* row_start = _cols._row_start.data();
+    const UInt_t* col = _cols._col.data();
+    const double* coeff = _cols._coeff.data();
 
-        y++;
-    }
+    auto vars = [&](size_t begin, size_t end) {
+        for (size_t c = begin; c < end; c++)
+            for (UInt_t k = row_start[c]; k < row_start[c + 1]; k++)
+                x[c] += y[col[k]] * coeff[k];
+    };
+
+    if (_pool)
+        _pool->Run(_active_vars, vars, SSPLLQ_MIN_ROWS_PER_THREAD);
+    else
+        Neuland::ParallelFor(_active_vars, _num_threads, vars, SSPLLQ_MIN_ROWS_PER_THREAD);
 }
 
 bool sparse_sync_pair_llq_mean_zero::solve(uint max_vars) { return sparse_sync_pair_llq::solve(max_vars, true); }
@@ -21,6 +21,11 @@
 #include "string.h"
 #include "vector"
 
+namespace Neuland
+{
+    class ParallelForPool;
+}
+
 #define CMS_OK 0
 #define CMS_TOO_LITTLE_DATA 1
 #define CMS_TOO_MUCH_NOISE 2
@@ -100,6 +105,29 @@ struct sspllq_pair_sync
     double _coeff2;
 };
 
+/** \brief Compressed sparse row storage of a matrix.
+ *
+ * Row r holds the entries _coeff[k] in the columns _col[k] for
+ * _row_start[r] <= k < _row_start[r+1].  Storing the transposed
+ * matrix the same way gives the compressed sparse column form.
+ */
+struct sspllq_csr
+{
+    std::vector<UInt_t> _row_start;
+    std::vector<UInt_t> _col;
+    std::vector<double> _coeff;
+
+    void clear()
+    {
+        _row_start.clear();
+        _col.clear();
+        _coeff.clear();
+    }
+
+    /// Build from the pair list, either as is (rows are pairs) or transposed (rows are variables).
+    void build(const std::vector<sspllq_pair_sync>& pairs, UInt_t num_vars, bool transpose);
+};
+
 class sparse_linear_least_squares
 {
 
@@ -177,6 +205,13 @@ class auto_ptr_free
 class sparse_sync_pair_llq : public sparse_linear_least_squares
 {
   public:
+    sparse_sync_pair_llq()
+        : _active_vars(0)
+        , _num_threads(0)
+        , _pool(NULL)
+    {
+    }
+
   public:
     std::vector<sspllq_pair_sync> _pair_data;
     std::vector<double> _pair_rhs;
@@ -185,9 +220,27 @@ class sparse_sync_pair_llq : public sparse_linear_least_squares
 
     UInt_t _active_vars;
 
+    /// Initial guess of the solution, indexed like _solution.  Empty or NaN entries
+    /// mean no guess (0).  Typically the values of the previous calibration.
+    std::vector<double> _initial_guess;
+
+    /// Threads used for the matrix products, 0 for all available cores.
+    UInt_t _num_threads;
+
+  protected:
+    /// The (scaled) equation system, rows are pairs, for mult_forw.
+    sspllq_csr _rows;
+    /// The transposed system, rows are variables, for mult_backw.
+    sspllq_csr _cols;
+    /// Threads for the matrix products, only during solve().
+    Neuland::ParallelForPool* _pool;
+
   public:
     void add_sync_pair(int ind1, double coeff1, int ind2, double coeff2, double rhs);
 
+    void set_initial_guess(const std::vector<double>& guess) { _initial_guess = guess; }
+    void set_num_threads(UInt_t n) { _num_threads = n; }
+
     bool solve(UInt_t max_vars, bool add_eqn_for_each_set = false);
 
   public:
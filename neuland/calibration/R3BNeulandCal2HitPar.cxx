@@ -19,6 +19,8 @@
 #include "R3BNeulandCal2HitPar.h"
 #include "FairLogger.h"
 #include "FairRuntimeDb.h"
+#include "Math/MinimizerOptions.h"
+#include "ParallelFor.h"
 #include "R3BLandCosmic1Util.h"
 #include "R3BNeulandCalData.h"
 #include "R3BNeulandHitModulePar.h"
@@ -28,7 +30,11 @@
 #include "TGraph.h"
 #include "TH1F.h"
 #include "TMath.h"
+#include "TObjArray.h"
+#include "TROOT.h"
 #include "TVector3.h"
+#include <array>
+#include <vector>
 
 /* About numbering:  LAND is numbered in x from high x to low x
  * and in y from low y to high y.  Same applies to the VETO.
@@ -70,6 +76,182 @@ const Double_t MINIMUM_IONIZING = 2.30; // vadim 1.15 ???
 
 using namespace std;
 
+namespace
+{
+    // Synchronization of each bar from existing module parameters. The time offsets of the two PMTs are +-tdiff -
+    // tsync, i.e. tsync = -(t1 + t2) / 2. NaN if a bar has no complete parameters.
+    std::vector<Double_t> GetPreviousTimeSync(R3BNeulandHitPar* par, const Int_t nBars)
+    {
+        std::vector<Double_t> tsync(nBars, 0.);
+        std::vector<Int_t> nSides(nBars, 0);
+
+        for (Int_t i = 0; i < par->GetNumModulePar(); i++)
+        {
+            const R3BNeulandHitModulePar* modpar = par->GetModuleParAt(i);
+            const Int_t id = modpar->GetModuleId() - 1;
+            if (id < 0 || id >= nBars || !TMath::Finite(modpar->GetTimeOffset()))
+                continue;
+            tsync[id] -= 0.5 * modpar->GetTimeOffset();
+            nSides[id]++;
+        }
+
+        for (Int_t id = 0; id < nBars; id++)
+            if (nSides[id] != 2)
+                tsync[id] = NAN;
+
+        return tsync;
+    }
+
+    // Outcome of the synchronization of a single plane
+    enum PlaneSync : Char_t
+    {
+        kSyncAnchored, // Aligned to the previous synchronization of its neighbours
+        kSyncMeanZero, // No previously calibrated neighbour, the mean of the plane is set to zero
+        kSyncFailed    // Parts of the plane can not be aligned to each other, the plane is not calibrated
+    };
+
+    /* Synchronizes each selected plane on its own, using only the bars within the plane. Only
+     * neighbouring bars are linked, so a dead or low-statistics bar splits the plane into pieces
+     * that are solved separately. The free offset of each piece is taken from the cross-plane
+     * mean differences to neighbouring planes that are not recalibrated, using their previous
+     * synchronization. Single bars without such a reference are left unsynchronized (NaN). If the
+     * whole plane is one piece without reference, its mean is set to zero. If there are several
+     * pieces and one of them has no reference, the plane can not be synchronized (kSyncFailed).
+     */
+    std::vector<Char_t> SyncPlanesIndependently(const Int_t nPlanes,
+                                                const Int_t nPaddles,
+                                                const UInt_t nThreads,
+                                                const std::vector<Bool_t>& calibPlane,
+                                                const std::vector<std::vector<val_err_inv>>& within,
+                                                const std::vector<std::vector<std::vector<val_err_inv>>>& cross,
+                                                const std::vector<Double_t>& prevTSync,
+                                                std::vector<std::vector<std::array<Double_t, 2>>>& tsync)
+    {
+        // Not std::vector<bool>, the planes are written concurrently
+        std::vector<Char_t> status(nPlanes, kSyncAnchored);
+
+        auto prev = [&](Int_t pl, Int_t pdl) {
+            return prevTSync.empty() ? (Double_t)NAN : prevTSync[pl * nPaddles + pdl];
+        };
+        auto linked = [&](Int_t pl, Int_t pdl) {
+            return TMath::Finite(within[pl][pdl]._e2_inv) && within[pl][pdl]._e2_inv > 0;
+        };
+
+        Neuland::ParallelForEach(nPlanes, nThreads, [&](size_t p) {
+            const Int_t pl = p;
+            for (Int_t pdl = 0; pdl < nPaddles; pdl++)
+                tsync[pl][pdl].fill(NAN);
+
+            if (!calibPlane[pl])
+                return;
+
+            // The pieces are runs of linked neighbouring bars [first, last]
+            std::vector<std::array<Int_t, 2>> pieces;
+            for (Int_t first = 0, last = 0; first < nPaddles; first = ++last)
+            {
+                while (last < nPaddles - 1 && linked(pl, last))
+                    last++;
+                pieces.push_back({ first, last });
+            }
+
+            Int_t nMultiBar = 0;
+            for (const auto& piece : pieces)
+                if (piece[1] > piece[0])
+                    nMultiBar++;
+
+            for (const auto& piece : pieces)
+            {
+                const Int_t first = piece[0];
+                const Int_t nBars = piece[1] - first + 1;
+
+                // A single bar is its own reference, without error
+                std::vector<val_err_inv> sol(1);
+                sol[0]._val = 0.;
+                sol[0]._e2_inv = INFINITY;
+
+                if (nBars > 1)
+                {
+                    sparse_sync_pair_llq_mean_zero syncer_t;
+                    syncer_t.set_num_threads(1);
+
+                    for (Int_t i = 0; i < nBars - 1; i++)
+                    {
+                        const val_err_inv& diff = within[pl][first + i];
+                        Double_t weight = sqrt(diff._e2_inv);
+                        syncer_t.add_sync_pair(i, -weight, i + 1, weight, diff._val * weight);
+                    }
+
+                    syncer_t.solve(nBars);
+                    sol = syncer_t._solution;
+                }
+
+                // Each cross-plane mean difference to a fixed neighbour gives one estimate of the offset
+                Double_t sum = 0;
+                Double_t sumw = 0;
+                auto addOffset = [&](const val_err_inv& diff, Double_t offset) {
+                    if (TMath::Finite(diff._e2_inv) && diff._e2_inv > 0 && TMath::Finite(offset))
+                    {
+                        sum += offset * diff._e2_inv;
+                        sumw += diff._e2_inv;
+                    }
+                };
+
+                for (Int_t i = 0; i < nBars; i++)
+                {
+                    const Int_t pdl = first + i;
+
+                    if (pl > 0 && !calibPlane[pl - 1])
+                        for (Int_t pdl1 = 0; pdl1 < nPaddles; pdl1++)
+                        {
+                            const val_err_inv& diff = cross[pl - 1][pdl1][pdl];
+                            addOffset(diff, prev(pl - 1, pdl1) + diff._val - sol[i]._val);
+                        }
+
+                    if (pl < nPlanes - 1 && !calibPlane[pl + 1])
+                        for (Int_t pdl2 = 0; pdl2 < nPaddles; pdl2++)
+                        {
+                            const val_err_inv& diff = cross[pl][pdl][pdl2];
+                            addOffset(diff, prev(pl + 1, pdl2) - diff._val - sol[i]._val);
+                        }
+                }
+
+                Double_t offset = 0.;
+                Double_t offset_e2 = 0.;
+                if (sumw > 0)
+                {
+                    offset = sum / sumw;
+                    offset_e2 = 1. / sumw;
+                }
+                else if (nBars == 1)
+                {
+                    continue;
+                }
+                else if (nMultiBar == 1)
+                {
+                    status[pl] = kSyncMeanZero;
+                }
+                else
+                {
+                    status[pl] = kSyncFailed;
+                    break;
+                }
+
+                for (Int_t i = 0; i < nBars; i++)
+                {
+                    tsync[pl][first + i][0] = sol[i]._val + offset;
+                    tsync[pl][first + i][1] = sqrt(1 / sol[i]._e2_inv + offset_e2);
+                }
+            }
+
+            if (status[pl] == kSyncFailed)
+                for (Int_t pdl = 0; pdl < nPaddles; pdl++)
+                    tsync[pl][pdl].fill(NAN);
+        });
+
+        return status;
+    }
+} // namespace
+
 bool n_calib_mean::calc_params(ident_no_set& bad_fit_idents, val_err_inv& mean)
 {
     Double_t sum = 0, sum_x = 0, sum_x2 = 0;
@@ -992,82 +1174,116 @@ void R3BNeulandCal2HitPar::FinishTask()
 {
     LOG(INFO) << "R3BNeulandCal2HitPar::FinishTask : " << nData << " Events registered.";
 
-    LOG(INFO) << "R3BNeulandCal2HitPar::FinishTask : "
-              << "**************TIMES**************";
+    // Planes to (re)calibrate. In plane mode, all other planes keep their previous parameters.
+    std::vector<Bool_t> calibPlane(fPlanes, fCalibPlanes.empty());
+    for (const auto plane : fCalibPlanes)
+        if (plane >= 1 && plane <= fPlanes)
+            calibPlane[plane - 1] = kTRUE;
 
-    LOG(INFO) << "R3BNeulandCal2HitPar::FinishTask : "
-              << "Analysing history: t-diff";
+    const UInt_t nThreads = Neuland::NumberOfThreads(fNumThreads);
+    if (nThreads > 1)
+    {
+        ROOT::EnableThreadSafety();
+        LOG(INFO) << "R3BNeulandCal2HitPar::FinishTask : "
+                  << "Using " << nThreads << " threads";
+    }
 
-    for (Int_t pl = 0; pl < fPlanes; pl++)
-        for (Int_t pdl = 0; pdl < fPaddles; pdl++)
-            _collect_diff[pl][pdl].analyse_history(_bad_fit_idents);
+    // The fits below may run concurrently. TMinuit, the default minimizer, uses a global instance, so Minuit2 is
+    // used in any case, such that the result does not depend on the number of threads
+    const std::string prevMinimizerType = ROOT::Math::MinimizerOptions::DefaultMinimizerType();
+    const std::string prevMinimizerAlgo = ROOT::Math::MinimizerOptions::DefaultMinimizerAlgo();
+    ROOT::Math::MinimizerOptions::SetDefaultMinimizer("Minuit2");
 
-    LOG(INFO) << "R3BNeulandCal2HitPar::FinishTask : "
-              << "Analysing history: t-mean-within";
+    // Previous synchronization, used as starting point (warm start) and as reference for plane mode
+    std::vector<Double_t> prevTSync;
+    if (fWarmStart || !fCalibPlanes.empty())
+        prevTSync = GetPreviousTimeSync(fPar, fPlanes * fPaddles);
 
-    for (Int_t pl = 0; pl < fPlanes; pl++)
-        for (Int_t pdl = 0; pdl < fPaddles - 1; pdl++)
-        {
-            LOG(DEBUG) << "================== mean: " << pl << ",(" << pdl << "-" << pdl + 1 << ")";
-            _collect_mean_within[pl][pdl].analyse_history(_bad_fit_idents);
-        }
+    LOG(INFO) << "R3BNeulandCal2HitPar::FinishTask : "
+              << "**************TIMES**************";
 
     LOG(INFO) << "R3BNeulandCal2HitPar::FinishTask : "
-              << "Analysing history: t-mean-cross";
+              << "Analysing history: t-diff, t-mean-within, t-mean-cross";
 
-    for (Int_t pl = 0; pl < fPlanes - 1; pl++)
-        for (Int_t pdl1 = 0; pdl1 < fPaddles; pdl1++)
-            for (Int_t pdl2 = 0; pdl2 < fPaddles; pdl2++)
+    // Each plane collects its suspicious events separately, the sets are merged afterwards.
+    // The union does not depend on the order, so neither does the result.
+    {
+        std::vector<ident_no_set> bad_fit_idents(fPlanes);
+
+        Neuland::ParallelForEach(fPlanes, nThreads, [&](size_t pl) {
+            if (calibPlane[pl])
             {
-                LOG(DEBUG) << "================== mean: (" << pl << "," << pdl1 << ")-(" << pl + 1 << "," << pdl2
-                           << ")";
-                _collect_mean_cross[pl][pdl1][pdl2].analyse_history(_bad_fit_idents);
+                for (Int_t pdl = 0; pdl < fPaddles; pdl++)
+                    _collect_diff[pl][pdl].analyse_history(bad_fit_idents[pl]);
+
+                for (Int_t pdl = 0; pdl < fPaddles - 1; pdl++)
+                    _collect_mean_within[pl][pdl].analyse_history(bad_fit_idents[pl]);
             }
 
-    LOG(INFO) << "R3BNeulandCal2HitPar::FinishTask : "
-              << "Collecting and fitting history: t-diff";
+            if (pl < (size_t)fPlanes - 1 && (calibPlane[pl] || calibPlane[pl + 1]))
+                for (Int_t pdl1 = 0; pdl1 < fPaddles; pdl1++)
+                    for (Int_t pdl2 = 0; pdl2 < fPaddles; pdl2++)
+                        _collect_mean_cross[pl][pdl1][pdl2].analyse_history(bad_fit_idents[pl]);
+        });
 
-    Double_t tdiff[fPlanes][fPaddles][3];
-    Double_t invveff[fPlanes][fPaddles][2];
+        for (const auto& idents : bad_fit_idents)
+            _bad_fit_idents.insert(idents.begin(), idents.end());
+    }
 
-    for (Int_t pl = 0; pl < fPlanes; pl++)
-        for (Int_t pdl = 0; pdl < fPaddles; pdl++)
-            _collect_diff[pl][pdl].calc_params(_bad_fit_idents, tdiff[pl][pdl], invveff[pl][pdl]);
+    LOG(INFO) << "R3BNeulandCal2HitPar::FinishTask : "
+              << "Collecting and fitting history: t-diff, t-mean-within, t-mean-cross";
 
-    val_err_inv mean_diff_within_t[fPlanes][fPaddles - 1];
-    val_err_inv mean_diff_cross_t[fPlanes - 1][fPaddles][fPaddles];
+    std::vector<std::vector<std::array<Double_t, 3>>> tdiff(fPlanes, std::vector<std::array<Double_t, 3>>(fPaddles));
+    std::vector<std::vector<std::array<Double_t, 2>>> invveff(fPlanes,
+                                                              std::vector<std::array<Double_t, 2>>(fPaddles));
 
-    LOG(INFO) << "R3BNeulandCal2HitPar::FinishTask : "
-              << "Collecting history: t-mean-within";
+    std::vector<std::vector<val_err_inv>> mean_diff_within_t(fPlanes, std::vector<val_err_inv>(fPaddles - 1));
+    std::vector<std::vector<std::vector<val_err_inv>>> mean_diff_cross_t(
+        fPlanes - 1, std::vector<std::vector<val_err_inv>>(fPaddles, std::vector<val_err_inv>(fPaddles)));
 
     /* this calcs a mean_diff from all the data stored in _collect_mean_within
     and stores the mean in mean_diff_within_t
     */
 
-    for (Int_t pl = 0; pl < fPlanes; pl++)
-        for (Int_t pdl = 0; pdl < fPaddles - 1; pdl++)
+    Neuland::ParallelForEach(fPlanes * fPaddles, nThreads, [&](size_t i) {
+        const Int_t pl = i / fPaddles;
+        const Int_t pdl = i % fPaddles;
+
+        tdiff[pl][pdl].fill(NAN);
+        invveff[pl][pdl].fill(NAN);
+        if (pdl < fPaddles - 1)
+            mean_diff_within_t[pl][pdl].set_nan();
+        if (pl < fPlanes - 1)
+            for (Int_t pdl2 = 0; pdl2 < fPaddles; pdl2++)
+                mean_diff_cross_t[pl][pdl][pdl2].set_nan();
+
+        if (calibPlane[pl])
         {
-            LOG(DEBUG) << "================== mean: " << pl << ",(" << pdl << "-" << pdl + 1 << ")";
-            _collect_mean_within[pl][pdl].calc_params(_bad_fit_idents, mean_diff_within_t[pl][pdl]);
-        }
+            _collect_diff[pl][pdl].calc_params(_bad_fit_idents, tdiff[pl][pdl].data(), invveff[pl][pdl].data());
 
-    LOG(INFO) << "R3BNeulandCal2HitPar::FinishTask : "
-              << "Collecting history: t-mean-cross";
+            if (pdl < fPaddles - 1)
+                _collect_mean_within[pl][pdl].calc_params(_bad_fit_idents, mean_diff_within_t[pl][pdl]);
+        }
 
-    for (Int_t pl = 0; pl < fPlanes - 1; pl++)
-        for (Int_t pdl1 = 0; pdl1 < fPaddles; pdl1++)
+        if (pl < fPlanes - 1 && (calibPlane[pl] || calibPlane[pl + 1]))
             for (Int_t pdl2 = 0; pdl2 < fPaddles; pdl2++)
-            {
-                LOG(DEBUG) << "================== mean: (" << pl << "," << pdl1 << ")-(" << pl + 1 << "," << pdl2
-                           << ")";
-                _collect_mean_cross[pl][pdl1][pdl2].calc_params(_bad_fit_idents, mean_diff_cross_t[pl][pdl1][pdl2]);
-            }
+                _collect_mean_cross[pl][pdl][pdl2].calc_params(_bad_fit_idents, mean_diff_cross_t[pl][pdl][pdl2]);
+    });
 
     LOG(INFO) << "R3BNeulandCal2HitPar::FinishTask : "
               << "Syncing: t-mean";
-    Double_t tsync[fPlanes][fPaddles][2];
+    std::vector<std::vector<std::array<Double_t, 2>>> tsync(fPlanes, std::vector<std::array<Double_t, 2>>(fPaddles));
+    if (fCalibPlanes.empty())
     {
         sparse_sync_pair_llq_mean_zero syncer_t;
+        syncer_t.set_num_threads(nThreads);
+
+        if (fWarmStart)
+        {
+            LOG(INFO) << "R3BNeulandCal2HitPar::FinishTask : "
+                      << "Starting time sync from previous parameters";
+            syncer_t.set_initial_guess(prevTSync);
+        }
 
         /* time_ind will be zero if it cannot be determined, and otherwise
         indexed beginning at one.  One then add fPlanes_use-2 to get th
@@ -1123,47 +1339,76 @@ void R3BNeulandCal2HitPar::FinishTask()
                 tsync[pl][pdl][1] = 1 / sqrt(syncer_t._solution[pl * fPaddles + pdl]._e2_inv);
             }
     }
-    LOG(INFO) << "R3BNeulandCal2HitPar::FinishTask : "
-              << "*************ENERGIES************";
+    else
+    {
+        LOG(INFO) << "R3BNeulandCal2HitPar::FinishTask : "
+                  << "Syncing planes independently";
 
-    Double_t ecal[fPlanes][fPaddles][2];
-    Double_t ecalerr[fPlanes][fPaddles][2];
-    TF1 gausfit = TF1("Gaus", "gaus", 0, 200);
-    TF1 linearfit = TF1("linear", "[1]*x+[0]");
+        const auto status = SyncPlanesIndependently(
+            fPlanes, fPaddles, nThreads, calibPlane, mean_diff_within_t, mean_diff_cross_t, prevTSync, tsync);
 
-    for (Int_t pl = 0; pl < fPlanes; pl++)
-        for (Int_t pdl = 0; pdl < fPaddles; pdl++)
-        {
-            TH1F* histo = _ecalhistos[pl][pdl];
-            if (histo->GetEntries() < 1000)
+        for (Int_t pl = 0; pl < fPlanes; pl++)
+            if (calibPlane[pl] && status[pl] == kSyncMeanZero)
             {
-                ecal[pl][pdl][0] = NAN;
-                ecal[pl][pdl][1] = NAN;
-                ecalerr[pl][pdl][0] = NAN;
-                ecalerr[pl][pdl][1] = NAN;
-                continue;
+                LOG(WARNING) << "R3BNeulandCal2HitPar::FinishTask : Plane " << pl + 1
+                             << " has no previously calibrated neighbour, its mean time offset is set to zero!";
+            }
+            else if (calibPlane[pl] && status[pl] == kSyncFailed)
+            {
+                // Keep the previous parameters of this plane
+                LOG(ERROR) << "R3BNeulandCal2HitPar::FinishTask : Plane " << pl + 1
+                           << " is split by dead bars and can not be aligned to its neighbours, it is not calibrated!";
+                calibPlane[pl] = kFALSE;
             }
+    }
 
-            Double_t max = histo->GetBinCenter(histo->GetMaximumBin());
-            gausfit.SetParameter(1, max);
-            histo->Fit(&gausfit, "qn", "", max - 5, max + 5);
-            Double_t k0k1 = gausfit.GetParameter(1) * gausfit.GetParameter(1);
-            Double_t k0k1err = 2 * gausfit.GetParameter(1) * gausfit.GetParError(1);
+    LOG(INFO) << "R3BNeulandCal2HitPar::FinishTask : "
+              << "*************ENERGIES************";
 
-            _ecalgraphs[pl][pdl]->Fit(&linearfit, "q");
-            Double_t k0dk1 = exp(linearfit.GetParameter(0));
-            Double_t k0dk1err = k0dk1 * linearfit.GetParError(0);
+    std::vector<std::vector<std::array<Double_t, 2>>> ecal(fPlanes, std::vector<std::array<Double_t, 2>>(fPaddles));
+    std::vector<std::vector<std::array<Double_t, 2>>> ecalerr(fPlanes,
+                                                              std::vector<std::array<Double_t, 2>>(fPaddles));
 
-            ecal[pl][pdl][0] = MINIMUM_IONIZING / sqrt(k0k1 * k0dk1);
-            ecal[pl][pdl][1] = MINIMUM_IONIZING / sqrt(k0k1 / k0dk1);
+    Neuland::ParallelForEach(fPlanes * fPaddles, nThreads, [&](size_t i) {
+        const Int_t pl = i / fPaddles;
+        const Int_t pdl = i % fPaddles;
 
-            ecalerr[pl][pdl][0] = MINIMUM_IONIZING * pow(k0k1 * k0dk1, -1.5) *
-                                  sqrt((k0dk1 * k0k1err) * (k0dk1 * k0k1err) + (k0k1 * k0dk1err) * (k0k1 * k0dk1err));
-            ecalerr[pl][pdl][1] = MINIMUM_IONIZING * pow(k0k1 / k0dk1, -1.5) *
-                                  sqrt((k0k1err / k0dk1) * (k0k1err / k0dk1) +
-                                       ((k0k1 * k0dk1err / (k0dk1 * k0dk1)) * (k0k1 * k0dk1err / (k0dk1 * k0dk1))));
+        TH1F* histo = _ecalhistos[pl][pdl];
+        if (!calibPlane[pl] || histo->GetEntries() < 1000)
+        {
+            ecal[pl][pdl][0] = NAN;
+            ecal[pl][pdl][1] = NAN;
+            ecalerr[pl][pdl][0] = NAN;
+            ecalerr[pl][pdl][1] = NAN;
+            return;
         }
 
+        // One set of fit functions per bar, such that bars can be fitted concurrently
+        TF1 gausfit = TF1("Gaus", "gaus", 0, 200);
+        TF1 linearfit = TF1("linear", "[1]*x+[0]");
+
+        Double_t max = histo->GetBinCenter(histo->GetMaximumBin());
+        gausfit.SetParameter(1, max);
+        histo->Fit(&gausfit, "qn", "", max - 5, max + 5);
+        Double_t k0k1 = gausfit.GetParameter(1) * gausfit.GetParameter(1);
+        Double_t k0k1err = 2 * gausfit.GetParameter(1) * gausfit.GetParError(1);
+
+        _ecalgraphs[pl][pdl]->Fit(&linearfit, "q");
+        Double_t k0dk1 = exp(linearfit.GetParameter(0));
+        Double_t k0dk1err = k0dk1 * linearfit.GetParError(0);
+
+        ecal[pl][pdl][0] = MINIMUM_IONIZING / sqrt(k0k1 * k0dk1);
+        ecal[pl][pdl][1] = MINIMUM_IONIZING / sqrt(k0k1 / k0dk1);
+
+        ecalerr[pl][pdl][0] = MINIMUM_IONIZING * pow(k0k1 * k0dk1, -1.5) *
+                              sqrt((k0dk1 * k0k1err) * (k0dk1 * k0k1err) + (k0k1 * k0dk1err) * (k0k1 * k0dk1err));
+        ecalerr[pl][pdl][1] = MINIMUM_IONIZING * pow(k0k1 / k0dk1, -1.5) *
+                              sqrt((k0k1err / k0dk1) * (k0k1err / k0dk1) +
+                                   ((k0k1 * k0dk1err / (k0dk1 * k0dk1)) * (k0k1 * k0dk1err / (k0dk1 * k0dk1))));
+    });
+
+    ROOT::Math::MinimizerOptions::SetDefaultMinimizer(prevMinimizerType.c_str(), prevMinimizerAlgo.c_str());
+
     TH1F* h_tdiff = new TH1F("h_land_diffc", "TDiff vs BarID", fPaddles * fPlanes, 0.5, 0.5 + fPaddles * fPlanes);
     h_tdiff->SetMaximum(200);
     h_tdiff->SetMinimum(-200);
@@ -1194,6 +1439,23 @@ void R3BNeulandCal2HitPar::FinishTask()
     std::vector<TString> fails;
     std::vector<TString> susp_s;
 
+    if (fWarmStart || !fCalibPlanes.empty())
+    {
+        // The previous parameters of the (re)calibrated planes are replaced by the new ones
+        TObjArray* modpars = fPar->GetListOfModulePar();
+        for (Int_t i = 0; i < modpars->GetEntriesFast(); i++)
+        {
+            R3BNeulandHitModulePar* modpar = (R3BNeulandHitModulePar*)modpars->At(i);
+            const Int_t pl = (modpar->GetModuleId() - 1) / fPaddles;
+            if (pl >= 0 && pl < fPlanes && calibPlane[pl])
+            {
+                modpars->RemoveAt(i);
+                delete modpar;
+            }
+        }
+        modpars->Compress();
+    }
+
     Bool_t calib[fPlanes][fPaddles];
     memset(calib, 0, sizeof(calib));
 
@@ -1206,6 +1468,9 @@ void R3BNeulandCal2HitPar::FinishTask()
         for (Int_t pdl = 0; pdl < fPaddles; pdl++)
             for (Int_t pm = 0; pm < 2; pm++)
             {
+                if (!calibPlane[pl])
+                    continue;
+
                 R3BNeulandHitModulePar* syncmodpar = new R3BNeulandHitModulePar();
                 syncmodpar->SetModuleId(pl * fPaddles + pdl + 1);
                 syncmodpar->SetSide(pm + 1);
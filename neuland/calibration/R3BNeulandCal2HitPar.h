@@ -21,6 +21,7 @@
 
 #include "FairTask.h"
 #include <set>
+#include <vector>
 
 struct val_err_inv;
 
@@ -114,12 +115,27 @@ class R3BNeulandCal2HitPar : public FairTask
     // Min QDC for Event
     inline void SetMinEventQDC(Int_t i) { fMinEventQDC = i; }
 
+    // Start the time synchronization from the parameters already present in the
+    // NeulandHitPar container (e.g. from the previous run), which are replaced
+    inline void SetWarmStart(Bool_t b = kTRUE) { fWarmStart = b; }
+
+    // Number of threads for the calibration at the end of the run, 0 for all cores. Default is 1
+    inline void SetNumThreads(UInt_t n) { fNumThreads = n; }
+
+    // Only (re)calibrate the given planes (counting from 1), e.g. after HV changes. The planes are
+    // synchronized on their own and aligned to the previous parameters of their neighbours.
+    // All other planes keep their parameters from the NeulandHitPar container.
+    inline void SetCalibratePlanes(const std::vector<Int_t>& planes) { fCalibPlanes = planes; }
+
   private:
     Int_t fPlanes = 60;
     Int_t fPaddles = 50;
     Float_t fDeviationTH = 20.0;
     Float_t fErrorTH = 2.0;
     Int_t fMinEventQDC = 100;
+    Bool_t fWarmStart = kFALSE;
+    UInt_t fNumThreads = 1;
+    std::vector<Int_t> fCalibPlanes;
 
     TClonesArray* fLandPmt;
     R3BNeulandHitPar* fPar;
@@ -74,6 +74,7 @@ InitStatus R3BNeulandMapped2Cal::Init()
     }
 
     LOG(INFO) << "R3BNeulandMapped2Cal::Init : read " << fNofTcalPars << " calibrated modules";
+    fTcalLookup.Build(fTcalPar, R3BNeulandTCalLookup::Electronics::VFTX);
 
     FairRootManager* mgr = FairRootManager::Instance();
     if (NULL == mgr)
@@ -118,6 +119,10 @@ void R3BNeulandMapped2Cal::SetParContainers()
 InitStatus R3BNeulandMapped2Cal::ReInit()
 {
     SetParContainers();
+    if (fTcalPar)
+    {
+        fTcalLookup.Build(fTcalPar, R3BNeulandTCalLookup::Electronics::VFTX);
+    }
     return kSUCCESS;
 }
 
@@ -157,8 +162,6 @@ void R3BNeulandMapped2Cal::MakeCal()
 {
     Int_t nHits = fMapped->GetEntriesFast();
 
-    R3BTCalModulePar* par;
-
     Int_t tdc;
     Double_t timeLE;
     Double_t timeTE;
@@ -197,24 +200,24 @@ void R3BNeulandMapped2Cal::MakeCal()
         int edge = 2 * iSide - 1;
 
         // Convert TDC to [ns] leading
-        if (!(par = fTcalPar->GetModuleParAt(iPlane, iBar, edge)))
+        if (!fTcalLookup.HasChannel(iPlane, iBar, edge))
         {
             LOG(DEBUG) << "R3BNeulandTcal::Exec : Tcal par not found, barId: " << iBar << ", side: " << iSide;
             continue;
         }
 
         tdc = 1 == iSide ? hit->fFineTime1LE : hit->fFineTime2LE;
-        timeLE = par->GetTimeVFTX(tdc);
+        timeLE = fTcalLookup.GetTime(iPlane, iBar, edge, tdc);
 
         // Convert TDC to [ns] trailing
-        if (!(par = fTcalPar->GetModuleParAt(iPlane, iBar, edge + 1)))
+        if (!fTcalLookup.HasChannel(iPlane, iBar, edge + 1))
         {
             LOG(DEBUG) << "R3BNeulandTcal::Exec : Tcal par not found, barId: " << iBar << ", side: " << iSide;
             continue;
         }
 
         tdc = 1 == iSide ? hit->fFineTime1TE : hit->fFineTime2TE;
-        timeTE = par->GetTimeVFTX(tdc);
+        timeTE = fTcalLookup.GetTime(iPlane, iBar, edge + 1, tdc);
 
         if (timeLE < 0. || timeLE > fClockFreq || timeTE < 0. || timeTE > fClockFreq)
         {
@@ -296,58 +299,52 @@ void R3BNeulandMapped2Cal::FinishTask()
 
 Double_t R3BNeulandMapped2Cal::WalkCorrection(Double_t x)
 {
-    Double_t y = 0;
+    static const Double_t walkval[34] = { 69.5,  // 18
+                                          68.0,  // 22
+                                          67.6,  // 26
+                                          65.6,  // 30
+                                          65.0,  // 34
+                                          63.8,  // 38
+                                          62.9,  // 42
+                                          62.5,  // 46
+                                          62.1,  // 50
+                                          61.8,  // 54
+                                          61.5,  // 58
+                                          61.0,  // 62
+                                          60.85, // 66
+                                          60.7,  // 70
+                                          60.55, // 74
+                                          60.4,  // 78
+                                          60.3,  // 82  60.25
+                                          60.27, // 86  60.4
+                                          60.05, // 90
+                                          60.05, // 94 60.1
+                                          60.0,  // 98
+                                          59.8,  // 102
+                                          59.7,  // 106
+                                          59.6,  // 110
+                                          59.6,  // 114
+                                          59.55, // 118
+                                          59.4,  // 122
+                                          59.4,  // 126
+                                          59.3,  // 130
+                                          59.25, // 134
+                                          59.05, // 138
+                                          59.0,  // 142  58.95
+                                          58.95, 58.91 };
 
     if (x < 0.)
-        return y;
-
-    Double_t walkval[34] = { 69.5,  // 18
-                             68.0,  // 22
-                             67.6,  // 26
-                             65.6,  // 30
-                             65.0,  // 34
-                             63.8,  // 38
-                             62.9,  // 42
-                             62.5,  // 46
-                             62.1,  // 50
-                             61.8,  // 54
-                             61.5,  // 58
-                             61.0,  // 62
-                             60.85, // 66
-                             60.7,  // 70
-                             60.55, // 74
-                             60.4,  // 78
-                             60.3,  // 82  60.25
-                             60.27, // 86  60.4
-                             60.05, // 90
-                             60.05, // 94 60.1
-                             60.0,  // 98
-                             59.8,  // 102
-                             59.7,  // 106
-                             59.6,  // 110
-                             59.6,  // 114
-                             59.55, // 118
-                             59.4,  // 122
-                             59.4,  // 126
-                             59.3,  // 130
-                             59.25, // 134
-                             59.05, // 138
-                             59.0,  // 142  58.95
-                             58.95, 58.91 };
+        return 0.;
 
+    Double_t y;
     if (x < 16.)
         y = 70.5 - x / 4.;
-
-    for (Int_t i = 0; i < 34; i++)
-    {
-
-        if (x >= 16. + 4. * i && x < 20 + 4. * i)
-            y = walkval[i];
-    }
-
-    if (x >= 152. && x < 160.)
+    else if (x < 152.)
+        // Table of 4 ns wide QDC bins, x - 16. is exact here
+        y = walkval[(Int_t)((x - 16.) / 4.)];
+    else if (x < 160.)
         y = 58.9 + 0.08 / 8. * (160. - x);
-    if (x >= 160.)
+    else
         y = 58.55 + 0.3 / 30. * (190. - x);
     // if (x>=160.&&x<190.) y = 58.7 + 0.4/30.*(190.-x);
     // if (x>=190.) y = 58.5;
@@ -15,6 +15,7 @@
 #define R3BNEULANDMAPPED2CAL_H
 
 #include "FairTask.h"
+#include "R3BNeulandTCalLookup.h"
 #include "TH2F.h"
 
 class TClonesArray;
@@ -138,6 +139,7 @@ class R3BNeulandMapped2Cal : public FairTask
 
     R3BTCalPar* fTcalPar; /**< TCAL parameter container. */
     UInt_t fNofTcalPars;  /**< Number of modules in parameter file. */
+    R3BNeulandTCalLookup fTcalLookup; //! Tabulated TCAL times per channel.
 
     R3BEventHeader* header; /**< Event header. */
     Int_t fTrigger;         /**< Trigger value. */
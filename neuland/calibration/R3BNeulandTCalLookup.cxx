@@ -0,0 +1,109 @@
+/******************************************************************************
+ *   Copyright (C) 2019 GSI Helmholtzzentrum für Schwerionenforschung GmbH    *
+ *   Copyright (C) 2019 Members of R3B Collaboration                          *
+ *                                                                            *
+ *             This software is distributed under the terms of the            *
+ *                 GNU General Public Licence (GPL) version 3,                *
+ *                    copied verbatim in the file "LICENSE".                  *
+ *                                                                            *
+ * In applying this license GSI does not waive the privileges and immunities  *
+ * granted to it by virtue of its status as an Intergovernmental Organization *
+ * or submit itself to any jurisdiction.                                      *
+ ******************************************************************************/
+
+#include "R3BNeulandTCalLookup.h"
+#include "R3BTCalModulePar.h"
+#include "R3BTCalPar.h"
+#include "TObjArray.h"
+#include <algorithm>
+
+constexpr UShort_t R3BNeulandTCalLookup::NoBin;
+
+void R3BNeulandTCalLookup::Build(R3BTCalPar* par, Electronics electronics)
+{
+    const TObjArray* modules = par->GetListOfModulePar();
+
+    fNPlanes = fNBars = fNEdges = 0;
+    for (Int_t m = 0; m < modules->GetEntries(); m++)
+    {
+        const auto module = (R3BTCalModulePar*)modules->At(m);
+        if (module != nullptr)
+        {
+            fNPlanes = std::max(fNPlanes, module->GetPlane());
+            fNBars = std::max(fNBars, module->GetPaddle());
+            fNEdges = std::max(fNEdges, module->GetSide());
+        }
+    }
+    fChannels.assign(fNPlanes * fNBars * fNEdges, Channel{ false, 0, {}, {}, {}, {} });
+
+    for (Int_t m = 0; m < modules->GetEntries(); m++)
+    {
+        const auto module = (R3BTCalModulePar*)modules->At(m);
+        if (module == nullptr)
+        {
+            continue;
+        }
+
+        const Int_t index = GetIndex(module->GetPlane(), module->GetPaddle(), module->GetSide());
+        // Like R3BTCalPar::GetModuleParAt, the first container of a channel is used, even if it is empty
+        if (index < 0 || fChannels[index].present)
+        {
+            continue;
+        }
+        auto& channel = fChannels[index];
+        channel.present = true;
+
+        // The parameters map TDC + 1 to the bins
+        const Int_t n = std::min(module->GetNofChannels(), (Int_t)NoBin);
+        if (n <= 0)
+        {
+            continue;
+        }
+        Int_t first = module->GetBinLowAt(0);
+        Int_t last = electronics == Electronics::VFTX ? module->GetBinLowAt(0) : module->GetBinUpAt(0);
+        for (Int_t i = 1; i < n; i++)
+        {
+            first = std::min(first, module->GetBinLowAt(i));
+            last = std::max(last, electronics == Electronics::VFTX ? module->GetBinLowAt(i) : module->GetBinUpAt(i));
+        }
+        if (last < first)
+        {
+            continue;
+        }
+
+        channel.firstTdc = first - 1;
+        channel.bin.assign(last - first + 1, NoBin);
+
+        // Fill backwards, so that the first matching bin wins as in R3BTCalModulePar
+        for (Int_t i = n - 1; i >= 0; i--)
+        {
+            const Int_t low = module->GetBinLowAt(i);
+            const Int_t up = electronics == Electronics::VFTX ? low : module->GetBinUpAt(i);
+            for (Int_t tdc1 = low; tdc1 <= up; tdc1++)
+            {
+                channel.bin[tdc1 - first] = i;
+            }
+        }
+
+        // Keep only the bins that are used, renumbered in TDC order
+        std::vector<UShort_t> used(n, NoBin);
+        for (auto& b : channel.bin)
+        {
+            if (b == NoBin)
+            {
+                continue;
+            }
+            if (used[b] == NoBin)
+            {
+                used[b] = channel.offset.size();
+                channel.offset.push_back(module->GetOffsetAt(b));
+                if (electronics == Electronics::Tacquila)
+                {
+                    channel.slope.push_back(module->GetSlopeAt(b));
+                    channel.low.push_back(module->GetBinLowAt(b));
+                }
+            }
+            b = used[b];
+        }
+    }
+}
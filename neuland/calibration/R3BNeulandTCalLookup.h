@@ -0,0 +1,99 @@
+/******************************************************************************
+ *   Copyright (C) 2019 GSI Helmholtzzentrum für Schwerionenforschung GmbH    *
+ *   Copyright (C) 2019 Members of R3B Collaboration                          *
+ *                                                                            *
+ *             This software is distributed under the terms of the            *
+ *                 GNU General Public Licence (GPL) version 3,                *
+ *                    copied verbatim in the file "LICENSE".                  *
+ *                                                                            *
+ * In applying this license GSI does not waive the privileges and immunities  *
+ * granted to it by virtue of its status as an Intergovernmental Organization *
+ * or submit itself to any jurisdiction.                                      *
+ ******************************************************************************/
+
+#ifndef R3BNEULANDTCALLOOKUP_H
+#define R3BNEULANDTCALLOOKUP_H
+
+#include "Rtypes.h"
+#include <vector>
+
+class R3BTCalPar;
+
+/**
+ * Channel-major lookup of TCAL calibrated times.
+ * For each plane, bar and edge found in the parameter container, every TDC value covered by the parameters is mapped
+ * once to the calibration bin R3BTCalModulePar::GetTimeVFTX or GetTimeTacquila would use. Per TDC value, only a 16 bit
+ * bin index is stored; offset and slope are kept per bin. The time is computed from them exactly as in
+ * R3BTCalModulePar. This replaces the per hit parameter search by three array accesses.
+ */
+class R3BNeulandTCalLookup
+{
+  public:
+    enum class Electronics
+    {
+        VFTX,
+        Tacquila
+    };
+
+    /** Value of R3BTCalModulePar for a TDC value without calibration. */
+    static constexpr Double_t NoTime = -10000.;
+
+    R3BNeulandTCalLookup() = default;
+
+    /** (Re-)build from all modules in the container, sides are used as edges. */
+    void Build(R3BTCalPar* par, Electronics electronics);
+
+    /** Whether the container has parameters for the channel, as R3BTCalPar::GetModuleParAt. They may be empty. */
+    bool HasChannel(Int_t plane, Int_t bar, Int_t edge) const
+    {
+        const Int_t index = GetIndex(plane, bar, edge);
+        return index >= 0 && fChannels[index].present;
+    }
+
+    /** Time for a TDC value, or NoTime. The channel has to exist, see HasChannel. */
+    Double_t GetTime(Int_t plane, Int_t bar, Int_t edge, Int_t tdc) const
+    {
+        const auto& channel = fChannels[GetIndex(plane, bar, edge)];
+        const Int_t i = tdc - channel.firstTdc;
+        if (i < 0 || i >= (Int_t)channel.bin.size() || channel.bin[i] == NoBin)
+        {
+            return NoTime;
+        }
+        const auto b = channel.bin[i];
+        if (channel.slope.empty())
+        {
+            return channel.offset[b];
+        }
+        return channel.offset[b] + channel.slope[b] * (Double_t)(tdc + 1 - channel.low[b]);
+    }
+
+  private:
+    static constexpr UShort_t NoBin = 0xFFFF;
+
+    struct Channel
+    {
+        bool present;
+        Int_t firstTdc;
+        std::vector<UShort_t> bin; // per TDC value from firstTdc
+        // Per bin. No slope and low for VFTX, where the time is the offset.
+        std::vector<Double_t> offset;
+        std::vector<Double_t> slope;
+        std::vector<Int_t> low;
+    };
+
+    Int_t GetIndex(Int_t plane, Int_t bar, Int_t edge) const
+    {
+        if (plane < 1 || plane > fNPlanes || bar < 1 || bar > fNBars || edge < 1 || edge > fNEdges)
+        {
+            return -1;
+        }
+        return ((plane - 1) * fNBars + (bar - 1)) * fNEdges + (edge - 1);
+    }
+
+    Int_t fNPlanes = 0;
+    Int_t fNBars = 0;
+    Int_t fNEdges = 0;
+    std::vector<Channel> fChannels;
+};
+
+#endif
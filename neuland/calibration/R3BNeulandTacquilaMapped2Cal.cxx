@@ -34,6 +34,9 @@
 #define planes fNofPMTs / 100
 #define toID(x, y, z) (((x - 1) * 50 + (y - 1)) * 2 + (z - 1))
 
+// Range of the tabulated walk correction, 12 bit QDC
+#define WALK_TABLE_SIZE 4096
+
 Double_t wlk(Double_t x)
 {
     Double_t y = 0;
@@ -62,7 +65,8 @@ R3BNeulandTacquilaMapped2Cal::R3BNeulandTacquilaMapped2Cal()
     , fMap17Seen()
     , fMapStopTime()
     , fMapStopClock()
-    , fMapQdcOffset()
+    , fQdcOffset()
+    , fWalk()
     , fClockFreq(1. / TACQUILA_CLOCK_MHZ * 1000.)
 {
 }
@@ -81,7 +85,8 @@ R3BNeulandTacquilaMapped2Cal::R3BNeulandTacquilaMapped2Cal(const char* name, Int
     , fMap17Seen()
     , fMapStopTime()
     , fMapStopClock()
-    , fMapQdcOffset()
+    , fQdcOffset()
+    , fWalk()
     , fClockFreq(1. / TACQUILA_CLOCK_MHZ * 1000.)
 {
 }
@@ -140,19 +145,28 @@ void R3BNeulandTacquilaMapped2Cal::SetParContainers()
 void R3BNeulandTacquilaMapped2Cal::SetParameter()
 {
 
-    std::map<Int_t, Double_t> tempMapQdcOffset;
+    std::vector<Double_t> tempQdcOffset;
     Int_t i = 0;
     for (Int_t plane = 1; i <= planes; plane++)
         for (Int_t bar = 1; bar <= 50; bar++)
             for (Int_t side = 1; side <= 2; side++)
             {
-                tempMapQdcOffset[i] = fQCalPar->GetParAt(plane, bar, side);
+                tempQdcOffset.push_back(fQCalPar->GetParAt(plane, bar, side));
                 i++;
             }
 
     LOG(INFO) << "R3BNeulandTacquilaMapped2Cal::SetParameter : Number of Parameters: " << i;
 
-    fMapQdcOffset = tempMapQdcOffset;
+    fQdcOffset = tempQdcOffset;
+
+    // Channel-major TCAL times and walk correction per qdc value
+    fTcalLookup.Build(fTcalPar, R3BNeulandTCalLookup::Electronics::Tacquila);
+
+    fWalk.resize(WALK_TABLE_SIZE);
+    for (Int_t q = 0; q < WALK_TABLE_SIZE; q++)
+    {
+        fWalk[q] = wlk(q);
+    }
 }
 
 InitStatus R3BNeulandTacquilaMapped2Cal::ReInit()
@@ -231,7 +245,6 @@ void R3BNeulandTacquilaMapped2Cal::MakeCal()
     Int_t iSide;
     Int_t channel;
     Int_t tdc;
-    R3BTCalModulePar* par;
     Double_t time;
     Double_t time2;
     Int_t qdc;
@@ -248,7 +261,7 @@ void R3BNeulandTacquilaMapped2Cal::MakeCal()
         iPaddle = hit2->GetPaddle();
         iSide = hit2->GetSide();
 
-        if (!(par = fTcalPar->GetModuleParAt(iPlane, iPaddle, iSide)))
+        if (!fTcalLookup.HasChannel(iPlane, iPaddle, iSide))
         {
             LOG(DEBUG) << "R3BNeulandTacquilaMapped2Cal::Exec : Tcal par not found, channel: " << iPlane << " / "
                        << iPaddle << " / " << iSide;
@@ -256,7 +269,7 @@ void R3BNeulandTacquilaMapped2Cal::MakeCal()
         }
 
         tdc = hit2->GetTacData();
-        time = par->GetTimeTacquila(tdc);
+        time = fTcalLookup.GetTime(iPlane, iPaddle, iSide, tdc);
         if (time < 0. || time > fClockFreq)
         {
             LOG(ERROR) << "R3BNeulandTacquilaMapped2Cal::Exec : error in time calibration: ch=" << channel
@@ -264,7 +277,7 @@ void R3BNeulandTacquilaMapped2Cal::MakeCal()
             continue;
         }
 
-        if (!(par = fTcalPar->GetModuleParAt(iPlane, iPaddle, iSide + 2)))
+        if (!fTcalLookup.HasChannel(iPlane, iPaddle, iSide + 2))
         {
             LOG(DEBUG) << "R3BNeulandTacquilaMapped2Cal::Exec : Tcal par not found, channel: " << iPlane << " / "
                        << iPaddle << " / " << (iSide + 2);
@@ -272,7 +285,7 @@ void R3BNeulandTacquilaMapped2Cal::MakeCal()
         }
 
         tdc = hit2->GetStopT();
-        time2 = par->GetTimeTacquila(tdc);
+        time2 = fTcalLookup.GetTime(iPlane, iPaddle, iSide + 2, tdc);
         if (time2 < 0. || time2 > fClockFreq)
         {
             LOG(ERROR) << "R3BNeulandTacquilaMapped2Cal::Exec : error in time calibration: ch=" << channel
@@ -280,13 +293,14 @@ void R3BNeulandTacquilaMapped2Cal::MakeCal()
             continue;
         }
 
-        qdc = hit2->GetQdcData() - fMapQdcOffset[toID(iPlane, iPaddle, iSide)];
+        const Int_t id = toID(iPlane, iPaddle, iSide);
+        qdc = hit2->GetQdcData() - (id >= 0 && id < (Int_t)fQdcOffset.size() ? fQdcOffset[id] : 0.);
         qdc = std::max(qdc, 0);
 
         time = time - time2 + hit2->GetClock() * fClockFreq;
         if (fWalkEnabled)
         {
-            time += wlk(qdc);
+            time += qdc < WALK_TABLE_SIZE ? fWalk[qdc] : wlk(qdc);
         }
         new ((*fPmt)[fNPmt]) R3BNeulandCalData((iPlane - 1) * 50 + iPaddle, iSide, time, qdc);
         fNPmt += 1;
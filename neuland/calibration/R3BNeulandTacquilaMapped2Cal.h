@@ -15,6 +15,9 @@
 #define R3BNEULANDTACQUILAMAPPED2CAL_H
 
 #include "FairTask.h"
+#include "R3BNeulandTCalLookup.h"
+#include <map>
+#include <vector>
 
 class TClonesArray;
 class TH1F;
@@ -137,7 +140,9 @@ class R3BNeulandTacquilaMapped2Cal : public FairTask
     std::map<Int_t, Bool_t> fMap17Seen;      /**< Map with flag of observed stop signal. */
     std::map<Int_t, Double_t> fMapStopTime;  /**< Map with value of stop time. */
     std::map<Int_t, Int_t> fMapStopClock;    /**< Map with value of stop clock. */
-    std::map<Int_t, Double_t> fMapQdcOffset; /**< Map with value of qdc offset. */
+    std::vector<Double_t> fQdcOffset;        /**< Qdc offset per channel. */
+    std::vector<Double_t> fWalk;             /**< Walk correction per qdc value. */
+    R3BNeulandTCalLookup fTcalLookup;        //! Tabulated TCAL times per channel.
     Double_t fClockFreq;                     /**< Clock cycle in [ns]. */
     TH1F* fh_pulser_5_2;                     /**< Resolution of one PMT. */
     TH1F* fh_pulser_105_2;                   /**< Resolution of one PMT. */
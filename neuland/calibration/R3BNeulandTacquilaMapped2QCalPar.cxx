@@ -20,9 +20,16 @@
 #include "R3BTCalEngine.h"
 #include "TClonesArray.h"
 #include "TH1F.h"
+#include "TMath.h"
+#include <algorithm>
 
 #define nPMTs 2 * fPaddles* fPlanes
 
+namespace
+{
+    constexpr Int_t gNQdcBins = 2001; // QDC values 0 to 2000
+} // namespace
+
 R3BNeulandTacquilaMapped2QCalPar::R3BNeulandTacquilaMapped2QCalPar(const char* name, Int_t iVerbose)
     : FairTask(name, iVerbose)
     , fPar(NULL)
@@ -39,12 +46,6 @@ R3BNeulandTacquilaMapped2QCalPar::R3BNeulandTacquilaMapped2QCalPar()
 
 R3BNeulandTacquilaMapped2QCalPar::~R3BNeulandTacquilaMapped2QCalPar()
 {
-    if (fData.size() > 0)
-        for (Int_t plane = fPlanes - 1; plane >= 0; plane--)
-            for (Int_t bar = fPaddles - 1; bar >= 0; bar--)
-                for (Int_t side = 1; side <= 2; side++)
-                    fData.at(plane).at(bar).at(side)->Delete();
-
     if (fPar)
         delete fPar;
 }
@@ -70,26 +71,16 @@ InitStatus R3BNeulandTacquilaMapped2QCalPar::Init()
         return kFATAL;
     }
 
-    TH1F* histo;
-
-    for (Int_t plane = 1; plane <= fPlanes; plane++)
+    if (fRunningMean)
     {
-        std::vector<std::vector<TH1F*>> v_plane;
-        for (Int_t bar = 1; bar <= fPaddles; bar++)
-        {
-            std::vector<TH1F*> v_bar;
-            for (Int_t side = 1; side <= 2; side++)
-            {
-                std::string s =
-                    "h_pedpar_" + std::to_string(plane) + "_" + std::to_string(bar) + "_" + std::to_string(side);
-                histo = new TH1F(s.c_str(), "PedPar", 2001, -0.5, 2000.5);
-                v_bar.push_back(histo);
-            }
-            v_plane.push_back(v_bar);
-        }
-        fData.push_back(v_plane);
+        fPedestals.assign(nPMTs, Neuland::PedestalEstimator(fWindow));
+    }
+    else
+    {
+        fSpectra.assign(nPMTs * gNQdcBins, 0);
     }
     fPar = (R3BNeulandQCalPar*)FairRuntimeDb::instance()->getContainer("NeulandQCalPar");
+    fPar->SetSize(nPMTs);
 
     return kSUCCESS;
 }
@@ -111,27 +102,69 @@ void R3BNeulandTacquilaMapped2QCalPar::Exec(Option_t* option)
         if (!hit)
             continue;
 
-        fData.at(hit->GetPlane() - 1).at(hit->GetPaddle() - 1).at(hit->GetSide() - 1)->Fill(hit->GetQdcData());
+        const Int_t channel = GetChannel(hit->GetPlane(), hit->GetPaddle(), hit->GetSide());
+        if (channel < 0 || channel >= nPMTs)
+            continue;
+
+        const Int_t qdc = hit->GetQdcData();
+        if (fRunningMean)
+            fPedestals[channel].Add(qdc);
+        else if (qdc < gNQdcBins)
+            fSpectra[channel * gNQdcBins + qdc]++;
+    }
+
+    fEventNumber++;
+    if (fUpdateRate > 0 && fEventNumber % fUpdateRate == 0)
+    {
+        Publish();
+        LOG(INFO) << "R3BNeulandTacquilaMapped2QCalPar: Published pedestals after " << fEventNumber
+                  << " pedestal events";
     }
 }
 
-void R3BNeulandTacquilaMapped2QCalPar::FinishTask()
+Int_t R3BNeulandTacquilaMapped2QCalPar::GetPedestal(Int_t channel) const
+{
+    if (fRunningMean)
+        return TMath::Nint(fPedestals[channel].GetPedestal());
+
+    // First maximum, as TH1::GetMaximumBin; 0 for an empty spectrum
+    const auto spectrum = fSpectra.begin() + channel * gNQdcBins;
+    return std::max_element(spectrum, spectrum + gNQdcBins) - spectrum;
+}
+
+void R3BNeulandTacquilaMapped2QCalPar::Publish()
 {
-    Int_t i = 0;
-    TH1F* pars = new TH1F("QCalPar", "Pedestal Offset", nPMTs, 0.5, nPMTs + 0.5);
-    TH1F* histo;
-    fPar->SetSize(nPMTs);
     for (Int_t plane = 1; plane <= fPlanes; plane++)
         for (Int_t bar = 1; bar <= fPaddles; bar++)
             for (Int_t side = 1; side <= 2; side++)
             {
-                histo = fData.at(plane - 1).at(bar - 1).at(side - 1);
-                Int_t maxBinPos = histo->GetBinCenter(histo->GetMaximumBin());
-                pars->SetBinContent(i++ + 1, maxBinPos);
-                fPar->SetParAt(plane, bar, side, maxBinPos);
+                const Int_t channel = GetChannel(plane, bar, side);
+                if (!fRunningMean || fPedestals[channel].IsValid())
+                    fPar->SetParAt(plane, bar, side, GetPedestal(channel));
             }
-    pars->Write();
     fPar->setChanged();
 }
 
+void R3BNeulandTacquilaMapped2QCalPar::FinishTask()
+{
+    Publish();
+
+    TH1F* pars = new TH1F("QCalPar", "Pedestal Offset", nPMTs, 0.5, nPMTs + 0.5);
+    for (Int_t i = 0; i < nPMTs; i++)
+    {
+        pars->SetBinContent(i + 1, GetPedestal(i));
+    }
+    pars->Write();
+
+    if (fRunningMean)
+    {
+        TH1F* widths = new TH1F("QCalParWidth", "Pedestal Width", nPMTs, 0.5, nPMTs + 0.5);
+        for (Int_t i = 0; i < nPMTs; i++)
+        {
+            widths->SetBinContent(i + 1, fPedestals[i].GetWidth());
+        }
+        widths->Write();
+    }
+}
+
 ClassImp(R3BNeulandTacquilaMapped2QCalPar)
@@ -15,9 +15,10 @@
 #define R3BNEULANDTACQUILAMAPPED2QCALPAR_H
 
 #include "FairTask.h"
+#include "PedestalEstimator.h"
+#include <vector>
 
 class TClonesArray;
-class TH1F;
 class R3BEventHeader;
 class R3BNeulandQCalPar;
 
@@ -37,6 +38,25 @@ class R3BNeulandTacquilaMapped2QCalPar : public FairTask
 
     void SetPlanes(Int_t planes) { fPlanes = planes; }
 
+    // The pedestal is the most probable QDC value of each channel (1 channel bins up to 2000). With
+    // SetRunningMean(kTRUE), it is a running, outlier-clipped mean instead (Neuland::PedestalEstimator): bounded
+    // memory and it follows drifts, but it differs from the most probable value on skewed pedestal peaks.
+    void SetRunningMean(Bool_t enable) { fRunningMean = enable; }
+
+    // Number of pedestal events the running mean per channel effectively averages over
+    void SetWindow(UInt_t window) { fWindow = window; }
+
+    // Publish the current pedestals to the parameter container every nEvents pedestal events (0: only at the end)
+    void SetUpdateRate(Int_t nEvents) { fUpdateRate = nEvents; }
+
+  private:
+    Int_t GetChannel(Int_t plane, Int_t bar, Int_t side) const
+    {
+        return ((plane - 1) * fPaddles + bar - 1) * 2 + side - 1;
+    }
+    Int_t GetPedestal(Int_t channel) const;
+    void Publish();
+
   private:
     Int_t fPlanes = 60;
     Int_t fPaddles = 50;
@@ -45,10 +65,14 @@ class R3BNeulandTacquilaMapped2QCalPar : public FairTask
     R3BNeulandQCalPar* fPar;
 
     Int_t fEventNumber = 0;
+    Bool_t fRunningMean = kFALSE;
+    UInt_t fWindow = 1000;
+    Int_t fUpdateRate = 0;
 
     R3BEventHeader* header;
 
-    std::vector<std::vector<std::vector<TH1F*>>> fData;
+    std::vector<UInt_t> fSpectra;                       //! QDC spectrum per channel
+    std::vector<Neuland::PedestalEstimator> fPedestals; //! with fRunningMean
 
   public:
     ClassDef(R3BNeulandTacquilaMapped2QCalPar, 1)
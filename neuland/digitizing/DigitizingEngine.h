@@ -81,6 +81,8 @@ namespace Neuland
       public:
         virtual ~DigitizingEngine() = default; // FIXME: Root doesn't like pure virtual destructors (= 0;)
         virtual std::unique_ptr<Digitizing::Channel> BuildChannel() = 0;
+        // Engines with random smearing restart their random number sequence, no-op for deterministic engines
+        virtual void SetSeed(UInt_t) {}
 
         void DepositLight(Int_t paddle_id, Double_t time, Double_t light, Double_t dist);
         Double_t GetTriggerTime() const;
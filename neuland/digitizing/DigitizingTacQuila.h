@@ -72,6 +72,7 @@ namespace Neuland
         DigitizingTacQuila();
         ~DigitizingTacQuila() override = default;
         std::unique_ptr<Digitizing::Channel> BuildChannel() override;
+        void SetSeed(const UInt_t seed) override { fTQP.fRnd->SetSeed(seed); }
 
         void SetPMTThreshold(const Double_t v) { fTQP.fPMTThresh = v; }
         void SetSaturationCoefficient(const Double_t v) { fTQP.fSaturationCoefficient = v; }
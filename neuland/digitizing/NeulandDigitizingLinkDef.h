@@ -30,5 +30,8 @@
 #pragma link C++ class Neuland::DigitizingTamex+;
 #pragma link C++ class R3BNeulandHitMon+;
 #pragma link C++ class R3BNeulandDigitizer+;
+#pragma link C++ class R3BNeulandFastSimTable+;
+#pragma link C++ class R3BNeulandFastSimTableMaker+;
+#pragma link C++ class R3BNeulandFastSim+;
 
 #endif
@@ -0,0 +1,167 @@
+/******************************************************************************
+ *   Copyright (C) 2019 GSI Helmholtzzentrum für Schwerionenforschung GmbH    *
+ *   Copyright (C) 2019 Members of R3B Collaboration                          *
+ *                                                                            *
+ *             This software is distributed under the terms of the            *
+ *                 GNU General Public Licence (GPL) version 3,                *
+ *                    copied verbatim in the file "LICENSE".                  *
+ *                                                                            *
+ * In applying this license GSI does not waive the privileges and immunities  *
+ * granted to it by virtue of its status as an Intergovernmental Organization *
+ * or submit itself to any jurisdiction.                                      *
+ ******************************************************************************/
+
+#include "PaddleLookup.h"
+#include "R3BNeulandGeoPar.h"
+#include "TGeoBBox.h"
+#include "TGeoMatrix.h"
+#include "TGeoNode.h"
+#include <algorithm>
+#include <cmath>
+
+namespace Neuland
+{
+    PaddleLookup::PaddleLookup(const R3BNeulandGeoPar* par)
+        : fPar(par)
+        , fHalfLength(par->GetPaddleHalfLength())
+    {
+        const auto neuland = par->fNeulandGeoNode;
+        for (Int_t i = 0; i < neuland->GetNdaughters(); i++)
+        {
+            const auto node = neuland->GetDaughter(i);
+            const auto paddle = node->GetNumber();
+
+            const auto box = (TGeoBBox*)node->GetVolume()->GetShape();
+            fHalfWidth = std::min(box->GetDY(), box->GetDZ());
+
+            const Double_t* translation = node->GetMatrix()->GetTranslation();
+            const Double_t local[3] = { 1., 0., 0. };
+            Double_t axis[3];
+            node->GetMatrix()->LocalToMasterVect(local, axis);
+
+            if (paddle >= (Int_t)fCenters.size())
+            {
+                fCenters.resize(paddle + 1);
+                fAxes.resize(paddle + 1);
+            }
+            fCenters[paddle] = TVector3(translation[0], translation[1], translation[2]);
+            fAxes[paddle] = TVector3(axis[0], axis[1], axis[2]).Unit();
+
+            const bool horizontal = std::abs(axis[0]) > std::abs(axis[1]);
+            auto plane = std::find_if(fPlanes.begin(), fPlanes.end(), [&](const Plane& p) {
+                return std::abs(p.z - translation[2]) < fHalfWidth;
+            });
+            if (plane == fPlanes.end())
+            {
+                fPlanes.push_back(Plane{ translation[2], horizontal, {} });
+                plane = fPlanes.end() - 1;
+            }
+            plane->bars.push_back(Bar{ horizontal ? translation[1] : translation[0], paddle });
+        }
+
+        if (fPlanes.empty())
+        {
+            return;
+        }
+
+        std::sort(fPlanes.begin(), fPlanes.end(), [](const Plane& a, const Plane& b) { return a.z < b.z; });
+        for (auto& plane : fPlanes)
+        {
+            std::sort(plane.bars.begin(), plane.bars.end(), [](const Bar& a, const Bar& b) {
+                return a.transverse < b.transverse;
+            });
+        }
+
+        fFrontZ = fPlanes.front().z - fHalfWidth;
+        fBackZ = fPlanes.back().z + fHalfWidth;
+        fMinX = fMinY = 1e99;
+        fMaxX = fMaxY = -1e99;
+        for (const auto& plane : fPlanes)
+        {
+            for (const auto& bar : plane.bars)
+            {
+                const auto& c = fCenters[bar.paddle];
+                const auto dx = plane.horizontal ? fHalfLength : fHalfWidth;
+                const auto dy = plane.horizontal ? fHalfWidth : fHalfLength;
+                fMinX = std::min(fMinX, c.X() - dx);
+                fMaxX = std::max(fMaxX, c.X() + dx);
+                fMinY = std::min(fMinY, c.Y() - dy);
+                fMaxY = std::max(fMaxY, c.Y() + dy);
+            }
+        }
+    }
+
+    TVector3 PaddleLookup::ToNeulandPosition(const TVector3& global) const
+    {
+        const Double_t in[3] = { global.X(), global.Y(), global.Z() };
+        Double_t out[3];
+        fPar->fNeulandGeoNode->GetMatrix()->MasterToLocal(in, out);
+        return TVector3(out[0], out[1], out[2]);
+    }
+
+    TVector3 PaddleLookup::ToNeulandDirection(const TVector3& global) const
+    {
+        const Double_t in[3] = { global.X(), global.Y(), global.Z() };
+        Double_t out[3];
+        fPar->fNeulandGeoNode->GetMatrix()->MasterToLocalVect(in, out);
+        return TVector3(out[0], out[1], out[2]);
+    }
+
+    Int_t PaddleLookup::FindPaddle(const TVector3& position) const
+    {
+        if (fPlanes.empty() || position.Z() < fFrontZ || position.Z() > fBackZ)
+        {
+            return -1;
+        }
+
+        // Planes and bars are sorted, find the first one whose far edge is not before the position
+        const auto plane = std::lower_bound(fPlanes.begin(),
+                                            fPlanes.end(),
+                                            position.Z(),
+                                            [&](const Plane& p, Double_t z) { return p.z + fHalfWidth < z; });
+        if (plane == fPlanes.end() || position.Z() < plane->z - fHalfWidth)
+        {
+            return -1;
+        }
+
+        const auto t = plane->horizontal ? position.Y() : position.X();
+        const auto bar = std::lower_bound(plane->bars.begin(),
+                                          plane->bars.end(),
+                                          t,
+                                          [&](const Bar& b, Double_t v) { return b.transverse + fHalfWidth < v; });
+        if (bar == plane->bars.end() || t < bar->transverse - fHalfWidth)
+        {
+            return -1;
+        }
+
+        if (std::abs(GetPositionAlongPaddle(position, bar->paddle)) > fHalfLength)
+        {
+            return -1;
+        }
+        return bar->paddle;
+    }
+
+    Double_t PaddleLookup::GetPositionAlongPaddle(const TVector3& position, Int_t paddle) const
+    {
+        return (position - fCenters.at(paddle)).Dot(fAxes.at(paddle));
+    }
+
+    bool PaddleLookup::FindEntry(const TVector3& vertex, const TVector3& direction, Double_t& pathLength) const
+    {
+        if (fPlanes.empty() || direction.Z() <= 0.)
+        {
+            return false;
+        }
+
+        const auto u = direction.Unit();
+        pathLength = (fFrontZ - vertex.Z()) / u.Z();
+        if (pathLength < 0.)
+        {
+            // Vertex inside or behind the detector
+            return false;
+        }
+
+        const auto entry = vertex + pathLength * u;
+        return entry.X() >= fMinX && entry.X() <= fMaxX && entry.Y() >= fMinY && entry.Y() <= fMaxY;
+    }
+} // namespace Neuland
@@ -0,0 +1,77 @@
+/******************************************************************************
+ *   Copyright (C) 2019 GSI Helmholtzzentrum für Schwerionenforschung GmbH    *
+ *   Copyright (C) 2019 Members of R3B Collaboration                          *
+ *                                                                            *
+ *             This software is distributed under the terms of the            *
+ *                 GNU General Public Licence (GPL) version 3,                *
+ *                    copied verbatim in the file "LICENSE".                  *
+ *                                                                            *
+ * In applying this license GSI does not waive the privileges and immunities  *
+ * granted to it by virtue of its status as an Intergovernmental Organization *
+ * or submit itself to any jurisdiction.                                      *
+ ******************************************************************************/
+
+#ifndef NEULAND_PADDLE_LOOKUP_H
+#define NEULAND_PADDLE_LOOKUP_H
+
+#include "Rtypes.h"
+#include "TVector3.h"
+#include <vector>
+
+class R3BNeulandGeoPar;
+
+namespace Neuland
+{
+    // Fast lookup of the paddle at a position, built once from the geometry parameters.
+    // All positions and directions are given in the NeuLAND frame, i.e. the local coordinates of the NeuLAND node.
+    class PaddleLookup
+    {
+      public:
+        PaddleLookup() = default;
+        explicit PaddleLookup(const R3BNeulandGeoPar* par);
+
+        TVector3 ToNeulandPosition(const TVector3& global) const;
+        TVector3 ToNeulandDirection(const TVector3& global) const;
+
+        // Paddle ID at the position, or -1 if there is no paddle
+        Int_t FindPaddle(const TVector3& position) const;
+        // Position along the paddle axis, as used by the digitizing engine
+        Double_t GetPositionAlongPaddle(const TVector3& position, Int_t paddle) const;
+
+        // Path length along the line until it enters the front face of the detector. Returns false if the line
+        // does not point towards the detector or passes outside the front face.
+        bool FindEntry(const TVector3& vertex, const TVector3& direction, Double_t& pathLength) const;
+
+        Double_t GetFrontZ() const { return fFrontZ; }
+        Double_t GetBackZ() const { return fBackZ; }
+
+      private:
+        struct Bar
+        {
+            Double_t transverse; // Position perpendicular to the paddle axis in the plane
+            Int_t paddle;
+        };
+
+        struct Plane
+        {
+            Double_t z;
+            bool horizontal; // Paddle axis along x
+            std::vector<Bar> bars;
+        };
+
+        const R3BNeulandGeoPar* fPar = nullptr;
+        std::vector<Plane> fPlanes;
+        std::vector<TVector3> fCenters; // Indexed by paddle ID
+        std::vector<TVector3> fAxes;    // Indexed by paddle ID
+        Double_t fHalfLength = 0.;
+        Double_t fHalfWidth = 0.;
+        Double_t fFrontZ = 0.;
+        Double_t fBackZ = 0.;
+        Double_t fMinX = 0.;
+        Double_t fMaxX = 0.;
+        Double_t fMinY = 0.;
+        Double_t fMaxY = 0.;
+    };
+} // namespace Neuland
+
+#endif // NEULAND_PADDLE_LOOKUP_H
@@ -84,29 +84,7 @@ void R3BNeulandDigitizer::Exec(Option_t*)
 {
     fHits.Reset();
 
-    std::map<UInt_t, Double_t> paddleEnergyDeposit;
-    // Look at each Land Point, if it deposited energy in the scintillator, store it with reference to the bar
-    for (const auto& point : fPoints.Retrieve())
-    {
-        if (point->GetEnergyLoss() > 0.)
-        {
-            const Int_t paddleID = point->GetPaddle();
-
-            // Convert position of point to paddle-coordinates, including any rotation or translation
-            const TVector3 position = point->GetPosition();
-            const TVector3 converted_position = fNeulandGeoPar->ConvertToLocalCoordinates(position, paddleID);
-            LOG(DEBUG) << "NeulandDigitizer: Point in paddle " << paddleID
-                       << " with global position XYZ: " << position.X() << " " << position.Y() << " " << position.Z();
-            LOG(DEBUG) << "NeulandDigitizer: Converted to local position XYZ: " << converted_position.X() << " "
-                       << converted_position.Y() << " " << converted_position.Z();
-
-            // Within the paddle frame, the relevant distance of the light from the pmt is always given by the
-            // X-Coordinate
-            const Double_t dist = converted_position.X();
-            fDigitizingEngine->DepositLight(paddleID, point->GetTime(), point->GetLightYield() * 1000., dist);
-            paddleEnergyDeposit[paddleID] += point->GetEnergyLoss() * 1000;
-        } // eloss
-    }     // points
+    auto paddleEnergyDeposit = DepositPoints(*fDigitizingEngine, *fNeulandGeoPar, fPoints.Retrieve());
 
     const Double_t triggerTime = fDigitizingEngine->GetTriggerTime();
     const auto paddles = fDigitizingEngine->ExtractPaddles();
@@ -147,19 +125,7 @@ void R3BNeulandDigitizer::Exec(Option_t*)
             continue;
         }
 
-        const TVector3 hitPositionLocal = TVector3(paddle->GetPosition(), 0., 0.);
-        const TVector3 hitPositionGlobal = fNeulandGeoPar->ConvertToGlobalCoordinates(hitPositionLocal, paddleID);
-        const TVector3 hitPixel = fNeulandGeoPar->ConvertGlobalToPixel(hitPositionGlobal);
-
-        R3BNeulandHit hit(paddleID,
-                          paddle->GetLeftChannel()->GetTDC(),
-                          paddle->GetRightChannel()->GetTDC(),
-                          paddle->GetTime(),
-                          paddle->GetLeftChannel()->GetEnergy(),
-                          paddle->GetRightChannel()->GetEnergy(),
-                          paddle->GetEnergy(),
-                          hitPositionGlobal,
-                          hitPixel);
+        R3BNeulandHit hit = BuildHit(paddleID, *paddle, *fNeulandGeoPar);
 
         if (fHitFilters.IsValid(hit))
         {
@@ -170,6 +136,55 @@ void R3BNeulandDigitizer::Exec(Option_t*)
     LOG(DEBUG) << "R3BNeulandDigitizer: produced " << fHits.Size() << " hits";
 }
 
+std::map<Int_t, Double_t> R3BNeulandDigitizer::DepositPoints(Neuland::DigitizingEngine& engine,
+                                                             const R3BNeulandGeoPar& geoPar,
+                                                             const std::vector<R3BNeulandPoint*>& points)
+{
+    std::map<Int_t, Double_t> paddleEnergyDeposit;
+    // Look at each Land Point, if it deposited energy in the scintillator, store it with reference to the bar
+    for (const auto& point : points)
+    {
+        if (point->GetEnergyLoss() > 0.)
+        {
+            const Int_t paddleID = point->GetPaddle();
+
+            // Convert position of point to paddle-coordinates, including any rotation or translation
+            const TVector3 position = point->GetPosition();
+            const TVector3 converted_position = geoPar.ConvertToLocalCoordinates(position, paddleID);
+            LOG(DEBUG) << "NeulandDigitizer: Point in paddle " << paddleID
+                       << " with global position XYZ: " << position.X() << " " << position.Y() << " " << position.Z();
+            LOG(DEBUG) << "NeulandDigitizer: Converted to local position XYZ: " << converted_position.X() << " "
+                       << converted_position.Y() << " " << converted_position.Z();
+
+            // Within the paddle frame, the relevant distance of the light from the pmt is always given by the
+            // X-Coordinate
+            const Double_t dist = converted_position.X();
+            engine.DepositLight(paddleID, point->GetTime(), point->GetLightYield() * 1000., dist);
+            paddleEnergyDeposit[paddleID] += point->GetEnergyLoss() * 1000;
+        } // eloss
+    }     // points
+    return paddleEnergyDeposit;
+}
+
+R3BNeulandHit R3BNeulandDigitizer::BuildHit(const Int_t paddleID,
+                                            const Neuland::Digitizing::Paddle& paddle,
+                                            const R3BNeulandGeoPar& geoPar)
+{
+    const TVector3 hitPositionLocal = TVector3(paddle.GetPosition(), 0., 0.);
+    const TVector3 hitPositionGlobal = geoPar.ConvertToGlobalCoordinates(hitPositionLocal, paddleID);
+    const TVector3 hitPixel = geoPar.ConvertGlobalToPixel(hitPositionGlobal);
+
+    return R3BNeulandHit(paddleID,
+                         paddle.GetLeftChannel()->GetTDC(),
+                         paddle.GetRightChannel()->GetTDC(),
+                         paddle.GetTime(),
+                         paddle.GetLeftChannel()->GetEnergy(),
+                         paddle.GetRightChannel()->GetEnergy(),
+                         paddle.GetEnergy(),
+                         hitPositionGlobal,
+                         hitPixel);
+}
+
 void R3BNeulandDigitizer::Finish()
 {
     TDirectory* tmp = gDirectory;
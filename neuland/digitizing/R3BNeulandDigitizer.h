@@ -21,6 +21,8 @@
 #include "R3BNeulandHit.h"
 #include "R3BNeulandPoint.h"
 #include "TCAConnector.h"
+#include <map>
+#include <vector>
 
 class TGeoNode;
 class TH1F;
@@ -63,6 +65,15 @@ class R3BNeulandDigitizer : public FairTask
     void Exec(Option_t*) override;
     void AddFilter(const Filterable<R3BNeulandHit&>::Filter& f) { fHitFilters.Add(f); }
 
+    // Per-event steps, also used outside of the task by Neuland::BatchExecutor
+    // Deposits the light of the points in the engine, returns the energy deposit per paddle
+    static std::map<Int_t, Double_t> DepositPoints(Neuland::DigitizingEngine& engine,
+                                                   const R3BNeulandGeoPar& geoPar,
+                                                   const std::vector<R3BNeulandPoint*>& points);
+    static R3BNeulandHit BuildHit(Int_t paddleID,
+                                  const Neuland::Digitizing::Paddle& paddle,
+                                  const R3BNeulandGeoPar& geoPar);
+
   private:
     TCAInputConnector<R3BNeulandPoint> fPoints;
     TCAOutputConnector<R3BNeulandHit> fHits;
@@ -0,0 +1,171 @@
+/******************************************************************************
+ *   Copyright (C) 2019 GSI Helmholtzzentrum für Schwerionenforschung GmbH    *
+ *   Copyright (C) 2019 Members of R3B Collaboration                          *
+ *                                                                            *
+ *             This software is distributed under the terms of the            *
+ *                 GNU General Public Licence (GPL) version 3,                *
+ *                    copied verbatim in the file "LICENSE".                  *
+ *                                                                            *
+ * In applying this license GSI does not waive the privileges and immunities  *
+ * granted to it by virtue of its status as an Intergovernmental Organization *
+ * or submit itself to any jurisdiction.                                      *
+ ******************************************************************************/
+
+#include "R3BNeulandFastSim.h"
+#include "DigitizingEngine.h"
+#include "FairLogger.h"
+#include "FairRunAna.h"
+#include "FairRuntimeDb.h"
+#include "TFile.h"
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+R3BNeulandFastSim::R3BNeulandFastSim(TString tableFile, TString output)
+    : FairTask("R3BNeulandFastSim")
+    , fTableFile(std::move(tableFile))
+    , fTracks("MCTrack")
+    , fHits(std::move(output))
+    , fNeulandGeoPar(nullptr)
+{
+}
+
+void R3BNeulandFastSim::SetParContainers()
+{
+    FairRunAna* run = FairRunAna::Instance();
+    if (!run)
+    {
+        LOG(FATAL) << "R3BNeulandFastSim::SetParContainers: No analysis run";
+        return;
+    }
+
+    FairRuntimeDb* rtdb = run->GetRuntimeDb();
+    if (!rtdb)
+    {
+        LOG(FATAL) << "R3BNeulandFastSim::SetParContainers: No runtime database";
+        return;
+    }
+
+    fNeulandGeoPar = (R3BNeulandGeoPar*)rtdb->getContainer("R3BNeulandGeoPar");
+    if (!fNeulandGeoPar)
+    {
+        LOG(FATAL) << "R3BNeulandFastSim::SetParContainers: No R3BNeulandGeoPar";
+        return;
+    }
+}
+
+InitStatus R3BNeulandFastSim::Init()
+{
+    fTracks.Init();
+    fHits.Init();
+
+    TDirectory* tmp = gDirectory;
+    TFile file(fTableFile, "READ");
+    gDirectory = tmp;
+    const auto table =
+        file.IsZombie() ? nullptr : dynamic_cast<R3BNeulandFastSimTable*>(file.Get("R3BNeulandFastSimTable"));
+    if (table == nullptr)
+    {
+        LOG(FATAL) << "R3BNeulandFastSim::Init: No R3BNeulandFastSimTable in " << fTableFile;
+        return kFATAL;
+    }
+    fTable.reset(table);
+    LOG(INFO) << "R3BNeulandFastSim: Using table with " << fTable->GetNEntries() << " entries from " << fTableFile;
+
+    fLookup = Neuland::PaddleLookup(fNeulandGeoPar);
+    return kSUCCESS;
+}
+
+void R3BNeulandFastSim::Exec(Option_t*)
+{
+    fHits.Reset();
+    fPaddleHits.clear();
+
+    for (const auto track : fTracks.Retrieve())
+    {
+        if (track->GetMotherId() != -1 || track->GetPdgCode() != 2112)
+        {
+            continue;
+        }
+
+        TVector3 start;
+        TVector3 momentum;
+        track->GetStartVertex(start);
+        track->GetMomentum(momentum);
+        const auto vertex = fLookup.ToNeulandPosition(start);
+        const auto direction = fLookup.ToNeulandDirection(momentum).Unit();
+
+        Double_t entryPath;
+        if (!fLookup.FindEntry(vertex, direction, entryPath))
+        {
+            continue;
+        }
+
+        const auto energy = (track->GetEnergy() - track->GetMass()) * 1000.; // [MeV]
+        const auto entry = fTable->Sample(energy, &fRnd);
+        if (entry < 0 || !fTable->IsInteraction(entry))
+        {
+            continue;
+        }
+
+        // Place the first interaction along the neutron line
+        const auto pathLength = entryPath + fTable->GetDepth(entry);
+        const auto beta = track->GetP() / track->GetEnergy();
+        const auto offset = R3BNeulandFastSimTable::FromNeutronFrame(fTable->GetOffset(entry), direction);
+        const auto position = vertex + pathLength * direction + offset;
+        const auto time =
+            track->GetStartT() + R3BNeulandFastSimTable::TimeOfFlight(pathLength, beta) + fTable->GetTimeOffset(entry);
+
+        fTable->GetHits(entry, fEntryHits);
+        for (const auto& hit : fEntryHits)
+        {
+            const auto hitPosition = position + R3BNeulandFastSimTable::FromNeutronFrame(hit.offset, direction);
+            const auto paddle = fLookup.FindPaddle(hitPosition);
+            if (paddle < 0)
+            {
+                continue;
+            }
+
+            const auto hitTime = time + hit.dt;
+            const auto it = fPaddleHits.find(paddle);
+            if (it == fPaddleHits.end())
+            {
+                fPaddleHits[paddle] = PaddleHit{ hitTime, hit.e, hitPosition };
+                continue;
+            }
+            it->second.energy += hit.e;
+            if (hitTime < it->second.time)
+            {
+                it->second.time = hitTime;
+                it->second.position = hitPosition;
+            }
+        }
+    }
+
+    // Create Hits as R3BNeulandDigitizer would from the paddle response
+    using Neuland::Digitizing::Paddle;
+    for (const auto& kv : fPaddleHits)
+    {
+        const Int_t paddleID = kv.first;
+        const auto& paddle = kv.second;
+
+        const auto x = std::max(-Paddle::gHalfLength,
+                                std::min(Paddle::gHalfLength, fLookup.GetPositionAlongPaddle(paddle.position, paddleID)));
+        const TVector3 hitPositionGlobal = fNeulandGeoPar->ConvertToGlobalCoordinates(TVector3(x, 0., 0.), paddleID);
+        const TVector3 hitPixel = fNeulandGeoPar->ConvertGlobalToPixel(hitPositionGlobal);
+
+        fHits.Insert(R3BNeulandHit(paddleID,
+                                   paddle.time + (Paddle::gHalfLength - x) / Paddle::gCMedium,
+                                   paddle.time + (Paddle::gHalfLength + x) / Paddle::gCMedium,
+                                   paddle.time,
+                                   paddle.energy * std::exp(Paddle::gAttenuation * x),
+                                   paddle.energy * std::exp(-Paddle::gAttenuation * x),
+                                   paddle.energy,
+                                   hitPositionGlobal,
+                                   hitPixel));
+    }
+
+    LOG(DEBUG) << "R3BNeulandFastSim: produced " << fHits.Size() << " hits";
+}
+
+ClassImp(R3BNeulandFastSim);
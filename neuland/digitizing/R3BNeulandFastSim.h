@@ -0,0 +1,86 @@
+/******************************************************************************
+ *   Copyright (C) 2019 GSI Helmholtzzentrum für Schwerionenforschung GmbH    *
+ *   Copyright (C) 2019 Members of R3B Collaboration                          *
+ *                                                                            *
+ *             This software is distributed under the terms of the            *
+ *                 GNU General Public Licence (GPL) version 3,                *
+ *                    copied verbatim in the file "LICENSE".                  *
+ *                                                                            *
+ * In applying this license GSI does not waive the privileges and immunities  *
+ * granted to it by virtue of its status as an Intergovernmental Organization *
+ * or submit itself to any jurisdiction.                                      *
+ ******************************************************************************/
+
+#ifndef R3BNEULANDFASTSIM_H
+#define R3BNEULANDFASTSIM_H
+
+#include "FairTask.h"
+#include "PaddleLookup.h"
+#include "R3BMCTrack.h"
+#include "R3BNeulandFastSimTable.h"
+#include "R3BNeulandGeoPar.h"
+#include "R3BNeulandHit.h"
+#include "TCAConnector.h"
+#include "TRandom3.h"
+#include <map>
+#include <memory>
+#include <vector>
+
+/**
+ * NeuLAND fast simulation task
+ *
+ * Replaces the transport inside NeuLAND and R3BNeulandDigitizer: For each primary neutron that enters the front face
+ * of NeuLAND, an entry of the response table (see R3BNeulandFastSimTableMaker) is sampled and placed along the
+ * neutron line. Hits in the same paddle are merged, keeping the earliest time and summing the energy.
+ * The simulation itself can then be run without R3BNeuland, or with NeuLAND as passive volume.
+ *   Input:  Branch MCTrack
+ *           Response table file
+ *           Stored Neuland Geometry Parameter NeulandGeoPar
+ *   Output: Branch NeulandHits = TClonesArray("R3BNeulandHit")
+ */
+
+class R3BNeulandFastSim : public FairTask
+{
+  public:
+    explicit R3BNeulandFastSim(TString tableFile, TString output = "NeulandHits");
+
+    ~R3BNeulandFastSim() override = default;
+
+    // No copy and no move is allowed (Rule of three/five)
+    R3BNeulandFastSim(const R3BNeulandFastSim&) = delete;
+    R3BNeulandFastSim(R3BNeulandFastSim&&) = delete;
+    R3BNeulandFastSim& operator=(const R3BNeulandFastSim&) = delete;
+    R3BNeulandFastSim& operator=(R3BNeulandFastSim&&) = delete;
+
+  protected:
+    InitStatus Init() override;
+    void SetParContainers() override;
+
+  public:
+    void Exec(Option_t*) override;
+    void SetSeed(UInt_t seed) { fRnd.SetSeed(seed); }
+
+  private:
+    struct PaddleHit
+    {
+        Double_t time;
+        Double_t energy;
+        TVector3 position;
+    };
+
+    TString fTableFile;
+    TCAInputConnector<R3BMCTrack> fTracks;
+    TCAOutputConnector<R3BNeulandHit> fHits;
+
+    R3BNeulandGeoPar* fNeulandGeoPar; // non-owning
+    Neuland::PaddleLookup fLookup;
+    std::unique_ptr<R3BNeulandFastSimTable> fTable;
+    TRandom3 fRnd;
+
+    std::map<Int_t, PaddleHit> fPaddleHits;
+    std::vector<R3BNeulandFastSimTable::Hit> fEntryHits;
+
+    ClassDefOverride(R3BNeulandFastSim, 0)
+};
+
+#endif // R3BNEULANDFASTSIM_H
@@ -0,0 +1,121 @@
+/******************************************************************************
+ *   Copyright (C) 2019 GSI Helmholtzzentrum für Schwerionenforschung GmbH    *
+ *   Copyright (C) 2019 Members of R3B Collaboration                          *
+ *                                                                            *
+ *             This software is distributed under the terms of the            *
+ *                 GNU General Public Licence (GPL) version 3,                *
+ *                    copied verbatim in the file "LICENSE".                  *
+ *                                                                            *
+ * In applying this license GSI does not waive the privileges and immunities  *
+ * granted to it by virtue of its status as an Intergovernmental Organization *
+ * or submit itself to any jurisdiction.                                      *
+ ******************************************************************************/
+
+#include "R3BNeulandFastSimTable.h"
+#include "TRandom.h"
+#include <algorithm>
+#include <cmath>
+
+R3BNeulandFastSimTable::R3BNeulandFastSimTable(Double_t energyBinWidth)
+    : TNamed("R3BNeulandFastSimTable", "NeuLAND fast simulation response table")
+    , fEnergyBinWidth(energyBinWidth)
+{
+}
+
+void R3BNeulandFastSimTable::AddNoInteraction(Double_t energy)
+{
+    AddInteraction(energy, -1., TVector3(), 0., {});
+}
+
+void R3BNeulandFastSimTable::AddInteraction(Double_t energy,
+                                            Double_t depth,
+                                            const TVector3& offset,
+                                            Double_t dt,
+                                            const std::vector<Hit>& hits)
+{
+    fEntryBin.push_back(std::max(0, (Int_t)std::floor(energy / fEnergyBinWidth)));
+    fEntryFirstHit.push_back(fHitE.size());
+    fEntryDepth.push_back(depth);
+    fEntryDX.push_back(offset.X());
+    fEntryDY.push_back(offset.Y());
+    fEntryDZ.push_back(offset.Z());
+    fEntryDT.push_back(dt);
+
+    for (const auto& hit : hits)
+    {
+        fHitDX.push_back(hit.offset.X());
+        fHitDY.push_back(hit.offset.Y());
+        fHitDZ.push_back(hit.offset.Z());
+        fHitDT.push_back(hit.dt);
+        fHitE.push_back(hit.e);
+    }
+
+    fBinEntries.clear();
+}
+
+Int_t R3BNeulandFastSimTable::Sample(Double_t energy, TRandom* rnd) const
+{
+    if (fBinEntries.empty())
+    {
+        BuildIndex();
+    }
+
+    const Int_t nBins = fBinEntries.size();
+    const Int_t bin = std::max(0, (Int_t)std::floor(energy / fEnergyBinWidth));
+
+    // Search outwards for the closest filled bin
+    for (Int_t d = 0; bin - d >= 0 || bin + d < nBins; d++)
+    {
+        for (const auto b : { bin - d, bin + d })
+        {
+            if (b >= 0 && b < nBins && !fBinEntries[b].empty())
+            {
+                const auto& entries = fBinEntries[b];
+                return entries[std::min<Int_t>(entries.size() - 1, rnd->Rndm() * entries.size())];
+            }
+        }
+    }
+    return -1;
+}
+
+TVector3 R3BNeulandFastSimTable::GetOffset(Int_t entry) const
+{
+    return TVector3(fEntryDX.at(entry), fEntryDY.at(entry), fEntryDZ.at(entry));
+}
+
+void R3BNeulandFastSimTable::GetHits(Int_t entry, std::vector<Hit>& hits) const
+{
+    hits.clear();
+    const Int_t begin = fEntryFirstHit.at(entry);
+    const Int_t end = entry + 1 < GetNEntries() ? fEntryFirstHit[entry + 1] : (Int_t)fHitE.size();
+    for (Int_t i = begin; i < end; i++)
+    {
+        hits.push_back(Hit{ TVector3(fHitDX[i], fHitDY[i], fHitDZ[i]), fHitDT[i], fHitE[i] });
+    }
+}
+
+TVector3 R3BNeulandFastSimTable::ToNeutronFrame(const TVector3& v, const TVector3& direction)
+{
+    // Inverse of TVector3::RotateUz: project onto the images of the axes
+    TVector3 ex(1., 0., 0.);
+    TVector3 ey(0., 1., 0.);
+    ex.RotateUz(direction);
+    ey.RotateUz(direction);
+    return TVector3(v.Dot(ex), v.Dot(ey), v.Dot(direction));
+}
+
+void R3BNeulandFastSimTable::BuildIndex() const
+{
+    fBinEntries.clear();
+    for (Int_t i = 0; i < GetNEntries(); i++)
+    {
+        const Int_t bin = fEntryBin[i];
+        if (bin >= (Int_t)fBinEntries.size())
+        {
+            fBinEntries.resize(bin + 1);
+        }
+        fBinEntries[bin].push_back(i);
+    }
+}
+
+ClassImp(R3BNeulandFastSimTable);
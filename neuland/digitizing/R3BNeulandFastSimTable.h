@@ -0,0 +1,106 @@
+/******************************************************************************
+ *   Copyright (C) 2019 GSI Helmholtzzentrum für Schwerionenforschung GmbH    *
+ *   Copyright (C) 2019 Members of R3B Collaboration                          *
+ *                                                                            *
+ *             This software is distributed under the terms of the            *
+ *                 GNU General Public Licence (GPL) version 3,                *
+ *                    copied verbatim in the file "LICENSE".                  *
+ *                                                                            *
+ * In applying this license GSI does not waive the privileges and immunities  *
+ * granted to it by virtue of its status as an Intergovernmental Organization *
+ * or submit itself to any jurisdiction.                                      *
+ ******************************************************************************/
+
+#ifndef R3BNEULANDFASTSIMTABLE_H
+#define R3BNEULANDFASTSIMTABLE_H
+
+#include "TNamed.h"
+#include "TVector3.h"
+#include <vector>
+
+class TRandom;
+
+/**
+ * NeuLAND fast simulation response table
+ *
+ * Library of the detector response to single primary neutrons, binned in kinetic energy and derived from a full
+ * simulation with R3BNeulandFastSimTableMaker. Each entry is the response to one neutron that entered the front face:
+ * either no interaction, or the first interaction point and the hits it led to. Sampling complete entries keeps the
+ * correlations between interaction probability, depth, deposited light and hit topology.
+ *
+ * The first interaction is stored relative to the neutron line: depth is the path length behind the front face, the
+ * offset the remaining displacement from the line, and the time offset is relative to the time of flight along the
+ * line. Hits are stored relative to the first interaction. Offsets are given in the frame of the neutron, with z along
+ * its direction and x, y as defined by TVector3::RotateUz, such that the response can be placed on neutron lines of
+ * any direction. Use ToNeutronFrame and FromNeutronFrame to convert from and to the NeuLAND frame.
+ */
+
+class R3BNeulandFastSimTable : public TNamed
+{
+  public:
+    struct Hit
+    {
+        TVector3 offset; // [cm]
+        Double_t dt;     // [ns]
+        Double_t e;      // [MeV]
+    };
+
+    explicit R3BNeulandFastSimTable(Double_t energyBinWidth = 10.);
+
+    void AddNoInteraction(Double_t energy);
+    void AddInteraction(Double_t energy,
+                        Double_t depth,
+                        const TVector3& offset,
+                        Double_t dt,
+                        const std::vector<Hit>& hits);
+
+    // Random entry of the energy bin, or of the closest filled bin. Returns -1 if the table is empty.
+    Int_t Sample(Double_t energy, TRandom* rnd) const;
+
+    Int_t GetNEntries() const { return fEntryDepth.size(); }
+    Double_t GetEnergyBinWidth() const { return fEnergyBinWidth; }
+    bool IsInteraction(Int_t entry) const { return fEntryDepth.at(entry) >= 0.; }
+    Double_t GetDepth(Int_t entry) const { return fEntryDepth.at(entry); }
+    TVector3 GetOffset(Int_t entry) const;
+    Double_t GetTimeOffset(Int_t entry) const { return fEntryDT.at(entry); }
+    void GetHits(Int_t entry, std::vector<Hit>& hits) const;
+
+    // Time of flight [ns] along the neutron line, to which the time offsets are relative
+    static Double_t TimeOfFlight(Double_t pathLength, Double_t beta) { return pathLength / (beta * kSpeedOfLight); }
+
+    static TVector3 ToNeutronFrame(const TVector3& v, const TVector3& direction);
+    static TVector3 FromNeutronFrame(TVector3 v, const TVector3& direction)
+    {
+        v.RotateUz(direction);
+        return v;
+    }
+
+  private:
+    static constexpr Double_t kSpeedOfLight = 29.9792458; // [cm/ns]
+
+    void BuildIndex() const;
+
+    Double_t fEnergyBinWidth; // [MeV]
+
+    // Per entry, the depth is negative if there was no interaction
+    std::vector<Int_t> fEntryBin;
+    std::vector<Int_t> fEntryFirstHit;
+    std::vector<Float_t> fEntryDepth;
+    std::vector<Float_t> fEntryDX;
+    std::vector<Float_t> fEntryDY;
+    std::vector<Float_t> fEntryDZ;
+    std::vector<Float_t> fEntryDT;
+
+    // Per hit, all entries are stored back to back
+    std::vector<Float_t> fHitDX;
+    std::vector<Float_t> fHitDY;
+    std::vector<Float_t> fHitDZ;
+    std::vector<Float_t> fHitDT;
+    std::vector<Float_t> fHitE;
+
+    mutable std::vector<std::vector<Int_t>> fBinEntries; //! Entries per energy bin, rebuilt after reading
+
+    ClassDefOverride(R3BNeulandFastSimTable, 2)
+};
+
+#endif // R3BNEULANDFASTSIMTABLE_H
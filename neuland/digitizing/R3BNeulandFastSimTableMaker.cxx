@@ -0,0 +1,180 @@
+/******************************************************************************
+ *   Copyright (C) 2019 GSI Helmholtzzentrum für Schwerionenforschung GmbH    *
+ *   Copyright (C) 2019 Members of R3B Collaboration                          *
+ *                                                                            *
+ *             This software is distributed under the terms of the            *
+ *                 GNU General Public Licence (GPL) version 3,                *
+ *                    copied verbatim in the file "LICENSE".                  *
+ *                                                                            *
+ * In applying this license GSI does not waive the privileges and immunities  *
+ * granted to it by virtue of its status as an Intergovernmental Organization *
+ * or submit itself to any jurisdiction.                                      *
+ ******************************************************************************/
+
+#include "R3BNeulandFastSimTableMaker.h"
+#include "FairLogger.h"
+#include "FairRootManager.h"
+#include "FairRunAna.h"
+#include "FairRuntimeDb.h"
+#include "PrimaryTrack.h"
+#include <algorithm>
+#include <utility>
+
+R3BNeulandFastSimTableMaker::R3BNeulandFastSimTableMaker(Double_t energyBinWidth, TString points, TString hits)
+    : FairTask("R3BNeulandFastSimTableMaker")
+    , fTracks("MCTrack")
+    , fPoints(std::move(points))
+    , fHits(std::move(hits))
+    , fNeulandGeoPar(nullptr)
+    , fTable(energyBinWidth)
+{
+}
+
+void R3BNeulandFastSimTableMaker::SetParContainers()
+{
+    FairRunAna* run = FairRunAna::Instance();
+    if (!run)
+    {
+        LOG(FATAL) << "R3BNeulandFastSimTableMaker::SetParContainers: No analysis run";
+        return;
+    }
+
+    FairRuntimeDb* rtdb = run->GetRuntimeDb();
+    if (!rtdb)
+    {
+        LOG(FATAL) << "R3BNeulandFastSimTableMaker::SetParContainers: No runtime database";
+        return;
+    }
+
+    fNeulandGeoPar = (R3BNeulandGeoPar*)rtdb->getContainer("R3BNeulandGeoPar");
+    if (!fNeulandGeoPar)
+    {
+        LOG(FATAL) << "R3BNeulandFastSimTableMaker::SetParContainers: No R3BNeulandGeoPar";
+        return;
+    }
+}
+
+InitStatus R3BNeulandFastSimTableMaker::Init()
+{
+    fTracks.Init();
+    fPoints.Init();
+    fHits.Init();
+    fLookup = Neuland::PaddleLookup(fNeulandGeoPar);
+    return kSUCCESS;
+}
+
+void R3BNeulandFastSimTableMaker::Exec(Option_t*)
+{
+    const auto tracks = fTracks.Retrieve();
+    const auto points = fPoints.Retrieve();
+    const auto hits = fHits.Retrieve();
+
+    fPrimaryOfTrack.assign(tracks.size(), Neuland::UnresolvedTrack);
+    fFirstPoint.assign(tracks.size(), nullptr);
+    fFirstPointInPaddle.clear();
+    if (fHitsOfPrimary.size() < tracks.size())
+    {
+        fHitsOfPrimary.resize(tracks.size());
+    }
+
+    for (const auto point : points)
+    {
+        const auto iPrimary = Neuland::FindPrimaryTrack(point->GetTrackID(), tracks, fPrimaryOfTrack);
+        if (iPrimary < 0)
+        {
+            continue;
+        }
+
+        if (fFirstPoint[iPrimary] == nullptr || point->GetTime() < fFirstPoint[iPrimary]->GetTime())
+        {
+            fFirstPoint[iPrimary] = point;
+        }
+
+        // Only points with energy loss contribute to hits, see R3BNeulandDigitizer
+        const auto paddle = point->GetPaddle();
+        if (point->GetEnergyLoss() > 0. && paddle >= 0)
+        {
+            if (paddle >= (Int_t)fFirstPointInPaddle.size())
+            {
+                fFirstPointInPaddle.resize(paddle + 1, nullptr);
+            }
+            if (fFirstPointInPaddle[paddle] == nullptr || point->GetTime() < fFirstPointInPaddle[paddle]->GetTime())
+            {
+                fFirstPointInPaddle[paddle] = point;
+            }
+        }
+    }
+
+    for (const auto hit : hits)
+    {
+        const auto paddle = hit->GetPaddle();
+        if (paddle < 0 || paddle >= (Int_t)fFirstPointInPaddle.size() || fFirstPointInPaddle[paddle] == nullptr)
+        {
+            continue;
+        }
+        const auto iPrimary = fPrimaryOfTrack[fFirstPointInPaddle[paddle]->GetTrackID()];
+        const auto firstPoint = fFirstPoint[iPrimary];
+        TVector3 momentum;
+        tracks[iPrimary]->GetMomentum(momentum);
+        const auto direction = fLookup.ToNeulandDirection(momentum).Unit();
+        fHitsOfPrimary[iPrimary].push_back(R3BNeulandFastSimTable::Hit{
+            R3BNeulandFastSimTable::ToNeutronFrame(fLookup.ToNeulandPosition(hit->GetPosition()) -
+                                                       fLookup.ToNeulandPosition(firstPoint->GetPosition()),
+                                                   direction),
+            hit->GetT() - firstPoint->GetTime(),
+            hit->GetE() });
+    }
+
+    for (size_t iTrack = 0; iTrack < tracks.size(); iTrack++)
+    {
+        const auto track = tracks[iTrack];
+        if (!Neuland::IsPrimaryTrack(track))
+        {
+            continue;
+        }
+
+        TVector3 start;
+        TVector3 momentum;
+        track->GetStartVertex(start);
+        track->GetMomentum(momentum);
+        const auto vertex = fLookup.ToNeulandPosition(start);
+        const auto direction = fLookup.ToNeulandDirection(momentum).Unit();
+
+        Double_t entry;
+        if (fLookup.FindEntry(vertex, direction, entry))
+        {
+            const auto energy = (track->GetEnergy() - track->GetMass()) * 1000.; // [MeV]
+            const auto firstPoint = fFirstPoint[iTrack];
+            if (firstPoint == nullptr)
+            {
+                fTable.AddNoInteraction(energy);
+            }
+            else
+            {
+                const auto position = fLookup.ToNeulandPosition(firstPoint->GetPosition());
+                const auto pathLength = (position - vertex).Dot(direction);
+                const auto beta = track->GetP() / track->GetEnergy();
+                const auto tof = track->GetStartT() + R3BNeulandFastSimTable::TimeOfFlight(pathLength, beta);
+                fTable.AddInteraction(energy,
+                                      std::max(0., pathLength - entry),
+                                      R3BNeulandFastSimTable::ToNeutronFrame(
+                                          position - (vertex + pathLength * direction), direction),
+                                      firstPoint->GetTime() - tof,
+                                      fHitsOfPrimary[iTrack]);
+            }
+        }
+        fHitsOfPrimary[iTrack].clear();
+    }
+}
+
+void R3BNeulandFastSimTableMaker::Finish()
+{
+    LOG(INFO) << "R3BNeulandFastSimTableMaker: Table with " << fTable.GetNEntries() << " entries";
+
+    TDirectory* tmp = gDirectory;
+    FairRootManager::Instance()->GetOutFile()->cd();
+    fTable.Write();
+    gDirectory = tmp;
+}
+
+ClassImp(R3BNeulandFastSimTableMaker);
@@ -0,0 +1,80 @@
+/******************************************************************************
+ *   Copyright (C) 2019 GSI Helmholtzzentrum für Schwerionenforschung GmbH    *
+ *   Copyright (C) 2019 Members of R3B Collaboration                          *
+ *                                                                            *
+ *             This software is distributed under the terms of the            *
+ *                 GNU General Public Licence (GPL) version 3,                *
+ *                    copied verbatim in the file "LICENSE".                  *
+ *                                                                            *
+ * In applying this license GSI does not waive the privileges and immunities  *
+ * granted to it by virtue of its status as an Intergovernmental Organization *
+ * or submit itself to any jurisdiction.                                      *
+ ******************************************************************************/
+
+#ifndef R3BNEULANDFASTSIMTABLEMAKER_H
+#define R3BNEULANDFASTSIMTABLEMAKER_H
+
+#include "FairTask.h"
+#include "PaddleLookup.h"
+#include "R3BMCTrack.h"
+#include "R3BNeulandFastSimTable.h"
+#include "R3BNeulandGeoPar.h"
+#include "R3BNeulandHit.h"
+#include "R3BNeulandPoint.h"
+#include "TCAConnector.h"
+#include <vector>
+
+/**
+ * NeuLAND fast simulation table maker task
+ *
+ * Derives the response table for R3BNeulandFastSim from a full simulation. For each primary neutron that enters
+ * the front face of NeuLAND, the earliest point traced back to it is taken as first interaction, and each hit is
+ * attributed to the primary neutron of the earliest point with energy loss in its paddle.
+ *   Input:  Branches MCTrack, NeulandPoints and NeulandHits (from R3BNeulandDigitizer)
+ *           Stored Neuland Geometry Parameter NeulandGeoPar
+ *   Output: R3BNeulandFastSimTable written to the output file
+ */
+
+class R3BNeulandFastSimTableMaker : public FairTask
+{
+  public:
+    explicit R3BNeulandFastSimTableMaker(Double_t energyBinWidth = 10.,
+                                         TString points = "NeulandPoints",
+                                         TString hits = "NeulandHits");
+
+    ~R3BNeulandFastSimTableMaker() override = default;
+
+    // No copy and no move is allowed (Rule of three/five)
+    R3BNeulandFastSimTableMaker(const R3BNeulandFastSimTableMaker&) = delete;
+    R3BNeulandFastSimTableMaker(R3BNeulandFastSimTableMaker&&) = delete;
+    R3BNeulandFastSimTableMaker& operator=(const R3BNeulandFastSimTableMaker&) = delete;
+    R3BNeulandFastSimTableMaker& operator=(R3BNeulandFastSimTableMaker&&) = delete;
+
+  protected:
+    InitStatus Init() override;
+    void Finish() override;
+    void SetParContainers() override;
+
+  public:
+    void Exec(Option_t*) override;
+
+  private:
+    TCAInputConnector<R3BMCTrack> fTracks;
+    TCAInputConnector<R3BNeulandPoint> fPoints;
+    TCAInputConnector<R3BNeulandHit> fHits;
+
+    R3BNeulandGeoPar* fNeulandGeoPar; // non-owning
+    Neuland::PaddleLookup fLookup;
+
+    R3BNeulandFastSimTable fTable;
+
+    // Per event lookup tables, kept to reuse their memory
+    std::vector<Int_t> fPrimaryOfTrack;
+    std::vector<R3BNeulandPoint*> fFirstPoint;
+    std::vector<R3BNeulandPoint*> fFirstPointInPaddle;
+    std::vector<std::vector<R3BNeulandFastSimTable::Hit>> fHitsOfPrimary;
+
+    ClassDefOverride(R3BNeulandFastSimTableMaker, 0)
+};
+
+#endif // R3BNEULANDFASTSIMTABLEMAKER_H
@@ -0,0 +1,193 @@
+/******************************************************************************
+ *   Copyright (C) 2019 GSI Helmholtzzentrum für Schwerionenforschung GmbH    *
+ *   Copyright (C) 2019 Members of R3B Collaboration                          *
+ *                                                                            *
+ *             This software is distributed under the terms of the            *
+ *                 GNU General Public Licence (GPL) version 3,                *
+ *                    copied verbatim in the file "LICENSE".                  *
+ *                                                                            *
+ * In applying this license GSI does not waive the privileges and immunities  *
+ * granted to it by virtue of its status as an Intergovernmental Organization *
+ * or submit itself to any jurisdiction.                                      *
+ ******************************************************************************/
+
+#include "BatchExecutor.h"
+#include "FairLogger.h"
+#include "ParallelFor.h"
+#include "R3BNeulandDigitizer.h"
+#include "R3BNeulandGeoPar.h"
+#include "ReconstructionEngine.h"
+#include "TClonesArray.h"
+#include "TROOT.h"
+#include "TTree.h"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <utility>
+
+Neuland::BatchExecutor::BatchExecutor(const R3BNeulandGeoPar* geoPar,
+                                      EngineFactory engineFactory,
+                                      const ReconstructionEngine* reco,
+                                      const unsigned int nThreads)
+    : fGeoPar(geoPar)
+    , fEngineFactory(std::move(engineFactory))
+    , fReco(reco)
+    , fNThreads(nThreads)
+    , fSeed(1)
+    , fNProcessed(0)
+{
+    if (fGeoPar == nullptr)
+    {
+        throw std::runtime_error("Neuland::BatchExecutor: No R3BNeulandGeoPar");
+    }
+    SetClusteringCondition();
+    // ROOT objects are created in several threads
+    ROOT::EnableThreadSafety();
+}
+
+void Neuland::BatchExecutor::SetClusteringCondition(const Double_t dx,
+                                                   const Double_t dy,
+                                                   const Double_t dz,
+                                                   const Double_t dt)
+{
+    fClusteringEngine.SetClusteringCondition([=](const R3BNeulandHit& a, const R3BNeulandHit& b) {
+        return std::abs(a.GetPosition().X() - b.GetPosition().X()) < dx &&
+               std::abs(a.GetPosition().Y() - b.GetPosition().Y()) < dy &&
+               std::abs(a.GetPosition().Z() - b.GetPosition().Z()) < dz && std::abs(a.GetT() - b.GetT()) < dt;
+    });
+}
+
+void Neuland::BatchExecutor::Process(std::vector<Event>& events)
+{
+    const auto first = fNProcessed;
+    Neuland::ParallelFor(events.size(), fNThreads, [&](const size_t begin, const size_t end) {
+        const auto engine = fEngineFactory();
+        for (size_t i = begin; i < end; i++)
+        {
+            ProcessEvent(*engine, events[i], first + i);
+        }
+    });
+    fNProcessed += events.size();
+}
+
+void Neuland::BatchExecutor::ProcessEvent(DigitizingEngine& engine, Event& event, const ULong64_t eventNumber) const
+{
+    // TRandom3 interprets 0 as "seed from the clock"
+    const auto seed = static_cast<UInt_t>(fSeed + eventNumber);
+    engine.SetSeed(seed == 0 ? 1 : seed);
+
+    // Digitizing, see R3BNeulandDigitizer::Exec
+    std::vector<R3BNeulandPoint*> points;
+    points.reserve(event.points.size());
+    for (auto& point : event.points)
+    {
+        points.push_back(&point);
+    }
+    R3BNeulandDigitizer::DepositPoints(engine, *fGeoPar, points);
+
+    event.hits.clear();
+    for (const auto& kv : engine.ExtractPaddles())
+    {
+        if (!kv.second->HasFired())
+        {
+            continue;
+        }
+        auto hit = R3BNeulandDigitizer::BuildHit(kv.first, *kv.second, *fGeoPar);
+        if (fHitFilters.IsValid(hit))
+        {
+            event.hits.push_back(std::move(hit));
+        }
+    }
+
+    // Clustering, see R3BNeulandClusterFinder::Exec
+    auto digis = event.hits;
+    event.clusters.clear();
+    for (auto& cluster : fClusteringEngine.Clusterize(digis))
+    {
+        event.clusters.emplace_back(std::move(cluster));
+    }
+
+    // Reconstruction, see R3BNeulandNeutronReconstruction::Exec
+    event.neutrons.clear();
+    if (fReco != nullptr)
+    {
+        std::vector<R3BNeulandCluster*> clusters;
+        clusters.reserve(event.clusters.size());
+        for (auto& cluster : event.clusters)
+        {
+            clusters.push_back(&cluster);
+        }
+        event.neutrons = fReco->GetNeutrons(clusters);
+    }
+}
+
+Long64_t Neuland::BatchExecutor::ProcessTree(TTree* input, TTree* output, const size_t batchSize)
+{
+    TClonesArray* inPoints = nullptr;
+    if (input->SetBranchAddress("NeulandPoints", &inPoints) < 0)
+    {
+        throw std::runtime_error("Neuland::BatchExecutor: No branch NeulandPoints in the input tree");
+    }
+
+    auto outHits = new TClonesArray("R3BNeulandHit");
+    auto outClusters = new TClonesArray("R3BNeulandCluster");
+    auto outNeutrons = new TClonesArray("R3BNeulandNeutron");
+    output->Branch("NeulandHits", &outHits);
+    output->Branch("NeulandClusters", &outClusters);
+    if (fReco != nullptr)
+    {
+        output->Branch("NeulandNeutrons", &outNeutrons);
+    }
+
+    const Long64_t nEntries = input->GetEntries();
+    std::vector<Event> events;
+    for (Long64_t batchBegin = 0; batchBegin < nEntries; batchBegin += batchSize)
+    {
+        const Long64_t batchEnd = std::min<Long64_t>(nEntries, batchBegin + batchSize);
+
+        // Reading and writing stay sequential, only the processing is distributed
+        events.resize(batchEnd - batchBegin);
+        for (Long64_t entry = batchBegin; entry < batchEnd; entry++)
+        {
+            input->GetEntry(entry);
+            auto& points = events[entry - batchBegin].points;
+            points.clear();
+            const Int_t n = inPoints->GetEntriesFast();
+            points.reserve(n);
+            for (Int_t i = 0; i < n; i++)
+            {
+                points.push_back(*static_cast<R3BNeulandPoint*>(inPoints->At(i)));
+            }
+        }
+
+        Process(events);
+
+        for (auto& event : events)
+        {
+            outHits->Clear("C");
+            outClusters->Clear("C");
+            outNeutrons->Clear("C");
+            for (auto& hit : event.hits)
+            {
+                new ((*outHits)[outHits->GetEntriesFast()]) R3BNeulandHit(std::move(hit));
+            }
+            for (auto& cluster : event.clusters)
+            {
+                new ((*outClusters)[outClusters->GetEntriesFast()]) R3BNeulandCluster(std::move(cluster));
+            }
+            for (auto& neutron : event.neutrons)
+            {
+                new ((*outNeutrons)[outNeutrons->GetEntriesFast()]) R3BNeulandNeutron(std::move(neutron));
+            }
+            output->Fill();
+        }
+        LOG(INFO) << "Neuland::BatchExecutor: Processed " << batchEnd << " of " << nEntries << " events";
+    }
+
+    input->ResetBranchAddresses();
+    output->ResetBranchAddresses();
+    delete outHits;
+    delete outClusters;
+    delete outNeutrons;
+    return nEntries;
+}
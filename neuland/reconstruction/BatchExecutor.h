@@ -0,0 +1,94 @@
+/******************************************************************************
+ *   Copyright (C) 2019 GSI Helmholtzzentrum für Schwerionenforschung GmbH    *
+ *   Copyright (C) 2019 Members of R3B Collaboration                          *
+ *                                                                            *
+ *             This software is distributed under the terms of the            *
+ *                 GNU General Public Licence (GPL) version 3,                *
+ *                    copied verbatim in the file "LICENSE".                  *
+ *                                                                            *
+ * In applying this license GSI does not waive the privileges and immunities  *
+ * granted to it by virtue of its status as an Intergovernmental Organization *
+ * or submit itself to any jurisdiction.                                      *
+ ******************************************************************************/
+
+#ifndef NEULAND_BATCHEXECUTOR_H
+#define NEULAND_BATCHEXECUTOR_H
+
+#include "ClusteringEngine.h"
+#include "DigitizingEngine.h"
+#include "Filterable.h"
+#include "R3BNeulandCluster.h"
+#include "R3BNeulandHit.h"
+#include "R3BNeulandNeutron.h"
+#include "R3BNeulandPoint.h"
+#include "Rtypes.h"
+#include <functional>
+#include <memory>
+#include <vector>
+
+class R3BNeulandGeoPar;
+class TTree;
+
+namespace Neuland
+{
+    class ReconstructionEngine;
+
+    /* Runs the NeuLAND chain Digitizer -> ClusterFinder -> neutron reconstruction for batches of events outside of
+     * FairRun, with the events of a batch distributed over several threads. None of these steps keeps state between
+     * events, so each event is processed independently and the results are stored back in the order of the input.
+     *
+     * Each thread uses its own digitizing engine, created by the engine factory. The random sequence of the engine is
+     * restarted for every event with a seed derived from the event number, so the output does not depend on the number
+     * of threads. The reconstruction engine is shared and must support concurrent calls of GetNeutrons.
+     */
+    class BatchExecutor
+    {
+      public:
+        using EngineFactory = std::function<std::unique_ptr<DigitizingEngine>()>;
+
+        struct Event
+        {
+            std::vector<R3BNeulandPoint> points; // input
+            std::vector<R3BNeulandHit> hits;
+            std::vector<R3BNeulandCluster> clusters;
+            std::vector<R3BNeulandNeutron> neutrons;
+        };
+
+        // geoPar and reco are not owned. Without reconstruction engine, no neutrons are produced.
+        BatchExecutor(const R3BNeulandGeoPar* geoPar,
+                      EngineFactory engineFactory,
+                      const ReconstructionEngine* reco = nullptr,
+                      unsigned int nThreads = 0);
+
+        // Same defaults as R3BNeulandClusterFinder
+        void SetClusteringCondition(Double_t dx = 1. * 7.5,
+                                    Double_t dy = 1. * 7.5,
+                                    Double_t dz = 2. * 7.5,
+                                    Double_t dt = 1.);
+        void AddFilter(const Filterable<R3BNeulandHit&>::Filter& f) { fHitFilters.Add(f); }
+        void SetSeed(UInt_t seed) { fSeed = seed; }
+        void SetNThreads(unsigned int n) { fNThreads = n; }
+
+        // Processes the points of all events, filling their hits, clusters and neutrons
+        void Process(std::vector<Event>& events);
+
+        /* Reads the TClonesArray branch NeulandPoints of the input tree in batches of batchSize events and fills the
+         * branches NeulandHits, NeulandClusters and (with reconstruction engine) NeulandNeutrons of the output tree,
+         * one entry per input entry. Returns the number of processed events. */
+        Long64_t ProcessTree(TTree* input, TTree* output, size_t batchSize = 1000);
+
+      private:
+        void ProcessEvent(DigitizingEngine& engine, Event& event, ULong64_t eventNumber) const;
+
+        const R3BNeulandGeoPar* fGeoPar;
+        EngineFactory fEngineFactory;
+        const ReconstructionEngine* fReco;
+        unsigned int fNThreads;
+        UInt_t fSeed;
+        ULong64_t fNProcessed;
+        ClusteringEngine<R3BNeulandHit> fClusteringEngine;
+        Filterable<R3BNeulandHit&> fHitFilters;
+    };
+} // namespace Neuland
+
+#endif // NEULAND_BATCHEXECUTOR_H
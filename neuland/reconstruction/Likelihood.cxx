@@ -15,10 +15,13 @@
 #include <boost/algorithm/string.hpp>
 #include <fstream>
 #include <iostream>
-#include <vector>
+#include <map>
 
 Neuland::Likelihood::Likelihood(const std::string& filename)
     : fFileName(filename)
+    , fEMin(0)
+    , fEMax(-1)
+    , fNHypos(0)
 {
 
     std::cout << "Neuland::Likelihood::Likelihood processing " << filename << std::endl;
@@ -38,6 +41,7 @@ Neuland::Likelihood::Likelihood(const std::string& filename)
     }
 
     // Get Data
+    std::map<int, std::map<H, double>> data;
     while (std::getline(file, line))
     {
         if (line.empty())
@@ -47,24 +51,53 @@ Neuland::Likelihood::Likelihood(const std::string& filename)
         boost::algorithm::split(split, line, boost::is_any_of("\t "), boost::algorithm::token_compress_on);
         for (size_t i = 1; i < split.size(); i++)
         {
-            fData[std::stoi(split.at(0))][hs.at(i - 1)] = std::stof((split.at(i)));
+            data[std::stoi(split.at(0))][hs.at(i - 1)] = std::stof((split.at(i)));
         }
     }
-}
 
-double Neuland::Likelihood::P(Neuland::Likelihood::E e, Neuland::Likelihood::H h) const
-{
-    const auto eit = fData.lower_bound(e);
-    if (eit == fData.end())
+    if (data.empty())
+    {
+        std::cout << "Neuland::Likelihood::Likelihood - No data found in " << filename << std::endl;
+        return;
+    }
+
+    // Flatten into a regular table with unit bin width. Each bin holds the values of the first row at or above it.
+    for (const auto& h : hs)
     {
-        std::cout << "Neuland::Likelihood::P(E|H) - E " << e << " not found in " << fFileName << std::endl;
-        return 0;
+        if (h < 0)
+        {
+            std::cout << "Neuland::Likelihood::Likelihood - Ignoring negative hypothesis " << h << std::endl;
+            continue;
+        }
+        if (h >= static_cast<H>(fHypoIndex.size()))
+        {
+            fHypoIndex.resize(h + 1, -1);
+        }
+        if (fHypoIndex[h] < 0)
+        {
+            fHypoIndex[h] = fNHypos++;
+        }
     }
-    const auto nit = eit->second.find(h);
-    if (nit == eit->second.end())
+
+    const auto eMin = data.cbegin()->first;
+    const auto eMax = data.crbegin()->first;
+    fEMin = eMin;
+    fEMax = eMax;
+    fData.assign(static_cast<size_t>(eMax - eMin + 1) * fNHypos, 0.);
+
+    auto row = data.cbegin();
+    for (int e = eMin; e <= eMax; e++)
     {
-        std::cout << "Neuland::Likelihood::P(E|H) - H " << h << " not found in " << fFileName << std::endl;
-        return 0;
+        if (row->first < e)
+        {
+            ++row;
+        }
+        for (const auto& hp : row->second)
+        {
+            if (hp.first >= 0)
+            {
+                fData[static_cast<size_t>(e - eMin) * fNHypos + fHypoIndex[hp.first]] = hp.second;
+            }
+        }
     }
-    return nit->second;
 }
@@ -14,11 +14,16 @@
 #ifndef R3BROOT_LIKELIHOOD_H
 #define R3BROOT_LIKELIHOOD_H
 
-#include <map>
+#include <cmath>
 #include <string>
+#include <vector>
 
 namespace Neuland
 {
+    // Likelihood table P(E|H), read from a text file with the hypotheses in the first line and one line per
+    // (integer) value of E. P(e, h) returns the entry of the first row with E >= e, like a lower_bound lookup.
+    // The rows are stored in a flat, regularly binned table with unit bin width, so the lookup is a direct index
+    // computation instead of a tree search.
     class Likelihood
     {
       public:
@@ -27,11 +32,25 @@ namespace Neuland
 
         explicit Likelihood(const std::string& filename);
 
-        double P(E e, H h) const;
+        double P(E e, H h) const
+        {
+            if (!(e <= fEMax) || h < 0 || h >= static_cast<H>(fHypoIndex.size()) || fHypoIndex[h] < 0)
+            {
+                return 0;
+            }
+            const auto row = e <= fEMin ? 0 : static_cast<size_t>(std::ceil(e) - fEMin);
+            return fData[row * fNHypos + fHypoIndex[h]];
+        }
+
+        const std::string& GetFileName() const { return fFileName; }
 
       private:
         std::string fFileName;
-        std::map<E, std::map<H, double>> fData;
+        E fEMin;
+        E fEMax;
+        size_t fNHypos;
+        std::vector<int> fHypoIndex; // hypothesis -> column, -1 if not present
+        std::vector<double> fData;   // row-major, (E - fEMin) * fNHypos + column
     };
 } // namespace Neuland
 
@@ -0,0 +1,121 @@
+/******************************************************************************
+ *   Copyright (C) 2019 GSI Helmholtzzentrum für Schwerionenforschung GmbH    *
+ *   Copyright (C) 2019 Members of R3B Collaboration                          *
+ *                                                                            *
+ *             This software is distributed under the terms of the            *
+ *                 GNU General Public Licence (GPL) version 3,                *
+ *                    copied verbatim in the file "LICENSE".                  *
+ *                                                                            *
+ * In applying this license GSI does not waive the privileges and immunities  *
+ * granted to it by virtue of its status as an Intergovernmental Organization *
+ * or submit itself to any jurisdiction.                                      *
+ ******************************************************************************/
+
+#include "LikelihoodBuilder.h"
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <set>
+#include <stdexcept>
+
+void Neuland::LikelihoodBuilder::Add(const EventRecord& event)
+{
+    const auto clusters = event.GetClusters();
+
+    double etot = 0.;
+    for (size_t i = 0; i < clusters.size(); i++)
+    {
+        const auto& cluster = clusters[i];
+        const int primary = event.clusters[i].primaryInteractions > 0 ? 1 : 0;
+        etot += cluster.GetE();
+
+        // Same quantities as the cluster likelihoods in RecoBayes
+        Fill(fTables["energy"], cluster.GetE(), primary);
+        Fill(fTables["etof"], cluster.GetEToF(), primary);
+        Fill(fTables["rval"], std::log10(cluster.GetRCluster(0.793)), primary);
+        Fill(fTables["size"], cluster.GetSize(), primary);
+        Fill(fTables["time"], cluster.GetT(), primary);
+    }
+
+    if (!clusters.empty())
+    {
+        Fill(fTables["nclus"], clusters.size(), event.nIn);
+        Fill(fTables["etot"], etot, event.nIn);
+    }
+}
+
+void Neuland::LikelihoodBuilder::AddFile(const std::string& filename)
+{
+    EventReader reader(filename);
+    EventRecord event;
+    while (reader.Next(event))
+    {
+        Add(event);
+    }
+}
+
+void Neuland::LikelihoodBuilder::Write(const std::string& prefix) const
+{
+    for (const auto& table : fTables)
+    {
+        WriteTable(table.second, prefix + "." + table.first + ".dat");
+    }
+}
+
+void Neuland::LikelihoodBuilder::Fill(Table& table, const double value, const int hypothesis)
+{
+    if (!std::isfinite(value))
+    {
+        return;
+    }
+    // Likelihood::P(e, h) uses the first row with E >= e
+    table[static_cast<int>(std::ceil(value))][hypothesis] += 1.;
+}
+
+void Neuland::LikelihoodBuilder::WriteTable(const Table& table, const std::string& filename)
+{
+    if (table.empty())
+    {
+        return;
+    }
+
+    std::set<int> hypotheses;
+    std::map<int, double> norm;
+    for (const auto& row : table)
+    {
+        for (const auto& hc : row.second)
+        {
+            hypotheses.insert(hc.first);
+            norm[hc.first] += hc.second;
+        }
+    }
+
+    std::ofstream file(filename);
+    if (!file)
+    {
+        throw std::runtime_error("Neuland::LikelihoodBuilder: Cannot write " + filename);
+    }
+    std::cout << "Neuland::LikelihoodBuilder writing " << filename << std::endl;
+
+    file << "E";
+    for (const auto h : hypotheses)
+    {
+        file << "\t" << h;
+    }
+    file << "\n";
+
+    // All rows are written, as Likelihood fills gaps with the next row
+    const auto empty = std::map<int, double>();
+    for (int e = table.cbegin()->first; e <= table.crbegin()->first; e++)
+    {
+        const auto it = table.find(e);
+        const auto& counts = it == table.cend() ? empty : it->second;
+        file << e;
+        for (const auto h : hypotheses)
+        {
+            const auto hc = counts.find(h);
+            file << "\t" << (hc == counts.cend() ? 0. : hc->second / norm.at(h));
+        }
+        file << "\n";
+    }
+}
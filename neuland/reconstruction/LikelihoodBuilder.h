@@ -0,0 +1,44 @@
+/******************************************************************************
+ *   Copyright (C) 2019 GSI Helmholtzzentrum für Schwerionenforschung GmbH    *
+ *   Copyright (C) 2019 Members of R3B Collaboration                          *
+ *                                                                            *
+ *             This software is distributed under the terms of the            *
+ *                 GNU General Public Licence (GPL) version 3,                *
+ *                    copied verbatim in the file "LICENSE".                  *
+ *                                                                            *
+ * In applying this license GSI does not waive the privileges and immunities  *
+ * granted to it by virtue of its status as an Intergovernmental Organization *
+ * or submit itself to any jurisdiction.                                      *
+ ******************************************************************************/
+
+#ifndef R3BROOT_LIKELIHOODBUILDER_H
+#define R3BROOT_LIKELIHOODBUILDER_H
+
+#include "EventRecord.h"
+#include <map>
+#include <string>
+
+namespace Neuland
+{
+    // Accumulates the likelihood tables used by RecoBayes from exported events. Event-level tables (nclus, etot) are
+    // binned per number of incoming neutrons, cluster-level tables per primary (1) or secondary (0) cluster.
+    // Write produces text files in the format read by Likelihood, with each row holding the normalized counts of
+    // values in (E-1, E].
+    class LikelihoodBuilder
+    {
+      public:
+        void Add(const EventRecord&);
+        void AddFile(const std::string& filename);
+        void Write(const std::string& prefix) const;
+
+      private:
+        using Table = std::map<int, std::map<int, double>>; // row -> hypothesis -> count
+
+        static void Fill(Table&, double value, int hypothesis);
+        static void WriteTable(const Table&, const std::string& filename);
+
+        std::map<std::string, Table> fTables; // suffix -> table
+    };
+} // namespace Neuland
+
+#endif // R3BROOT_LIKELIHOODBUILDER_H
@@ -156,6 +156,8 @@ namespace Neuland
     {
         const UInt_t nVars = 3;
 
+        CacheBins();
+
         ROOT::Math::Minimizer* min = ROOT::Math::Factory::CreateMinimizer("Minuit2", "Simplex");
         min->SetMaxFunctionCalls(100000000);
         min->SetMaxIterations(10000000);
@@ -177,6 +179,32 @@ namespace Neuland
         std::cout << "Neutron2DCalibr::Optimize done!" << std::endl;
     }
 
+    void Neutron2DCalibr::CacheBins()
+    {
+        // The objective is evaluated very often. Instead of looping over all bins of each histogram with
+        // TCutG::IntegralHist, only keep the filled bins (including under- and overflow) in the same order.
+        fBinsNreac.clear();
+        fEntriesNreac.clear();
+        for (const auto& nh : fHistsNreac)
+        {
+            const TH2D* h = nh.second;
+            auto& bins = fBinsNreac[nh.first];
+            for (Int_t biny = 0; biny <= h->GetNbinsY() + 1; biny++)
+            {
+                const Double_t y = h->GetYaxis()->GetBinCenter(biny);
+                for (Int_t binx = 0; binx <= h->GetNbinsX() + 1; binx++)
+                {
+                    const Double_t content = h->GetBinContent(binx, biny);
+                    if (content != 0.)
+                    {
+                        bins.push_back({ h->GetXaxis()->GetBinCenter(binx), y, content });
+                    }
+                }
+            }
+            fEntriesNreac[nh.first] = h->GetEntries();
+        }
+    }
+
     TCutG* Neutron2DCalibr::GetCut(const UInt_t nNeutrons, const Double_t k, const Double_t k0, const Double_t m)
     {
         if (!fCuts[nNeutrons])
@@ -225,11 +253,21 @@ namespace Neuland
         GetCut(0, k, k0, m);
 
         Double_t wasted_efficiency = 0;
-        for (auto& nh : fHistsNreac)
+        for (const auto& nb : fBinsNreac)
         {
-            const UInt_t nNeutrons = nh.first;
-            wasted_efficiency += 1. - ((Double_t)GetCut(nNeutrons, k, k0, m)->IntegralHist(nh.second) /
-                                       (Double_t)nh.second->GetEntries());
+            const UInt_t nNeutrons = nb.first;
+            const TCutG* cut = GetCut(nNeutrons, k, k0, m);
+
+            // Same as TCutG::IntegralHist, bins are selected by their center
+            Double_t integral = 0.;
+            for (const auto& bin : nb.second)
+            {
+                if (cut->IsInside(bin.x, bin.y))
+                {
+                    integral += bin.content;
+                }
+            }
+            wasted_efficiency += 1. - integral / fEntriesNreac.at(nNeutrons);
         }
         return wasted_efficiency;
     }
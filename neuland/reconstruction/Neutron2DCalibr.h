@@ -20,6 +20,7 @@
 #include "TString.h"
 #include <iostream>
 #include <map>
+#include <vector>
 
 class TCutG;
 class TH2D;
@@ -56,6 +57,15 @@ namespace Neuland
         void AddFilter(const Filterable<R3BNeulandCluster*>::Filter f) { fClusterFilters.Add(f); }
 
       private:
+        // Filled bin of a histogram, with the bin center as used by TCutG::IntegralHist
+        struct Bin
+        {
+            Double_t x;
+            Double_t y;
+            Double_t content;
+        };
+
+        void CacheBins();
         TCutG* GetCut(const UInt_t nNeutrons, const Double_t k, const Double_t k0, const Double_t m);
         Double_t WastedEfficiency(const Double_t* d);
 
@@ -63,6 +73,8 @@ namespace Neuland
         std::map<UInt_t, TH2D*> fHistsNreac;
         std::map<UInt_t, TH2D*> fHistsNin;
         std::map<UInt_t, TCutG*> fCuts;
+        std::map<UInt_t, std::vector<Bin>> fBinsNreac;
+        std::map<UInt_t, Double_t> fEntriesNreac;
         Filterable<R3BNeulandCluster*> fClusterFilters;
     };
 
@@ -39,11 +39,7 @@ Neuland::RecoBayes::~RecoBayes() { fhPrim->Write(); }
 std::vector<R3BNeulandNeutron> Neuland::RecoBayes::GetNeutrons(const std::vector<R3BNeulandCluster*>& clusters) const
 {
     std::vector<ScoredCluster> scoredClusters(clusters.begin(), clusters.end());
-
-    for (auto& sc : scoredClusters)
-    {
-        ScoreCluster(sc);
-    }
+    ScoreClusters(scoredClusters);
 
     std::sort(scoredClusters.begin(), scoredClusters.end(), [](const ScoredCluster& a, const ScoredCluster& b) {
         return a.prim > b.prim;
@@ -98,31 +94,47 @@ std::vector<R3BNeulandNeutron> Neuland::RecoBayes::GetNeutrons(const std::vector
     return neutrons;
 }
 
-void Neuland::RecoBayes::ScoreCluster(Neuland::RecoBayes::ScoredCluster& sc) const
+void Neuland::RecoBayes::ScoreCluster(Neuland::RecoBayes::ScoredCluster& sc) const { Score(&sc, &sc + 1); }
+
+void Neuland::RecoBayes::ScoreClusters(Neuland::RecoBayes::ScoredClusters& scs) const
 {
-    sc.prim = 0.5;
-    sc.sec = 0.5;
+    Score(scs.data(), scs.data() + scs.size());
+}
 
-    for (const auto& cl : fClusterLikelihoods)
+void Neuland::RecoBayes::Score(ScoredCluster* begin, ScoredCluster* end) const
+{
+    // The likelihoods are in the outer loop, such that each table is used for all clusters of the event in one go
+    for (auto sc = begin; sc != end; sc++)
     {
-        cl.Apply(sc);
+        sc->prim = 0.5;
+        sc->sec = 0.5;
     }
 
-    auto norm = sc.prim + sc.sec;
-    if (norm < 0.001)
-    {
-        sc.prim = 0;
-        sc.sec = 1;
-    }
-    else
+    for (const auto& cl : fClusterLikelihoods)
     {
-        sc.prim /= norm;
-        sc.sec /= norm;
+        for (auto sc = begin; sc != end; sc++)
+        {
+            cl.Apply(*sc);
+        }
     }
 
-    std::cout << " -> " << sc.prim << ", " << sc.sec << std::endl;
+    std::lock_guard<std::mutex> lock(fhPrimMutex);
+    for (auto sc = begin; sc != end; sc++)
+    {
+        auto norm = sc->prim + sc->sec;
+        if (norm < 0.001)
+        {
+            sc->prim = 0;
+            sc->sec = 1;
+        }
+        else
+        {
+            sc->prim /= norm;
+            sc->sec /= norm;
+        }
 
-    fhPrim->Fill(sc.prim);
+        fhPrim->Fill(sc->prim);
+    }
 }
 
 unsigned int Neuland::RecoBayes::GetNMult(const ScoredClusters& clusters) const
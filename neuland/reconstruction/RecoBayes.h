@@ -19,6 +19,7 @@
 #include <TCAConnector.h> // Delete me
 #include <functional>
 #include <map>
+#include <mutex>
 #include <numeric>
 
 class TH1D;
@@ -60,7 +61,6 @@ namespace Neuland
                 const auto s = likelihood.P(e, 0);
                 sc.prim *= p;
                 sc.sec *= s;
-                std::cout << " (" << e << " : " << p << " , " << s << ") ";
             }
         };
 
@@ -71,6 +71,7 @@ namespace Neuland
 
         unsigned int GetNMult(const ScoredClusters&) const;
         void ScoreCluster(ScoredCluster&) const;
+        void ScoreClusters(ScoredClusters&) const;
 
         std::vector<R3BNeulandNeutron> GetNeutrons(const std::vector<R3BNeulandCluster*>&) const override;
         void SetMinPrim(const double m) { fMinPrim = m; }
@@ -78,10 +79,14 @@ namespace Neuland
         void Init() override { fPrimaryClusters.Init(); } // Delete Me
 
       private:
+        // Scores the clusters [begin, end), shared by ScoreCluster and ScoreClusters
+        void Score(ScoredCluster* begin, ScoredCluster* end) const;
+
         const std::vector<unsigned int> fHypotheses;
         const Likelihood fPNclus;
         const Likelihood fPEtot;
         TH1D* fhPrim;
+        mutable std::mutex fhPrimMutex; // GetNeutrons may be called concurrently, e.g. by BatchExecutor
         double fMinPrim;
 
         const std::vector<ClusterLikelihood> fClusterLikelihoods;
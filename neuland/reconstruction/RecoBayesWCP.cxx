@@ -83,6 +83,7 @@ void Neuland::RecoBayesWCP::ScoreCluster(Neuland::RecoBayesWCP::ScoredCluster& s
         sc.sec /= norm;
     }
 
+    std::lock_guard<std::mutex> lock(fhPrimMutex);
     fhPrim->Fill(sc.prim);
 }
 
@@ -19,6 +19,7 @@
 #include <TCAConnector.h> // Delete me
 #include <functional>
 #include <map>
+#include <mutex>
 #include <numeric>
 
 class TH1D;
@@ -78,6 +79,7 @@ namespace Neuland
         const Likelihood fPNclus;
         const Likelihood fPEtot;
         TH1D* fhPrim;
+        mutable std::mutex fhPrimMutex; // GetNeutrons may be called concurrently, e.g. by BatchExecutor
 
         const std::vector<ClusterLikelihood> fClusterLikelihoods;
 
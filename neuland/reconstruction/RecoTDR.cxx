@@ -17,6 +17,7 @@
 #include "FairRuntimeDb.h"
 #include "IsElastic.h"
 #include "R3BNeulandNeutron2DPar.h"
+#include <algorithm>
 #include <numeric>
 
 Neuland::RecoTDR::RecoTDR()
@@ -101,27 +102,62 @@ void Neuland::RecoTDR::FilterClustersByBeta(std::vector<R3BNeulandCluster*>& clu
 
 void Neuland::RecoTDR::FilterClustersByElasticScattering(std::vector<R3BNeulandCluster*>& clusters) const
 {
-    std::map<const R3BNeulandCluster*, bool> marked;
+    // A cluster b is removed if any cluster a that is strictly earlier in time could have produced it by elastic
+    // scattering. Instead of checking all pairs, the clusters are sorted by time so that only later clusters are
+    // visited, and the expensive IsElastic is only evaluated for pairs that pass the cheap reachability check.
+    const auto nClusters = clusters.size();
 
-    for (const auto& c : clusters)
+    std::vector<Double_t> times(nClusters);
+    std::vector<Double_t> durations(nClusters);
+    std::vector<TVector3> positions(nClusters);
+    for (size_t i = 0; i < nClusters; i++)
     {
-        marked[c] = false;
+        const auto firstHit = clusters[i]->GetFirstHit();
+        times[i] = firstHit.GetT();
+        durations[i] = clusters[i]->GetLastHit().GetT() - times[i];
+        positions[i] = firstHit.GetPosition();
     }
 
-    for (const auto& a : clusters)
+    std::vector<size_t> order(nClusters);
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(), [&](const size_t a, const size_t b) { return times[a] < times[b]; });
+
+    std::vector<char> marked(nClusters, 0);
+    size_t firstLater = 0;
+    for (size_t ia = 0; ia < nClusters; ia++)
     {
-        for (const auto& b : clusters)
+        const auto a = order[ia];
+        // Clusters with the same time cannot scatter into each other
+        firstLater = std::max(firstLater, ia + 1);
+        while (firstLater < nClusters && !(times[a] < times[order[firstLater]]))
         {
-            if (a != b && a->GetT() < b->GetT() && Neuland::IsElastic(a, b))
+            firstLater++;
+        }
+
+        for (size_t ib = firstLater; ib < nClusters; ib++)
+        {
+            const auto b = order[ib];
+            if (marked[b])
+            {
+                continue;
+            }
+            if (Neuland::IsElasticReachable(positions[a], positions[b], durations[b]) &&
+                Neuland::IsElastic(clusters[a], clusters[b]))
             {
-                marked[b] = true;
+                marked[b] = 1;
             }
         }
     }
 
-    clusters.erase(
-        std::remove_if(clusters.begin(), clusters.end(), [&](const R3BNeulandCluster* a) { return marked.at(a); }),
-        clusters.end());
+    size_t kept = 0;
+    for (size_t i = 0; i < nClusters; i++)
+    {
+        if (!marked[i])
+        {
+            clusters[kept++] = clusters[i];
+        }
+    }
+    clusters.resize(kept);
 }
 
 UInt_t Neuland::RecoTDR::FindNumberOfNeutrons(std::vector<R3BNeulandCluster*>& clusters) const
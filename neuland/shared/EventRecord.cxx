@@ -0,0 +1,217 @@
+/******************************************************************************
+ *   Copyright (C) 2019 GSI Helmholtzzentrum für Schwerionenforschung GmbH    *
+ *   Copyright (C) 2019 Members of R3B Collaboration                          *
+ *                                                                            *
+ *             This software is distributed under the terms of the            *
+ *                 GNU General Public Licence (GPL) version 3,                *
+ *                    copied verbatim in the file "LICENSE".                  *
+ *                                                                            *
+ * In applying this license GSI does not waive the privileges and immunities  *
+ * granted to it by virtue of its status as an Intergovernmental Organization *
+ * or submit itself to any jurisdiction.                                      *
+ ******************************************************************************/
+
+#include "EventRecord.h"
+#include <cstring>
+#include <stdexcept>
+
+namespace
+{
+    const char Magic[4] = { 'N', 'L', 'E', 'V' };
+    const uint32_t Version = 1;
+
+    struct EventHeader
+    {
+        int32_t runID;
+        int32_t eventID;
+        int32_t nIn;
+        uint32_t nNeutrons;
+        uint32_t nClusters;
+        uint32_t nHits;
+    };
+
+    static_assert(sizeof(Neuland::HitRecord) == 9 * 4, "HitRecord must not contain padding");
+    static_assert(sizeof(Neuland::ClusterRecord) == 2 * 4, "ClusterRecord must not contain padding");
+    static_assert(sizeof(EventHeader) == 6 * 4, "EventHeader must not contain padding");
+
+    template <typename T>
+    char* Put(char* out, const T* data, const size_t n)
+    {
+        std::memcpy(out, data, n * sizeof(T));
+        return out + n * sizeof(T);
+    }
+
+    template <typename T>
+    const char* Get(const char* in, std::vector<T>& data, const size_t n)
+    {
+        data.resize(n);
+        std::memcpy(data.data(), in, n * sizeof(T));
+        return in + n * sizeof(T);
+    }
+} // namespace
+
+namespace Neuland
+{
+    HitRecord::HitRecord(const R3BNeulandHit& hit)
+        : id(hit.GetPaddle())
+        , e(hit.GetE())
+        , t(hit.GetT())
+        , x(hit.GetPosition().X())
+        , y(hit.GetPosition().Y())
+        , z(hit.GetPosition().Z())
+        , px(hit.GetPixel().X())
+        , py(hit.GetPixel().Y())
+        , pz(hit.GetPixel().Z())
+    {
+    }
+
+    R3BNeulandHit HitRecord::ToHit() const
+    {
+        // Raw TDC and QDC values are not part of the record
+        return R3BNeulandHit(id, 0., 0., t, 0., 0., e, TVector3(x, y, z), TVector3(px, py, pz));
+    }
+
+    void EventRecord::Clear()
+    {
+        neutrons.clear();
+        clusters.clear();
+        hits.clear();
+    }
+
+    void EventRecord::AddCluster(const R3BNeulandCluster& cluster, const int32_t primaryInteractions)
+    {
+        const auto& clusterHits = cluster.GetHits();
+        clusters.push_back({ static_cast<uint32_t>(clusterHits.size()), primaryInteractions });
+        for (const auto& hit : clusterHits)
+        {
+            hits.emplace_back(hit);
+        }
+    }
+
+    std::vector<R3BNeulandCluster> EventRecord::GetClusters() const
+    {
+        std::vector<R3BNeulandCluster> out;
+        out.reserve(clusters.size());
+        auto hit = hits.cbegin();
+        for (const auto& cluster : clusters)
+        {
+            std::vector<R3BNeulandHit> clusterHits;
+            clusterHits.reserve(cluster.nHits);
+            for (uint32_t i = 0; i < cluster.nHits; i++, hit++)
+            {
+                clusterHits.push_back(hit->ToHit());
+            }
+            out.emplace_back(std::move(clusterHits));
+        }
+        return out;
+    }
+
+    EventWriter::EventWriter(const std::string& filename)
+        : fFile(filename, std::ios::binary | std::ios::trunc)
+        , fNEvents(0)
+    {
+        if (!fFile)
+        {
+            throw std::runtime_error("Neuland::EventWriter: Cannot open " + filename);
+        }
+        fFile.write(Magic, sizeof(Magic));
+        fFile.write(reinterpret_cast<const char*>(&Version), sizeof(Version));
+    }
+
+    void EventWriter::Write(const EventRecord& event)
+    {
+        size_t nHits = 0;
+        for (const auto& cluster : event.clusters)
+        {
+            nHits += cluster.nHits;
+        }
+        if (nHits != event.hits.size())
+        {
+            throw std::runtime_error("Neuland::EventWriter: Cluster sizes do not match the number of hits");
+        }
+
+        const EventHeader header{ event.runID,
+                                  event.eventID,
+                                  event.nIn,
+                                  static_cast<uint32_t>(event.neutrons.size()),
+                                  static_cast<uint32_t>(event.clusters.size()),
+                                  static_cast<uint32_t>(event.hits.size()) };
+        const uint32_t size = sizeof(EventHeader) + sizeof(HitRecord) * (event.neutrons.size() + event.hits.size()) +
+                              sizeof(ClusterRecord) * event.clusters.size();
+
+        // Assemble the record in memory and hand it to the stream in one piece
+        fBuffer.resize(sizeof(size) + size);
+        char* out = fBuffer.data();
+        out = Put(out, &size, 1);
+        out = Put(out, &header, 1);
+        out = Put(out, event.neutrons.data(), event.neutrons.size());
+        out = Put(out, event.clusters.data(), event.clusters.size());
+        Put(out, event.hits.data(), event.hits.size());
+        fFile.write(fBuffer.data(), fBuffer.size());
+        fNEvents++;
+    }
+
+    void EventWriter::Close() { fFile.close(); }
+
+    EventReader::EventReader(const std::string& filename)
+        : fFile(filename, std::ios::binary)
+    {
+        if (!fFile)
+        {
+            throw std::runtime_error("Neuland::EventReader: Cannot open " + filename);
+        }
+        char magic[sizeof(Magic)];
+        uint32_t version = 0;
+        fFile.read(magic, sizeof(magic));
+        fFile.read(reinterpret_cast<char*>(&version), sizeof(version));
+        if (!fFile || std::memcmp(magic, Magic, sizeof(Magic)) != 0)
+        {
+            throw std::runtime_error("Neuland::EventReader: " + filename + " is not a NeuLAND event file");
+        }
+        if (version != Version)
+        {
+            throw std::runtime_error("Neuland::EventReader: Unsupported format version " + std::to_string(version));
+        }
+    }
+
+    bool EventReader::Next(EventRecord& event)
+    {
+        uint32_t size = 0;
+        if (!fFile.read(reinterpret_cast<char*>(&size), sizeof(size)))
+        {
+            return false;
+        }
+        fBuffer.resize(size);
+        if (size < sizeof(EventHeader) || !fFile.read(fBuffer.data(), size))
+        {
+            throw std::runtime_error("Neuland::EventReader: Truncated record");
+        }
+
+        EventHeader header;
+        std::memcpy(&header, fBuffer.data(), sizeof(header));
+        if (size != sizeof(EventHeader) + sizeof(HitRecord) * (size_t(header.nNeutrons) + header.nHits) +
+                        sizeof(ClusterRecord) * header.nClusters)
+        {
+            throw std::runtime_error("Neuland::EventReader: Corrupt record");
+        }
+
+        event.runID = header.runID;
+        event.eventID = header.eventID;
+        event.nIn = header.nIn;
+        const char* in = fBuffer.data() + sizeof(header);
+        in = Get(in, event.neutrons, header.nNeutrons);
+        in = Get(in, event.clusters, header.nClusters);
+        Get(in, event.hits, header.nHits);
+
+        size_t nHits = 0;
+        for (const auto& cluster : event.clusters)
+        {
+            nHits += cluster.nHits;
+        }
+        if (nHits != header.nHits)
+        {
+            throw std::runtime_error("Neuland::EventReader: Corrupt record");
+        }
+        return true;
+    }
+} // namespace Neuland
@@ -0,0 +1,94 @@
+/******************************************************************************
+ *   Copyright (C) 2019 GSI Helmholtzzentrum für Schwerionenforschung GmbH    *
+ *   Copyright (C) 2019 Members of R3B Collaboration                          *
+ *                                                                            *
+ *             This software is distributed under the terms of the            *
+ *                 GNU General Public Licence (GPL) version 3,                *
+ *                    copied verbatim in the file "LICENSE".                  *
+ *                                                                            *
+ * In applying this license GSI does not waive the privileges and immunities  *
+ * granted to it by virtue of its status as an Intergovernmental Organization *
+ * or submit itself to any jurisdiction.                                      *
+ ******************************************************************************/
+
+#ifndef NEULAND_EVENTRECORD_H
+#define NEULAND_EVENTRECORD_H
+
+#include "R3BNeulandCluster.h"
+#include "R3BNeulandHit.h"
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace Neuland
+{
+    // Flat, ROOT-free representation of the Hit, Cluster and Event messages in neuland.proto, for fast export of
+    // training data to external tools.
+    struct HitRecord
+    {
+        int32_t id; // paddle
+        float e;
+        float t;
+        float x, y, z;      // position
+        int32_t px, py, pz; // pixel
+
+        HitRecord() = default;
+        explicit HitRecord(const R3BNeulandHit&);
+        R3BNeulandHit ToHit() const;
+    };
+
+    struct ClusterRecord
+    {
+        uint32_t nHits;
+        int32_t primaryInteractions;
+    };
+
+    // The hits of all clusters are stored back to back in hits, in the order of the clusters
+    struct EventRecord
+    {
+        int32_t runID = 0;
+        int32_t eventID = 0;
+        int32_t nIn = 0;
+        std::vector<HitRecord> neutrons;
+        std::vector<ClusterRecord> clusters;
+        std::vector<HitRecord> hits;
+
+        void Clear();
+        void AddCluster(const R3BNeulandCluster&, int32_t primaryInteractions = 0);
+        std::vector<R3BNeulandCluster> GetClusters() const;
+    };
+
+    /* Writes events as length-delimited binary records. The file starts with a magic word and a format version, each
+     * record with its size in bytes, followed by fixed size headers and the plain arrays of the event. Numbers are
+     * stored in host byte order (little endian on all supported platforms). */
+    class EventWriter
+    {
+      public:
+        explicit EventWriter(const std::string& filename);
+
+        void Write(const EventRecord&);
+        void Close();
+        uint64_t GetNEvents() const { return fNEvents; }
+
+      private:
+        std::ofstream fFile;
+        std::vector<char> fBuffer;
+        uint64_t fNEvents;
+    };
+
+    // Sequential reader for files written by EventWriter. Next reuses the vectors of the given event.
+    class EventReader
+    {
+      public:
+        explicit EventReader(const std::string& filename);
+
+        bool Next(EventRecord&);
+
+      private:
+        std::ifstream fFile;
+        std::vector<char> fBuffer;
+    };
+} // namespace Neuland
+
+#endif // NEULAND_EVENTRECORD_H
@@ -16,6 +16,22 @@
 
 // Code extracted from R3BNeutronTracker2D. It is absolutely atrocious. Don't look at it. Nothing too see here. Go away.
 
+bool Neuland::IsElasticReachable(const TVector3& pos1, const TVector3& pos3, const Double_t dt)
+{
+    // Mirrors the calculation of beta3min in IsElastic below. For beta3min >= 1, gamma3min and thus p3min become NaN
+    // or infinite and IsElastic always returns false. The small tolerance keeps this check on the safe side.
+    const Double_t c = 29.9792458;
+    const Double_t dio = 10.6;
+
+    const Double_t v3x = (pos3 - pos1).X();
+    const Double_t v3y = (pos3 - pos1).Y();
+    const Double_t v3z = (pos3 - pos1).Z();
+    const Double_t dr = sqrt(v3x * v3x + v3y * v3y + v3z * v3z);
+
+    const Double_t beta3min = (dr - dio) / dt / c;
+    return !(beta3min > 1. + 1e-9);
+}
+
 bool Neuland::IsElastic(const R3BNeulandCluster* cl1, const R3BNeulandCluster* cl2)
 {
     const R3BNeulandCluster* c1;
@@ -19,6 +19,10 @@
 namespace Neuland
 {
     bool IsElastic(const R3BNeulandCluster*, const R3BNeulandCluster*);
+
+    // Cheap necessary condition for IsElastic: The velocity of the scattered neutron, estimated from the distance
+    // between the first hits and the duration of the second cluster, must stay below the speed of light.
+    bool IsElasticReachable(const TVector3& firstHitOfFirst, const TVector3& firstHitOfSecond, Double_t durationSecond);
 } // namespace Neuland
 
 #endif // NEULAND_ISELASTIC
@@ -30,5 +30,6 @@
 #pragma link C++ class R3BNeulandOnlineReconstruction+;
 #pragma link C++ class R3BNeulandOnlineSpectra+;
 #pragma link C++ class R3BNeulandVisualizer+;
+#pragma link C++ class R3BNeulandEventExporter+;
 
 #endif
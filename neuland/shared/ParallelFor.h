@@ -0,0 +1,207 @@
+/******************************************************************************
+ *   Copyright (C) 2019 GSI Helmholtzzentrum für Schwerionenforschung GmbH    *
+ *   Copyright (C) 2019 Members of R3B Collaboration                          *
+ *                                                                            *
+ *             This software is distributed under the terms of the            *
+ *                 GNU General Public Licence (GPL) version 3,                *
+ *                    copied verbatim in the file "LICENSE".                  *
+ *                                                                            *
+ * In applying this license GSI does not waive the privileges and immunities  *
+ * granted to it by virtue of its status as an Intergovernmental Organization *
+ * or submit itself to any jurisdiction.                                      *
+ ******************************************************************************/
+
+#ifndef NEULAND_PARALLELFOR_H
+#define NEULAND_PARALLELFOR_H
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace Neuland
+{
+    // Number of threads to use if the user did not specify any (0)
+    inline unsigned int NumberOfThreads(unsigned int requested)
+    {
+        if (requested > 0)
+        {
+            return requested;
+        }
+        return std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    // Splits the range [0, n) into at most nThreads contiguous chunks and calls func(begin, end) for each chunk in its
+    // own thread. The chunks only depend on n and nThreads, so results written to per-index slots are deterministic.
+    // Chunks smaller than minChunk are avoided, small ranges are processed in the calling thread.
+    template <typename Func>
+    void ParallelFor(const size_t n, unsigned int nThreads, Func&& func, const size_t minChunk = 1)
+    {
+        nThreads = NumberOfThreads(nThreads);
+        const size_t nChunks = std::max<size_t>(1, std::min<size_t>(nThreads, n / std::max<size_t>(1, minChunk)));
+        if (nChunks == 1)
+        {
+            func(size_t(0), n);
+            return;
+        }
+
+        std::vector<std::thread> threads;
+        threads.reserve(nChunks - 1);
+        for (size_t c = 1; c < nChunks; c++)
+        {
+            threads.emplace_back([&func, c, n, nChunks]() { func(c * n / nChunks, (c + 1) * n / nChunks); });
+        }
+        func(size_t(0), n / nChunks);
+        for (auto& thread : threads)
+        {
+            thread.join();
+        }
+    }
+
+    // Same chunking as ParallelFor, but the threads are started once and reused for every Run. For many short loops,
+    // e.g. the matrix products of an iterative solver, where starting threads per loop would cost more than it saves.
+    class ParallelForPool
+    {
+      public:
+        explicit ParallelForPool(unsigned int nThreads)
+            : fNThreads(NumberOfThreads(nThreads))
+            , fN(0)
+            , fNChunks(0)
+            , fPending(0)
+            , fGeneration(0)
+            , fStop(false)
+        {
+            fThreads.reserve(fNThreads - 1);
+            for (unsigned int t = 1; t < fNThreads; t++)
+            {
+                fThreads.emplace_back([this, t]() { Work(t); });
+            }
+        }
+
+        ~ParallelForPool()
+        {
+            {
+                std::lock_guard<std::mutex> lock(fMutex);
+                fStop = true;
+            }
+            fStart.notify_all();
+            for (auto& thread : fThreads)
+            {
+                thread.join();
+            }
+        }
+
+        ParallelForPool(const ParallelForPool&) = delete;
+        ParallelForPool& operator=(const ParallelForPool&) = delete;
+
+        template <typename Func>
+        void Run(const size_t n, Func&& func, const size_t minChunk = 1)
+        {
+            const size_t nChunks =
+                std::max<size_t>(1, std::min<size_t>(fNThreads, n / std::max<size_t>(1, minChunk)));
+            if (nChunks == 1)
+            {
+                func(size_t(0), n);
+                return;
+            }
+
+            {
+                std::lock_guard<std::mutex> lock(fMutex);
+                fTask = [&func](size_t begin, size_t end) { func(begin, end); };
+                fN = n;
+                fNChunks = nChunks;
+                fPending = fThreads.size();
+                fGeneration++;
+            }
+            fStart.notify_all();
+            func(size_t(0), n / nChunks);
+
+            std::unique_lock<std::mutex> lock(fMutex);
+            fDone.wait(lock, [this]() { return fPending == 0; });
+            fTask = nullptr;
+        }
+
+      private:
+        void Work(const size_t c)
+        {
+            uint64_t seen = 0;
+            std::unique_lock<std::mutex> lock(fMutex);
+            while (true)
+            {
+                fStart.wait(lock, [this, seen]() { return fStop || fGeneration != seen; });
+                if (fStop)
+                {
+                    return;
+                }
+                seen = fGeneration;
+                const size_t n = fN;
+                const size_t nChunks = fNChunks;
+                lock.unlock();
+                if (c < nChunks)
+                {
+                    fTask(c * n / nChunks, (c + 1) * n / nChunks);
+                }
+                lock.lock();
+                if (--fPending == 0)
+                {
+                    fDone.notify_one();
+                }
+            }
+        }
+
+        const unsigned int fNThreads;
+        std::vector<std::thread> fThreads;
+        std::mutex fMutex;
+        std::condition_variable fStart;
+        std::condition_variable fDone;
+        std::function<void(size_t, size_t)> fTask;
+        size_t fN;
+        size_t fNChunks;
+        size_t fPending;
+        uint64_t fGeneration;
+        bool fStop;
+    };
+
+    // Calls func(i) for every i in [0, n), distributing the indices dynamically over nThreads threads.
+    // Suited for tasks of very different duration, e.g. fits. func must only write to slots belonging to i
+    // to keep the output independent of the scheduling.
+    template <typename Func>
+    void ParallelForEach(const size_t n, unsigned int nThreads, Func&& func)
+    {
+        nThreads = std::min<size_t>(NumberOfThreads(nThreads), n);
+        if (nThreads <= 1)
+        {
+            for (size_t i = 0; i < n; i++)
+            {
+                func(i);
+            }
+            return;
+        }
+
+        std::atomic<size_t> next(0);
+        auto worker = [&]() {
+            for (size_t i = next++; i < n; i = next++)
+            {
+                func(i);
+            }
+        };
+
+        std::vector<std::thread> threads;
+        threads.reserve(nThreads - 1);
+        for (unsigned int t = 1; t < nThreads; t++)
+        {
+            threads.emplace_back(worker);
+        }
+        worker();
+        for (auto& thread : threads)
+        {
+            thread.join();
+        }
+    }
+} // namespace Neuland
+
+#endif // NEULAND_PARALLELFOR_H
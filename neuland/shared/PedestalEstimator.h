@@ -0,0 +1,130 @@
+/******************************************************************************
+ *   Copyright (C) 2019 GSI Helmholtzzentrum für Schwerionenforschung GmbH    *
+ *   Copyright (C) 2019 Members of R3B Collaboration                          *
+ *                                                                            *
+ *             This software is distributed under the terms of the            *
+ *                 GNU General Public Licence (GPL) version 3,                *
+ *                    copied verbatim in the file "LICENSE".                  *
+ *                                                                            *
+ * In applying this license GSI does not waive the privileges and immunities  *
+ * granted to it by virtue of its status as an Intergovernmental Organization *
+ * or submit itself to any jurisdiction.                                      *
+ ******************************************************************************/
+
+#ifndef NEULAND_PEDESTALESTIMATOR_H
+#define NEULAND_PEDESTALESTIMATOR_H
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace Neuland
+{
+    /* Streaming estimate of the pedestal (position and width) of a single QDC channel with bounded memory.
+     * The first samples are buffered to seed the estimate with their median and median absolute deviation. Afterwards
+     * every sample within cut standard deviations of the current pedestal updates a Welford-style running mean and
+     * variance. Until window samples have been accepted, this is the exact mean and variance of the accepted samples,
+     * after that older samples are forgotten exponentially, such that the estimate follows a drifting baseline. */
+    class PedestalEstimator
+    {
+      public:
+        explicit PedestalEstimator(const unsigned int window = 1000,
+                                   const double cut = 4.,
+                                   const double minWidth = 1.,
+                                   const unsigned int nSeed = 50)
+            : fWindow(std::max(1u, window))
+            , fCut(cut)
+            , fMinWidth(minWidth)
+            , fNSeed(std::max(1u, std::min(nSeed, fWindow)))
+        {
+        }
+
+        void Add(const double x)
+        {
+            if (!fSeeded)
+            {
+                fSeed.push_back(x);
+                if (fSeed.size() >= fNSeed)
+                {
+                    Seed();
+                }
+                return;
+            }
+            Update(x);
+        }
+
+        void Reset()
+        {
+            fSeed.clear();
+            fSeeded = false;
+            fSeedWidth = 0.;
+            fMean = 0.;
+            fVariance = 0.;
+            fNAccepted = 0;
+            fNRejected = 0;
+        }
+
+        bool IsValid() const { return fNAccepted > 0; }
+        double GetPedestal() const { return fMean; }
+        double GetWidth() const { return std::sqrt(fVariance); }
+        unsigned long GetEntries() const { return fNAccepted; }
+        unsigned long GetRejected() const { return fNRejected; }
+
+      private:
+        void Seed()
+        {
+            std::vector<double> dev(fSeed);
+            const auto mid = dev.begin() + dev.size() / 2;
+            std::nth_element(dev.begin(), mid, dev.end());
+            const double median = *mid;
+            for (auto& d : dev)
+            {
+                d = std::abs(d - median);
+            }
+            std::nth_element(dev.begin(), mid, dev.end());
+            // 1.4826 * MAD estimates the standard deviation of a normal distribution
+            fSeedWidth = 1.4826 * *mid;
+            fMean = median;
+            fSeeded = true;
+
+            // Replay the buffered samples through the regular update and release the buffer
+            std::vector<double> seed;
+            seed.swap(fSeed);
+            for (const auto x : seed)
+            {
+                Update(x);
+            }
+        }
+
+        void Update(const double x)
+        {
+            // Until enough samples were accepted, the running variance is too noisy to cut on
+            const double width = fNAccepted < fNSeed ? fSeedWidth : GetWidth();
+            const double delta = x - fMean;
+            if (std::abs(delta) > fCut * std::max(width, fMinWidth))
+            {
+                fNRejected++;
+                return;
+            }
+            fNAccepted++;
+            const double w = 1. / std::min<unsigned long>(fNAccepted, fWindow);
+            fMean += w * delta;
+            fVariance = (1. - w) * (fVariance + w * delta * delta);
+        }
+
+        unsigned int fWindow;
+        double fCut;
+        double fMinWidth;
+        unsigned int fNSeed;
+
+        std::vector<double> fSeed;
+        bool fSeeded = false;
+        double fSeedWidth = 0.;
+        double fMean = 0.;
+        double fVariance = 0.;
+        unsigned long fNAccepted = 0;
+        unsigned long fNRejected = 0;
+    };
+} // namespace Neuland
+
+#endif // NEULAND_PEDESTALESTIMATOR_H
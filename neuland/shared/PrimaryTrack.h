@@ -0,0 +1,66 @@
+/******************************************************************************
+ *   Copyright (C) 2019 GSI Helmholtzzentrum für Schwerionenforschung GmbH    *
+ *   Copyright (C) 2019 Members of R3B Collaboration                          *
+ *                                                                            *
+ *             This software is distributed under the terms of the            *
+ *                 GNU General Public Licence (GPL) version 3,                *
+ *                    copied verbatim in the file "LICENSE".                  *
+ *                                                                            *
+ * In applying this license GSI does not waive the privileges and immunities  *
+ * granted to it by virtue of its status as an Intergovernmental Organization *
+ * or submit itself to any jurisdiction.                                      *
+ ******************************************************************************/
+
+#ifndef NEULAND_PRIMARYTRACK_H
+#define NEULAND_PRIMARYTRACK_H
+
+#include "R3BMCTrack.h"
+#include <vector>
+
+namespace Neuland
+{
+    // Marks the entries of a track to primary lookup table that are not resolved yet
+    constexpr Int_t UnresolvedTrack = -2;
+
+    inline bool IsPrimaryTrack(const R3BMCTrack* track)
+    {
+        // TODO: The test can be modified to rely on some other information,
+        // e.g. if the neutrons were created in a reaction in the target simulated with Geant
+        return track->GetMotherId() == -1 && track->GetPdgCode() == 2112;
+    }
+
+    // Find the primary track a track descends from (else -1). Results are cached in t2p for every track on the way,
+    // t2p has one entry per track and starts out filled with UnresolvedTrack.
+    inline Int_t FindPrimaryTrack(Int_t iTrack, const std::vector<R3BMCTrack*>& tracks, std::vector<Int_t>& t2p)
+    {
+        auto iPrimary = -1;
+        auto i = iTrack;
+        while (i > -1)
+        {
+            if (t2p.at(i) != UnresolvedTrack)
+            {
+                iPrimary = t2p[i];
+                break;
+            }
+            const auto track = tracks[i];
+            if (IsPrimaryTrack(track))
+            {
+                iPrimary = i;
+                break;
+            }
+            // Else, start tracing back:
+            i = track->GetMotherId();
+        }
+
+        // Cache the result along the traced path
+        i = iTrack;
+        while (i > -1 && t2p[i] == UnresolvedTrack)
+        {
+            t2p[i] = iPrimary;
+            i = i == iPrimary ? -1 : tracks[i]->GetMotherId();
+        }
+        return iPrimary;
+    }
+} // namespace Neuland
+
+#endif // NEULAND_PRIMARYTRACK_H
@@ -0,0 +1,90 @@
+/******************************************************************************
+ *   Copyright (C) 2019 GSI Helmholtzzentrum für Schwerionenforschung GmbH    *
+ *   Copyright (C) 2019 Members of R3B Collaboration                          *
+ *                                                                            *
+ *             This software is distributed under the terms of the            *
+ *                 GNU General Public Licence (GPL) version 3,                *
+ *                    copied verbatim in the file "LICENSE".                  *
+ *                                                                            *
+ * In applying this license GSI does not waive the privileges and immunities  *
+ * granted to it by virtue of its status as an Intergovernmental Organization *
+ * or submit itself to any jurisdiction.                                      *
+ ******************************************************************************/
+
+#include "R3BNeulandEventExporter.h"
+#include "FairLogger.h"
+#include "FairRun.h"
+#include <algorithm>
+#include <stdexcept>
+#include <utility>
+
+R3BNeulandEventExporter::R3BNeulandEventExporter(TString filename, TString clusters, TString primaryHits)
+    : FairTask("R3BNeulandEventExporter")
+    , fFileName(std::move(filename))
+    , fClusters(std::move(clusters))
+    , fPrimaryHits(std::move(primaryHits))
+    , fNIn(-1)
+    , fRunID(0)
+    , fEventID(0)
+{
+}
+
+InitStatus R3BNeulandEventExporter::Init()
+{
+    fClusters.Init();
+    fPrimaryHits.Init();
+
+    if (FairRun::Instance() != nullptr)
+    {
+        fRunID = FairRun::Instance()->GetRunId();
+    }
+
+    try
+    {
+        fWriter.reset(new Neuland::EventWriter(fFileName.Data()));
+    }
+    catch (const std::runtime_error& e)
+    {
+        LOG(FATAL) << "R3BNeulandEventExporter::Init " << e.what();
+        return kFATAL;
+    }
+    return kSUCCESS;
+}
+
+void R3BNeulandEventExporter::Exec(Option_t*)
+{
+    const auto clusters = fClusters.Retrieve();
+    const auto primaryHits = fPrimaryHits.Retrieve();
+
+    fEvent.Clear();
+    fEvent.runID = fRunID;
+    fEvent.eventID = fEventID++;
+    fEvent.nIn = fNIn >= 0 ? fNIn : static_cast<Int_t>(primaryHits.size());
+
+    for (const auto hit : primaryHits)
+    {
+        fEvent.neutrons.emplace_back(*hit);
+    }
+
+    for (const auto cluster : clusters)
+    {
+        const auto& hits = cluster->GetHits();
+        const auto nPrimary = std::count_if(primaryHits.cbegin(), primaryHits.cend(), [&](const R3BNeulandHit* ph) {
+            return std::find(hits.cbegin(), hits.cend(), *ph) != hits.cend();
+        });
+        fEvent.AddCluster(*cluster, static_cast<int32_t>(nPrimary));
+    }
+
+    fWriter->Write(fEvent);
+}
+
+void R3BNeulandEventExporter::Finish()
+{
+    if (fWriter)
+    {
+        LOG(INFO) << "R3BNeulandEventExporter: Wrote " << fWriter->GetNEvents() << " events to " << fFileName;
+        fWriter->Close();
+    }
+}
+
+ClassImp(R3BNeulandEventExporter);
@@ -0,0 +1,63 @@
+/******************************************************************************
+ *   Copyright (C) 2019 GSI Helmholtzzentrum für Schwerionenforschung GmbH    *
+ *   Copyright (C) 2019 Members of R3B Collaboration                          *
+ *                                                                            *
+ *             This software is distributed under the terms of the            *
+ *                 GNU General Public Licence (GPL) version 3,                *
+ *                    copied verbatim in the file "LICENSE".                  *
+ *                                                                            *
+ * In applying this license GSI does not waive the privileges and immunities  *
+ * granted to it by virtue of its status as an Intergovernmental Organization *
+ * or submit itself to any jurisdiction.                                      *
+ ******************************************************************************/
+
+#ifndef R3BROOT_R3BNEULANDEVENTEXPORTER_H
+#define R3BROOT_R3BNEULANDEVENTEXPORTER_H
+
+#include "EventRecord.h"
+#include "FairTask.h"
+#include "R3BNeulandCluster.h"
+#include "R3BNeulandHit.h"
+#include "TCAConnector.h"
+#include <memory>
+
+// Writes the NeuLAND clusters of each event to a Neuland::EventWriter file. If available, the primary hits are
+// exported as neutrons and used to count the primary interactions in each cluster.
+class R3BNeulandEventExporter : public FairTask
+{
+  public:
+    explicit R3BNeulandEventExporter(TString filename = "neuland_events.bin",
+                                     TString clusters = "NeulandClusters",
+                                     TString primaryHits = "NeulandPrimaryHits");
+    ~R3BNeulandEventExporter() override = default;
+
+    // No copy and no move is allowed (Rule of three/five)
+    R3BNeulandEventExporter(const R3BNeulandEventExporter&) = delete;
+    R3BNeulandEventExporter(R3BNeulandEventExporter&&) = delete;
+    R3BNeulandEventExporter& operator=(const R3BNeulandEventExporter&) = delete;
+    R3BNeulandEventExporter& operator=(R3BNeulandEventExporter&&) = delete;
+
+    // Number of incoming neutrons stored with each event. By default, the number of primary hits is used.
+    void SetNIn(Int_t nIn) { fNIn = nIn; }
+
+  protected:
+    InitStatus Init() override;
+    void Finish() override;
+
+  public:
+    void Exec(Option_t*) override;
+
+  private:
+    TString fFileName;
+    TCAInputConnector<R3BNeulandCluster> fClusters;
+    TCAOptionalInputConnector<R3BNeulandHit> fPrimaryHits;
+    Int_t fNIn;
+    Int_t fRunID;
+    Int_t fEventID;
+    std::unique_ptr<Neuland::EventWriter> fWriter; //!
+    Neuland::EventRecord fEvent;                   //!
+
+    ClassDefOverride(R3BNeulandEventExporter, 0);
+};
+
+#endif // R3BROOT_R3BNEULANDEVENTEXPORTER_H
@@ -114,9 +114,15 @@ Bool_t R3BNeuland::ProcessHits(FairVolume*)
         gMC->CurrentVolOffID(1, fPaddleID);
     }
 
-    // Sum energy loss for all steps in the active volume
-    fELoss += gMC->Edep();
-    fLightYield += GetLightYield(gMC->TrackCharge(), gMC->TrackStep(), gMC->Edep());
+    // Sum energy loss for all steps in the active volume. The steps of a track in the paddle are only
+    // accumulated here, one R3BNeulandPoint is created when the track leaves the paddle. Steps without
+    // energy deposition (e.g. of neutrons) add no light.
+    const Double_t edep = gMC->Edep();
+    if (edep > 0.)
+    {
+        fELoss += edep;
+        fLightYield += GetLightYield(gMC->TrackCharge(), gMC->TrackStep(), edep);
+    }
 
     // Set additional parameters at exit of active volume. Create R3BNeulandPoint.
     if (gMC->IsTrackExiting() || gMC->IsTrackStop() || gMC->IsTrackDisappeared())
@@ -13,105 +13,41 @@
 
 #include "R3BNeulandPrimaryInteractionFinder.h"
 #include "FairLogger.h"
+#include "PrimaryTrack.h"
 #include <utility>
 #include <vector>
 
-bool IsPrimaryTrack(R3BMCTrack* track)
+namespace
 {
-    // TODO: The test can be modified to rely on some other information,
-    // e.g. if the neutrons were created in a reaction in the target simulated with Geant
-    return track->GetMotherId() == -1 && track->GetPdgCode() == 2112;
-}
-
-// Map a hit to every point if possible (else -1)
-std::map<R3BNeulandPoint*, R3BNeulandHit*> MapPointsToHits(const std::vector<R3BNeulandPoint*>& points,
-                                                           const std::vector<R3BNeulandHit*>& hits)
-{
-    std::map<R3BNeulandPoint*, R3BNeulandHit*> m;
-    for (const auto& point : points)
+    // Index the hits by paddle. If several hits share a paddle, the last one wins.
+    void MapPaddlesToHits(const std::vector<R3BNeulandHit*>& hits, std::vector<R3BNeulandHit*>& p2h)
     {
-        m[point] = nullptr;
+        p2h.clear();
         for (const auto hit : hits)
         {
-            if (point->GetPaddle() == hit->GetPaddle())
+            const auto paddle = hit->GetPaddle();
+            if (paddle < 0)
             {
-                m[point] = hit;
+                continue;
             }
-        }
-    }
-    return m;
-};
-
-// Map a primary track to every point if possible (else -1)
-std::map<R3BNeulandPoint*, R3BMCTrack*> MapPointsToPrimaryTracks(const std::vector<R3BNeulandPoint*>& points,
-                                                                 const std::vector<R3BMCTrack*>& tracks)
-{
-    std::map<R3BNeulandPoint*, R3BMCTrack*> m;
-    for (const auto& point : points)
-    {
-        m[point] = nullptr;
-        auto iTrack = point->GetTrackID();
-        while (iTrack > -1)
-        {
-            const auto track = tracks.at(iTrack);
-            if (IsPrimaryTrack(track))
-            {
-                m[point] = track;
-                break;
-            }
-            // Else, start tracing back:
-            iTrack = track->GetMotherId();
-        }
-    }
-    return m;
-}
-
-R3BNeulandPoint* FindFirstPoint(const R3BMCTrack* track, const std::map<R3BNeulandPoint*, R3BMCTrack*>& p2t)
-{
-    R3BNeulandPoint* minPoint = nullptr;
-    //  Search for min ToF:
-    double minToF = 1e99;
-
-    for (const auto& pt : p2t)
-    {
-        // Only look at points traced back to this track:
-        if (pt.second == track)
-        {
-            const auto ToF = pt.first->GetTime();
-            if (ToF < minToF)
+            if (static_cast<size_t>(paddle) >= p2h.size())
             {
-                minToF = ToF;
-                minPoint = pt.first;
+                p2h.resize(paddle + 1, nullptr);
             }
+            p2h[paddle] = hit;
         }
     }
-    return minPoint;
-}
-
-R3BNeulandHit* FindFirstHit(const R3BMCTrack* track,
-                            const std::map<R3BNeulandPoint*, R3BMCTrack*>& p2t,
-                            const std::map<R3BNeulandPoint*, R3BNeulandHit*>& p2h)
-{
-    R3BNeulandPoint* minHitPoint = nullptr;
-    //  Search for min ToF:
-    double minHitToF = 1e99;
 
-    for (const auto& pt : p2t)
+    R3BNeulandHit* FindHit(const R3BNeulandPoint* point, const std::vector<R3BNeulandHit*>& p2h)
     {
-        // Only look at points traced back to this track:
-        // AND where a hit is registered
-        if (pt.second == track && p2h.at(pt.first) != nullptr)
+        const auto paddle = point->GetPaddle();
+        if (paddle < 0 || static_cast<size_t>(paddle) >= p2h.size())
         {
-            const auto ToF = pt.first->GetTime();
-            if (ToF < minHitToF)
-            {
-                minHitToF = ToF;
-                minHitPoint = pt.first;
-            }
+            return nullptr;
         }
+        return p2h[paddle];
     }
-    return minHitPoint ? p2h.at(minHitPoint) : nullptr;
-}
+} // namespace
 
 R3BNeulandPrimaryInteractionFinder::R3BNeulandPrimaryInteractionFinder(TString pointsIn,
                                                                        TString hitsIn,
@@ -153,29 +89,52 @@ void R3BNeulandPrimaryInteractionFinder::Exec(Option_t*)
     fPointsOut.Reset();
     fHitsOut.Reset();
 
-    const auto p2h = MapPointsToHits(points, hits);
-    const auto p2t = MapPointsToPrimaryTracks(points, tracks);
+    // All lookups are by track index and paddle, the R3BStack track indices are contiguous
+    MapPaddlesToHits(hits, fHitOfPaddle);
+    fPrimaryOfTrack.assign(tracks.size(), Neuland::UnresolvedTrack);
+    fFirstPoint.assign(tracks.size(), nullptr);
+    fFirstHitPoint.assign(tracks.size(), nullptr);
 
-    if (FairLogger::GetLogger()->IsLogNeeded(fair::Severity::debug))
+    const auto debug = FairLogger::GetLogger()->IsLogNeeded(fair::Severity::debug);
+    if (debug)
     {
         LOG(DEBUG) << "R3BNeulandPrimaryInteractionFinder: Points without Hit in: ";
-        for (const auto& kv : p2h)
+    }
+
+    // Single pass over all points: Keep the points with min ToF traced back to each primary track,
+    // both in total and of those where a hit is registered
+    for (const auto point : points)
+    {
+        const auto hit = FindHit(point, fHitOfPaddle);
+        if (debug && hit == nullptr)
         {
-            if (kv.second == nullptr)
-            {
-                const auto point = kv.first;
-                LOG(DEBUG) << point->GetDetectorID() << ":" << tracks.at(point->GetTrackID())->GetPdgCode() << ":"
-                           << point->GetLightYield() << ":" << point->GetEnergyLoss() << "\t";
-            }
+            LOG(DEBUG) << point->GetDetectorID() << ":" << tracks.at(point->GetTrackID())->GetPdgCode() << ":"
+                       << point->GetLightYield() << ":" << point->GetEnergyLoss() << "\t";
+        }
+
+        const auto iPrimary = Neuland::FindPrimaryTrack(point->GetTrackID(), tracks, fPrimaryOfTrack);
+        if (iPrimary < 0)
+        {
+            continue;
+        }
+
+        const auto ToF = point->GetTime();
+        if (fFirstPoint[iPrimary] == nullptr || ToF < fFirstPoint[iPrimary]->GetTime())
+        {
+            fFirstPoint[iPrimary] = point;
+        }
+        if (hit != nullptr && (fFirstHitPoint[iPrimary] == nullptr || ToF < fFirstHitPoint[iPrimary]->GetTime()))
+        {
+            fFirstHitPoint[iPrimary] = point;
         }
     }
 
-    for (const auto& track : tracks)
+    for (size_t iTrack = 0; iTrack < tracks.size(); iTrack++)
     {
-        if (IsPrimaryTrack(track))
+        if (Neuland::IsPrimaryTrack(tracks[iTrack]))
         {
-            const auto firstPoint = FindFirstPoint(track, p2t);
-            const auto firstHit = FindFirstHit(track, p2t, p2h);
+            const auto firstPoint = fFirstPoint[iTrack];
+            const auto firstHit = fFirstHitPoint[iTrack] ? FindHit(fFirstHitPoint[iTrack], fHitOfPaddle) : nullptr;
 
             if (firstPoint)
             {
@@ -21,6 +21,7 @@
 #include "TCAConnector.h"
 #include "TH1D.h"
 #include "TH2D.h"
+#include <vector>
 
 class R3BNeulandPrimaryInteractionFinder : public FairTask
 {
@@ -53,6 +54,12 @@ class R3BNeulandPrimaryInteractionFinder : public FairTask
     TCAOutputConnector<R3BNeulandPoint> fPointsOut;
     TCAOutputConnector<R3BNeulandHit> fHitsOut;
 
+    // Per event lookup tables, kept to reuse their memory
+    std::vector<R3BNeulandHit*> fHitOfPaddle;
+    std::vector<Int_t> fPrimaryOfTrack;
+    std::vector<R3BNeulandPoint*> fFirstPoint;
+    std::vector<R3BNeulandPoint*> fFirstHitPoint;
+
     TH1D* fhDistance;
     TH2D* fhPointsVsHits;
     TH2D* fhPointVsHitPaddle;
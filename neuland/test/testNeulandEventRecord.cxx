@@ -0,0 +1,139 @@
+/******************************************************************************
+ *   Copyright (C) 2019 GSI Helmholtzzentrum für Schwerionenforschung GmbH    *
+ *   Copyright (C) 2019 Members of R3B Collaboration                          *
+ *                                                                            *
+ *             This software is distributed under the terms of the            *
+ *                 GNU General Public Licence (GPL) version 3,                *
+ *                    copied verbatim in the file "LICENSE".                  *
+ *                                                                            *
+ * In applying this license GSI does not waive the privileges and immunities  *
+ * granted to it by virtue of its status as an Intergovernmental Organization *
+ * or submit itself to any jurisdiction.                                      *
+ ******************************************************************************/
+
+#include "EventRecord.h"
+#include "Likelihood.h"
+#include "LikelihoodBuilder.h"
+#include "gtest/gtest.h"
+#include <cstdio>
+#include <fstream>
+#include <string>
+
+namespace
+{
+    Neuland::EventRecord MakeEvent(const int id)
+    {
+        Neuland::EventRecord event;
+        event.runID = 7;
+        event.eventID = id;
+        event.nIn = 1;
+        const R3BNeulandHit h1(101, 0., 0., 40., 0., 0., 12.5, TVector3(1., 2., 1500.), TVector3(0., 0., 0.));
+        const R3BNeulandHit h2(152, 0., 0., 41., 0., 0., 3.5, TVector3(3., 2., 1505.), TVector3(1., 0., 1.));
+        const R3BNeulandHit h3(900, 0., 0., 55., 0., 0., 1.5, TVector3(50., -20., 1600.), TVector3(5., 2., 9.));
+        event.neutrons.emplace_back(h1);
+        event.AddCluster(R3BNeulandCluster(std::vector<R3BNeulandHit>{ h1, h2 }), 1);
+        event.AddCluster(R3BNeulandCluster(h3), 0);
+        return event;
+    }
+
+    TEST(testNeulandEventRecord, RoundTrip)
+    {
+        const std::string filename = "testNeulandEventRecord.bin";
+        {
+            Neuland::EventWriter writer(filename);
+            for (int i = 0; i < 3; i++)
+            {
+                writer.Write(MakeEvent(i));
+            }
+            EXPECT_EQ(writer.GetNEvents(), 3u);
+        }
+
+        Neuland::EventReader reader(filename);
+        Neuland::EventRecord event;
+        for (int i = 0; i < 3; i++)
+        {
+            ASSERT_TRUE(reader.Next(event));
+            EXPECT_EQ(event.runID, 7);
+            EXPECT_EQ(event.eventID, i);
+            EXPECT_EQ(event.nIn, 1);
+            ASSERT_EQ(event.neutrons.size(), 1u);
+            EXPECT_EQ(event.neutrons[0].id, 101);
+            ASSERT_EQ(event.clusters.size(), 2u);
+            EXPECT_EQ(event.clusters[0].primaryInteractions, 1);
+            EXPECT_EQ(event.clusters[1].primaryInteractions, 0);
+
+            const auto clusters = event.GetClusters();
+            ASSERT_EQ(clusters.size(), 2u);
+            EXPECT_EQ(clusters[0].GetSize(), 2u);
+            EXPECT_DOUBLE_EQ(clusters[0].GetE(), 16.);
+            EXPECT_EQ(clusters[1].GetFirstHit().GetPaddle(), 900);
+            EXPECT_DOUBLE_EQ(clusters[1].GetFirstHit().GetT(), 55.);
+            EXPECT_DOUBLE_EQ(clusters[1].GetFirstHit().GetPosition().Y(), -20.);
+            EXPECT_DOUBLE_EQ(clusters[1].GetFirstHit().GetPixel().Z(), 9.);
+        }
+        EXPECT_FALSE(reader.Next(event));
+        std::remove(filename.c_str());
+    }
+
+    TEST(testNeulandEventRecord, RejectsForeignFile)
+    {
+        const std::string filename = "testNeulandEventRecordForeign.bin";
+        {
+            std::ofstream file(filename);
+            file << "Not an event file";
+        }
+        EXPECT_THROW(Neuland::EventReader reader(filename), std::runtime_error);
+        std::remove(filename.c_str());
+    }
+
+    TEST(testNeulandEventRecord, RejectsWrongClusterSizes)
+    {
+        const std::string filename = "testNeulandEventRecordCorrupt.bin";
+        {
+            Neuland::EventWriter writer(filename);
+            writer.Write(MakeEvent(0));
+        }
+        {
+            // The record ends with the two clusters and their three hits, make the last cluster claim two hits
+            std::fstream file(filename, std::ios::binary | std::ios::in | std::ios::out);
+            file.seekp(-static_cast<std::streamoff>(3 * sizeof(Neuland::HitRecord) + sizeof(Neuland::ClusterRecord)),
+                       std::ios::end);
+            const uint32_t nHits = 2;
+            file.write(reinterpret_cast<const char*>(&nHits), sizeof(nHits));
+        }
+
+        Neuland::EventReader reader(filename);
+        Neuland::EventRecord event;
+        EXPECT_THROW(reader.Next(event), std::runtime_error);
+        std::remove(filename.c_str());
+    }
+
+    TEST(testNeulandEventRecord, BuildsLikelihoodTables)
+    {
+        Neuland::LikelihoodBuilder builder;
+        for (int i = 0; i < 4; i++)
+        {
+            builder.Add(MakeEvent(i));
+        }
+        builder.Write("testNeulandEventRecord");
+
+        const Neuland::Likelihood nclus("testNeulandEventRecord.nclus.dat");
+        EXPECT_DOUBLE_EQ(nclus.P(2, 1), 1.);
+        EXPECT_DOUBLE_EQ(nclus.P(3, 1), 0.);
+
+        const Neuland::Likelihood size("testNeulandEventRecord.size.dat");
+        EXPECT_DOUBLE_EQ(size.P(2, 1), 1.);
+        EXPECT_DOUBLE_EQ(size.P(1, 0), 1.);
+        EXPECT_DOUBLE_EQ(size.P(2, 0), 0.);
+
+        const Neuland::Likelihood energy("testNeulandEventRecord.energy.dat");
+        EXPECT_DOUBLE_EQ(energy.P(16, 1), 1.);
+        EXPECT_DOUBLE_EQ(energy.P(1.5, 0), 1.);
+        EXPECT_DOUBLE_EQ(energy.P(1.5, 1), 0.);
+
+        for (const auto suffix : { "nclus", "etot", "energy", "etof", "rval", "size", "time" })
+        {
+            std::remove(("testNeulandEventRecord." + std::string(suffix) + ".dat").c_str());
+        }
+    }
+} // namespace
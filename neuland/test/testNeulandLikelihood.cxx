@@ -0,0 +1,62 @@
+/******************************************************************************
+ *   Copyright (C) 2019 GSI Helmholtzzentrum für Schwerionenforschung GmbH    *
+ *   Copyright (C) 2019 Members of R3B Collaboration                          *
+ *                                                                            *
+ *             This software is distributed under the terms of the            *
+ *                 GNU General Public Licence (GPL) version 3,                *
+ *                    copied verbatim in the file "LICENSE".                  *
+ *                                                                            *
+ * In applying this license GSI does not waive the privileges and immunities  *
+ * granted to it by virtue of its status as an Intergovernmental Organization *
+ * or submit itself to any jurisdiction.                                      *
+ ******************************************************************************/
+
+#include "Likelihood.h"
+#include "gtest/gtest.h"
+#include <cstdio>
+#include <fstream>
+
+namespace
+{
+    using Neuland::Likelihood;
+
+    class testLikelihood : public testing::Test
+    {
+      protected:
+        void SetUp() override
+        {
+            std::ofstream file(fFileName);
+            file << "E\t1\t2\t4" << std::endl;
+            file << "0\t0.1\t0.2\t0.4" << std::endl;
+            file << "1\t0.11\t0.21\t0.41" << std::endl;
+            file << std::endl;
+            file << "5\t0.15\t0.25\t0.45" << std::endl;
+            file << "6\t0.16\t0.26" << std::endl;
+        }
+
+        void TearDown() override { std::remove(fFileName.c_str()); }
+
+        const std::string fFileName = "testNeulandLikelihood.dat";
+    };
+
+    TEST_F(testLikelihood, returnsValueOfTheFirstRowAtOrAboveE)
+    {
+        const Likelihood lh(fFileName);
+        EXPECT_FLOAT_EQ(0.1, lh.P(-10., 1));
+        EXPECT_FLOAT_EQ(0.2, lh.P(0., 2));
+        EXPECT_FLOAT_EQ(0.41, lh.P(0.3, 4));
+        EXPECT_FLOAT_EQ(0.11, lh.P(1., 1));
+        EXPECT_FLOAT_EQ(0.25, lh.P(1.01, 2));
+        EXPECT_FLOAT_EQ(0.45, lh.P(4.99, 4));
+        EXPECT_FLOAT_EQ(0.16, lh.P(5.5, 1));
+    }
+
+    TEST_F(testLikelihood, returnsZeroOutsideOfTheTable)
+    {
+        const Likelihood lh(fFileName);
+        EXPECT_EQ(0., lh.P(6.01, 1));
+        EXPECT_EQ(0., lh.P(3., 3));
+        EXPECT_EQ(0., lh.P(3., 7));
+        EXPECT_EQ(0., lh.P(6., 4));
+    }
+} // namespace
@@ -0,0 +1,87 @@
+/******************************************************************************
+ *   Copyright (C) 2019 GSI Helmholtzzentrum für Schwerionenforschung GmbH    *
+ *   Copyright (C) 2019 Members of R3B Collaboration                          *
+ *                                                                            *
+ *             This software is distributed under the terms of the            *
+ *                 GNU General Public Licence (GPL) version 3,                *
+ *                    copied verbatim in the file "LICENSE".                  *
+ *                                                                            *
+ * In applying this license GSI does not waive the privileges and immunities  *
+ * granted to it by virtue of its status as an Intergovernmental Organization *
+ * or submit itself to any jurisdiction.                                      *
+ ******************************************************************************/
+
+#include "PedestalEstimator.h"
+#include "gtest/gtest.h"
+#include <random>
+
+namespace
+{
+    TEST(testPedestalEstimator, InvalidWithoutSeed)
+    {
+        Neuland::PedestalEstimator est(1000, 4., 1., 50);
+        for (int i = 0; i < 49; i++)
+        {
+            est.Add(100.);
+        }
+        EXPECT_FALSE(est.IsValid());
+        est.Add(100.);
+        EXPECT_TRUE(est.IsValid());
+        EXPECT_DOUBLE_EQ(est.GetPedestal(), 100.);
+        EXPECT_EQ(est.GetEntries(), 50u);
+    }
+
+    TEST(testPedestalEstimator, IgnoresSignalTail)
+    {
+        std::mt19937 gen(42);
+        std::normal_distribution<double> pedestal(120., 3.);
+        std::uniform_real_distribution<double> signal(150., 2000.);
+        std::uniform_real_distribution<double> choice(0., 1.);
+
+        Neuland::PedestalEstimator est;
+        for (int i = 0; i < 100000; i++)
+        {
+            est.Add(choice(gen) < 0.3 ? signal(gen) : pedestal(gen));
+        }
+        ASSERT_TRUE(est.IsValid());
+        EXPECT_NEAR(est.GetPedestal(), 120., 0.5);
+        EXPECT_NEAR(est.GetWidth(), 3., 0.5);
+        EXPECT_GT(est.GetRejected(), 25000u);
+    }
+
+    TEST(testPedestalEstimator, FollowsDrift)
+    {
+        std::mt19937 gen(7);
+        std::normal_distribution<double> noise(0., 2.);
+
+        Neuland::PedestalEstimator est(500);
+        for (int i = 0; i < 20000; i++)
+        {
+            est.Add(100. + noise(gen));
+        }
+        EXPECT_NEAR(est.GetPedestal(), 100., 0.5);
+
+        // Slow drift of 10 channels, well within the cut for each step
+        for (int i = 0; i < 20000; i++)
+        {
+            est.Add(100. + 10. * i / 20000. + noise(gen));
+        }
+        for (int i = 0; i < 5000; i++)
+        {
+            est.Add(110. + noise(gen));
+        }
+        EXPECT_NEAR(est.GetPedestal(), 110., 0.5);
+    }
+
+    TEST(testPedestalEstimator, Reset)
+    {
+        Neuland::PedestalEstimator est(100, 4., 1., 1);
+        est.Add(10.);
+        EXPECT_TRUE(est.IsValid());
+        est.Reset();
+        EXPECT_FALSE(est.IsValid());
+        EXPECT_EQ(est.GetEntries(), 0u);
+        est.Add(20.);
+        EXPECT_DOUBLE_EQ(est.GetPedestal(), 20.);
+    }
+} // namespace
@@ -12,10 +12,14 @@
  ******************************************************************************/
 
 #include "FairRuntimeDb.h"
+#include "IsElastic.h"
 #include "R3BNeulandNeutron2DPar.h"
 #include "RecoTDR.h"
 #include "gtest/gtest.h"
 #include <algorithm>
+#include <cmath>
+#include <map>
+#include <random>
 
 namespace
 {
@@ -147,6 +151,118 @@ namespace
         R3BNeulandNeutron2DPar* fPar;
     };
 
+    // Straightforward all-pairs version of the elastic scattering filter, used as reference
+    void FilterClustersByElasticScatteringAllPairs(std::vector<R3BNeulandCluster*>& clusters)
+    {
+        std::map<const R3BNeulandCluster*, bool> marked;
+        for (const auto& c : clusters)
+        {
+            marked[c] = false;
+        }
+        for (const auto& a : clusters)
+        {
+            for (const auto& b : clusters)
+            {
+                if (a != b && a->GetT() < b->GetT() && Neuland::IsElastic(a, b))
+                {
+                    marked[b] = true;
+                }
+            }
+        }
+        clusters.erase(
+            std::remove_if(clusters.begin(), clusters.end(), [&](const R3BNeulandCluster* a) { return marked.at(a); }),
+            clusters.end());
+    }
+
+    // Random clusters of adjacent paddles, roughly following a neutron flying downstream into NeuLAND
+    std::vector<R3BNeulandCluster*> MakeRandomClusters(std::mt19937& rng, const UInt_t nClusters)
+    {
+        std::uniform_real_distribution<Double_t> xy(-125., 125.);
+        std::uniform_real_distribution<Double_t> plane(0., 30.);
+        std::uniform_real_distribution<Double_t> beta(0.5, 0.9);
+        std::uniform_real_distribution<Double_t> step(-7.5, 7.5);
+        std::uniform_real_distribution<Double_t> dt(0., 1.5);
+        std::uniform_real_distribution<Double_t> energy(0.5, 80.);
+        std::uniform_int_distribution<Int_t> nHits(1, 6);
+
+        std::vector<R3BNeulandCluster*> clusters;
+        Int_t paddle = 0;
+        for (UInt_t n = 0; n < nClusters; n++)
+        {
+            TVector3 pos(xy(rng), xy(rng), 1400. + 5. * std::floor(plane(rng)));
+            Double_t t = pos.Mag() / (beta(rng) * 29.9792458);
+
+            std::vector<R3BNeulandHit> hits;
+            const auto size = nHits(rng);
+            for (Int_t h = 0; h < size; h++)
+            {
+                const auto e = energy(rng);
+                hits.emplace_back(++paddle, t, t, t, e, e, e, pos, TVector3());
+                pos += TVector3(step(rng), step(rng), 5. * std::round(step(rng) / 7.5));
+                t += dt(rng);
+            }
+            clusters.push_back(new R3BNeulandCluster(hits));
+        }
+        return clusters;
+    }
+
+    TEST(testRecoTDRRandom, filtersClustersByElasticScatteringLikeAllPairs)
+    {
+        std::mt19937 rng(4242);
+        RecoTDR rs{};
+        UInt_t nRemovedTotal = 0;
+
+        for (UInt_t event = 0; event < 500; event++)
+        {
+            auto clusters = MakeRandomClusters(rng, 1 + event % 40);
+            std::shuffle(clusters.begin(), clusters.end(), rng);
+
+            auto expected = clusters;
+            FilterClustersByElasticScatteringAllPairs(expected);
+            auto filtered = clusters;
+            rs.FilterClustersByElasticScattering(filtered);
+
+            ASSERT_EQ(expected, filtered) << "Event " << event;
+            nRemovedTotal += clusters.size() - filtered.size();
+
+            for (auto cluster : clusters)
+            {
+                delete cluster;
+            }
+        }
+        // Make sure the comparison is not trivial
+        EXPECT_GT(nRemovedTotal, 0u);
+    }
+
+    TEST(testRecoTDRRandom, filtersClustersWithIdenticalTimesLikeAllPairs)
+    {
+        std::mt19937 rng(1337);
+        RecoTDR rs{};
+
+        for (UInt_t event = 0; event < 100; event++)
+        {
+            auto clusters = MakeRandomClusters(rng, 20);
+            // Duplicate some clusters to get ties in time
+            for (UInt_t n = 0; n < 5; n++)
+            {
+                clusters.push_back(new R3BNeulandCluster(*clusters.at(n * 3)));
+            }
+            std::shuffle(clusters.begin(), clusters.end(), rng);
+
+            auto expected = clusters;
+            FilterClustersByElasticScatteringAllPairs(expected);
+            auto filtered = clusters;
+            rs.FilterClustersByElasticScattering(filtered);
+
+            ASSERT_EQ(expected, filtered) << "Event " << event;
+
+            for (auto cluster : clusters)
+            {
+                delete cluster;
+            }
+        }
+    }
+
     TEST_F(testRecoTDR, takesAVectorOfClustersAndReturnsAVectorOfNeutrons)
     {
         RecoTDR rs{};
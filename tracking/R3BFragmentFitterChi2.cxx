@@ -21,229 +21,240 @@
 
 #define SPEED_OF_LIGHT 29.9792458 // cm/ns
 
-R3BTrackingParticle* gCandidate;
-R3BTrackingSetup* gSetup;
-R3BTPropagator* gProp;
-
-Bool_t gEnergyLoss;
-
-double Chi2(const double* xx)
+namespace
 {
-    // Bool_t result = kFALSE;
-    Double_t sdev = 0.;
-    Double_t x_l = 0.;
-    Double_t y_l = 0.;
-    Double_t prev_l = 0.;
-    Double_t time = 0.;
-    Double_t chi2 = 0.;
-    Int_t nchi2 = 0;
+    // Objective functions of the mass fits. The candidate, the setup and the propagator are held by the object
+    // instead of file-scope globals, so that independent candidates can be fitted concurrently in several threads.
+    // Each candidate must only be used by one fit at a time.
+    class Chi2Function
+    {
+      public:
+        Chi2Function(R3BTrackingParticle* candidate,
+                     R3BTrackingSetup* setup,
+                     R3BTPropagator* prop,
+                     Bool_t energyLoss)
+            : fCandidate(candidate)
+            , fSetup(setup)
+            , fProp(prop)
+            , fEnergyLoss(energyLoss)
+        {
+        }
 
-    gCandidate->SetMass(xx[0]);
-    gCandidate->UpdateMomentum();
+        double Forward(const double* xx) const;
 
-    gCandidate->Reset();
+        double Backward(const double* xx) const;
 
-    // Propagate through the setup, defined by array of detectors
-    for (auto const& det : gSetup->GetArray())
+      private:
+        R3BTrackingParticle* fCandidate;
+        R3BTrackingSetup* fSetup;
+        R3BTPropagator* fProp;
+        Bool_t fEnergyLoss;
+    };
+
+    double Chi2Function::Forward(const double* xx) const
     {
-        if (kTarget != det->section)
-        {
-            /*result = */ gProp->PropagateToDetector(gCandidate, det);
+        // Bool_t result = kFALSE;
+        Double_t sdev = 0.;
+        Double_t x_l = 0.;
+        Double_t y_l = 0.;
+        Double_t prev_l = 0.;
+        Double_t time = 0.;
+        Double_t chi2 = 0.;
+        Int_t nchi2 = 0;
 
-            time += (gCandidate->GetLength() - prev_l) / (gCandidate->GetBeta() * SPEED_OF_LIGHT);
-            prev_l = gCandidate->GetLength();
-        }
+        fCandidate->SetMass(xx[0]);
+        fCandidate->UpdateMomentum();
+
+        fCandidate->Reset();
 
-        if (gEnergyLoss)
+        // Propagate through the setup, defined by array of detectors
+        const Int_t nDet = fSetup->GetNumberOfDetectors();
+        for (Int_t i = 0; i < nDet; i++)
         {
-            if (kTof != det->section)
+            auto det = fSetup->GetByHandle(i);
+
+            if (kTarget != det->section)
             {
-                Double_t weight = 1.;
-                if (kTarget == det->section)
+                /*result = */ fProp->PropagateToDetector(fCandidate, det);
+
+                time += (fCandidate->GetLength() - prev_l) / (fCandidate->GetBeta() * SPEED_OF_LIGHT);
+                prev_l = fCandidate->GetLength();
+            }
+
+            if (fEnergyLoss)
+            {
+                if (kTof != det->section)
                 {
-                    weight = 0.5;
+                    Double_t weight = 1.;
+                    if (kTarget == det->section)
+                    {
+                        weight = 0.5;
+                    }
+                    fCandidate->PassThroughDetector(det, weight);
                 }
-                gCandidate->PassThroughDetector(det, weight);
             }
-        }
 
-        // Convert global track coordinates into local on the det plane
-        det->GlobalToLocal(gCandidate->GetPosition(), x_l, y_l);
+            // Convert global track coordinates into local on the det plane
+            det->GlobalToLocal(fCandidate->GetPosition(), x_l, y_l);
 
-        R3BHit* hit =
-            gSetup->GetHit(det->GetDetectorName().Data(), gCandidate->GetHitIndexByName(det->GetDetectorName().Data()));
+            R3BHit* hit = fSetup->GetHit(i, fCandidate->GetHitIndex(i));
 
-        // X deviation at the last detector
-        if (kAfterGlad == det->section)
-        {
-            sdev += TMath::Power(x_l - hit->GetX(), 2);
-        }
+            // X deviation at the last detector
+            if (kAfterGlad == det->section)
+            {
+                sdev += TMath::Power(x_l - hit->GetX(), 2);
+            }
 
-        // if(kTarget != det->section)
-        // if(kAfterGlad == det->section)
-        {
-            chi2 += TMath::Power((x_l - hit->GetX()) / det->res_x, 2);
-            // LOG(INFO) << nchi2 << "  " << chi2 << ",  dev: " << (x_l - det->hit_x);
-            nchi2 += 1;
-        }
+            // if(kTarget != det->section)
+            // if(kAfterGlad == det->section)
+            {
+                chi2 += TMath::Power((x_l - hit->GetX()) / det->res_x, 2);
+                // LOG(INFO) << nchi2 << "  " << chi2 << ",  dev: " << (x_l - det->hit_x);
+                nchi2 += 1;
+            }
 
-        if (kTof == det->section)
-        {
-            chi2 += TMath::Power((time - hit->GetTime()) / det->res_t, 2);
+            if (kTof == det->section)
+            {
+                chi2 += TMath::Power((time - hit->GetTime()) / det->res_t, 2);
+            }
         }
-    }
 
-    // sdev /= 2;
-    // sdev = TMath::Sqrt(sdev);
+        // sdev /= 2;
+        // sdev = TMath::Sqrt(sdev);
 
-    // chi2 /= nchi2;
-    gCandidate->SetChi2(chi2);
+        // chi2 /= nchi2;
+        fCandidate->SetChi2(chi2);
 
-    return chi2;
-}
+        return chi2;
+    }
 
-double Chi2Backward(const double* xx)
-{
-    // Bool_t result = kFALSE;
-    // Double_t sdev = 0.;
-    Double_t x_l = 0.;
-    Double_t y_l = 0.;
-    // Double_t prev_l = 0.;
-    // Double_t time = 0.;
-    Double_t chi2 = 0.;
-    Int_t nchi2 = 0;
-
-    gCandidate->SetMass(xx[0]);
-    gCandidate->UpdateMomentum();
-
-    gCandidate->Reset();
-
-    // Propagate through the setup, defined by array of detectors
-    for (Int_t i = (gSetup->GetArray().size() - 2); i >= 0; i--)
+    double Chi2Function::Backward(const double* xx) const
     {
-        auto det = gSetup->GetArray().at(i);
+        // Bool_t result = kFALSE;
+        // Double_t sdev = 0.;
+        Double_t x_l = 0.;
+        Double_t y_l = 0.;
+        // Double_t prev_l = 0.;
+        // Double_t time = 0.;
+        Double_t chi2 = 0.;
+        Int_t nchi2 = 0;
 
-        if (i < (gSetup->GetArray().size() - 2))
+        fCandidate->SetMass(xx[0]);
+        fCandidate->UpdateMomentum();
+
+        fCandidate->Reset();
+
+        // Propagate through the setup, defined by array of detectors
+        for (Int_t i = (fSetup->GetArray().size() - 2); i >= 0; i--)
         {
-            /*result = */ gProp->PropagateToDetectorBackward(gCandidate, det);
+            auto det = fSetup->GetArray().at(i);
 
-            // time += (gCandidate->GetLength() - prev_l) / (gCandidate->GetBeta() * SPEED_OF_LIGHT);
-            // prev_l = gCandidate->GetLength();
+            if (i < (fSetup->GetArray().size() - 2))
+            {
+                /*result = */ fProp->PropagateToDetectorBackward(fCandidate, det);
 
-            LOG(DEBUG2) << " at " << det->GetDetectorName() << ", momentum:" << gCandidate->GetMomentum().X() << ","
-                        << gCandidate->GetMomentum().Y() << gCandidate->GetMomentum().Z();
-        }
+                // time += (fCandidate->GetLength() - prev_l) / (fCandidate->GetBeta() * SPEED_OF_LIGHT);
+                // prev_l = fCandidate->GetLength();
 
-        if (gEnergyLoss)
-        {
-            Double_t weight = 1.;
-            if (kTarget == det->section)
+                LOG(DEBUG2) << " at " << det->GetDetectorName() << ", momentum:" << fCandidate->GetMomentum().X()
+                            << "," << fCandidate->GetMomentum().Y() << fCandidate->GetMomentum().Z();
+            }
+
+            if (fEnergyLoss)
             {
-                weight = 0.5;
+                Double_t weight = 1.;
+                if (kTarget == det->section)
+                {
+                    weight = 0.5;
+                }
+                fCandidate->PassThroughDetectorBackward(det, weight);
             }
-            gCandidate->PassThroughDetectorBackward(det, weight);
-        }
 
-        // Convert global track coordinates into local on the det plane
-        det->GlobalToLocal(gCandidate->GetPosition(), x_l, y_l);
+            // Convert global track coordinates into local on the det plane
+            det->GlobalToLocal(fCandidate->GetPosition(), x_l, y_l);
 
-        R3BHit* hit =
-            gSetup->GetHit(det->GetDetectorName().Data(), gCandidate->GetHitIndexByName(det->GetDetectorName().Data()));
+            R3BHit* hit = fSetup->GetHit(i, fCandidate->GetHitIndex(i));
 
-        // if(kTarget != det->section)
-        // if(kAfterGlad == det->section)
-        {
-            chi2 += TMath::Power((x_l - hit->GetX()) / det->res_x, 2);
-            // LOG(INFO) << nchi2 << "  " << chi2 << ",  dev: " << (x_l - det->hit_x);
-            nchi2 += 1;
+            // if(kTarget != det->section)
+            // if(kAfterGlad == det->section)
+            {
+                chi2 += TMath::Power((x_l - hit->GetX()) / det->res_x, 2);
+                // LOG(INFO) << nchi2 << "  " << chi2 << ",  dev: " << (x_l - det->hit_x);
+                nchi2 += 1;
+            }
+
+            //        if(kTof == det->section)
+            //        {
+            //            chi2 += TMath::Power((time - hit->GetTime()) / det->res_t, 2);
+            //        }
         }
 
-        //        if(kTof == det->section)
-        //        {
-        //            chi2 += TMath::Power((time - hit->GetTime()) / det->res_t, 2);
-        //        }
-    }
+        // sdev /= 2;
+        // sdev = TMath::Sqrt(sdev);
 
-    // sdev /= 2;
-    // sdev = TMath::Sqrt(sdev);
+        // chi2 /= nchi2;
+        fCandidate->SetChi2(chi2);
 
-    // chi2 /= nchi2;
-    gCandidate->SetChi2(chi2);
+        return chi2;
+    }
+} // namespace
 
-    return chi2;
+R3BFragmentFitterChi2::R3BFragmentFitterChi2()
+    : fPropagator(nullptr)
+    , fEnergyLoss(kTRUE)
+{
 }
 
-R3BFragmentFitterChi2::R3BFragmentFitterChi2() {}
-
 R3BFragmentFitterChi2::~R3BFragmentFitterChi2() {}
 
 void R3BFragmentFitterChi2::Init(R3BTPropagator* prop, Bool_t energyLoss)
 {
     fPropagator = prop;
-    gProp = prop;
-    gEnergyLoss = energyLoss;
-
-    fMinimum = ROOT::Math::Factory::CreateMinimizer("Minuit2", "");
-
-    // set tolerance , etc...
-    fMinimum->SetMaxFunctionCalls(1000000); // for Minuit/Minuit2
-    fMinimum->SetMaxIterations(10000);      // for GSL
-    fMinimum->SetTolerance(10.);
-    fMinimum->SetPrintLevel(0);
-    fMinimum->SetStrategy(0);
-
-    // create funciton wrapper for minmizer
-    // a IMultiGenFunction type
-    ROOT::Math::Functor* f = new ROOT::Math::Functor(&Chi2Backward, 1);
-
-    fMinimum->SetFunction(*f);
+    fEnergyLoss = energyLoss;
 }
 
 Int_t R3BFragmentFitterChi2::FitTrack(R3BTrackingParticle* particle, R3BTrackingSetup* setup)
 {
-    gCandidate = particle;
-
-    ROOT::Math::Minimizer* minimum = ROOT::Math::Factory::CreateMinimizer("Minuit2", "Combined");
+    // The minimizer is local to the call: no state is shared between fits
+    ROOT::Minuit2::Minuit2Minimizer minimum(ROOT::Minuit2::kCombined);
 
     // set tolerance , etc...
-    minimum->SetMaxFunctionCalls(1000000); // for Minuit/Minuit2
-    minimum->SetMaxIterations(10000);      // for GSL
-    minimum->SetTolerance(0.001);
-    minimum->SetPrintLevel(0);
+    minimum.SetMaxFunctionCalls(1000000); // for Minuit/Minuit2
+    minimum.SetMaxIterations(10000);      // for GSL
+    minimum.SetTolerance(0.001);
+    minimum.SetPrintLevel(0);
 
     // create funciton wrapper for minmizer
     // a IMultiGenFunction type
-    ROOT::Math::Functor f(&Chi2, 1);
+    // the forward fit always includes the energy loss
+    Chi2Function chi2(particle, setup, fPropagator, kTRUE);
+    ROOT::Math::Functor f(&chi2, &Chi2Function::Forward, 1);
     double variable[1] = { particle->GetMass() };
     double step[1] = {
         0.001,
     };
 
-    minimum->SetFunction(f);
+    minimum.SetFunction(f);
 
     // Set the free variables to be minimized!
-    minimum->SetLimitedVariable(0, "m", variable[0], step[0], variable[0] - 0.5, variable[0] + 0.5);
+    minimum.SetLimitedVariable(0, "m", variable[0], step[0], variable[0] - 0.5, variable[0] + 0.5);
 
     Int_t status = 0;
 
     // do the minimization
-    gEnergyLoss = kTRUE;
+    minimum.Minimize();
 
-    minimum->Minimize();
-
-    status = minimum->Status();
+    status = minimum.Status();
     if (0 != status)
     {
         return status;
     }
 
-    particle->SetMass(minimum->X()[0]);
+    particle->SetMass(minimum.X()[0]);
     particle->UpdateMomentum();
 
     particle->Reset();
 
-    delete minimum;
-
     return status;
 }
 
@@ -251,26 +262,43 @@ Int_t R3BFragmentFitterChi2::FitTrackBackward(R3BTrackingParticle* particle, R3B
 {
     // fPropagator->SetVis(kTRUE);
 
-    gCandidate = particle;
-    gSetup = setup;
+    const Int_t hfi4 = setup->GetHandle("fi4");
+    const Int_t hfi5 = setup->GetHandle("fi5");
+    const Int_t hfi6 = setup->GetHandle("fi6");
+    auto fi4 = setup->GetByHandle(hfi4);
+    auto fi5 = setup->GetByHandle(hfi5);
+    auto fi6 = setup->GetByHandle(hfi6);
+    // auto tof = setup->GetFirstByType(kTof);
+
+    // The minimizer is local to the call: no state is shared between fits
+    ROOT::Minuit2::Minuit2Minimizer minimum(ROOT::Minuit2::kMigrad);
 
-    auto fi4 = gSetup->GetByName("fi4");
-    auto fi5 = gSetup->GetByName("fi5");
-    auto fi6 = gSetup->GetByName("fi6");
-    // auto tof = gSetup->GetFirstByType(kTof);
+    // set tolerance , etc...
+    minimum.SetMaxFunctionCalls(1000000); // for Minuit/Minuit2
+    minimum.SetMaxIterations(10000);      // for GSL
+    minimum.SetTolerance(10.);
+    minimum.SetPrintLevel(0);
+    minimum.SetStrategy(0);
 
-    double variable[1] = { 132. * 0.9314940954 };
+    // create funciton wrapper for minmizer
+    // a IMultiGenFunction type
+    Chi2Function chi2(particle, setup, fPropagator, fEnergyLoss);
+    ROOT::Math::Functor f(&chi2, &Chi2Function::Backward, 1);
+
+    minimum.SetFunction(f);
+
+    double variable[1] = { TMath::Min(TMath::Max(132. * 0.9314940954, fMassMin), fMassMax) };
     double step[1] = { 0.01 };
 
     // Set the free variables to be minimized!
-    fMinimum->SetLimitedVariable(0, "m", variable[0], step[0], 125. * 0.9314940954, 133. * 0.9314940954);
+    minimum.SetLimitedVariable(0, "m", variable[0], step[0], fMassMin, fMassMax);
 
     TVector3 pos1;
     TVector3 pos2;
     TVector3 pos3;
-    fi4->LocalToGlobal(pos1, gSetup->GetHit("fi4", particle->GetHitIndexByName("fi4"))->GetX(), 0.);
-    fi5->LocalToGlobal(pos2, gSetup->GetHit("fi5", particle->GetHitIndexByName("fi5"))->GetX(), 0.);
-    fi6->LocalToGlobal(pos3, gSetup->GetHit("fi6", particle->GetHitIndexByName("fi6"))->GetX(), 0.);
+    fi4->LocalToGlobal(pos1, setup->GetHit(hfi4, particle->GetHitIndex(hfi4))->GetX(), 0.);
+    fi5->LocalToGlobal(pos2, setup->GetHit(hfi5, particle->GetHitIndex(hfi5))->GetX(), 0.);
+    fi6->LocalToGlobal(pos3, setup->GetHit(hfi6, particle->GetHitIndex(hfi6))->GetX(), 0.);
     /*Int_t np = 3;
     Double_t x[] = {pos1.X(), pos2.X(), pos3.X()};
     Double_t xe[] = {fi4->res_x, fi5->res_x, fi6->res_x};
@@ -285,38 +313,38 @@ Int_t R3BFragmentFitterChi2::FitTrackBackward(R3BTrackingParticle* particle, R3B
     f1->Eval(fi6->hit_x)) ).Unit(); TVector3 pos0(f2->Eval(fi6->pos0.Z()), 0., fi6->pos0.Z());*/
     TVector3 direction0 = (pos2 - pos3).Unit();
     TVector3 pos0 = pos3;
-    Double_t mom = gCandidate->GetMass() * gCandidate->GetStartBeta() * gCandidate->GetStartGamma();
+    Double_t mom = particle->GetMass() * particle->GetStartBeta() * particle->GetStartGamma();
     TVector3 startMomentum(mom * direction0.X(), mom * direction0.Y(), mom * direction0.Z());
-    gCandidate->SetStartPosition(pos0);
-    gCandidate->SetStartMomentum(startMomentum);
-    gCandidate->Reset();
+    particle->SetStartPosition(pos0);
+    particle->SetStartMomentum(startMomentum);
+    particle->Reset();
 
     // pos1.Print();
     // startMomentum.Print();
 
-    for (Int_t i = 0; i <= (gSetup->GetArray().size() - 2); i++)
+    for (Int_t i = 0; i <= (setup->GetArray().size() - 2); i++)
     {
-        auto det = gSetup->GetArray().at(i);
+        auto det = setup->GetArray().at(i);
 
-        if (gEnergyLoss)
+        if (fEnergyLoss)
         {
             Double_t weight = 1.;
             if (kTarget == det->section)
             {
                 weight = 0.5;
             }
-            gCandidate->PassThroughDetector(det, weight);
+            particle->PassThroughDetector(det, weight);
         }
     }
 
-    // LOG(INFO) << "1 Start beta:" << gCandidate->GetStartBeta()
-    //<< ",  Beta:" << gCandidate->GetBeta();
+    // LOG(INFO) << "1 Start beta:" << particle->GetStartBeta()
+    //<< ",  Beta:" << particle->GetBeta();
 
-    gCandidate->SetStartBeta(gCandidate->GetBeta());
-    gCandidate->SetCharge(-1. * gCandidate->GetCharge());
-    gCandidate->UpdateMomentum();
+    particle->SetStartBeta(particle->GetBeta());
+    particle->SetCharge(-1. * particle->GetCharge());
+    particle->UpdateMomentum();
 
-    // Double_t chi2 = Chi2Backward(variable);
+    // Double_t chi2 = chi2.Backward(variable);
 
     // LOG(INFO) << "2 chi2 = " << chi2;
 
@@ -325,21 +353,19 @@ Int_t R3BFragmentFitterChi2::FitTrackBackward(R3BTrackingParticle* particle, R3B
     Int_t status = 0;
 
     // do the minimization
-    fMinimum->Minimize();
+    minimum.Minimize();
 
-    gCandidate->SetCharge(-1. * gCandidate->GetCharge());
+    particle->SetCharge(-1. * particle->GetCharge());
 
-    status = fMinimum->Status();
+    status = minimum.Status();
     if (0 != status)
     {
         return status;
     }
 
-    particle->SetMass(fMinimum->X()[0]);
+    particle->SetMass(minimum.X()[0]);
     particle->UpdateMomentum();
 
-    fMinimum->Clear();
-
     // candidate->Reset();
 
     return status;
@@ -405,8 +431,8 @@ Double_t R3BFragmentFitterChi2::TrackFragment(R3BTrackingParticle* particle,
             // Convert global track coordinates into local on the det plane
             det->GlobalToLocal(particle->GetPosition(), x_l, y_l);
 
-            R3BHit* hit = fDetectors->GetHit(det->GetDetectorName().Data(),
-       particle->GetHitIndexByName(det->GetDetectorName().Data()));
+            const Int_t handle = fDetectors->GetHandle(det->GetDetectorName().Data());
+            R3BHit* hit = fDetectors->GetHit(handle, particle->GetHitIndex(handle));
 
             // X deviation at the last detector
             if (kAfterGlad == det->section)
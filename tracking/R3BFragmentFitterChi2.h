@@ -16,11 +16,11 @@
 
 #include "R3BFragmentFitterGeneric.h"
 
-#include "Math/Factory.h"
 #include "Math/Functor.h"
-#include "Math/Minimizer.h"
 #include "Minuit2/Minuit2Minimizer.h"
 
+// Mass fit by chi2 minimisation. The fits keep no state in the fitter between calls, FitTrack and FitTrackBackward
+// may be called concurrently for different candidates, as long as the propagator is not in visualisation mode.
 class R3BFragmentFitterChi2 : public R3BFragmentFitterGeneric
 {
   public:
@@ -47,10 +47,10 @@ class R3BFragmentFitterChi2 : public R3BFragmentFitterGeneric
     Double_t Velocity(R3BTrackingParticle* candidate);
 
   private:
-    ROOT::Math::Minimizer* fMinimum;
     R3BTPropagator* fPropagator;
+    Bool_t fEnergyLoss;
 
-    ClassDef(R3BFragmentFitterChi2, 1)
+    ClassDef(R3BFragmentFitterChi2, 2)
 };
 
 #endif
@@ -16,6 +16,8 @@
 ClassImp(R3BFragmentFitterGeneric)
 
     R3BFragmentFitterGeneric::R3BFragmentFitterGeneric()
+    : fMassMin(125. * 0.9314940954)
+    , fMassMax(133. * 0.9314940954)
 {
 }
 
@@ -32,7 +32,21 @@ class R3BFragmentFitterGeneric
 
     virtual Int_t FitTrackBackward(R3BTrackingParticle*, R3BTrackingSetup*) = 0;
 
-    ClassDef(R3BFragmentFitterGeneric, 1)
+    // Range of the fitted mass (GeV/c2), also the rigidity range the tracker prepares the propagation for.
+    // Default is 125-133 u.
+    void SetMassLimits(Double_t massMin, Double_t massMax)
+    {
+        fMassMin = massMin;
+        fMassMax = massMax;
+    }
+    Double_t GetMassMin() const { return fMassMin; }
+    Double_t GetMassMax() const { return fMassMax; }
+
+  protected:
+    Double_t fMassMin;
+    Double_t fMassMax;
+
+    ClassDef(R3BFragmentFitterGeneric, 2)
 };
 
 #endif
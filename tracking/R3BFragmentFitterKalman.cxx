@@ -0,0 +1,594 @@
+/******************************************************************************
+ *   Copyright (C) 2019 GSI Helmholtzzentrum für Schwerionenforschung GmbH    *
+ *   Copyright (C) 2019 Members of R3B Collaboration                          *
+ *                                                                            *
+ *             This software is distributed under the terms of the            *
+ *                 GNU General Public Licence (GPL) version 3,                *
+ *                    copied verbatim in the file "LICENSE".                  *
+ *                                                                            *
+ * In applying this license GSI does not waive the privileges and immunities  *
+ * granted to it by virtue of its status as an Intergovernmental Organization *
+ * or submit itself to any jurisdiction.                                      *
+ ******************************************************************************/
+
+#include "R3BFragmentFitterKalman.h"
+#include "R3BHit.h"
+#include "R3BTGeoPar.h"
+#include "R3BTPropagator.h"
+#include "R3BTrackingDetector.h"
+#include "R3BTrackingParticle.h"
+#include "R3BTrackingSetup.h"
+
+#include "TMath.h"
+#include "TVector3.h"
+
+#include <vector>
+
+namespace
+{
+    const Int_t kN = 5; // x, y, tx, ty, q/p
+
+    typedef Double_t Matrix[kN][kN];
+
+    // Local frame of a detector plane, see R3BTrackingDetector::GlobalToLocal
+    struct Frame
+    {
+        TVector3 origin;
+        TVector3 ex;
+        TVector3 ey;
+        TVector3 ez;
+    };
+
+    struct Jacobian
+    {
+        Matrix J;
+    };
+
+    // C = J C J^T
+    void Transform(const Matrix& J, Matrix& C)
+    {
+        Matrix JC;
+        for (Int_t i = 0; i < kN; i++)
+        {
+            for (Int_t j = 0; j < kN; j++)
+            {
+                JC[i][j] = 0.;
+                for (Int_t k = 0; k < kN; k++)
+                {
+                    JC[i][j] += J[i][k] * C[k][j];
+                }
+            }
+        }
+        for (Int_t i = 0; i < kN; i++)
+        {
+            for (Int_t j = 0; j < kN; j++)
+            {
+                C[i][j] = 0.;
+                for (Int_t k = 0; k < kN; k++)
+                {
+                    C[i][j] += JC[i][k] * J[j][k];
+                }
+            }
+        }
+    }
+
+    // Fit of one candidate: the measuring detectors with the hits of the candidate and the transport between them.
+    // The state on a detector plane is taken on the downstream side of its material, except for the result of the
+    // backward filter, which is at the centre of the target.
+    class KalmanFit
+    {
+      public:
+        KalmanFit(R3BTrackingParticle* candidate,
+                  R3BTrackingSetup* setup,
+                  R3BTPropagator* prop,
+                  Bool_t energyLoss,
+                  Bool_t scattering);
+
+        // At least three detectors and hits on the last two, for the seed
+        Bool_t IsValid() const { return fValid; }
+
+        // Mass used for the velocity in the material effects
+        void SetMass(Double_t mass) { fMass = mass; }
+
+        // State on the last detector, on the straight line through the hits of the last two detectors
+        Bool_t Seed(Double_t qp, Double_t* s) const;
+
+        // Large initial covariance for a filter pass
+        void SeedCovariance(const Double_t* s, Matrix& C) const;
+
+        // Conversion between the state on the first detector and global position and momentum
+        Bool_t GetState(const R3BTrackingParticle* particle, Double_t* s) const;
+        void GetParticle(const Double_t* s, TVector3& position, TVector3& momentum) const;
+
+        // Filter from the last detector to the target centre, resp. in the opposite direction. With jacobians the
+        // transport Jacobians are computed and stored, otherwise those of the previous pass are used.
+        Bool_t FilterBackward(Double_t* s, Matrix& C, Double_t& chi2, Bool_t jacobians);
+        Bool_t FilterForward(Double_t* s, Matrix& C, Double_t& chi2, Bool_t jacobians);
+
+        // Transport from the target centre to the last detector, without measurements
+        Bool_t TransportForward(Double_t* s) const;
+
+      private:
+        R3BTrackingParticle ToParticle(Int_t i, const Double_t* s, Bool_t backward) const;
+        Bool_t FromParticle(Int_t i, const R3BTrackingParticle& particle, Bool_t backward, Double_t* s) const;
+
+        Bool_t Propagate(Int_t from, Int_t to, const Double_t* s, Double_t* out) const;
+        Bool_t Propagate(Int_t from, Int_t to, const Double_t* s, Double_t* out, Matrix& J) const;
+
+        Double_t Weight(Int_t i) const { return (kTarget == fDetectors[i]->section) ? 0.5 : 1.; }
+        void Material(Int_t i, Bool_t backward, Double_t* s, Matrix* C) const;
+        void Update(Int_t i, Double_t* s, Matrix& C, Double_t& chi2) const;
+
+        R3BTPropagator* fProp;
+        Bool_t fEnergyLoss;
+        Bool_t fScattering;
+        Double_t fCharge;
+        Double_t fMass;
+        std::vector<R3BTrackingDetector*> fDetectors;
+        std::vector<Frame> fFrames;
+        std::vector<Double_t> fHitX;
+        std::vector<Bool_t> fMeasured;
+        std::vector<Jacobian> fBackward; // [i]: from detector i to i - 1
+        std::vector<Jacobian> fForward;  // [i]: from detector i - 1 to i
+        Bool_t fValid;
+    };
+
+    KalmanFit::KalmanFit(R3BTrackingParticle* candidate,
+                         R3BTrackingSetup* setup,
+                         R3BTPropagator* prop,
+                         Bool_t energyLoss,
+                         Bool_t scattering)
+        : fProp(prop)
+        , fEnergyLoss(energyLoss)
+        , fScattering(scattering)
+        , fCharge(candidate->GetCharge())
+        , fMass(candidate->GetMass())
+        , fValid(kFALSE)
+    {
+        const Int_t nDet = setup->GetNumberOfDetectors();
+        for (Int_t i = 0; i < nDet; i++)
+        {
+            R3BTrackingDetector* det = setup->GetByHandle(i);
+            if (kTof == det->section)
+            {
+                continue;
+            }
+
+            const Double_t angle = det->GetGeoPar()->GetRotY() * TMath::DegToRad();
+            Frame f = { det->pos0, TVector3(1., 0., 0.), TVector3(0., 1., 0.), TVector3(0., 0., 1.) };
+            f.ex.RotateY(angle);
+            f.ez.RotateY(angle);
+
+            const Int_t index = candidate->GetHitIndex(i);
+
+            fDetectors.push_back(det);
+            fFrames.push_back(f);
+            fMeasured.push_back(index >= 0);
+            fHitX.push_back(index >= 0 ? setup->GetHit(i, index)->GetX() : 0.);
+        }
+
+        const Int_t n = fDetectors.size();
+        fBackward.resize(n);
+        fForward.resize(n);
+        fValid = (n >= 3) && fMeasured[n - 1] && fMeasured[n - 2];
+    }
+
+    R3BTrackingParticle KalmanFit::ToParticle(Int_t i, const Double_t* s, Bool_t backward) const
+    {
+        // Backward, the particle runs along the reversed momentum with the opposite charge
+        const Frame& f = fFrames[i];
+        const TVector3 pos = f.origin + s[0] * f.ex + s[1] * f.ey;
+        const Double_t p = TMath::Abs(fCharge / s[4]);
+        const TVector3 mom = (backward ? -p : p) * (s[2] * f.ex + s[3] * f.ey + f.ez).Unit();
+        const Double_t beta = p / TMath::Sqrt(p * p + fMass * fMass);
+        return R3BTrackingParticle(
+            backward ? -fCharge : fCharge, pos.X(), pos.Y(), pos.Z(), mom.X(), mom.Y(), mom.Z(), beta, fMass);
+    }
+
+    Bool_t KalmanFit::FromParticle(Int_t i, const R3BTrackingParticle& particle, Bool_t backward, Double_t* s) const
+    {
+        const Frame& f = fFrames[i];
+        const TVector3 d = particle.GetPosition() - f.origin;
+        const Double_t p = particle.GetMomentum().Mag();
+        const TVector3 dir = (backward ? -1. / p : 1. / p) * particle.GetMomentum();
+        const Double_t pz = dir.Dot(f.ez);
+        if (!(pz > 0.))
+        {
+            return kFALSE;
+        }
+        s[0] = d.Dot(f.ex);
+        s[1] = d.Dot(f.ey);
+        s[2] = dir.Dot(f.ex) / pz;
+        s[3] = dir.Dot(f.ey) / pz;
+        s[4] = fCharge / p;
+        return TMath::Finite(s[0]) && TMath::Finite(s[2]) && TMath::Finite(s[4]);
+    }
+
+    Bool_t KalmanFit::Seed(Double_t qp, Double_t* s) const
+    {
+        const Int_t last = fDetectors.size() - 1;
+        TVector3 a;
+        TVector3 b;
+        fDetectors[last - 1]->LocalToGlobal(a, fHitX[last - 1], 0.);
+        fDetectors[last]->LocalToGlobal(b, fHitX[last], 0.);
+        const TVector3 dir = (b - a).Unit();
+        const Frame& f = fFrames[last];
+        const Double_t pz = dir.Dot(f.ez);
+        if (!(pz > 0.))
+        {
+            return kFALSE;
+        }
+        s[0] = fHitX[last];
+        s[1] = 0.;
+        s[2] = dir.Dot(f.ex) / pz;
+        s[3] = dir.Dot(f.ey) / pz;
+        s[4] = qp;
+        return kTRUE;
+    }
+
+    void KalmanFit::SeedCovariance(const Double_t* s, Matrix& C) const
+    {
+        const Double_t sigma[kN] = { 1., 1., 0.01, 0.01, 0.1 * TMath::Abs(s[4]) };
+        for (Int_t i = 0; i < kN; i++)
+        {
+            for (Int_t j = 0; j < kN; j++)
+            {
+                C[i][j] = (i == j) ? sigma[i] * sigma[i] : 0.;
+            }
+        }
+    }
+
+    Bool_t KalmanFit::GetState(const R3BTrackingParticle* particle, Double_t* s) const
+    {
+        return FromParticle(0, *particle, kFALSE, s);
+    }
+
+    void KalmanFit::GetParticle(const Double_t* s, TVector3& position, TVector3& momentum) const
+    {
+        const R3BTrackingParticle particle = ToParticle(0, s, kFALSE);
+        position = particle.GetPosition();
+        momentum = particle.GetMomentum();
+    }
+
+    Bool_t KalmanFit::Propagate(Int_t from, Int_t to, const Double_t* s, Double_t* out) const
+    {
+        const Bool_t backward = (to < from);
+        R3BTrackingParticle particle = ToParticle(from, s, backward);
+        const Bool_t result = backward ? fProp->PropagateToDetectorBackward(&particle, fDetectors[to])
+                                       : fProp->PropagateToDetector(&particle, fDetectors[to]);
+        return result && FromParticle(to, particle, backward, out);
+    }
+
+    Bool_t KalmanFit::Propagate(Int_t from, Int_t to, const Double_t* s, Double_t* out, Matrix& J) const
+    {
+        if (!Propagate(from, to, s, out))
+        {
+            return kFALSE;
+        }
+
+        // Forward differences. The steps shift the transported track by 0.1 mm or more, well above the numerical noise
+        // of the propagation (up to 1e-3 cm with the adaptive step size), and keep it in the linear range.
+        const Double_t delta[kN] = { 1e-1, 1e-1, 1e-3, 1e-3, 1e-3 * TMath::Abs(s[4]) };
+        for (Int_t k = 0; k < kN; k++)
+        {
+            Double_t sk[kN];
+            Double_t outk[kN];
+            for (Int_t i = 0; i < kN; i++)
+            {
+                sk[i] = s[i];
+            }
+            sk[k] += delta[k];
+            if (!Propagate(from, to, sk, outk))
+            {
+                return kFALSE;
+            }
+            for (Int_t i = 0; i < kN; i++)
+            {
+                J[i][k] = (outk[i] - out[i]) / delta[k];
+            }
+        }
+        return kTRUE;
+    }
+
+    void KalmanFit::Material(Int_t i, Bool_t backward, Double_t* s, Matrix* C) const
+    {
+        R3BTrackingDetector* det = fDetectors[i];
+        const Double_t weight = Weight(i);
+
+        if (fEnergyLoss)
+        {
+            // Energy loss, and its derivative for the q/p row of the covariance
+            const Double_t eps = 1e-4;
+            Double_t shifted[kN] = { s[0], s[1], s[2], s[3], s[4] * (1. + eps) };
+            R3BTrackingParticle particle = ToParticle(i, s, kFALSE);
+            R3BTrackingParticle particleShifted = ToParticle(i, shifted, kFALSE);
+            if (backward)
+            {
+                particle.PassThroughDetectorBackward(det, weight);
+                particleShifted.PassThroughDetectorBackward(det, weight);
+            }
+            else
+            {
+                particle.PassThroughDetector(det, weight);
+                particleShifted.PassThroughDetector(det, weight);
+            }
+            const Double_t qp = fCharge / particle.GetMomentum().Mag();
+            const Double_t d = (fCharge / particleShifted.GetMomentum().Mag() - qp) / (eps * s[4]);
+            s[4] = qp;
+            if (C)
+            {
+                for (Int_t j = 0; j < kN; j++)
+                {
+                    (*C)[4][j] *= d;
+                    (*C)[j][4] *= d;
+                }
+            }
+        }
+
+        if (fScattering && C)
+        {
+            // Multiple scattering (Highland), radiation length from the approximation of Dahl
+            const R3BTGeoPar* geo = det->GetGeoPar();
+            const Double_t Z = geo->GetZ();
+            if (Z <= 0.)
+            {
+                return;
+            }
+            const Double_t x0 = 716.4 * geo->GetA() / (Z * (Z + 1.) * TMath::Log(287. / TMath::Sqrt(Z)));
+            const Double_t t2 = 1. + s[2] * s[2] + s[3] * s[3];
+            const Double_t t = weight * 2. * geo->GetDimZ() * geo->GetDensity() / x0 * TMath::Sqrt(t2);
+            if (t <= 0.)
+            {
+                return;
+            }
+            const Double_t p = TMath::Abs(fCharge / s[4]);
+            const Double_t beta = p / TMath::Sqrt(p * p + fMass * fMass);
+            const Double_t z = TMath::Abs(fCharge);
+            const Double_t theta0 =
+                0.0136 / (beta * p) * z * TMath::Sqrt(t) * (1. + 0.038 * TMath::Log(t * z * z / (beta * beta)));
+            const Double_t var = theta0 * theta0 * t2;
+            (*C)[2][2] += var * (1. + s[2] * s[2]);
+            (*C)[3][3] += var * (1. + s[3] * s[3]);
+            (*C)[2][3] += var * s[2] * s[3];
+            (*C)[3][2] += var * s[2] * s[3];
+        }
+    }
+
+    void KalmanFit::Update(Int_t i, Double_t* s, Matrix& C, Double_t& chi2) const
+    {
+        if (!fMeasured[i])
+        {
+            return;
+        }
+
+        // Measurement of the local x
+        const Double_t r = fHitX[i] - s[0];
+        const Double_t S = C[0][0] + fDetectors[i]->res_x * fDetectors[i]->res_x;
+        Double_t K[kN];
+        Double_t row[kN];
+        for (Int_t j = 0; j < kN; j++)
+        {
+            K[j] = C[j][0] / S;
+            row[j] = C[0][j];
+        }
+        for (Int_t j = 0; j < kN; j++)
+        {
+            s[j] += K[j] * r;
+            for (Int_t k = 0; k < kN; k++)
+            {
+                C[j][k] -= K[j] * row[k];
+            }
+        }
+        chi2 += r * r / S;
+    }
+
+    Bool_t KalmanFit::FilterBackward(Double_t* s, Matrix& C, Double_t& chi2, Bool_t jacobians)
+    {
+        const Int_t last = fDetectors.size() - 1;
+        Double_t out[kN];
+
+        chi2 = 0.;
+        Update(last, s, C, chi2);
+        for (Int_t i = last; i > 0; i--)
+        {
+            Material(i, kTRUE, s, &C);
+            if (!(jacobians ? Propagate(i, i - 1, s, out, fBackward[i].J) : Propagate(i, i - 1, s, out)))
+            {
+                return kFALSE;
+            }
+            Transform(fBackward[i].J, C);
+            for (Int_t j = 0; j < kN; j++)
+            {
+                s[j] = out[j];
+            }
+            Update(i - 1, s, C, chi2);
+        }
+        Material(0, kTRUE, s, &C);
+        return kTRUE;
+    }
+
+    Bool_t KalmanFit::FilterForward(Double_t* s, Matrix& C, Double_t& chi2, Bool_t jacobians)
+    {
+        const Int_t last = fDetectors.size() - 1;
+        Double_t out[kN];
+
+        chi2 = 0.;
+        Material(0, kFALSE, s, &C);
+        Update(0, s, C, chi2);
+        for (Int_t i = 1; i <= last; i++)
+        {
+            if (!(jacobians ? Propagate(i - 1, i, s, out, fForward[i].J) : Propagate(i - 1, i, s, out)))
+            {
+                return kFALSE;
+            }
+            Transform(fForward[i].J, C);
+            for (Int_t j = 0; j < kN; j++)
+            {
+                s[j] = out[j];
+            }
+            Material(i, kFALSE, s, &C);
+            Update(i, s, C, chi2);
+        }
+        return kTRUE;
+    }
+
+    Bool_t KalmanFit::TransportForward(Double_t* s) const
+    {
+        const Int_t last = fDetectors.size() - 1;
+        Double_t out[kN];
+
+        Material(0, kFALSE, s, nullptr);
+        for (Int_t i = 1; i <= last; i++)
+        {
+            if (!Propagate(i - 1, i, s, out))
+            {
+                return kFALSE;
+            }
+            for (Int_t j = 0; j < kN; j++)
+            {
+                s[j] = out[j];
+            }
+            Material(i, kFALSE, s, nullptr);
+        }
+        return kTRUE;
+    }
+
+    void PackCovariance(const Matrix& C, Double_t* cov)
+    {
+        for (Int_t i = 0; i < kN; i++)
+        {
+            for (Int_t j = 0; j <= i; j++)
+            {
+                cov[i * (i + 1) / 2 + j] = C[i][j];
+            }
+        }
+    }
+} // namespace
+
+R3BFragmentFitterKalman::R3BFragmentFitterKalman()
+    : fPropagator(nullptr)
+    , fEnergyLoss(kTRUE)
+    , fNIterations(2)
+    , fScattering(kTRUE)
+{
+}
+
+R3BFragmentFitterKalman::~R3BFragmentFitterKalman() {}
+
+void R3BFragmentFitterKalman::Init(R3BTPropagator* prop, Bool_t energyLoss)
+{
+    fPropagator = prop;
+    fEnergyLoss = energyLoss;
+}
+
+Int_t R3BFragmentFitterKalman::FitTrack(R3BTrackingParticle* particle, R3BTrackingSetup* setup)
+{
+    KalmanFit fit(particle, setup, fPropagator, fEnergyLoss, fScattering);
+    if (!fit.IsValid())
+    {
+        return 1;
+    }
+
+    // The forward filter from the start of the particle seeds the backward filter
+    const Double_t betaGamma = particle->GetStartBeta() * particle->GetStartGamma();
+    Double_t s[kN];
+    Matrix C;
+    Double_t chi2 = 0.;
+    particle->UpdateMomentum();
+    particle->Reset();
+    if (!fit.GetState(particle, s))
+    {
+        return 1;
+    }
+    fit.SeedCovariance(s, C);
+    if (!fit.FilterForward(s, C, chi2, kTRUE))
+    {
+        return 2;
+    }
+
+    for (Int_t iteration = 0; iteration < fNIterations; iteration++)
+    {
+        if (iteration > 0)
+        {
+            fit.SetMass(TMath::Abs(particle->GetCharge() / s[4]) / betaGamma);
+            if (!fit.TransportForward(s))
+            {
+                return 2;
+            }
+        }
+        fit.SeedCovariance(s, C);
+        if (!fit.FilterBackward(s, C, chi2, 0 == iteration))
+        {
+            return 2;
+        }
+    }
+
+    TVector3 position;
+    TVector3 momentum;
+    Double_t cov[15];
+    fit.GetParticle(s, position, momentum);
+    PackCovariance(C, cov);
+
+    particle->SetStartPosition(position);
+    particle->SetStartMomentum(momentum);
+    particle->SetMass(momentum.Mag() / betaGamma);
+    particle->UpdateMomentum();
+    particle->Reset();
+    particle->SetChi2(chi2);
+    particle->SetCovariance(cov);
+
+    return 0;
+}
+
+Int_t R3BFragmentFitterKalman::FitTrackBackward(R3BTrackingParticle* particle, R3BTrackingSetup* setup)
+{
+    KalmanFit fit(particle, setup, fPropagator, fEnergyLoss, fScattering);
+    if (!fit.IsValid())
+    {
+        return 1;
+    }
+
+    // Momentum of the mass hypothesis at the start velocity as seed
+    const Double_t betaGamma = particle->GetStartBeta() * particle->GetStartGamma();
+    Double_t s[kN];
+    Matrix C;
+    Double_t chi2 = 0.;
+    if (!fit.Seed(particle->GetCharge() / (particle->GetMass() * betaGamma), s))
+    {
+        return 1;
+    }
+
+    for (Int_t iteration = 0; iteration < fNIterations; iteration++)
+    {
+        if (iteration > 0)
+        {
+            fit.SetMass(TMath::Abs(particle->GetCharge() / s[4]) / betaGamma);
+            if (!fit.TransportForward(s))
+            {
+                return 2;
+            }
+        }
+        fit.SeedCovariance(s, C);
+        if (!fit.FilterBackward(s, C, chi2, 0 == iteration))
+        {
+            return 2;
+        }
+    }
+
+    // As after the backward fit of R3BFragmentFitterChi2: at the target, with the reversed momentum
+    TVector3 position;
+    TVector3 momentum;
+    Double_t cov[15];
+    fit.GetParticle(s, position, momentum);
+    PackCovariance(C, cov);
+
+    particle->SetPosition(position);
+    particle->SetMomentum(-1. * momentum);
+    particle->SetMass(momentum.Mag() / betaGamma);
+    particle->SetChi2(chi2);
+    particle->SetCovariance(cov);
+
+    return 0;
+}
+
+ClassImp(R3BFragmentFitterKalman)
@@ -0,0 +1,55 @@
+/******************************************************************************
+ *   Copyright (C) 2019 GSI Helmholtzzentrum für Schwerionenforschung GmbH    *
+ *   Copyright (C) 2019 Members of R3B Collaboration                          *
+ *                                                                            *
+ *             This software is distributed under the terms of the            *
+ *                 GNU General Public Licence (GPL) version 3,                *
+ *                    copied verbatim in the file "LICENSE".                  *
+ *                                                                            *
+ * In applying this license GSI does not waive the privileges and immunities  *
+ * granted to it by virtue of its status as an Intergovernmental Organization *
+ * or submit itself to any jurisdiction.                                      *
+ ******************************************************************************/
+
+#ifndef R3BFRAGMENTFITTERKALMAN
+#define R3BFRAGMENTFITTERKALMAN
+
+#include "R3BFragmentFitterGeneric.h"
+
+// Kalman filter fit of the fragment track. The state (x, y, tx, ty, q/p) on the detector planes is transported
+// with the propagator, with numerical transport Jacobians, the energy loss of R3BTrackingDetector::GetEnergyLoss
+// and the multiple scattering in the detector materials. The measurements are the local x of the hits on all
+// detectors except the ToF wall, as for R3BFragmentFitterChi2. FitTrackBackward filters from the last detector,
+// seeded by the hits of the last two detectors, to the target. FitTrack starts with a forward filter from the start
+// of the particle, whose result seeds the backward filter. The mass follows from the fitted momentum at the target
+// and the start velocity of the particle; the fitted state, its chi2 and covariance are stored in the particle.
+// As R3BFragmentFitterChi2, the fits keep no state in the fitter and may run concurrently for different candidates.
+class R3BFragmentFitterKalman : public R3BFragmentFitterGeneric
+{
+  public:
+    R3BFragmentFitterKalman();
+    ~R3BFragmentFitterKalman();
+
+    void Init(R3BTPropagator* prop = nullptr, Bool_t energyLoss = kTRUE);
+
+    Int_t FitTrack(R3BTrackingParticle*, R3BTrackingSetup*);
+
+    Int_t FitTrackBackward(R3BTrackingParticle*, R3BTrackingSetup*);
+
+    // Number of backward filter passes. Each further pass is seeded by the forward transport of the previous
+    // result, linearised with the Jacobians of the first pass. Default is 2.
+    void SetNumberOfIterations(Int_t nIterations) { fNIterations = nIterations; }
+
+    // Multiple scattering in the detector materials as process noise. Default is on.
+    void SetMultipleScattering(Bool_t scattering) { fScattering = scattering; }
+
+  private:
+    R3BTPropagator* fPropagator;
+    Bool_t fEnergyLoss;
+    Int_t fNIterations;
+    Bool_t fScattering;
+
+    ClassDef(R3BFragmentFitterKalman, 1)
+};
+
+#endif
@@ -0,0 +1,311 @@
+/******************************************************************************
+ *   Copyright (C) 2019 GSI Helmholtzzentrum für Schwerionenforschung GmbH    *
+ *   Copyright (C) 2019 Members of R3B Collaboration                          *
+ *                                                                            *
+ *             This software is distributed under the terms of the            *
+ *                 GNU General Public Licence (GPL) version 3,                *
+ *                    copied verbatim in the file "LICENSE".                  *
+ *                                                                            *
+ * In applying this license GSI does not waive the privileges and immunities  *
+ * granted to it by virtue of its status as an Intergovernmental Organization *
+ * or submit itself to any jurisdiction.                                      *
+ ******************************************************************************/
+
+#include "R3BFragmentRoadSearch.h"
+#include "R3BTGeoPar.h"
+#include "R3BTPropagator.h"
+#include "R3BTrackingDetector.h"
+#include "R3BTrackingParticle.h"
+#include "R3BTrackingSetup.h"
+
+#include "FairLogger.h"
+
+#include "TMath.h"
+
+#include <algorithm>
+
+using namespace std;
+
+// Window of an entry for which no transport succeeded: accept everything
+static const Double_t kOpen = 1e30;
+
+R3BFragmentRoadSearch::R3BFragmentRoadSearch()
+    : fPropagator(nullptr)
+    , fSetup(nullptr)
+    , fEnergyLoss(kTRUE)
+    , fCharge(50.)
+    , fBeta(0.8328)
+    , fMassMin(125. * 0.9314940954)
+    , fMassMax(133. * 0.9314940954)
+    , fNMass(3)
+    , fNBins(200)
+    , fNSigma(5.)
+    , fRef(-1)
+    , fTarget(-1)
+    , fRefMin(0.)
+    , fRefMax(0.)
+    , fBinWidth(1.)
+{
+}
+
+R3BFragmentRoadSearch::~R3BFragmentRoadSearch() {}
+
+void R3BFragmentRoadSearch::SetMassRange(Double_t massMin, Double_t massMax, Int_t nSteps)
+{
+    fMassMin = massMin;
+    fMassMax = massMax;
+    fNMass = std::max(2, nSteps);
+}
+
+void R3BFragmentRoadSearch::SetMargin(const string& detName, Double_t margin)
+{
+    fMarginByName.push_back(make_pair(detName, margin));
+}
+
+Bool_t R3BFragmentRoadSearch::Init(R3BTPropagator* prop,
+                                   R3BTrackingSetup* setup,
+                                   const string& refName,
+                                   Bool_t energyLoss)
+{
+    fPropagator = prop;
+    fSetup = setup;
+    fEnergyLoss = energyLoss;
+
+    const Int_t nDet = fSetup->GetArray().size();
+
+    fRef = fSetup->GetHandle(refName);
+    if (fRef < 0)
+    {
+        LOG(ERROR) << "R3BFragmentRoadSearch: reference detector " << refName << " was not found in setup.";
+        return kFALSE;
+    }
+    fTarget = -1;
+    for (Int_t i = 0; i < nDet; i++)
+    {
+        if (kTarget == fSetup->GetByHandle(i)->section)
+        {
+            fTarget = i;
+            break;
+        }
+    }
+
+    fMargin.assign(nDet, 0.);
+    for (auto const& x : fMarginByName)
+    {
+        const Int_t handle = fSetup->GetHandle(x.first);
+        if (handle >= 0)
+        {
+            fMargin[handle] = x.second;
+        }
+    }
+
+    // Reference detector acceptance in local x
+    const Double_t halfWidth = fSetup->GetArray()[fRef]->GetGeoPar()->GetDimX();
+    fRefMin = -halfWidth;
+    fRefMax = halfWidth;
+    fBinWidth = 2. * halfWidth / fNBins;
+
+    // Transport the grid edges for all masses, plus a displaced vertex at the central mass
+    const Int_t nEdges = fNBins + 1;
+    const Double_t dVertex = 0.1;
+    vector<vector<Double_t>> xEdge(nEdges * fNMass);
+    vector<vector<Bool_t>> okEdge(nEdges * fNMass);
+    vector<Double_t> dxdv(nEdges * nDet, 0.);
+    vector<Double_t> xv;
+    vector<Bool_t> okv;
+    for (Int_t e = 0; e < nEdges; e++)
+    {
+        const Double_t xRef = fRefMin + e * fBinWidth;
+        for (Int_t k = 0; k < fNMass; k++)
+        {
+            const Double_t mass = fMassMin + (fMassMax - fMassMin) * k / (fNMass - 1);
+            Transport(xRef, 0., mass, xEdge[e * fNMass + k], okEdge[e * fNMass + k]);
+        }
+
+        const Int_t kMid = fNMass / 2;
+        Transport(xRef, dVertex, fMassMin + (fMassMax - fMassMin) * kMid / (fNMass - 1), xv, okv);
+        for (Int_t i = fRef + 1; i < nDet; i++)
+        {
+            if (okv[i] && okEdge[e * fNMass + kMid][i])
+            {
+                dxdv[e * nDet + i] = TMath::Abs(xv[i] - xEdge[e * fNMass + kMid][i]) / dVertex;
+            }
+        }
+    }
+
+    // Envelope per bin: both edges, all masses
+    fMin.assign(nDet * fNBins, -kOpen);
+    fMax.assign(nDet * fNBins, kOpen);
+    fSlope.assign(nDet * fNBins, 0.);
+    fVertexSlope.assign(nDet * fNBins, 0.);
+    Int_t nOpen = 0;
+    for (Int_t i = fRef + 1; i < nDet; i++)
+    {
+        for (Int_t b = 0; b < fNBins; b++)
+        {
+            Double_t xmin = kOpen;
+            Double_t xmax = -kOpen;
+            Double_t slope = 0.;
+            Bool_t complete = kTRUE;
+            for (Int_t k = 0; k < fNMass; k++)
+            {
+                const Int_t e0 = b * fNMass + k;
+                const Int_t e1 = (b + 1) * fNMass + k;
+                if (!okEdge[e0][i] || !okEdge[e1][i])
+                {
+                    complete = kFALSE;
+                    break;
+                }
+                xmin = std::min(xmin, std::min(xEdge[e0][i], xEdge[e1][i]));
+                xmax = std::max(xmax, std::max(xEdge[e0][i], xEdge[e1][i]));
+                slope = std::max(slope, TMath::Abs(xEdge[e1][i] - xEdge[e0][i]) / fBinWidth);
+            }
+            if (!complete)
+            {
+                // No reliable transport (e.g. track leaves the field volume): do not prune
+                nOpen += 1;
+                continue;
+            }
+            const Int_t index = i * fNBins + b;
+            fMin[index] = xmin;
+            fMax[index] = xmax;
+            fSlope[index] = slope;
+            fVertexSlope[index] = std::max(dxdv[b * nDet + i], dxdv[(b + 1) * nDet + i]);
+        }
+    }
+
+    LOG(INFO) << "R3BFragmentRoadSearch: transport tables for " << (nDet - fRef - 1) << " detectors behind "
+              << refName << " with " << fNBins << " bins, " << nOpen << " open windows.";
+
+    return kTRUE;
+}
+
+Bool_t R3BFragmentRoadSearch::Transport(Double_t xRef,
+                                        Double_t xVertex,
+                                        Double_t mass,
+                                        vector<Double_t>& x,
+                                        vector<Bool_t>& ok)
+{
+    const Int_t nDet = fSetup->GetArray().size();
+    x.assign(nDet, 0.);
+    ok.assign(nDet, kFALSE);
+
+    TVector3 vertex(xVertex, 0., 0.);
+    if (fTarget >= 0)
+    {
+        fSetup->GetArray()[fTarget]->LocalToGlobal(vertex, xVertex, 0.);
+    }
+    TVector3 posRef;
+    fSetup->GetArray()[fRef]->LocalToGlobal(posRef, xRef, 0.);
+
+    const TVector3 direction = (posRef - vertex).Unit();
+    const Double_t mom = mass * fBeta / TMath::Sqrt(1. - fBeta * fBeta);
+    R3BTrackingParticle particle(fCharge,
+                                 vertex.X(),
+                                 vertex.Y(),
+                                 vertex.Z(),
+                                 mom * direction.X(),
+                                 mom * direction.Y(),
+                                 mom * direction.Z(),
+                                 fBeta,
+                                 mass);
+
+    // Same sequence as the forward chi2 of the fitter
+    Double_t y_l = 0.;
+    for (Int_t i = 0; i < nDet; i++)
+    {
+        R3BTrackingDetector* det = fSetup->GetArray()[i];
+        if (kTarget != det->section)
+        {
+            if (!fPropagator->PropagateToDetector(&particle, det))
+            {
+                return kFALSE;
+            }
+        }
+
+        if (fEnergyLoss && kTof != det->section)
+        {
+            particle.PassThroughDetector(det, (kTarget == det->section) ? 0.5 : 1.);
+        }
+
+        det->GlobalToLocal(particle.GetPosition(), x[i], y_l);
+        ok[i] = !TMath::IsNaN(x[i]);
+    }
+
+    return kTRUE;
+}
+
+Int_t R3BFragmentRoadSearch::GetDetectorIndex(Int_t handle) const
+{
+    if (nullptr == fSetup || handle <= fRef || handle >= fSetup->GetNumberOfDetectors())
+    {
+        return -1;
+    }
+    return handle;
+}
+
+Int_t R3BFragmentRoadSearch::GetBin(Double_t xRef) const
+{
+    // Hits outside the nominal acceptance are not covered by the tables, the edge bins would cut them
+    if (xRef < fRefMin || xRef > fRefMax)
+    {
+        return -1;
+    }
+    Int_t bin = (Int_t)TMath::Floor((xRef - fRefMin) / fBinWidth);
+    return std::min(fNBins - 1, bin);
+}
+
+Bool_t R3BFragmentRoadSearch::IsInWindow(Int_t bin, Int_t iDet, Double_t x) const
+{
+    if (bin < 0 || iDet <= fRef || fMin.empty())
+    {
+        return kTRUE;
+    }
+    const Int_t index = iDet * fNBins + bin;
+    if (fMax[index] >= kOpen)
+    {
+        return kTRUE;
+    }
+
+    const auto& dets = fSetup->GetArray();
+    Double_t sigma2 = TMath::Power(dets[iDet]->res_x, 2) + TMath::Power(fSlope[index] * dets[fRef]->res_x, 2);
+    if (fTarget >= 0)
+    {
+        sigma2 += TMath::Power(fVertexSlope[index] * dets[fTarget]->res_x, 2);
+    }
+    const Double_t width = fNSigma * TMath::Sqrt(sigma2) + fMargin[iDet];
+
+    return (x > fMin[index] - width) && (x < fMax[index] + width);
+}
+
+Bool_t R3BFragmentRoadSearch::IsOnLine(Int_t ia, Double_t xa, Int_t ib, Double_t xb, Int_t ic, Double_t xc) const
+{
+    if (ia < 0 || ib < 0 || ic < 0)
+    {
+        return kTRUE;
+    }
+
+    const auto& dets = fSetup->GetArray();
+    TVector3 pa;
+    TVector3 pb;
+    dets[ia]->LocalToGlobal(pa, xa, 0.);
+    dets[ib]->LocalToGlobal(pb, xb, 0.);
+
+    // Intersection of the line a-b with the plane of c, p = (1-t) a + t b
+    R3BTrackingDetector* c = dets[ic];
+    const Double_t denom = (pb - pa).Dot(c->norm);
+    if (TMath::Abs(denom) < 1e-9)
+    {
+        return kTRUE;
+    }
+    const Double_t t = (c->pos0 - pa).Dot(c->norm) / denom;
+    const TVector3 pc = pa + t * (pb - pa);
+    Double_t xPred = 0.;
+    Double_t y_l = 0.;
+    c->GlobalToLocal(pc, xPred, y_l);
+
+    const Double_t sigma = TMath::Sqrt(TMath::Power(c->res_x, 2) + TMath::Power((1. - t) * dets[ia]->res_x, 2) +
+                                       TMath::Power(t * dets[ib]->res_x, 2));
+
+    return TMath::Abs(xc - xPred) < fNSigma * sigma + fMargin[ic];
+}
@@ -0,0 +1,101 @@
+/******************************************************************************
+ *   Copyright (C) 2019 GSI Helmholtzzentrum für Schwerionenforschung GmbH    *
+ *   Copyright (C) 2019 Members of R3B Collaboration                          *
+ *                                                                            *
+ *             This software is distributed under the terms of the            *
+ *                 GNU General Public Licence (GPL) version 3,                *
+ *                    copied verbatim in the file "LICENSE".                  *
+ *                                                                            *
+ * In applying this license GSI does not waive the privileges and immunities  *
+ * granted to it by virtue of its status as an Intergovernmental Organization *
+ * or submit itself to any jurisdiction.                                      *
+ ******************************************************************************/
+
+#ifndef R3B_FRAGMENT_ROAD_SEARCH
+#define R3B_FRAGMENT_ROAD_SEARCH
+
+#include "Rtypes.h"
+
+#include <string>
+#include <utility>
+#include <vector>
+
+class R3BTPropagator;
+class R3BTrackingDetector;
+class R3BTrackingSetup;
+
+/* Road search for the fragment tracker.
+ *
+ * At Init the fragment is transported with the field map from the target
+ * through the reference detector (PSP) to all downstream detectors, for a
+ * grid of reference hit positions and for the extreme rigidities of the
+ * mass range. This gives, per reference bin, the window of local x each
+ * downstream detector can be hit in. Behind GLAD the track is straight, so
+ * a third hit must in addition lie on the line through two others.
+ *
+ * The windows are widened at query time by nSigma times the measurement
+ * resolutions (res_x of the detectors, including target and reference) and
+ * an optional margin per detector, so they follow the resolutions set by
+ * the tracker. Reference hits outside the tabulated acceptance are not
+ * pruned.
+ */
+class R3BFragmentRoadSearch
+{
+  public:
+    R3BFragmentRoadSearch();
+    ~R3BFragmentRoadSearch();
+
+    void SetMassRange(Double_t massMin, Double_t massMax, Int_t nSteps = 3);
+    void SetBeta(Double_t beta) { fBeta = beta; }
+    void SetCharge(Double_t charge) { fCharge = charge; }
+    void SetNumberOfBins(Int_t nBins) { fNBins = nBins; }
+    void SetNSigma(Double_t nSigma) { fNSigma = nSigma; }
+    void SetMargin(const std::string& detName, Double_t margin);
+
+    // Fills the transport tables. Detectors downstream of refName are covered.
+    Bool_t Init(R3BTPropagator* prop, R3BTrackingSetup* setup, const std::string& refName, Bool_t energyLoss);
+
+    // Index of the detector in the tables = its handle in the setup, -1 if not covered by the tables
+    Int_t GetDetectorIndex(Int_t handle) const;
+
+    // Bin of the reference detector table for a local x on the reference detector, -1 outside the tabulated
+    // acceptance [fRefMin, fRefMax]
+    Int_t GetBin(Double_t xRef) const;
+
+    // Is the local x on detector iDet compatible with the reference hit bin? Always true for bin -1.
+    Bool_t IsInWindow(Int_t bin, Int_t iDet, Double_t x) const;
+
+    // Straight line behind GLAD: is xc on detector ic compatible with the line through xa and xb?
+    Bool_t IsOnLine(Int_t ia, Double_t xa, Int_t ib, Double_t xb, Int_t ic, Double_t xc) const;
+
+  private:
+    Bool_t Transport(Double_t xRef, Double_t xVertex, Double_t mass, std::vector<Double_t>& x, std::vector<Bool_t>& ok);
+
+    R3BTPropagator* fPropagator;
+    R3BTrackingSetup* fSetup;
+    Bool_t fEnergyLoss;
+
+    Double_t fCharge;
+    Double_t fBeta;
+    Double_t fMassMin;
+    Double_t fMassMax;
+    Int_t fNMass;
+    Int_t fNBins;
+    Double_t fNSigma;
+
+    Int_t fRef;    // reference detector index
+    Int_t fTarget; // target index, -1 if none
+    Double_t fRefMin;
+    Double_t fRefMax;
+    Double_t fBinWidth;
+
+    std::vector<Double_t> fMargin;
+    // per [det * fNBins + bin]: envelope of the transported x, |dx/dxRef| and |dx/dxVertex|
+    std::vector<Double_t> fMin;
+    std::vector<Double_t> fMax;
+    std::vector<Double_t> fSlope;
+    std::vector<Double_t> fVertexSlope;
+    std::vector<std::pair<std::string, Double_t>> fMarginByName;
+};
+
+#endif
@@ -21,6 +21,7 @@
 #include "R3BFragmentTracker.h"
 #include "R3BFi4HitItem.h"
 #include "R3BFragmentFitterGeneric.h"
+#include "R3BFragmentRoadSearch.h"
 #include "R3BGladFieldMap.h"
 #include "R3BHit.h"
 #include "R3BMCTrack.h"
@@ -44,11 +45,30 @@
 #include "TH1F.h"
 #include "TH2F.h"
 #include "TMath.h"
+#include "TROOT.h"
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
 
 using namespace std;
 
 #define SPEED_OF_LIGHT 29.9792458 // cm/ns
 
+// Charge of the fragment and velocity the candidates start with
+static const Double_t kFragmentCharge = 50.;
+static const Double_t kStartBeta = 0.8328;
+
+// The backward fit ends at the target: use the result as the start of the fragment
+static void SetStartAtTarget(R3BTrackingParticle* candidate)
+{
+    candidate->SetStartPosition(candidate->GetPosition());
+    candidate->SetStartMomentum(-1. * candidate->GetMomentum());
+    candidate->SetStartBeta(kStartBeta);
+    candidate->UpdateMomentum();
+    candidate->Reset();
+}
+
 R3BFragmentTracker::R3BFragmentTracker(const char* name, Bool_t vis, Int_t verbose)
     : FairTask(name, verbose)
     , fFieldPar(NULL)
@@ -60,6 +80,16 @@ R3BFragmentTracker::R3BFragmentTracker(const char* name, Bool_t vis, Int_t verbo
     , fVis(vis)
     , fFitter(nullptr)
     , fEnergyLoss(kTRUE)
+    , fNThreads(1)
+    , fUseRoadSearch(kFALSE)
+    , fRoadSearch(nullptr)
+    , fAdaptiveRK(kFALSE)
+    , fTargetHandle(-1)
+    , fPspHandle(-1)
+    , fFi4Handle(-1)
+    , fFi5Handle(-1)
+    , fFi6Handle(-1)
+    , fTofHandle(-1)
 {
     // this is the list of detectors (active areas) we use for tracking
     fDetectors->AddDetector("target", kTarget, "TargetGeoPar");
@@ -70,7 +100,13 @@ R3BFragmentTracker::R3BFragmentTracker(const char* name, Bool_t vis, Int_t verbo
     fDetectors->AddDetector("tofd", kTof, "tofdGeoPar", "TofdHit");
 }
 
-R3BFragmentTracker::~R3BFragmentTracker() {}
+R3BFragmentTracker::~R3BFragmentTracker()
+{
+    if (fRoadSearch)
+    {
+        delete fRoadSearch;
+    }
+}
 
 /* For the tracking we use a user-defined list of TrackingDetectors,
  * stored in a TClonesArrays. The TrackingDetectors will provide
@@ -125,6 +161,16 @@ InitStatus R3BFragmentTracker::Init()
 
     fDetectors->Init();
 
+    if (!InitHandles())
+    {
+        return kERROR;
+    }
+
+    if (!InitRoadSearch())
+    {
+        return kERROR;
+    }
+
     fh_mult_psp = new TH1F("h_mult_psp", "Multiplicity PSP", 20, -0.5, 19.5);
     fh_mult_fi4 = new TH1F("h_mult_fi4", "Multiplicity Fi4", 20, -0.5, 19.5);
     fh_mult_fi5 = new TH1F("h_mult_fi5", "Multiplicity Fi5", 20, -0.5, 19.5);
@@ -150,6 +196,11 @@ InitStatus R3BFragmentTracker::Init()
 
     fFitter->Init(fPropagator, fEnergyLoss);
 
+    if (fNThreads != 1)
+    {
+        ROOT::EnableThreadSafety();
+    }
+
     return kSUCCESS;
 }
 
@@ -162,6 +213,11 @@ InitStatus R3BFragmentTracker::ReInit()
         return kERROR;
     }
 
+    if (!InitRoadSearch())
+    {
+        return kERROR;
+    }
+
     return kSUCCESS;
 }
 
@@ -195,12 +251,12 @@ void R3BFragmentTracker::Exec(const Option_t*)
      */
     fDetectors->CopyHits();
 
-    R3BTrackingDetector* target = fDetectors->GetByName("target");
-    R3BTrackingDetector* psp = fDetectors->GetByName("psp");
-    R3BTrackingDetector* fi4 = fDetectors->GetByName("fi4");
-    R3BTrackingDetector* fi5 = fDetectors->GetByName("fi5");
-    R3BTrackingDetector* fi6 = fDetectors->GetByName("fi6");
-    R3BTrackingDetector* tof = fDetectors->GetByName("tofd");
+    R3BTrackingDetector* target = fDetectors->GetByHandle(fTargetHandle);
+    R3BTrackingDetector* psp = fDetectors->GetByHandle(fPspHandle);
+    R3BTrackingDetector* fi4 = fDetectors->GetByHandle(fFi4Handle);
+    R3BTrackingDetector* fi5 = fDetectors->GetByHandle(fFi5Handle);
+    R3BTrackingDetector* fi6 = fDetectors->GetByHandle(fFi6Handle);
+    R3BTrackingDetector* tof = fDetectors->GetByHandle(fTofHandle);
 
     // remember: in this test, target hast no data
     // if (target->hits->GetEntriesFast()==0) return; // no error, can always happen
@@ -228,7 +284,7 @@ void R3BFragmentTracker::Exec(const Option_t*)
 
     // Important: Set charge and initial position and momentum of the particle
     Double_t beta = 1. / TMath::Sqrt(1 + TMath::Power(ion->GetMass() / ion->GetP(), 2));
-    R3BTrackingParticle* particle = new R3BTrackingParticle(50.,
+    R3BTrackingParticle* particle = new R3BTrackingParticle(kFragmentCharge,
                                                             ion->GetStartX(),
                                                             ion->GetStartY(),
                                                             ion->GetStartZ(),
@@ -257,11 +313,27 @@ void R3BFragmentTracker::Exec(const Option_t*)
     //    for (all tof hits)
     fPropagator->SetVis(kFALSE);
 
-    Int_t nCand = 0;
+    // Build all hit combinations first, then fit them. The fits are independent of each other and may run in
+    // several threads, the selection below is done in the order of creation.
+    std::vector<R3BTrackingParticle*> candidates;
 
     {
         target->hits.push_back(new R3BHit(0, 0., 0., 0., 0., 0));
         target->res_x = 0.1000;
+        psp->res_x = 0.0200;
+        fi4->res_x = 0.0200;
+        fi5->res_x = 0.0400;
+        fi6->res_x = 0.0500;
+        tof->res_x = 2.7;
+        tof->res_t = 0.03;
+
+        // Road search: skip combinations outside the acceptance windows of the PSP hit and
+        // off the straight line behind GLAD. Without it, all combinations are fitted.
+        const Bool_t road = (nullptr != fRoadSearch);
+        const Int_t ifi4 = road ? fRoadSearch->GetDetectorIndex(fFi4Handle) : -1;
+        const Int_t ifi5 = road ? fRoadSearch->GetDetectorIndex(fFi5Handle) : -1;
+        const Int_t ifi6 = road ? fRoadSearch->GetDetectorIndex(fFi6Handle) : -1;
+        const Int_t itof = road ? fRoadSearch->GetDetectorIndex(fTofHandle) : -1;
 
         for (auto const& xpsp : psp->hits)
         {
@@ -269,91 +341,106 @@ void R3BFragmentTracker::Exec(const Option_t*)
             {
                 continue;
             }
-            psp->res_x = 0.0200;
             fh_eloss_psp_mc->Fill(xpsp->GetEloss()); // MeV
 
+            const Int_t bin = road ? fRoadSearch->GetBin(xpsp->GetX()) : 0;
+
             for (auto const& xfi4 : fi4->hits)
             {
                 fh_eloss_fi4_mc->Fill(xfi4->GetEloss()); // MeV
-                fi4->res_x = 0.0200;
+
+                if (road && !fRoadSearch->IsInWindow(bin, ifi4, xfi4->GetX()))
+                {
+                    continue;
+                }
 
                 for (auto const& xfi5 : fi5->hits)
                 {
-                    fi5->res_x = 0.0400;
+                    if (road && !fRoadSearch->IsInWindow(bin, ifi5, xfi5->GetX()))
+                    {
+                        continue;
+                    }
 
                     for (auto const& xfi6 : fi6->hits)
                     {
-                        fi6->res_x = 0.0500;
+                        if (road &&
+                            (!fRoadSearch->IsInWindow(bin, ifi6, xfi6->GetX()) ||
+                             !fRoadSearch->IsOnLine(ifi4, xfi4->GetX(), ifi5, xfi5->GetX(), ifi6, xfi6->GetX())))
+                        {
+                            continue;
+                        }
 
                         for (auto const& xtof : tof->hits)
                         {
-                            tof->res_x = 2.7;
-                            tof->res_t = 0.03;
+                            if (road &&
+                                (!fRoadSearch->IsInWindow(bin, itof, xtof->GetX()) ||
+                                 !fRoadSearch->IsOnLine(ifi5, xfi5->GetX(), ifi6, xfi6->GetX(), itof, xtof->GetX())))
+                            {
+                                continue;
+                            }
 
-                            Double_t velocity0 = 0.8328;
+                            Double_t velocity0 = kStartBeta;
 
                             // Create object for particle which will be fitted
                             R3BTrackingParticle* candidate = new R3BTrackingParticle(
                                 particle->GetCharge(), 0., 0., 0., 0., 0., 0., velocity0, 132. * 0.9314940954);
 
-                            candidate->AddHit("target", 0);
-                            candidate->AddHit("psp", xpsp->GetHitId());
-                            candidate->AddHit("fi4", xfi4->GetHitId());
-                            candidate->AddHit("fi5", xfi5->GetHitId());
-                            candidate->AddHit("fi6", xfi6->GetHitId());
-                            candidate->AddHit("tofd", xtof->GetHitId());
+                            candidate->AddHit(fTargetHandle, 0);
+                            candidate->AddHit(fPspHandle, xpsp->GetHitId());
+                            candidate->AddHit(fFi4Handle, xfi4->GetHitId());
+                            candidate->AddHit(fFi5Handle, xfi5->GetHitId());
+                            candidate->AddHit(fFi6Handle, xfi6->GetHitId());
+                            candidate->AddHit(fTofHandle, xtof->GetHitId());
 
-                            // find momentum
-                            // momin is only a first guess
-                            Int_t status = fFitter->FitTrackBackward(candidate, fDetectors);
+                            candidates.push_back(candidate);
+                        }
+                    }
+                }
+            }
+        }
+    }
 
-                            nCand += 1;
+    // find momentum
+    // momin is only a first guess
+    std::vector<Int_t> status(candidates.size(), 0);
+    const Bool_t fast = fPropagator->HasTransferMaps();
+    fPropagator->SetFastMode(fast);
+    FitCandidates(candidates, status);
+    fPropagator->SetFastMode(kFALSE);
 
-                            if (TMath::IsNaN(candidate->GetMomentum().Z()))
-                            {
-                                delete candidate;
-                                continue;
-                            }
+    Int_t nCand = candidates.size();
 
-                            // candidate->GetPosition().Print();
-                            // candidate->GetMomentum().Print();
+    for (size_t i = 0; i < candidates.size(); i++)
+    {
+        R3BTrackingParticle* candidate = candidates[i];
 
-                            if (0 == status)
-                            {
-                                candidate->SetStartPosition(candidate->GetPosition());
-                                candidate->SetStartMomentum(-1. * candidate->GetMomentum());
-                                candidate->SetStartBeta(0.8328);
-                                candidate->UpdateMomentum();
-                                candidate->Reset();
-
-                                // candidate->GetStartPosition().Print();
-                                // candidate->GetStartMomentum().Print();
-
-                                // status = FitFragment(candidate);
-
-                                if (0 == status)
-                                {
-                                    // if(candidate->GetChi2() < 3.)
-                                    {
-                                        fFragments.push_back(candidate);
-                                    }
-                                }
-                                else
-                                {
-                                    delete candidate;
-                                }
-                            }
-                            else
-                            {
-                                delete candidate;
-                            }
+        if (TMath::IsNaN(candidate->GetMomentum().Z()))
+        {
+            delete candidate;
+            continue;
+        }
 
-                            // return;
-                        }
-                    }
-                }
+        // candidate->GetPosition().Print();
+        // candidate->GetMomentum().Print();
+
+        if (0 == status[i])
+        {
+            SetStartAtTarget(candidate);
+
+            // candidate->GetStartPosition().Print();
+            // candidate->GetStartMomentum().Print();
+
+            // status = FitFragment(candidate);
+
+            // if(candidate->GetChi2() < 3.)
+            {
+                fFragments.push_back(candidate);
             }
         }
+        else
+        {
+            delete candidate;
+        }
     }
 
     fh_ncand->Fill(nCand);
@@ -372,6 +459,17 @@ void R3BFragmentTracker::Exec(const Option_t*)
             }
         }
 
+        if (fast)
+        {
+            // The candidates were fitted with the transfer maps, refine the selected one with the RK propagation
+            R3BTrackingParticle refined(*candidate);
+            if (0 == fFitter->FitTrackBackward(&refined, fDetectors) && !TMath::IsNaN(refined.GetMomentum().Z()))
+            {
+                SetStartAtTarget(&refined);
+                *candidate = refined;
+            }
+        }
+
         Double_t momentum0 = candidate->GetStartMomentum().Mag();
         LOG(DEBUG1);
         LOG(DEBUG1) << "RESULT : " << momentum0;
@@ -405,7 +503,7 @@ void R3BFragmentTracker::Exec(const Option_t*)
                 fPropagator->PropagateToDetector(candidate, det);
             }
 
-            if (det->GetDetectorName().EqualTo("psp"))
+            if (iDet == fPspHandle)
             { // PSP
                 Double_t eloss = det->GetEnergyLoss(candidate);
                 fh_eloss_psp->Fill(eloss);
@@ -426,10 +524,7 @@ void R3BFragmentTracker::Exec(const Option_t*)
 
             // Convert global track coordinates into local on the det plane
             det->GlobalToLocal(candidate->GetPosition(), x_l, y_l);
-            Double_t det_hit_x =
-                fDetectors
-                    ->GetHit(det->GetDetectorName().Data(), candidate->GetHitIndexByName(det->GetDetectorName().Data()))
-                    ->GetX();
+            Double_t det_hit_x = fDetectors->GetHit(iDet, candidate->GetHitIndex(iDet))->GetX();
             fh_x_res[iDet]->Fill(x_l - det_hit_x);
             fh_x_pull[iDet]->Fill((x_l - det_hit_x) / det->res_x);
             iDet++;
@@ -453,6 +548,41 @@ void R3BFragmentTracker::Exec(const Option_t*)
     delete particle;
 }
 
+void R3BFragmentTracker::FitCandidates(const std::vector<R3BTrackingParticle*>& candidates,
+                                       std::vector<Int_t>& status)
+{
+    const size_t n = candidates.size();
+    const size_t nThreads =
+        std::min<size_t>(n, fNThreads > 0 ? fNThreads : std::max(1u, std::thread::hardware_concurrency()));
+
+    // Each candidate is fitted by exactly one thread and only writes its own status slot
+    std::atomic<size_t> next(0);
+    auto worker = [&]() {
+        for (size_t i = next++; i < n; i = next++)
+        {
+            status[i] = fFitter->FitTrackBackward(candidates[i], fDetectors);
+        }
+    };
+
+    if (nThreads <= 1)
+    {
+        worker();
+        return;
+    }
+
+    std::vector<std::thread> threads;
+    threads.reserve(nThreads - 1);
+    for (size_t t = 1; t < nThreads; t++)
+    {
+        threads.emplace_back(worker);
+    }
+    worker();
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+}
+
 void R3BFragmentTracker::Finish()
 {
     fh_mult_psp->Write();
@@ -570,6 +700,25 @@ Bool_t R3BFragmentTracker::InitPropagator()
             delete fPropagator;
         }
         fPropagator = new R3BTPropagator(gladField, fVis);
+        fPropagator->SetAdaptiveRK(fAdaptiveRK);
+
+        if (fTransferMapFile.Length() > 0 && !fPropagator->ReadTransferMaps(fTransferMapFile.Data()))
+        {
+            // Rigidity range of the fits: mass limits of the fitter at the start velocity, widened by 3 % for the
+            // energy loss in the detectors
+            const Double_t betaGamma = kStartBeta / TMath::Sqrt(1. - kStartBeta * kStartBeta);
+            const Double_t qpMin = 0.97 * kFragmentCharge / (fFitter->GetMassMax() * betaGamma);
+            const Double_t qpMax = 1.03 * kFragmentCharge / (fFitter->GetMassMin() * betaGamma);
+            LOG(INFO) << "Generating transfer maps for " << fTransferMapFile;
+            if (!fPropagator->GenerateTransferMaps(qpMin, qpMax))
+            {
+                LOG(ERROR) << "Could not generate transfer maps, using the RK propagation.";
+            }
+            else
+            {
+                fPropagator->WriteTransferMaps(fTransferMapFile.Data());
+            }
+        }
     }
     else
     {
@@ -579,4 +728,43 @@ Bool_t R3BFragmentTracker::InitPropagator()
     return kTRUE;
 }
 
+Bool_t R3BFragmentTracker::InitHandles()
+{
+    // Name lookups only here, the event loop works with the handles
+    fTargetHandle = fDetectors->GetHandle("target");
+    fPspHandle = fDetectors->GetHandle("psp");
+    fFi4Handle = fDetectors->GetHandle("fi4");
+    fFi5Handle = fDetectors->GetHandle("fi5");
+    fFi6Handle = fDetectors->GetHandle("fi6");
+    fTofHandle = fDetectors->GetHandle("tofd");
+
+    return (fTargetHandle >= 0 && fPspHandle >= 0 && fFi4Handle >= 0 && fFi5Handle >= 0 && fFi6Handle >= 0 &&
+            fTofHandle >= 0);
+}
+
+Bool_t R3BFragmentTracker::InitRoadSearch()
+{
+    if (fRoadSearch)
+    {
+        delete fRoadSearch;
+        fRoadSearch = nullptr;
+    }
+    if (!fUseRoadSearch)
+    {
+        return kTRUE;
+    }
+
+    // The transport tables are made with the same field, setup and energy loss as the fits
+    fRoadSearch = new R3BFragmentRoadSearch();
+    fRoadSearch->SetCharge(kFragmentCharge);
+    fRoadSearch->SetBeta(kStartBeta);
+    fRoadSearch->SetMassRange(fFitter->GetMassMin(), fFitter->GetMassMax());
+    fPropagator->SetVis(kFALSE);
+    if (!fRoadSearch->Init(fPropagator, fDetectors, "psp", fEnergyLoss))
+    {
+        return kFALSE;
+    }
+    return kTRUE;
+}
+
 ClassImp(R3BFragmentTracker)
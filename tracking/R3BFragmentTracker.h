@@ -15,6 +15,7 @@
 #define R3B_FRAGMENTTRACKER_H
 
 #include "FairTask.h"
+#include "TString.h"
 
 #include <string>
 #include <vector>
@@ -26,6 +27,7 @@ class R3BTrackingDetector;
 class R3BTrackingParticle;
 class R3BTrackingSetup;
 class R3BFragmentFitterGeneric;
+class R3BFragmentRoadSearch;
 
 class TH1F;
 
@@ -47,8 +49,27 @@ class R3BFragmentTracker : public FairTask
     void SetFragmentFitter(R3BFragmentFitterGeneric* fitter) { fFitter = fitter; }
     void SetEnergyLoss(Bool_t energyLoss) { fEnergyLoss = energyLoss; }
 
+    // Number of threads used to fit the candidate combinations of an event, 0 uses all cores. Requires a fitter
+    // whose FitTrackBackward is reentrant, e.g. R3BFragmentFitterChi2 or R3BFragmentFitterKalman. Default is 1.
+    void SetNumberOfThreads(UInt_t nThreads) { fNThreads = nThreads; }
+
+    // Pre-select hit combinations with the transport tables of R3BFragmentRoadSearch. Default is off.
+    void SetRoadSearch(Bool_t road) { fUseRoadSearch = road; }
+
+    // Fit the candidates with polynomial transfer maps through GLAD (see R3BTransferMap), read from the file or
+    // generated for the mass limits of the fitter and stored there if missing or made for another field. Maps that
+    // deviate from RK beyond the tolerance of R3BTPropagator are not used. The selected candidate is refined with RK.
+    void SetTransferMapFile(const TString& fileName) { fTransferMapFile = fileName; }
+
+    // Propagate with the adaptive-step integrator R3BTRungeKutta instead of FairRKPropagator. Default is off.
+    void SetAdaptiveRK(Bool_t adaptive) { fAdaptiveRK = adaptive; }
+
   private:
     Bool_t InitPropagator();
+    Bool_t InitRoadSearch();
+    Bool_t InitHandles();
+
+    void FitCandidates(const std::vector<R3BTrackingParticle*>& candidates, std::vector<Int_t>& status);
 
     R3BFieldPar* fFieldPar;
     R3BTPropagator* fPropagator;
@@ -61,6 +82,19 @@ class R3BFragmentTracker : public FairTask
 
     R3BFragmentFitterGeneric* fFitter;
     Bool_t fEnergyLoss;
+    UInt_t fNThreads;
+    Bool_t fUseRoadSearch;
+    R3BFragmentRoadSearch* fRoadSearch; //!
+    TString fTransferMapFile;
+    Bool_t fAdaptiveRK;
+
+    // Handles of the detectors in fDetectors, resolved at Init
+    Int_t fTargetHandle;
+    Int_t fPspHandle;
+    Int_t fFi4Handle;
+    Int_t fFi5Handle;
+    Int_t fFi6Handle;
+    Int_t fTofHandle;
 
     Double_t fAfterGladResolution;
 
@@ -82,7 +116,7 @@ class R3BFragmentTracker : public FairTask
     TH1F* fh_chi2;
     TH1F* fh_vz_res;
 
-    ClassDef(R3BFragmentTracker, 1)
+    ClassDef(R3BFragmentTracker, 4)
 };
 
 #endif
@@ -14,8 +14,10 @@
 #include "R3BTPropagator.h"
 #include "R3BGladFieldMap.h"
 #include "R3BTGeoPar.h"
+#include "R3BTRungeKutta.h"
 #include "R3BTrackingDetector.h"
 #include "R3BTrackingParticle.h"
+#include "R3BTransferMap.h"
 
 #include "FairLogger.h"
 #include "FairRKPropagator.h"
@@ -23,13 +25,30 @@
 #include "TH2F.h"
 #include "TLine.h"
 #include "TMath.h"
+#include "TRandom3.h"
+
+#include <algorithm>
+#include <fstream>
 
 R3BTPropagator::R3BTPropagator(R3BGladFieldMap* field, Bool_t vis)
     : fFairProp(new FairRKPropagator(field))
     , fField(field)
     , fmTofGeo(NULL)
     , fVis(vis)
+    , fMapForward(nullptr)
+    , fMapBackward(nullptr)
+    , fFastMode(kFALSE)
+    , fRK(new R3BTRungeKutta(field))
+    , fAdaptiveRK(kFALSE)
 {
+    fMapAcceptance[0] = 20.;
+    fMapAcceptance[1] = 10.;
+    fMapAcceptance[2] = 0.1;
+    fMapAcceptance[3] = 0.05;
+    fMapTolerance[0] = 0.05;
+    fMapTolerance[1] = 5e-4;
+    fMapTolerance[2] = 0.05;
+
     // Define magnetic field boundaries ------------------------------------
     TVector3 pos(field->GetPositionX(), field->GetPositionY(), field->GetPositionZ());
     Double_t angle = field->GetYAngle() * TMath::DegToRad();
@@ -72,7 +91,11 @@ R3BTPropagator::R3BTPropagator(R3BGladFieldMap* field, Bool_t vis)
     }
 }
 
-R3BTPropagator::~R3BTPropagator() {}
+R3BTPropagator::~R3BTPropagator()
+{
+    DeleteTransferMaps();
+    delete fRK;
+}
 
 Bool_t R3BTPropagator::PropagateToDetector(R3BTrackingParticle* particle, R3BTrackingDetector* detector)
 {
@@ -153,7 +176,14 @@ Bool_t R3BTPropagator::PropagateToPlane(R3BTrackingParticle* particle,
         }
         LOG(DEBUG2) << "Propagating to exit from magnetic field.";
         tpos = particle->GetPosition();
-        result = PropagateToPlaneRK(particle, fPlane2[0], fPlane2[1], fPlane2[2]);
+        if (fFastMode && fMapForward && fMapForward->Transport(particle))
+        {
+            result = kTRUE;
+        }
+        else
+        {
+            result = PropagateToPlaneRK(particle, fPlane2[0], fPlane2[1], fPlane2[2]);
+        }
         if (fVis)
         {
             TLine* l1 = new TLine(-tpos.X(), tpos.Z(), -particle->GetX(), particle->GetZ());
@@ -251,7 +281,14 @@ Bool_t R3BTPropagator::PropagateToPlaneBackward(R3BTrackingParticle* particle,
         }
         LOG(DEBUG2) << "Propagating to entrance of magnetic field.";
         tpos = particle->GetPosition();
-        result = PropagateToPlaneRK(particle, fPlane1[0], fPlane1[2], fPlane1[1]);
+        if (fFastMode && fMapBackward && fMapBackward->Transport(particle))
+        {
+            result = kTRUE;
+        }
+        else
+        {
+            result = PropagateToPlaneRK(particle, fPlane1[0], fPlane1[2], fPlane1[1]);
+        }
         if (fVis)
         {
             TLine* l1 = new TLine(-tpos.X(), tpos.Z(), -particle->GetX(), particle->GetZ());
@@ -288,6 +325,11 @@ Bool_t R3BTPropagator::PropagateToPlaneRK(R3BTrackingParticle* particle,
                                           const TVector3& v2,
                                           const TVector3& v3)
 {
+    if (fAdaptiveRK)
+    {
+        return fRK->PropagateToPlane(particle, v1, ((v2 - v1).Cross(v3 - v1)).Unit());
+    }
+
     Int_t nStep = 0;
 
     Double_t vecRKIn[7];
@@ -370,4 +412,289 @@ Bool_t R3BTPropagator::LineIntersectPlane(const TVector3& pos,
     return kTRUE;
 }
 
+void R3BTPropagator::SetTransferMapAcceptance(Double_t dx, Double_t dy, Double_t dtx, Double_t dty)
+{
+    fMapAcceptance[0] = dx;
+    fMapAcceptance[1] = dy;
+    fMapAcceptance[2] = dtx;
+    fMapAcceptance[3] = dty;
+}
+
+void R3BTPropagator::SetTransferMapTolerance(Double_t dpos, Double_t dslope, Double_t dlength)
+{
+    fMapTolerance[0] = dpos;
+    fMapTolerance[1] = dslope;
+    fMapTolerance[2] = dlength;
+}
+
+Bool_t R3BTPropagator::HasTransferMaps() const
+{
+    return fMapForward && fMapBackward && fMapForward->IsValid() && fMapBackward->IsValid();
+}
+
+Bool_t R3BTPropagator::SampleTransferMap(const R3BTransferMap* map,
+                                         Bool_t backward,
+                                         const Double_t* in,
+                                         Double_t* out)
+{
+    // Only q/p matters for the trajectory: unit charge and p = 1/|q/p|
+    const R3BTransferMap::Frame& f = map->GetInFrame();
+    const TVector3 pos = f.origin + in[0] * f.ex + in[1] * f.ey;
+    const TVector3 mom = (1. / TMath::Abs(in[4])) * (in[2] * f.ex + in[3] * f.ey + f.ez).Unit();
+    const Double_t charge = (in[4] > 0.) ? 1. : -1.;
+    R3BTrackingParticle particle(charge, pos.X(), pos.Y(), pos.Z(), mom.X(), mom.Y(), mom.Z(), 0.5, 1.);
+
+    Bool_t result;
+    if (backward)
+    {
+        result = PropagateToPlaneRK(&particle, fPlane1[0], fPlane1[2], fPlane1[1]);
+    }
+    else
+    {
+        result = PropagateToPlaneRK(&particle, fPlane2[0], fPlane2[1], fPlane2[2]);
+    }
+    if (!result || !map->GetOutState(&particle, out))
+    {
+        return kFALSE;
+    }
+    for (Int_t i = 0; i < R3BTransferMap::kNOut; i++)
+    {
+        if (!TMath::Finite(out[i]))
+        {
+            return kFALSE;
+        }
+    }
+    return kTRUE;
+}
+
+Bool_t R3BTPropagator::ValidateTransferMap(const R3BTransferMap* map, Bool_t backward, Int_t nSamples)
+{
+    TRandom3 rnd(backward ? 8 : 7);
+    Double_t in[R3BTransferMap::kNIn];
+    Double_t out[R3BTransferMap::kNOut];
+    Double_t eval[R3BTransferMap::kNOut];
+    // Deviations in position (x, y), slope (tx, ty) and path length, the largest of x and y resp. tx and ty
+    Double_t sum2[3] = { 0., 0., 0. };
+    Double_t dmax[3] = { 0., 0., 0. };
+    Int_t n = 0;
+    for (Int_t s = 0; s < nSamples; s++)
+    {
+        for (Int_t i = 0; i < R3BTransferMap::kNIn; i++)
+        {
+            in[i] = rnd.Uniform(map->GetLow(i), map->GetHigh(i));
+        }
+        if (!SampleTransferMap(map, backward, in, out))
+        {
+            continue;
+        }
+        map->Eval(in, eval);
+        const Double_t d[3] = { std::max(TMath::Abs(eval[0] - out[0]), TMath::Abs(eval[1] - out[1])),
+                                std::max(TMath::Abs(eval[2] - out[2]), TMath::Abs(eval[3] - out[3])),
+                                TMath::Abs(eval[4] - out[4]) };
+        for (Int_t k = 0; k < 3; k++)
+        {
+            sum2[k] += d[k] * d[k];
+            dmax[k] = std::max(dmax[k], d[k]);
+        }
+        n += 1;
+    }
+    if (0 == n)
+    {
+        LOG(ERROR) << "R3BTPropagator: no RK propagation through the " << (backward ? "backward" : "forward")
+                   << " transfer map domain succeeded.";
+        return kFALSE;
+    }
+
+    LOG(INFO) << "R3BTPropagator: " << (backward ? "backward" : "forward") << " transfer map vs RK, " << n
+              << " tracks: position rms " << TMath::Sqrt(sum2[0] / n) << " max " << dmax[0] << " cm, slope rms "
+              << TMath::Sqrt(sum2[1] / n) << " max " << dmax[1] << ", length rms " << TMath::Sqrt(sum2[2] / n)
+              << " max " << dmax[2] << " cm";
+    if (dmax[0] > fMapTolerance[0] || dmax[1] > fMapTolerance[1] || dmax[2] > fMapTolerance[2])
+    {
+        LOG(ERROR) << "R3BTPropagator: " << (backward ? "backward" : "forward")
+                   << " transfer map exceeds the tolerance of " << fMapTolerance[0] << " cm in position, "
+                   << fMapTolerance[1] << " in slope, " << fMapTolerance[2] << " cm in length.";
+        return kFALSE;
+    }
+    return kTRUE;
+}
+
+void R3BTPropagator::DeleteTransferMaps()
+{
+    delete fMapForward;
+    delete fMapBackward;
+    fMapForward = nullptr;
+    fMapBackward = nullptr;
+}
+
+Bool_t R3BTPropagator::GenerateTransferMaps(Double_t qpMin, Double_t qpMax, Int_t order, Int_t nSamples)
+{
+    DeleteTransferMaps();
+    fMapForward = new R3BTransferMap();
+    fMapBackward = new R3BTransferMap();
+
+    // Frames of the field boundaries; the backward maps run against the normals with the same x and y axes
+    R3BTransferMap::Frame in1, out2, in2, out1;
+    in1.origin = fPlane1[0];
+    in1.ex = (fPlane1[1] - fPlane1[2]).Unit();
+    in1.ez = fNorm1;
+    in1.ey = in1.ez.Cross(in1.ex);
+    out2.origin = fPlane2[0];
+    out2.ex = (fPlane2[1] - fPlane2[2]).Unit();
+    out2.ez = fNorm2;
+    out2.ey = out2.ez.Cross(out2.ex);
+    in2 = out2;
+    in2.ez = -fNorm2;
+    out1 = in1;
+    out1.ez = -fNorm1;
+    fMapForward->SetFrames(in1, out2);
+    fMapBackward->SetFrames(in2, out1);
+
+    const Double_t scale = ((R3BGladFieldMap*)fField)->GetScale();
+    fMapForward->SetOrder(order);
+    fMapBackward->SetOrder(order);
+    fMapForward->SetScale(scale);
+    fMapBackward->SetScale(scale);
+
+    // Forward domain around the beam axis
+    TVector3 axis;
+    if (!LineIntersectPlane(TVector3(0., 0., 0.), TVector3(0., 0., 1.), fPlane1[0], fNorm1, axis))
+    {
+        LOG(ERROR) << "R3BTPropagator: beam axis does not cross the field entrance.";
+        return kFALSE;
+    }
+    const TVector3 beam(0., 0., 1.);
+    const Double_t center[4] = { (axis - in1.origin).Dot(in1.ex),
+                                 (axis - in1.origin).Dot(in1.ey),
+                                 beam.Dot(in1.ex) / beam.Dot(in1.ez),
+                                 beam.Dot(in1.ey) / beam.Dot(in1.ez) };
+    Double_t low[R3BTransferMap::kNIn];
+    Double_t high[R3BTransferMap::kNIn];
+    for (Int_t i = 0; i < 4; i++)
+    {
+        low[i] = center[i] - fMapAcceptance[i];
+        high[i] = center[i] + fMapAcceptance[i];
+    }
+    low[4] = qpMin;
+    high[4] = qpMax;
+    fMapForward->SetDomain(low, high);
+
+    TRandom3 rnd(5);
+    std::vector<Double_t> vin;
+    std::vector<Double_t> vout;
+    Double_t in[R3BTransferMap::kNIn];
+    Double_t out[R3BTransferMap::kNOut];
+    Double_t outLow[4] = { 1e30, 1e30, 1e30, 1e30 };
+    Double_t outHigh[4] = { -1e30, -1e30, -1e30, -1e30 };
+    for (Int_t s = 0; s < nSamples; s++)
+    {
+        for (Int_t i = 0; i < R3BTransferMap::kNIn; i++)
+        {
+            in[i] = rnd.Uniform(low[i], high[i]);
+        }
+        if (!SampleTransferMap(fMapForward, kFALSE, in, out))
+        {
+            continue;
+        }
+        vin.insert(vin.end(), in, in + R3BTransferMap::kNIn);
+        vout.insert(vout.end(), out, out + R3BTransferMap::kNOut);
+        for (Int_t i = 0; i < 4; i++)
+        {
+            outLow[i] = std::min(outLow[i], out[i]);
+            outHigh[i] = std::max(outHigh[i], out[i]);
+        }
+    }
+    if (!fMapForward->Fit(vin, vout) || !ValidateTransferMap(fMapForward, kFALSE, nSamples / 10))
+    {
+        DeleteTransferMaps();
+        return kFALSE;
+    }
+
+    // Backward domain: image of the forward one (slopes keep their sign against the reversed normal)
+    for (Int_t i = 0; i < 4; i++)
+    {
+        const Double_t pad = 0.05 * (outHigh[i] - outLow[i]);
+        low[i] = outLow[i] - pad;
+        high[i] = outHigh[i] + pad;
+    }
+    low[4] = -qpMax;
+    high[4] = -qpMin;
+    fMapBackward->SetDomain(low, high);
+
+    vin.clear();
+    vout.clear();
+    for (Int_t s = 0; s < nSamples; s++)
+    {
+        for (Int_t i = 0; i < R3BTransferMap::kNIn; i++)
+        {
+            in[i] = rnd.Uniform(low[i], high[i]);
+        }
+        if (!SampleTransferMap(fMapBackward, kTRUE, in, out))
+        {
+            continue;
+        }
+        vin.insert(vin.end(), in, in + R3BTransferMap::kNIn);
+        vout.insert(vout.end(), out, out + R3BTransferMap::kNOut);
+    }
+    if (!fMapBackward->Fit(vin, vout) || !ValidateTransferMap(fMapBackward, kTRUE, nSamples / 10))
+    {
+        DeleteTransferMaps();
+        return kFALSE;
+    }
+
+    return kTRUE;
+}
+
+Bool_t R3BTPropagator::WriteTransferMaps(const char* fileName) const
+{
+    if (!HasTransferMaps())
+    {
+        return kFALSE;
+    }
+    std::ofstream os(fileName);
+    if (!os || !fMapForward->Write(os) || !fMapBackward->Write(os))
+    {
+        LOG(ERROR) << "R3BTPropagator: could not write transfer maps to " << fileName;
+        return kFALSE;
+    }
+    LOG(INFO) << "R3BTPropagator: transfer maps written to " << fileName;
+    return kTRUE;
+}
+
+Bool_t R3BTPropagator::ReadTransferMaps(const char* fileName)
+{
+    std::ifstream is(fileName);
+    if (!is)
+    {
+        return kFALSE;
+    }
+
+    R3BTransferMap* forward = new R3BTransferMap();
+    R3BTransferMap* backward = new R3BTransferMap();
+    Bool_t ok = forward->Read(is) && backward->Read(is);
+
+    // The maps are only valid for the field scale (magnet current) and field position they were made for
+    const Double_t scale = ((R3BGladFieldMap*)fField)->GetScale();
+    if (ok && (TMath::Abs(forward->GetScale() - scale) > 1e-9 * TMath::Max(1., TMath::Abs(scale)) ||
+               (forward->GetInFrame().origin - fPlane1[0]).Mag() > 1e-6 ||
+               (forward->GetOutFrame().origin - fPlane2[0]).Mag() > 1e-6))
+    {
+        LOG(WARNING) << "R3BTPropagator: transfer maps in " << fileName << " do not match the current field.";
+        ok = kFALSE;
+    }
+    ok = ok && ValidateTransferMap(forward, kFALSE, 1000) && ValidateTransferMap(backward, kTRUE, 1000);
+    if (!ok)
+    {
+        delete forward;
+        delete backward;
+        return kFALSE;
+    }
+
+    DeleteTransferMaps();
+    fMapForward = forward;
+    fMapBackward = backward;
+    LOG(INFO) << "R3BTPropagator: transfer maps read from " << fileName;
+    return kTRUE;
+}
+
 ClassImp(R3BTPropagator)
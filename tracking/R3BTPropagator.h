@@ -24,6 +24,8 @@ class R3BTGeoPar;
 class FairField;
 class R3BTrackingParticle;
 class R3BTrackingDetector;
+class R3BTransferMap;
+class R3BTRungeKutta;
 
 class R3BTPropagator : public TObject
 {
@@ -58,7 +60,33 @@ class R3BTPropagator : public TObject
 
     void SetVis(Bool_t vis = kTRUE) { fVis = vis; }
 
+    // Fast propagation through the field region with polynomial transfer maps (see R3BTransferMap),
+    // generated from the RK propagation for charge over momentum in [qpMin, qpMax] (e/(GeV/c)).
+    // In fast mode, crossings of the full field region use the maps, everything else the RK propagation.
+    Bool_t GenerateTransferMaps(Double_t qpMin, Double_t qpMax, Int_t order = 6, Int_t nSamples = 10000);
+    Bool_t WriteTransferMaps(const char* fileName) const;
+    Bool_t ReadTransferMaps(const char* fileName);
+    Bool_t HasTransferMaps() const;
+    // Half widths of the sampled entrance domain around the beam axis: x, y (cm), tx, ty
+    void SetTransferMapAcceptance(Double_t dx, Double_t dy, Double_t dtx, Double_t dty);
+    // Largest deviation from the RK propagation accepted for the maps in position x, y (cm), slope tx, ty and path
+    // length (cm), checked on fresh samples when the maps are generated or read. Maps beyond it are dropped, the
+    // propagation then stays with RK. Default is 0.05 cm, 5e-4 and 0.05 cm, about the resolution of the fibre
+    // detectors behind GLAD and well below the time resolution of the ToF wall.
+    void SetTransferMapTolerance(Double_t dpos, Double_t dslope, Double_t dlength);
+    void SetFastMode(Bool_t fast = kTRUE) { fFastMode = fast; }
+    Bool_t GetFastMode() const { return fFastMode; }
+
+    // RK propagation with the adaptive-step R3BTRungeKutta instead of FairRKPropagator
+    void SetAdaptiveRK(Bool_t adaptive = kTRUE) { fAdaptiveRK = adaptive; }
+    Bool_t GetAdaptiveRK() const { return fAdaptiveRK; }
+    R3BTRungeKutta* GetRungeKutta() const { return fRK; }
+
   private:
+    Bool_t SampleTransferMap(const R3BTransferMap* map, Bool_t backward, const Double_t* in, Double_t* out);
+    Bool_t ValidateTransferMap(const R3BTransferMap* map, Bool_t backward, Int_t nSamples);
+    void DeleteTransferMaps();
+
     FairRKPropagator* fFairProp;
 
     FairField* fField;
@@ -74,7 +102,16 @@ class R3BTPropagator : public TObject
 
     TCanvas* fc4;
 
-    ClassDef(R3BTPropagator, 1)
+    R3BTransferMap* fMapForward;  //!
+    R3BTransferMap* fMapBackward; //!
+    Bool_t fFastMode;
+    Double_t fMapAcceptance[4];
+    Double_t fMapTolerance[3];
+
+    R3BTRungeKutta* fRK; //!
+    Bool_t fAdaptiveRK;
+
+    ClassDef(R3BTPropagator, 5)
 };
 
 #endif //! R3B_T_PROPAGATOR
@@ -0,0 +1,288 @@
+/******************************************************************************
+ *   Copyright (C) 2019 GSI Helmholtzzentrum für Schwerionenforschung GmbH    *
+ *   Copyright (C) 2019 Members of R3B Collaboration                          *
+ *                                                                            *
+ *             This software is distributed under the terms of the            *
+ *                 GNU General Public Licence (GPL) version 3,                *
+ *                    copied verbatim in the file "LICENSE".                  *
+ *                                                                            *
+ * In applying this license GSI does not waive the privileges and immunities  *
+ * granted to it by virtue of its status as an Intergovernmental Organization *
+ * or submit itself to any jurisdiction.                                      *
+ ******************************************************************************/
+
+#include "R3BTRungeKutta.h"
+#include "R3BGladFieldMap.h"
+#include "R3BTrackingParticle.h"
+
+#include "TMath.h"
+
+namespace
+{
+    // Dormand-Prince 5(4) tableau; the 5th order weights are the last row of a
+    const Double_t a21 = 1. / 5.;
+    const Double_t a31 = 3. / 40., a32 = 9. / 40.;
+    const Double_t a41 = 44. / 45., a42 = -56. / 15., a43 = 32. / 9.;
+    const Double_t a51 = 19372. / 6561., a52 = -25360. / 2187., a53 = 64448. / 6561., a54 = -212. / 729.;
+    const Double_t a61 = 9017. / 3168., a62 = -355. / 33., a63 = 46732. / 5247., a64 = 49. / 176.,
+                   a65 = -5103. / 18656.;
+    const Double_t a71 = 35. / 384., a73 = 500. / 1113., a74 = 125. / 192., a75 = -2187. / 6784., a76 = 11. / 84.;
+
+    // Difference of the 5th and 4th order weights
+    const Double_t e1 = 71. / 57600., e3 = -71. / 16695., e4 = 71. / 1920., e5 = -17253. / 339200., e6 = 22. / 525.,
+                   e7 = -1. / 40.;
+
+    const Int_t kMaxSteps = 10000;
+
+    // Distance below which a state is on the plane [cm]
+    const Double_t kOnPlane = 1e-6;
+
+    inline Double_t Distance(const Double_t* s, const Double_t* point, const Double_t* normal)
+    {
+        return (s[0] - point[0]) * normal[0] + (s[1] - point[1]) * normal[1] + (s[2] - point[2]) * normal[2];
+    }
+
+    // Root in [0, h] of the cubic Hermite interpolation of the distance d with the slopes m
+    // at both ends, d0 and d1 of opposite sign. Newton iteration kept inside the bracket.
+    Double_t SolveCrossing(Double_t d0, Double_t m0, Double_t d1, Double_t m1, Double_t h)
+    {
+        const Double_t c0 = d0;
+        const Double_t c1 = m0 * h;
+        const Double_t c2 = 3. * (d1 - d0) - (2. * m0 + m1) * h;
+        const Double_t c3 = 2. * (d0 - d1) + (m0 + m1) * h;
+
+        Double_t lo = 0.;
+        Double_t hi = 1.;
+        Double_t x = d0 / (d0 - d1);
+        for (Int_t i = 0; i < 20; i++)
+        {
+            const Double_t f = c0 + x * (c1 + x * (c2 + x * c3));
+            if ((f > 0.) == (d0 > 0.))
+            {
+                lo = x;
+            }
+            else
+            {
+                hi = x;
+            }
+            const Double_t df = c1 + x * (2. * c2 + x * 3. * c3);
+            Double_t next = (df != 0.) ? x - f / df : -1.;
+            if (next <= lo || next >= hi)
+            {
+                next = 0.5 * (lo + hi);
+            }
+            if (TMath::Abs(next - x) < 1e-12)
+            {
+                x = next;
+                break;
+            }
+            x = next;
+        }
+        return x * h;
+    }
+} // namespace
+
+R3BTRungeKutta::R3BTRungeKutta(R3BGladFieldMap* field)
+    : fField(field)
+    , fTolerance(1e-5)
+    , fMinStep(1e-3)
+    , fMaxStep(100.)
+    , fMaxLength(5000.)
+{
+}
+
+inline void R3BTRungeKutta::Derivative(Double_t kappa, const Double_t* s, Double_t* ds) const
+{
+    // Qualified call: no virtual dispatch through FairField
+    Double_t b[3];
+    fField->R3BGladFieldMap::GetFieldValue(s, b);
+    ds[0] = s[3];
+    ds[1] = s[4];
+    ds[2] = s[5];
+    ds[3] = kappa * (s[4] * b[2] - s[5] * b[1]);
+    ds[4] = kappa * (s[5] * b[0] - s[3] * b[2]);
+    ds[5] = kappa * (s[3] * b[1] - s[4] * b[0]);
+}
+
+Double_t R3BTRungeKutta::Step(Double_t kappa,
+                              Double_t h,
+                              const Double_t* s,
+                              const Double_t* k1,
+                              Double_t* out,
+                              Double_t* k7) const
+{
+    Double_t k2[6], k3[6], k4[6], k5[6], k6[6];
+    Double_t t[6];
+
+    for (Int_t i = 0; i < 6; i++)
+    {
+        t[i] = s[i] + h * a21 * k1[i];
+    }
+    Derivative(kappa, t, k2);
+    for (Int_t i = 0; i < 6; i++)
+    {
+        t[i] = s[i] + h * (a31 * k1[i] + a32 * k2[i]);
+    }
+    Derivative(kappa, t, k3);
+    for (Int_t i = 0; i < 6; i++)
+    {
+        t[i] = s[i] + h * (a41 * k1[i] + a42 * k2[i] + a43 * k3[i]);
+    }
+    Derivative(kappa, t, k4);
+    for (Int_t i = 0; i < 6; i++)
+    {
+        t[i] = s[i] + h * (a51 * k1[i] + a52 * k2[i] + a53 * k3[i] + a54 * k4[i]);
+    }
+    Derivative(kappa, t, k5);
+    for (Int_t i = 0; i < 6; i++)
+    {
+        t[i] = s[i] + h * (a61 * k1[i] + a62 * k2[i] + a63 * k3[i] + a64 * k4[i] + a65 * k5[i]);
+    }
+    Derivative(kappa, t, k6);
+    for (Int_t i = 0; i < 6; i++)
+    {
+        out[i] = s[i] + h * (a71 * k1[i] + a73 * k3[i] + a74 * k4[i] + a75 * k5[i] + a76 * k6[i]);
+    }
+    Derivative(kappa, out, k7);
+
+    // The direction error becomes a position error of the same size times the path length
+    Double_t errPos = 0.;
+    Double_t errDir = 0.;
+    for (Int_t i = 0; i < 6; i++)
+    {
+        const Double_t e = h * (e1 * k1[i] + e3 * k3[i] + e4 * k4[i] + e5 * k5[i] + e6 * k6[i] + e7 * k7[i]);
+        if (i < 3)
+        {
+            errPos += e * e;
+        }
+        else
+        {
+            errDir += e * e;
+        }
+    }
+    return TMath::Max(TMath::Sqrt(errPos), h * TMath::Sqrt(errDir)) / fTolerance;
+}
+
+Bool_t R3BTRungeKutta::PropagateToPlane(Double_t kappa,
+                                        Double_t* state,
+                                        const Double_t* point,
+                                        const Double_t* normal,
+                                        Double_t& length,
+                                        Int_t* nEvaluations) const
+{
+    Double_t s[6], k1[6], out[6], k7[6];
+    for (Int_t i = 0; i < 6; i++)
+    {
+        s[i] = state[i];
+    }
+
+    length = 0.;
+    Double_t dist = Distance(s, point, normal);
+    if (TMath::Abs(dist) < kOnPlane)
+    {
+        return kTRUE;
+    }
+
+    Derivative(kappa, s, k1);
+    Int_t nEval = 1;
+    Double_t h = TMath::Min(fMaxStep, TMath::Max(fMinStep, TMath::Abs(dist)));
+    Bool_t crossed = kFALSE;
+
+    for (Int_t nStep = 0; nStep < kMaxSteps && length < fMaxLength; nStep++)
+    {
+        const Double_t err = Step(kappa, h, s, k1, out, k7);
+        nEval += 6;
+        if (err > 1. && h > fMinStep)
+        {
+            h = TMath::Max(fMinStep, h * TMath::Max(0.2, 0.9 * TMath::Power(err, -0.2)));
+            continue;
+        }
+
+        const Double_t distNew = Distance(out, point, normal);
+        if ((distNew > 0.) != (dist > 0.) || distNew == 0.)
+        {
+            // Crossing within this step: repeat it with the length to the plane
+            const Double_t m0 = k1[0] * normal[0] + k1[1] * normal[1] + k1[2] * normal[2];
+            const Double_t m1 = k7[0] * normal[0] + k7[1] * normal[1] + k7[2] * normal[2];
+            h = SolveCrossing(dist, m0, distNew, m1, h);
+            Step(kappa, h, s, k1, out, k7);
+            nEval += 6;
+            length += h;
+            crossed = kTRUE;
+            break;
+        }
+
+        for (Int_t i = 0; i < 6; i++)
+        {
+            s[i] = out[i];
+            k1[i] = k7[i];
+        }
+        length += h;
+        dist = distNew;
+        h = TMath::Min(fMaxStep, h * TMath::Min(5., TMath::Max(0.2, 0.9 * TMath::Power(err + 1e-10, -0.2))));
+    }
+
+    if (nEvaluations)
+    {
+        *nEvaluations = nEval;
+    }
+    if (!crossed)
+    {
+        return kFALSE;
+    }
+
+    // Remaining distance on a straight line
+    const Double_t norm = 1. / TMath::Sqrt(out[3] * out[3] + out[4] * out[4] + out[5] * out[5]);
+    for (Int_t i = 3; i < 6; i++)
+    {
+        out[i] *= norm;
+    }
+    const Double_t un = out[3] * normal[0] + out[4] * normal[1] + out[5] * normal[2];
+    if (un != 0.)
+    {
+        const Double_t rest = -Distance(out, point, normal) / un;
+        for (Int_t i = 0; i < 3; i++)
+        {
+            out[i] += rest * out[i + 3];
+        }
+        length += rest;
+    }
+
+    for (Int_t i = 0; i < 6; i++)
+    {
+        state[i] = out[i];
+    }
+    return kTRUE;
+}
+
+Bool_t R3BTRungeKutta::PropagateToPlane(R3BTrackingParticle* particle,
+                                        const TVector3& point,
+                                        const TVector3& normal) const
+{
+    const Double_t p = particle->GetMomentum().Mag();
+    if (p <= 0.)
+    {
+        return kFALSE;
+    }
+
+    Double_t state[6];
+    particle->GetPosition(state);
+    for (Int_t i = 0; i < 3; i++)
+    {
+        state[i + 3] = particle->GetMomentum()[i] / p;
+    }
+    const Double_t v1[3] = { point.X(), point.Y(), point.Z() };
+    const Double_t n[3] = { normal.X(), normal.Y(), normal.Z() };
+
+    Double_t length;
+    if (!PropagateToPlane(kC * particle->GetCharge() / p, state, v1, n, length))
+    {
+        return kFALSE;
+    }
+
+    Double_t cosines[4] = { state[3], state[4], state[5], p };
+    particle->SetPosition(state);
+    particle->SetCosines(cosines);
+    particle->AddStep(length);
+    return kTRUE;
+}
@@ -0,0 +1,88 @@
+/******************************************************************************
+ *   Copyright (C) 2019 GSI Helmholtzzentrum für Schwerionenforschung GmbH    *
+ *   Copyright (C) 2019 Members of R3B Collaboration                          *
+ *                                                                            *
+ *             This software is distributed under the terms of the            *
+ *                 GNU General Public Licence (GPL) version 3,                *
+ *                    copied verbatim in the file "LICENSE".                  *
+ *                                                                            *
+ * In applying this license GSI does not waive the privileges and immunities  *
+ * granted to it by virtue of its status as an Intergovernmental Organization *
+ * or submit itself to any jurisdiction.                                      *
+ ******************************************************************************/
+
+#ifndef R3B_T_RUNGE_KUTTA
+#define R3B_T_RUNGE_KUTTA
+
+#include "Rtypes.h"
+#include "TVector3.h"
+
+class R3BGladFieldMap;
+class R3BTrackingParticle;
+
+/* Embedded Runge-Kutta integrator (Dormand-Prince 5(4)) for the tracking
+ * through GLAD, with step size control by the difference of the 5th and 4th
+ * order solutions.
+ *
+ * The state is the position [cm] and the unit direction, integrated along the
+ * path length. The field is taken from R3BGladFieldMap without virtual call.
+ * Propagation to a plane stops at the step which crosses it; the length to the
+ * plane within that step is solved from the cubic Hermite interpolation of the
+ * distance, the step is repeated with that length and the remaining distance
+ * (of the order of the tolerance) is covered on a straight line.
+ *
+ * The integrator holds no state of a propagation and can be shared by threads.
+ */
+class R3BTRungeKutta
+{
+  public:
+    R3BTRungeKutta(R3BGladFieldMap* field);
+
+    // Maximum position error per step [cm], default 1e-5
+    void SetTolerance(Double_t tolerance) { fTolerance = tolerance; }
+    Double_t GetTolerance() const { return fTolerance; }
+
+    // Limits of the step length [cm], default 1e-3 and 100
+    void SetStepLimits(Double_t minStep, Double_t maxStep)
+    {
+        fMinStep = minStep;
+        fMaxStep = maxStep;
+    }
+
+    // Maximum path length of a propagation [cm], default 5000
+    void SetMaxLength(Double_t maxLength) { fMaxLength = maxLength; }
+
+    // Propagate the particle along its momentum onto the plane through point with normal
+    Bool_t PropagateToPlane(R3BTrackingParticle* particle, const TVector3& point, const TVector3& normal) const;
+
+    /* Propagate a state (x, y, z, ux, uy, uz) onto the plane
+     * @param kappa        charge over momentum times c [1/(kG cm)]
+     * @param state        (in/out) position [cm] and unit direction
+     * @param length       (return) path length [cm]
+     * @param nEvaluations (return, optional) number of field evaluations
+     */
+    Bool_t PropagateToPlane(Double_t kappa,
+                            Double_t* state,
+                            const Double_t* point,
+                            const Double_t* normal,
+                            Double_t& length,
+                            Int_t* nEvaluations = nullptr) const;
+
+    // Speed of light [GeV/c / (kG cm)]
+    static constexpr Double_t kC = 2.99792458e-4;
+
+  private:
+    void Derivative(Double_t kappa, const Double_t* s, Double_t* ds) const;
+
+    // One step of length h from s with derivative k1 at s. Returns the new state, its derivative
+    // (first stage of the next step) and the error estimate relative to the tolerance.
+    Double_t Step(Double_t kappa, Double_t h, const Double_t* s, const Double_t* k1, Double_t* out, Double_t* k7) const;
+
+    R3BGladFieldMap* fField;
+    Double_t fTolerance;
+    Double_t fMinStep;
+    Double_t fMaxStep;
+    Double_t fMaxLength;
+};
+
+#endif // R3B_T_RUNGE_KUTTA
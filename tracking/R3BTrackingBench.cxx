@@ -0,0 +1,276 @@
+/******************************************************************************
+ *   Copyright (C) 2019 GSI Helmholtzzentrum für Schwerionenforschung GmbH    *
+ *   Copyright (C) 2019 Members of R3B Collaboration                          *
+ *                                                                            *
+ *             This software is distributed under the terms of the            *
+ *                 GNU General Public Licence (GPL) version 3,                *
+ *                    copied verbatim in the file "LICENSE".                  *
+ *                                                                            *
+ * In applying this license GSI does not waive the privileges and immunities  *
+ * granted to it by virtue of its status as an Intergovernmental Organization *
+ * or submit itself to any jurisdiction.                                      *
+ ******************************************************************************/
+
+// Propagation benchmark: accuracy and speed of the RK propagations through GLAD
+// to a plane behind the magnet, for fragments from the target.
+//
+//   r3btrackingbench [-n tracks] [-d distance] glad map (.dat or .bin)
+//
+// The plane is perpendicular to the magnet axis, at the given distance (default
+// 100 cm) behind the end of the map. The reference is R3BTRungeKutta with a
+// tolerance of 1e-9 cm. Compared are FairRKPropagator as used by R3BTPropagator
+// and R3BTRungeKutta, on its own for different tolerances and through
+// R3BTPropagator::PropagateToPlaneRK.
+
+#include "R3BGladFieldMap.h"
+#include "R3BTPropagator.h"
+#include "R3BTRungeKutta.h"
+#include "R3BTrackingParticle.h"
+
+#include "TMath.h"
+#include "TRandom3.h"
+#include "TString.h"
+#include "TVector3.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <vector>
+
+namespace
+{
+    // Fragment of charge 50 and mass 132 u from the target
+    struct Track
+    {
+        Double_t state[6]; // position [cm], unit direction
+        Double_t p;        // momentum [GeV/c]
+        Double_t beta;
+    };
+
+    const Double_t kCharge = 50.;
+    const Double_t kMass = 132. * 0.9314940954;
+
+    std::vector<Track> GenerateTracks(Int_t n)
+    {
+        TRandom3 rnd(4357);
+        std::vector<Track> tracks(n);
+        for (auto& t : tracks)
+        {
+            t.beta = rnd.Uniform(0.80, 0.86);
+            t.p = kMass * t.beta / TMath::Sqrt(1. - t.beta * t.beta);
+            const TVector3 dir = TVector3(rnd.Uniform(-0.05, 0.05), rnd.Uniform(-0.02, 0.02), 1.).Unit();
+            t.state[0] = rnd.Gaus(0., 0.1);
+            t.state[1] = rnd.Gaus(0., 0.1);
+            t.state[2] = 0.;
+            t.state[3] = dir.X();
+            t.state[4] = dir.Y();
+            t.state[5] = dir.Z();
+        }
+        return tracks;
+    }
+
+    // Propagates a track, returns the state on the plane, kFALSE on failure
+    typedef std::function<Bool_t(const Track&, Double_t*)> Method;
+
+    void Measure(const char* name,
+                 const Method& method,
+                 const std::vector<Track>& tracks,
+                 const std::vector<std::vector<Double_t>>& reference,
+                 const Int_t* nEvaluations)
+    {
+        const Int_t n = tracks.size();
+        std::vector<std::vector<Double_t>> result(n, std::vector<Double_t>(6));
+        std::vector<Bool_t> ok(n);
+
+        const auto start = std::chrono::steady_clock::now();
+        for (Int_t i = 0; i < n; i++)
+        {
+            ok[i] = method(tracks[i], result[i].data());
+        }
+        const auto stop = std::chrono::steady_clock::now();
+
+        Int_t nFailed = 0;
+        Double_t sumPos = 0.;
+        Double_t maxPos = 0.;
+        Double_t maxDir = 0.;
+        for (Int_t i = 0; i < n; i++)
+        {
+            if (!ok[i])
+            {
+                nFailed++;
+                continue;
+            }
+            Double_t dPos = 0.;
+            Double_t dDir = 0.;
+            for (Int_t j = 0; j < 3; j++)
+            {
+                dPos += TMath::Power(result[i][j] - reference[i][j], 2);
+                dDir += TMath::Power(result[i][j + 3] - reference[i][j + 3], 2);
+            }
+            sumPos += TMath::Sqrt(dPos);
+            maxPos = TMath::Max(maxPos, TMath::Sqrt(dPos));
+            maxDir = TMath::Max(maxDir, TMath::Sqrt(dDir));
+        }
+
+        const Double_t seconds = std::chrono::duration<Double_t>(stop - start).count();
+        const Int_t nOk = n - nFailed;
+        char evaluations[32] = "-";
+        if (nEvaluations && n > 0)
+        {
+            snprintf(evaluations, sizeof(evaluations), "%.0f", Double_t(*nEvaluations) / n);
+        }
+        printf("%-28s %9.1f us/track  %8.3f um mean  %8.3f um max  %8.3f urad max  %6s evals/track  %d failed\n",
+               name,
+               n > 0 ? 1.e6 * seconds / n : 0.,
+               nOk > 0 ? 1.e4 * sumPos / nOk : 0.,
+               1.e4 * maxPos,
+               1.e6 * maxDir,
+               evaluations,
+               nFailed);
+    }
+
+    R3BTrackingParticle MakeParticle(const Track& t)
+    {
+        return R3BTrackingParticle(kCharge,
+                                   t.state[0],
+                                   t.state[1],
+                                   t.state[2],
+                                   t.p * t.state[3],
+                                   t.p * t.state[4],
+                                   t.p * t.state[5],
+                                   t.beta,
+                                   kMass);
+    }
+
+    void GetState(const R3BTrackingParticle& particle, Double_t* state)
+    {
+        const Double_t p = particle.GetMomentum().Mag();
+        for (Int_t j = 0; j < 3; j++)
+        {
+            state[j] = particle.GetPosition()[j];
+            state[j + 3] = particle.GetMomentum()[j] / p;
+        }
+    }
+} // namespace
+
+int main(int argc, char** argv)
+{
+    Int_t n = 2000;
+    Double_t distance = 100.;
+    const char* gladMap = NULL;
+
+    for (Int_t i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "-n") == 0 && i + 1 < argc)
+        {
+            n = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "-d") == 0 && i + 1 < argc)
+        {
+            distance = atof(argv[++i]);
+        }
+        else if (argv[i][0] != '-' && gladMap == NULL)
+        {
+            gladMap = argv[i];
+        }
+        else
+        {
+            gladMap = NULL;
+            break;
+        }
+    }
+
+    if (gladMap == NULL || n <= 0)
+    {
+        fprintf(stderr, "Usage: %s [-n tracks] [-d distance] glad map (.dat or .bin)\n", argv[0]);
+        return 1;
+    }
+
+    R3BGladFieldMap glad;
+    glad.SetFileName(gladMap);
+    glad.Init();
+
+    // Plane behind the magnet, perpendicular to its axis
+    const Double_t angle = glad.GetYAngle() * TMath::DegToRad();
+    TVector3 axis(0., 0., 1.);
+    axis.RotateY(angle);
+    const TVector3 centre(glad.GetPositionX(), glad.GetPositionY(), glad.GetPositionZ());
+    const TVector3 v1 = centre + (glad.GetZmax() + distance) * axis;
+    TVector3 ex(1., 0., 0.);
+    ex.RotateY(angle);
+    const TVector3 v2 = v1 + ex + TVector3(0., 1., 0.);
+    const TVector3 v3 = v1 - ex + TVector3(0., 1., 0.);
+    const Double_t point[3] = { v1.X(), v1.Y(), v1.Z() };
+    const Double_t normal[3] = { axis.X(), axis.Y(), axis.Z() };
+
+    const std::vector<Track> tracks = GenerateTracks(n);
+    printf("%d tracks of charge %.0f and mass %.1f GeV, beta 0.80-0.86, to a plane %.0f cm behind GLAD\n",
+           n,
+           kCharge,
+           kMass,
+           distance);
+
+    R3BTRungeKutta rk(&glad);
+    Int_t nEvaluations = 0;
+    auto adaptive = [&](const Track& t, Double_t* out) {
+        Double_t length;
+        Int_t nEval;
+        for (Int_t j = 0; j < 6; j++)
+        {
+            out[j] = t.state[j];
+        }
+        const Bool_t ok = rk.PropagateToPlane(R3BTRungeKutta::kC * kCharge / t.p, out, point, normal, length, &nEval);
+        nEvaluations += nEval;
+        return ok;
+    };
+
+    std::vector<std::vector<Double_t>> reference(n, std::vector<Double_t>(6));
+    rk.SetTolerance(1e-9);
+    rk.SetStepLimits(1e-4, 5.);
+    for (Int_t i = 0; i < n; i++)
+    {
+        if (!adaptive(tracks[i], reference[i].data()))
+        {
+            fprintf(stderr, "Reference propagation failed for track %d\n", i);
+            return 1;
+        }
+    }
+    rk.SetStepLimits(1e-3, 100.);
+
+    R3BTPropagator propagator(&glad);
+    auto viaPropagator = [&](const Track& t, Double_t* out) {
+        R3BTrackingParticle particle = MakeParticle(t);
+        const Bool_t ok = propagator.PropagateToPlaneRK(&particle, v1, v2, v3);
+
+        // Remaining distance on a straight line, as in R3BTPropagator::PropagateToPlane
+        TVector3 intersect;
+        if (ok && propagator.LineIntersectPlane(particle.GetPosition(), particle.GetMomentum(), v1, axis, intersect))
+        {
+            particle.SetPosition(intersect);
+        }
+        GetState(particle, out);
+        return ok;
+    };
+
+    propagator.SetAdaptiveRK(kFALSE);
+    Measure("FairRKPropagator", viaPropagator, tracks, reference, NULL);
+
+    const Double_t tolerances[] = { 1e-3, 1e-4, 1e-5, 1e-6 };
+    for (Double_t tolerance : tolerances)
+    {
+        rk.SetTolerance(tolerance);
+        nEvaluations = 0;
+        Measure(Form("R3BTRungeKutta tol %g cm", tolerance), adaptive, tracks, reference, &nEvaluations);
+    }
+
+    propagator.SetAdaptiveRK(kTRUE);
+    Measure(Form("R3BTPropagator adaptive %g", propagator.GetRungeKutta()->GetTolerance()),
+            viaPropagator,
+            tracks,
+            reference,
+            NULL);
+
+    return 0;
+}
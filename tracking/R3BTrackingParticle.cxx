@@ -26,6 +26,7 @@ R3BTrackingParticle::R3BTrackingParticle()
     , fBeta(0.)
     , fLength(0.)
     , fChi2(0.)
+    , fCovariance()
 {
 }
 
@@ -48,6 +49,7 @@ R3BTrackingParticle::R3BTrackingParticle(Double_t charge,
     , fBeta(beta)
     , fLength(0.)
     , fChi2(0.)
+    , fCovariance()
 {
 }
 
@@ -79,6 +81,11 @@ void R3BTrackingParticle::Reset()
 
 R3BTrackingParticle::~R3BTrackingParticle() {}
 
+void R3BTrackingParticle::InvalidHandle(Int_t handle) const
+{
+    LOG(FATAL) << "R3BTrackingParticle: Invalid detector handle " << handle;
+}
+
 void R3BTrackingParticle::PassThroughDetector(R3BTrackingDetector* det, Double_t weight)
 {
     Double_t eloss = weight * det->GetEnergyLoss(this) * 1e-3;
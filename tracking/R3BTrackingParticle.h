@@ -17,7 +17,7 @@
 #include "TMath.h"
 #include "TObject.h"
 #include "TVector3.h"
-#include <utility>
+#include <algorithm>
 #include <vector>
 
 class R3BTrackingDetector;
@@ -96,6 +96,15 @@ class R3BTrackingParticle : public TObject
 
     Double_t GetChi2() const { return fChi2; }
 
+    // Covariance of the fitted (x, y, tx = px/pz, ty = py/pz, q/p) in the local frame of the detector plane
+    // of the fit result, lower triangle packed row by row. Filled by R3BFragmentFitterKalman.
+    void SetCovariance(const Double_t* cov) { std::copy(cov, cov + 15, fCovariance); }
+    const Double_t* GetCovariance() const { return fCovariance; }
+    Double_t GetCovariance(Int_t i, Int_t j) const
+    {
+        return (i >= j) ? fCovariance[i * (i + 1) / 2 + j] : fCovariance[j * (j + 1) / 2 + i];
+    }
+
     void PassThroughDetector(R3BTrackingDetector* det, Double_t weight = 1.);
     void PassThroughDetectorBackward(R3BTrackingDetector* det, Double_t weight = 1.);
 
@@ -106,34 +115,30 @@ class R3BTrackingParticle : public TObject
 
     void Reset();
 
-    void AddHit(const std::string& detName, const Int_t& hitId)
-    {
-        std::pair<std::string, Int_t> index(detName, hitId);
-        fHits.push_back(index);
-    }
-
-    const Int_t GetSize() const { return fHits.size(); }
-
-    void GetHit(const Int_t& index, std::string& detName, Int_t& hitId)
+    // Hits by detector handle (R3BTrackingSetup::GetHandle), no string work for the fits in the event loop
+    void AddHit(Int_t handle, Int_t hitId)
     {
-        detName = fHits[index].first;
-        hitId = fHits[index].second;
+        if (handle < 0)
+        {
+            InvalidHandle(handle);
+        }
+        if (handle >= (Int_t)fHitIds.size())
+        {
+            fHitIds.resize(handle + 1, -1);
+        }
+        fHitIds[handle] = hitId;
     }
 
-    const Int_t GetHitIndexByName(const std::string& detName)
+    // Hit index on the detector with this handle, -1 for none
+    Int_t GetHitIndex(Int_t handle) const
     {
-        for (auto x : fHits)
-        {
-            if (0 == x.first.compare(detName))
-            {
-                return x.second;
-            }
-        }
-        return -1;
+        return (handle >= 0 && handle < (Int_t)fHitIds.size()) ? fHitIds[handle] : -1;
     }
 
   private:
-    std::vector<std::pair<std::string, Int_t>> fHits;
+    void InvalidHandle(Int_t handle) const;
+
+    std::vector<Int_t> fHitIds; // hit index by detector handle
 
     Double_t fCharge;
     TVector3 fStartPosition;
@@ -147,8 +152,9 @@ class R3BTrackingParticle : public TObject
     Double_t fLength;
 
     Double_t fChi2;
+    Double_t fCovariance[15];
 
-    ClassDef(R3BTrackingParticle, 1)
+    ClassDef(R3BTrackingParticle, 4)
 };
 
 #endif
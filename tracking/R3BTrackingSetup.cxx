@@ -50,13 +50,32 @@ void R3BTrackingSetup::AddDetector(const string& name,
 
 R3BTrackingDetector* R3BTrackingSetup::GetByName(const string& name)
 {
-    if (fMapIndex.find(name) == fMapIndex.end())
+    // find() only, operator[] is not safe for concurrent readers (fits in several threads)
+    auto it = fMapIndex.find(name);
+    if (it == fMapIndex.end())
     {
         LOG(ERROR) << "Detector " << name << " was not found in setup.";
         return nullptr;
     }
 
-    return fDetectors.at(fMapIndex[name]);
+    return fDetectors.at(it->second);
+}
+
+Int_t R3BTrackingSetup::GetHandle(const string& name) const
+{
+    auto it = fMapIndex.find(name);
+    if (it == fMapIndex.end())
+    {
+        LOG(ERROR) << "Detector " << name << " was not found in setup.";
+        return -1;
+    }
+
+    return it->second;
+}
+
+void R3BTrackingSetup::InvalidHandle(Int_t handle) const
+{
+    LOG(FATAL) << "Invalid detector handle " << handle << ", the setup has " << fDetectors.size() << " detectors.";
 }
 
 R3BTrackingDetector* R3BTrackingSetup::GetFirstByType(const EDetectorType& type)
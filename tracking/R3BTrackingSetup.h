@@ -32,6 +32,18 @@ class R3BTrackingSetup
 
     R3BTrackingDetector* GetByName(const std::string& name);
 
+    // Handle of a detector = its index in GetArray(), -1 if not found. Resolve the handles once at Init and use
+    // them in the event loop instead of the name lookups.
+    Int_t GetHandle(const std::string& name) const;
+
+    R3BTrackingDetector* GetByHandle(Int_t handle) const
+    {
+        CheckHandle(handle);
+        return fDetectors[handle];
+    }
+
+    Int_t GetNumberOfDetectors() const { return fDetectors.size(); }
+
     R3BTrackingDetector* GetFirstByType(const EDetectorType& type);
 
     void Init();
@@ -44,9 +56,30 @@ class R3BTrackingSetup
 
     R3BHit* GetHit(const std::string& detName, const Int_t& hitId) { return GetByName(detName)->hits[hitId]; }
 
+    // Hits of the current event (see CopyHits) by detector handle
+    const std::vector<R3BHit*>& GetHits(Int_t handle) const
+    {
+        CheckHandle(handle);
+        return fDetectors[handle]->hits;
+    }
+    R3BHit* GetHit(Int_t handle, Int_t hitId) const
+    {
+        CheckHandle(handle);
+        return fDetectors[handle]->hits[hitId];
+    }
+
     Double_t GetAfterGladResolution();
 
   private:
+    void CheckHandle(Int_t handle) const
+    {
+        if (handle < 0 || handle >= (Int_t)fDetectors.size())
+        {
+            InvalidHandle(handle);
+        }
+    }
+    void InvalidHandle(Int_t handle) const;
+
     std::vector<R3BTrackingDetector*> fDetectors;
     std::map<std::string, int> fMapIndex;
 
@@ -0,0 +1,428 @@
+/******************************************************************************
+ *   Copyright (C) 2019 GSI Helmholtzzentrum für Schwerionenforschung GmbH    *
+ *   Copyright (C) 2019 Members of R3B Collaboration                          *
+ *                                                                            *
+ *             This software is distributed under the terms of the            *
+ *                 GNU General Public Licence (GPL) version 3,                *
+ *                    copied verbatim in the file "LICENSE".                  *
+ *                                                                            *
+ * In applying this license GSI does not waive the privileges and immunities  *
+ * granted to it by virtue of its status as an Intergovernmental Organization *
+ * or submit itself to any jurisdiction.                                      *
+ ******************************************************************************/
+
+#include "R3BTransferMap.h"
+#include "R3BTrackingParticle.h"
+
+#include "FairLogger.h"
+
+#include "TMath.h"
+
+#include <iomanip>
+#include <istream>
+#include <ostream>
+#include <string>
+
+using namespace std;
+
+R3BTransferMap::R3BTransferMap()
+    : fOrder(5)
+    , fScale(1.)
+{
+    for (Int_t i = 0; i < kNIn; i++)
+    {
+        fLow[i] = -1.;
+        fHigh[i] = 1.;
+    }
+}
+
+R3BTransferMap::~R3BTransferMap() {}
+
+void R3BTransferMap::SetFrames(const Frame& in, const Frame& out)
+{
+    fIn = in;
+    fOut = out;
+}
+
+void R3BTransferMap::SetDomain(const Double_t* low, const Double_t* high)
+{
+    for (Int_t i = 0; i < kNIn; i++)
+    {
+        fLow[i] = low[i];
+        fHigh[i] = high[i];
+    }
+}
+
+void R3BTransferMap::MakeTerms()
+{
+    // All exponent combinations with total degree <= fOrder
+    fExp.clear();
+    Int_t e[kNIn] = { 0 };
+    while (kTRUE)
+    {
+        Int_t sum = 0;
+        for (Int_t i = 0; i < kNIn; i++)
+        {
+            sum += e[i];
+        }
+        if (sum <= fOrder)
+        {
+            fExp.insert(fExp.end(), e, e + kNIn);
+        }
+
+        Int_t i = 0;
+        while (i < kNIn && ++e[i] > fOrder)
+        {
+            e[i++] = 0;
+        }
+        if (i == kNIn)
+        {
+            break;
+        }
+    }
+}
+
+void R3BTransferMap::Basis(const Double_t* in, Double_t* t) const
+{
+    // Chebyshev polynomials T_0..T_order of the inputs scaled to [-1, 1]
+    const Int_t n = fOrder + 1;
+    for (Int_t i = 0; i < kNIn; i++)
+    {
+        const Double_t u = (2. * in[i] - fLow[i] - fHigh[i]) / (fHigh[i] - fLow[i]);
+        Double_t* ti = t + i * n;
+        ti[0] = 1.;
+        if (n > 1)
+        {
+            ti[1] = u;
+        }
+        for (Int_t k = 2; k < n; k++)
+        {
+            ti[k] = 2. * u * ti[k - 1] - ti[k - 2];
+        }
+    }
+}
+
+Bool_t R3BTransferMap::Fit(const vector<Double_t>& in, const vector<Double_t>& out)
+{
+    if (fOrder < 1 || fOrder > 15)
+    {
+        LOG(ERROR) << "R3BTransferMap: order " << fOrder << " not supported.";
+        fCoef.clear();
+        return kFALSE;
+    }
+
+    MakeTerms();
+    const Int_t nTerms = fExp.size() / kNIn;
+    const size_t nSamples = in.size() / kNIn;
+    if (nSamples < (size_t)nTerms || out.size() != nSamples * kNOut)
+    {
+        LOG(ERROR) << "R3BTransferMap: " << nSamples << " samples are not enough for " << nTerms << " terms.";
+        fCoef.clear();
+        return kFALSE;
+    }
+
+    // Normal equations, upper triangle
+    const Int_t n = fOrder + 1;
+    vector<Double_t> t(kNIn * n);
+    vector<Double_t> phi(nTerms);
+    vector<Double_t> ata(nTerms * nTerms, 0.);
+    vector<Double_t> atb(nTerms * kNOut, 0.);
+    for (size_t s = 0; s < nSamples; s++)
+    {
+        Basis(&in[s * kNIn], &t[0]);
+        for (Int_t j = 0; j < nTerms; j++)
+        {
+            const UChar_t* e = &fExp[j * kNIn];
+            Double_t p = 1.;
+            for (Int_t i = 0; i < kNIn; i++)
+            {
+                p *= t[i * n + e[i]];
+            }
+            phi[j] = p;
+        }
+        for (Int_t j = 0; j < nTerms; j++)
+        {
+            const Double_t pj = phi[j];
+            Double_t* row = &ata[j * nTerms];
+            for (Int_t k = j; k < nTerms; k++)
+            {
+                row[k] += pj * phi[k];
+            }
+            for (Int_t o = 0; o < kNOut; o++)
+            {
+                atb[j * kNOut + o] += pj * out[s * kNOut + o];
+            }
+        }
+    }
+
+    // Cholesky decomposition A = L L^T, stored in the lower triangle
+    for (Int_t j = 0; j < nTerms; j++)
+    {
+        for (Int_t k = 0; k < j; k++)
+        {
+            ata[j * nTerms + k] = ata[k * nTerms + j];
+        }
+    }
+    for (Int_t j = 0; j < nTerms; j++)
+    {
+        Double_t d = ata[j * nTerms + j];
+        for (Int_t k = 0; k < j; k++)
+        {
+            d -= ata[j * nTerms + k] * ata[j * nTerms + k];
+        }
+        if (d <= 0.)
+        {
+            LOG(ERROR) << "R3BTransferMap: singular fit, check the sampled domain.";
+            fCoef.clear();
+            return kFALSE;
+        }
+        d = TMath::Sqrt(d);
+        ata[j * nTerms + j] = d;
+        for (Int_t i = j + 1; i < nTerms; i++)
+        {
+            Double_t v = ata[i * nTerms + j];
+            for (Int_t k = 0; k < j; k++)
+            {
+                v -= ata[i * nTerms + k] * ata[j * nTerms + k];
+            }
+            ata[i * nTerms + j] = v / d;
+        }
+    }
+
+    // Forward and back substitution for all outputs
+    fCoef.assign(nTerms * kNOut, 0.);
+    for (Int_t o = 0; o < kNOut; o++)
+    {
+        vector<Double_t> y(nTerms);
+        for (Int_t j = 0; j < nTerms; j++)
+        {
+            Double_t v = atb[j * kNOut + o];
+            for (Int_t k = 0; k < j; k++)
+            {
+                v -= ata[j * nTerms + k] * y[k];
+            }
+            y[j] = v / ata[j * nTerms + j];
+        }
+        for (Int_t j = nTerms - 1; j >= 0; j--)
+        {
+            Double_t v = y[j];
+            for (Int_t k = j + 1; k < nTerms; k++)
+            {
+                v -= ata[k * nTerms + j] * fCoef[k * kNOut + o];
+            }
+            fCoef[j * kNOut + o] = v / ata[j * nTerms + j];
+        }
+    }
+
+    return kTRUE;
+}
+
+Bool_t R3BTransferMap::InDomain(const Double_t* in) const
+{
+    for (Int_t i = 0; i < kNIn; i++)
+    {
+        if (!(in[i] >= fLow[i] && in[i] <= fHigh[i]))
+        {
+            return kFALSE;
+        }
+    }
+    return kTRUE;
+}
+
+void R3BTransferMap::Eval(const Double_t* in, Double_t* out) const
+{
+    const Int_t n = fOrder + 1;
+    Double_t t[kNIn * 16];
+    Basis(in, t);
+
+    for (Int_t o = 0; o < kNOut; o++)
+    {
+        out[o] = 0.;
+    }
+    const Int_t nTerms = fExp.size() / kNIn;
+    for (Int_t j = 0; j < nTerms; j++)
+    {
+        const UChar_t* e = &fExp[j * kNIn];
+        const Double_t p = t[e[0]] * t[n + e[1]] * t[2 * n + e[2]] * t[3 * n + e[3]] * t[4 * n + e[4]];
+        const Double_t* c = &fCoef[j * kNOut];
+        for (Int_t o = 0; o < kNOut; o++)
+        {
+            out[o] += c[o] * p;
+        }
+    }
+}
+
+Bool_t R3BTransferMap::GetInState(const R3BTrackingParticle* particle, Double_t* in) const
+{
+    const TVector3 d = particle->GetPosition() - fIn.origin;
+    if (TMath::Abs(d.Dot(fIn.ez)) > 1e-4)
+    {
+        return kFALSE;
+    }
+    const TVector3& mom = particle->GetMomentum();
+    const Double_t pz = mom.Dot(fIn.ez);
+    if (pz <= 0.)
+    {
+        return kFALSE;
+    }
+    in[0] = d.Dot(fIn.ex);
+    in[1] = d.Dot(fIn.ey);
+    in[2] = mom.Dot(fIn.ex) / pz;
+    in[3] = mom.Dot(fIn.ey) / pz;
+    in[4] = particle->GetCharge() / mom.Mag();
+    return kTRUE;
+}
+
+Bool_t R3BTransferMap::GetOutState(R3BTrackingParticle* particle, Double_t* out) const
+{
+    const TVector3& mom = particle->GetMomentum();
+    const Double_t pz = mom.Dot(fOut.ez);
+    if (pz <= 0.)
+    {
+        return kFALSE;
+    }
+
+    // The RK propagation stops just in front of the plane, the rest is outside of the field
+    const TVector3 d = particle->GetPosition() - fOut.origin;
+    const Double_t t = -d.Dot(fOut.ez) / pz;
+    const TVector3 step = t * mom;
+    particle->SetPosition(particle->GetPosition() + step);
+    particle->AddStep(step.Dot(mom.Unit()));
+
+    const TVector3 dOut = particle->GetPosition() - fOut.origin;
+    out[0] = dOut.Dot(fOut.ex);
+    out[1] = dOut.Dot(fOut.ey);
+    out[2] = mom.Dot(fOut.ex) / pz;
+    out[3] = mom.Dot(fOut.ey) / pz;
+    out[4] = particle->GetLength();
+    return kTRUE;
+}
+
+Bool_t R3BTransferMap::Transport(R3BTrackingParticle* particle) const
+{
+    if (fCoef.empty())
+    {
+        return kFALSE;
+    }
+
+    Double_t in[kNIn];
+    if (!GetInState(particle, in) || !InDomain(in))
+    {
+        return kFALSE;
+    }
+
+    Double_t out[kNOut];
+    Eval(in, out);
+
+    const TVector3 pos = fOut.origin + out[0] * fOut.ex + out[1] * fOut.ey;
+    const TVector3 direction = (out[2] * fOut.ex + out[3] * fOut.ey + fOut.ez).Unit();
+    particle->SetPosition(pos);
+    particle->SetMomentum(particle->GetMomentum().Mag() * direction);
+    particle->AddStep(out[4]);
+    return kTRUE;
+}
+
+Bool_t R3BTransferMap::Write(ostream& os) const
+{
+    if (fCoef.empty())
+    {
+        return kFALSE;
+    }
+
+    const Frame* frames[2] = { &fIn, &fOut };
+    os << "R3BTransferMap 1\n";
+    os << setprecision(17);
+    os << fOrder << " " << fScale << "\n";
+    for (Int_t f = 0; f < 2; f++)
+    {
+        const TVector3* v[4] = { &frames[f]->origin, &frames[f]->ex, &frames[f]->ey, &frames[f]->ez };
+        for (Int_t k = 0; k < 4; k++)
+        {
+            os << v[k]->X() << " " << v[k]->Y() << " " << v[k]->Z() << (k < 3 ? " " : "\n");
+        }
+    }
+    for (Int_t i = 0; i < kNIn; i++)
+    {
+        os << fLow[i] << " " << fHigh[i] << (i < kNIn - 1 ? " " : "\n");
+    }
+    const Int_t nTerms = fExp.size() / kNIn;
+    os << nTerms << "\n";
+    for (Int_t j = 0; j < nTerms; j++)
+    {
+        for (Int_t i = 0; i < kNIn; i++)
+        {
+            os << (Int_t)fExp[j * kNIn + i] << " ";
+        }
+        for (Int_t o = 0; o < kNOut; o++)
+        {
+            os << fCoef[j * kNOut + o] << (o < kNOut - 1 ? " " : "\n");
+        }
+    }
+    return os.good();
+}
+
+Bool_t R3BTransferMap::Read(istream& is)
+{
+    string tag;
+    Int_t version = 0;
+    is >> tag >> version;
+    if (tag != "R3BTransferMap" || version != 1)
+    {
+        LOG(ERROR) << "R3BTransferMap: unknown format " << tag << " " << version;
+        return kFALSE;
+    }
+
+    is >> fOrder >> fScale;
+    Frame* frames[2] = { &fIn, &fOut };
+    for (Int_t f = 0; f < 2; f++)
+    {
+        TVector3* v[4] = { &frames[f]->origin, &frames[f]->ex, &frames[f]->ey, &frames[f]->ez };
+        for (Int_t k = 0; k < 4; k++)
+        {
+            Double_t x, y, z;
+            is >> x >> y >> z;
+            v[k]->SetXYZ(x, y, z);
+        }
+    }
+    for (Int_t i = 0; i < kNIn; i++)
+    {
+        is >> fLow[i] >> fHigh[i];
+    }
+
+    MakeTerms();
+    Int_t nTerms = 0;
+    is >> nTerms;
+    if (!is || fOrder < 1 || fOrder > 15 || nTerms != (Int_t)fExp.size() / kNIn)
+    {
+        LOG(ERROR) << "R3BTransferMap: inconsistent map header.";
+        fCoef.clear();
+        return kFALSE;
+    }
+    fCoef.assign(nTerms * kNOut, 0.);
+    for (Int_t j = 0; j < nTerms; j++)
+    {
+        for (Int_t i = 0; i < kNIn; i++)
+        {
+            Int_t e = -1;
+            is >> e;
+            if (e < 0 || e > fOrder)
+            {
+                LOG(ERROR) << "R3BTransferMap: exponent " << e << " of term " << j << " outside of order " << fOrder;
+                fCoef.clear();
+                return kFALSE;
+            }
+            fExp[j * kNIn + i] = e;
+        }
+        for (Int_t o = 0; o < kNOut; o++)
+        {
+            is >> fCoef[j * kNOut + o];
+        }
+    }
+    if (!is)
+    {
+        LOG(ERROR) << "R3BTransferMap: truncated map.";
+        fCoef.clear();
+        return kFALSE;
+    }
+    return kTRUE;
+}
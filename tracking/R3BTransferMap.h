@@ -0,0 +1,102 @@
+/******************************************************************************
+ *   Copyright (C) 2019 GSI Helmholtzzentrum für Schwerionenforschung GmbH    *
+ *   Copyright (C) 2019 Members of R3B Collaboration                          *
+ *                                                                            *
+ *             This software is distributed under the terms of the            *
+ *                 GNU General Public Licence (GPL) version 3,                *
+ *                    copied verbatim in the file "LICENSE".                  *
+ *                                                                            *
+ * In applying this license GSI does not waive the privileges and immunities  *
+ * granted to it by virtue of its status as an Intergovernmental Organization *
+ * or submit itself to any jurisdiction.                                      *
+ ******************************************************************************/
+
+#ifndef R3B_TRANSFER_MAP
+#define R3B_TRANSFER_MAP
+
+#include "Rtypes.h"
+#include "TVector3.h"
+
+#include <iosfwd>
+#include <vector>
+
+class R3BTrackingParticle;
+
+/* Polynomial transfer map between two planes enclosing a magnetic field.
+ *
+ * The state on the entrance plane (x, y, tx = px/pz, ty = py/pz, q/p in
+ * e/(GeV/c)), in the local frame of the plane, is mapped to the state on the
+ * exit plane (x, y, tx, ty) and the path length. Each output is a sum of
+ * products of Chebyshev polynomials of the scaled inputs up to a total
+ * degree, fitted by least squares to samples of RK propagations. The map
+ * is only valid inside the sampled domain; Transport() refuses states
+ * outside of it, so that the caller can fall back to the RK propagation.
+ */
+class R3BTransferMap
+{
+  public:
+    enum
+    {
+        kNIn = 5, // x, y, tx, ty, q/p
+        kNOut = 5 // x, y, tx, ty, length
+    };
+
+    // Plane with its local frame: ez is the direction of propagation
+    struct Frame
+    {
+        TVector3 origin;
+        TVector3 ex;
+        TVector3 ey;
+        TVector3 ez;
+    };
+
+    R3BTransferMap();
+    ~R3BTransferMap();
+
+    void SetFrames(const Frame& in, const Frame& out);
+    void SetDomain(const Double_t* low, const Double_t* high);
+    void SetOrder(Int_t order) { fOrder = order; }
+    void SetScale(Double_t scale) { fScale = scale; }
+
+    const Frame& GetInFrame() const { return fIn; }
+    const Frame& GetOutFrame() const { return fOut; }
+    Double_t GetLow(Int_t i) const { return fLow[i]; }
+    Double_t GetHigh(Int_t i) const { return fHigh[i]; }
+    Int_t GetOrder() const { return fOrder; }
+    Double_t GetScale() const { return fScale; }
+    Bool_t IsValid() const { return !fCoef.empty(); }
+
+    // Least-squares fit; in and out hold kNIn resp. kNOut values per sample
+    Bool_t Fit(const std::vector<Double_t>& in, const std::vector<Double_t>& out);
+
+    Bool_t InDomain(const Double_t* in) const;
+    void Eval(const Double_t* in, Double_t* out) const;
+
+    // Local entrance state of a particle on the entrance plane, kFALSE if it is not on the plane
+    Bool_t GetInState(const R3BTrackingParticle* particle, Double_t* in) const;
+
+    // Local exit state of a particle on (or close behind) the exit plane; the particle is moved onto it
+    Bool_t GetOutState(R3BTrackingParticle* particle, Double_t* out) const;
+
+    // Moves a particle from the entrance to the exit plane. kFALSE (particle untouched) if not applicable.
+    Bool_t Transport(R3BTrackingParticle* particle) const;
+
+    Bool_t Write(std::ostream& os) const;
+    Bool_t Read(std::istream& is);
+
+  private:
+    void MakeTerms();
+    void Basis(const Double_t* in, Double_t* t) const;
+
+    Frame fIn;
+    Frame fOut;
+    Double_t fLow[kNIn];
+    Double_t fHigh[kNIn];
+    Int_t fOrder;
+    Double_t fScale;
+
+    std::vector<UChar_t> fExp;   // kNIn exponents per term
+    std::vector<Double_t> fCoef; // kNOut coefficients per term
+};
+
+#endif
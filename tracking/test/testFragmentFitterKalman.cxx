@@ -0,0 +1,356 @@
+/******************************************************************************
+ *   Copyright (C) 2019 GSI Helmholtzzentrum für Schwerionenforschung GmbH    *
+ *   Copyright (C) 2019 Members of R3B Collaboration                          *
+ *                                                                            *
+ *             This software is distributed under the terms of the            *
+ *                 GNU General Public Licence (GPL) version 3,                *
+ *                    copied verbatim in the file "LICENSE".                  *
+ *                                                                            *
+ * In applying this license GSI does not waive the privileges and immunities  *
+ * granted to it by virtue of its status as an Intergovernmental Organization *
+ * or submit itself to any jurisdiction.                                      *
+ ******************************************************************************/
+
+#include "GladTestMap.h"
+#include "R3BFragmentFitterKalman.h"
+#include "R3BGladFieldMap.h"
+#include "R3BHit.h"
+#include "R3BTGeoPar.h"
+#include "R3BTPropagator.h"
+#include "R3BTrackingDetector.h"
+#include "R3BTrackingParticle.h"
+#include "R3BTrackingSetup.h"
+#include "TMath.h"
+#include "TVector3.h"
+#include "gtest/gtest.h"
+
+#include <cstdio>
+#include <memory>
+#include <random>
+#include <vector>
+
+// The fitted mass, momentum and track at the target must scatter around the true values as given by the covariance
+// stored in the particle: tracks with energy loss, multiple scattering and Gaussian hit resolutions, propagated with
+// either propagation through GLAD.
+
+namespace
+{
+    const Double_t kAmu = 0.9314940954;
+    const Double_t kCharge = 50.;
+    const Double_t kMassMin = 125. * kAmu;
+    const Double_t kMassMax = 133. * kAmu;
+    const Int_t kTracks = 400;
+
+    // Field [T] for GladTestMap::WriteField. The numerical Jacobians of the fit need a smooth transport: the field
+    // falls to zero at the ends of the map instead of stepping there, and By does not depend on y, as the trilinear
+    // interpolation would put a kink into it at the y = 0 grid plane, on which the tracks run.
+    void Field(Double_t x, Double_t y, Double_t z, Double_t* b)
+    {
+        const Double_t profile = TMath::Power(TMath::Cos(0.5 * TMath::Pi() * z / GladTestMap::kMax[2]), 2);
+        b[0] = 4.e-5 * x * y * profile;
+        b[1] = 2.5 * (1. + 2.e-4 * x * x) * profile;
+        b[2] = 0.;
+    }
+
+    // True values at the target centre
+    struct Track
+    {
+        Double_t mass;
+        Double_t beta;
+        Double_t x;
+        Double_t tx;
+        Double_t p;
+    };
+
+    // Mean and RMS of the pulls of one quantity
+    struct Pull
+    {
+        Double_t sum = 0.;
+        Double_t sum2 = 0.;
+        Int_t n = 0;
+
+        void Fill(Double_t pull)
+        {
+            sum += pull;
+            sum2 += pull * pull;
+            n++;
+        }
+        Double_t Mean() const { return sum / n; }
+        Double_t Rms() const { return TMath::Sqrt(sum2 / n - Mean() * Mean()); }
+    };
+
+    class testFragmentFitterKalman : public testing::Test
+    {
+      protected:
+        void SetUp() override
+        {
+            fFileName = GladTestMap::WriteField("testFragmentFitterKalman", Field);
+            fGlad.SetFileName(fFileName);
+            fGlad.Init();
+            fPropagator.reset(new R3BTPropagator(&fGlad));
+
+            // Carbon target, silicon PSP, plastic fibres: target and PSP in front of GLAD, the fibres and the ToF
+            // wall behind it along the central track
+            AddDetector("target", kTarget, TVector3(0., 0., 0.), 0., 1., 0.25, 0.1000);
+            SetMaterial(6., 12.011, 2.26, 78.);
+            AddDetector("psp", kTargetGlad, TVector3(0., 0., 50.), 0., 4., 0.015, 0.0200);
+            SetMaterial(14., 28.086, 2.33, 173.);
+
+            const Double_t beta = 0.8328;
+            const Double_t p = 129. * kAmu * beta / TMath::Sqrt(1. - beta * beta);
+            R3BTrackingParticle central(kCharge, 0., 0., 0., 0., 0., p, beta, 129. * kAmu);
+            const TVector3 v1(0., 0., 450.);
+            const TVector3 v2(1., 1., 450.);
+            const TVector3 v3(-1., 1., 450.);
+            ASSERT_TRUE(fPropagator->PropagateToPlane(&central, v1, v2, v3));
+            const TVector3 dir = central.GetMomentum().Unit();
+            const Double_t rotY = TMath::ATan2(dir.X(), dir.Z()) * TMath::RadToDeg();
+            AddDetector("fi4", kAfterGlad, central.GetPosition(), rotY, 30., 0.05, 0.0200);
+            SetMaterial(3.5, 6.5, 1.05, 68.7);
+            AddDetector("fi5", kAfterGlad, central.GetPosition() + 60. * dir, rotY, 30., 0.05, 0.0400);
+            SetMaterial(3.5, 6.5, 1.05, 68.7);
+            AddDetector("fi6", kAfterGlad, central.GetPosition() + 150. * dir, rotY, 30., 0.05, 0.0500);
+            SetMaterial(3.5, 6.5, 1.05, 68.7);
+            AddDetector("tofd", kTof, central.GetPosition() + 300. * dir, rotY, 60., 0.25, 2.7);
+            SetMaterial(3.5, 6.5, 1.05, 68.7);
+
+            fFitter.Init(fPropagator.get(), kTRUE);
+        }
+
+        void TearDown() override { std::remove(fFileName.Data()); }
+
+        void AddDetector(const char* name,
+                         EDetectorType type,
+                         const TVector3& pos,
+                         Double_t rotY,
+                         Double_t halfWidth,
+                         Double_t halfThickness,
+                         Double_t resolution)
+        {
+            fPars.emplace_back(new R3BTGeoPar(TString::Format("%sGeoPar", name)));
+            fPars.back()->SetPosXYZ(pos.X(), pos.Y(), pos.Z());
+            fPars.back()->SetRotXYZ(0., rotY, 0.);
+            fPars.back()->SetDimXYZ(halfWidth, 10., halfThickness);
+
+            fSetup.AddDetector(name, type, fPars.back()->GetName());
+            R3BTrackingDetector* det = fSetup.GetArray().back();
+            det->fGeo = fPars.back().get();
+            det->res_x = resolution;
+            det->Init();
+        }
+
+        // Material of the last added detector
+        void SetMaterial(Double_t Z, Double_t A, Double_t density, Double_t I)
+        {
+            fPars.back()->SetMaterial(Z, A, density, I);
+        }
+
+        // Random kink of the direction in the material of det (Highland, radiation length of Dahl), with the
+        // variance the fitter adds as process noise
+        void Scatter(R3BTrackingParticle& particle, R3BTrackingDetector* det, Double_t weight, std::mt19937& gen)
+        {
+            const R3BTGeoPar* geo = det->GetGeoPar();
+            const Double_t Z = geo->GetZ();
+            const Double_t x0 = 716.4 * geo->GetA() / (Z * (Z + 1.) * TMath::Log(287. / TMath::Sqrt(Z)));
+
+            const Double_t angle = geo->GetRotY() * TMath::DegToRad();
+            TVector3 ex(1., 0., 0.);
+            TVector3 ez(0., 0., 1.);
+            ex.RotateY(angle);
+            ez.RotateY(angle);
+            const TVector3 ey(0., 1., 0.);
+
+            const TVector3 mom = particle.GetMomentum();
+            const Double_t p = mom.Mag();
+            const Double_t tx = mom.Dot(ex) / mom.Dot(ez);
+            const Double_t ty = mom.Dot(ey) / mom.Dot(ez);
+            const Double_t t2 = 1. + tx * tx + ty * ty;
+            const Double_t t = weight * 2. * geo->GetDimZ() * geo->GetDensity() / x0 * TMath::Sqrt(t2);
+            const Double_t beta = particle.GetBeta();
+            const Double_t z = TMath::Abs(particle.GetCharge());
+            const Double_t theta0 =
+                0.0136 / (beta * p) * z * TMath::Sqrt(t) * (1. + 0.038 * TMath::Log(t * z * z / (beta * beta)));
+
+            std::normal_distribution<Double_t> normal(0., 1.);
+            const Double_t sigma = theta0 * TMath::Sqrt(t2);
+            const Double_t txNew = tx + sigma * TMath::Sqrt(1. + tx * tx) * normal(gen);
+            const Double_t tyNew = ty + sigma * TMath::Sqrt(1. + ty * ty) * normal(gen);
+            particle.SetMomentum(p * (txNew * ex + tyNew * ey + ez).Unit());
+        }
+
+        // True tracks from the target over the mass range, through all detectors with energy loss and multiple
+        // scattering, with one hit per track and detector
+        void MakeTracks()
+        {
+            std::mt19937 gen(1234);
+            std::uniform_real_distribution<Double_t> uniform(0., 1.);
+            std::normal_distribution<Double_t> normal(0., 1.);
+
+            const auto& dets = fSetup.GetArray();
+            while ((Int_t)fTracks.size() < kTracks)
+            {
+                Track track;
+                track.mass = kMassMin + (kMassMax - kMassMin) * uniform(gen);
+                track.beta = 0.82 + 0.02 * uniform(gen);
+                track.p = track.mass * track.beta / TMath::Sqrt(1. - track.beta * track.beta);
+
+                // Vertex spread by the target resolution, the target hit is at 0
+                TVector3 vertex;
+                TVector3 posPsp;
+                dets[0]->LocalToGlobal(vertex, dets[0]->res_x * normal(gen), 0.);
+                dets[1]->LocalToGlobal(posPsp, 3. * (2. * uniform(gen) - 1.), 0.2 * (2. * uniform(gen) - 1.));
+                const TVector3 mom = track.p * (posPsp - vertex).Unit();
+                track.x = vertex.X();
+                track.tx = mom.X() / mom.Z();
+
+                R3BTrackingParticle particle(
+                    kCharge, vertex.X(), vertex.Y(), vertex.Z(), mom.X(), mom.Y(), mom.Z(), track.beta, track.mass);
+                std::vector<Double_t> x;
+                Bool_t ok = kTRUE;
+                for (auto const& det : dets)
+                {
+                    const Double_t weight = (kTarget == det->section) ? 0.5 : 1.;
+                    if (kTarget != det->section)
+                    {
+                        ok = ok && fPropagator->PropagateToDetector(&particle, det);
+                    }
+                    Double_t xl = 0.;
+                    Double_t yl = 0.;
+                    det->GlobalToLocal(particle.GetPosition(), xl, yl);
+                    x.push_back(kTarget == det->section ? 0. : xl + det->res_x * normal(gen));
+                    if (kTof != det->section)
+                    {
+                        particle.PassThroughDetector(det, weight);
+                        Scatter(particle, det, weight, gen);
+                    }
+                }
+                if (!ok)
+                {
+                    continue;
+                }
+
+                for (size_t i = 0; i < dets.size(); i++)
+                {
+                    fHits.emplace_back(new R3BHit(i, x[i], 0., 0., 0., fTracks.size()));
+                    dets[i]->hits.push_back(fHits.back().get());
+                }
+                fTracks.push_back(track);
+            }
+        }
+
+        // Candidate of track i with the mass hypothesis in the middle of the range, starting at the target towards
+        // the PSP hit
+        std::unique_ptr<R3BTrackingParticle> MakeCandidate(Int_t i)
+        {
+            const Track& track = fTracks[i];
+            const Double_t mass = 129. * kAmu;
+            TVector3 posPsp;
+            fSetup.GetByHandle(1)->LocalToGlobal(posPsp, fSetup.GetHit(1, i)->GetX(), 0.);
+            const TVector3 mom = mass * track.beta / TMath::Sqrt(1. - track.beta * track.beta) * posPsp.Unit();
+            std::unique_ptr<R3BTrackingParticle> candidate(
+                new R3BTrackingParticle(kCharge, 0., 0., 0., mom.X(), mom.Y(), mom.Z(), track.beta, mass));
+            for (Int_t h = 0; h < fSetup.GetNumberOfDetectors(); h++)
+            {
+                candidate->AddHit(h, i);
+            }
+            return candidate;
+        }
+
+        // Pulls of x, tx and q/p at the target, of the momentum and of the mass
+        void FillPulls(const Track& track,
+                       const R3BTrackingParticle& particle,
+                       const TVector3& position,
+                       const TVector3& momentum,
+                       Pull* pulls)
+        {
+            const Double_t qp = kCharge / momentum.Mag();
+            const Double_t sigmaQP = TMath::Sqrt(particle.GetCovariance(4, 4));
+            pulls[0].Fill((position.X() - track.x) / TMath::Sqrt(particle.GetCovariance(0, 0)));
+            pulls[1].Fill((momentum.X() / momentum.Z() - track.tx) / TMath::Sqrt(particle.GetCovariance(2, 2)));
+            pulls[2].Fill((qp - kCharge / track.p) / sigmaQP);
+            pulls[3].Fill((momentum.Mag() - track.p) / (momentum.Mag() * sigmaQP / qp));
+            pulls[4].Fill((particle.GetMass() - track.mass) / (particle.GetMass() * sigmaQP / qp));
+        }
+
+        // Fit all tracks backward or with the forward filter first and fill the pulls
+        void Fit(Bool_t backward, Pull* pulls)
+        {
+            for (Int_t i = 0; i < kTracks; i++)
+            {
+                std::unique_ptr<R3BTrackingParticle> candidate = MakeCandidate(i);
+                if (backward)
+                {
+                    ASSERT_EQ(0, fFitter.FitTrackBackward(candidate.get(), &fSetup));
+
+                    // The backward fit leaves the particle at the target with the reversed momentum
+                    FillPulls(fTracks[i], *candidate, candidate->GetPosition(), -1. * candidate->GetMomentum(), pulls);
+                }
+                else
+                {
+                    ASSERT_EQ(0, fFitter.FitTrack(candidate.get(), &fSetup));
+                    FillPulls(
+                        fTracks[i], *candidate, candidate->GetStartPosition(), candidate->GetStartMomentum(), pulls);
+                }
+            }
+        }
+
+        void ExpectNormal(const Pull* pulls)
+        {
+            const char* names[5] = { "x", "tx", "q/p", "p", "mass" };
+            for (Int_t k = 0; k < 5; k++)
+            {
+                EXPECT_EQ(kTracks, pulls[k].n) << names[k];
+                EXPECT_NEAR(0., pulls[k].Mean(), 0.2) << names[k];
+                EXPECT_NEAR(1., pulls[k].Rms(), 0.15) << names[k];
+            }
+        }
+
+        TString fFileName;
+        R3BGladFieldMap fGlad;
+        std::unique_ptr<R3BTPropagator> fPropagator;
+        std::vector<std::unique_ptr<R3BTGeoPar>> fPars;
+        std::vector<std::unique_ptr<R3BHit>> fHits;
+        R3BTrackingSetup fSetup;
+        R3BFragmentFitterKalman fFitter;
+        std::vector<Track> fTracks;
+    };
+
+    TEST_F(testFragmentFitterKalman, backwardPullsFollowTheCovariance)
+    {
+        MakeTracks();
+        Pull pulls[5];
+        Fit(kTRUE, pulls);
+        ExpectNormal(pulls);
+    }
+
+    TEST_F(testFragmentFitterKalman, forwardPullsFollowTheCovariance)
+    {
+        MakeTracks();
+        Pull pulls[5];
+        Fit(kFALSE, pulls);
+        ExpectNormal(pulls);
+    }
+
+    // The adaptive step size of R3BTRungeKutta makes the propagation noisy on small scales
+    TEST_F(testFragmentFitterKalman, pullsWithAdaptivePropagation)
+    {
+        fPropagator->SetAdaptiveRK(kTRUE);
+        MakeTracks();
+        Pull backward[5];
+        Fit(kTRUE, backward);
+        ExpectNormal(backward);
+        Pull forward[5];
+        Fit(kFALSE, forward);
+        ExpectNormal(forward);
+    }
+
+    // Without the track behind GLAD there is nothing to seed the backward filter with
+    TEST_F(testFragmentFitterKalman, needsTheLastTwoHits)
+    {
+        MakeTracks();
+        std::unique_ptr<R3BTrackingParticle> candidate = MakeCandidate(0);
+        candidate->AddHit(fSetup.GetHandle("fi6"), -1);
+        EXPECT_EQ(1, fFitter.FitTrackBackward(candidate.get(), &fSetup));
+        EXPECT_EQ(1, fFitter.FitTrack(candidate.get(), &fSetup));
+    }
+} // namespace
@@ -0,0 +1,238 @@
+/******************************************************************************
+ *   Copyright (C) 2019 GSI Helmholtzzentrum für Schwerionenforschung GmbH    *
+ *   Copyright (C) 2019 Members of R3B Collaboration                          *
+ *                                                                            *
+ *             This software is distributed under the terms of the            *
+ *                 GNU General Public Licence (GPL) version 3,                *
+ *                    copied verbatim in the file "LICENSE".                  *
+ *                                                                            *
+ * In applying this license GSI does not waive the privileges and immunities  *
+ * granted to it by virtue of its status as an Intergovernmental Organization *
+ * or submit itself to any jurisdiction.                                      *
+ ******************************************************************************/
+
+#include "GladTestMap.h"
+#include "R3BFragmentRoadSearch.h"
+#include "R3BGladFieldMap.h"
+#include "R3BTGeoPar.h"
+#include "R3BTPropagator.h"
+#include "R3BTrackingDetector.h"
+#include "R3BTrackingParticle.h"
+#include "R3BTrackingSetup.h"
+#include "TMath.h"
+#include "TVector3.h"
+#include "gtest/gtest.h"
+
+#include <cstdio>
+#include <memory>
+#include <random>
+#include <vector>
+
+// The road search must never prune a true hit combination: tracks over the mass range, with vertex spread
+// and PSP hits beyond the tabulated acceptance, smeared by the detector resolutions.
+
+namespace
+{
+    const Double_t kAmu = 0.9314940954;
+    const Double_t kCharge = 50.;
+    const Double_t kBeta = 0.8328;
+    const Double_t kMassMin = 125. * kAmu;
+    const Double_t kMassMax = 133. * kAmu;
+    const Double_t kPspHalfWidth = 4.;
+
+    // Measured local x of a track on all detectors
+    struct Track
+    {
+        std::vector<Double_t> x;
+        Double_t xPspTrue;
+    };
+
+    class testRoadSearch : public testing::Test
+    {
+      protected:
+        void SetUp() override
+        {
+            fFileName = GladTestMap::Write("testFragmentRoadSearch");
+            fGlad.SetFileName(fFileName);
+            fGlad.Init();
+            fPropagator.reset(new R3BTPropagator(&fGlad));
+
+            // Target and PSP in front of GLAD, the detectors behind it along the central track
+            AddDetector("target", kTarget, TVector3(0., 0., 0.), 0., 1., 0.1000);
+            AddDetector("psp", kTargetGlad, TVector3(0., 0., 50.), 0., kPspHalfWidth, 0.0200);
+
+            R3BTrackingParticle central(kCharge, 0., 0., 0., 0., 0., Momentum(129. * kAmu), kBeta, 129. * kAmu);
+            const TVector3 v1(0., 0., 450.);
+            const TVector3 v2(1., 1., 450.);
+            const TVector3 v3(-1., 1., 450.);
+            ASSERT_TRUE(fPropagator->PropagateToPlane(&central, v1, v2, v3));
+            const TVector3 dir = central.GetMomentum().Unit();
+            const Double_t rotY = TMath::ATan2(dir.X(), dir.Z()) * TMath::RadToDeg();
+            AddDetector("fi4", kAfterGlad, central.GetPosition(), rotY, 30., 0.0200);
+            AddDetector("fi5", kAfterGlad, central.GetPosition() + 60. * dir, rotY, 30., 0.0400);
+            AddDetector("fi6", kAfterGlad, central.GetPosition() + 150. * dir, rotY, 30., 0.0500);
+            AddDetector("tofd", kTof, central.GetPosition() + 300. * dir, rotY, 60., 2.7);
+
+            fRoadSearch.SetCharge(kCharge);
+            fRoadSearch.SetBeta(kBeta);
+            fRoadSearch.SetMassRange(kMassMin, kMassMax);
+            ASSERT_TRUE(fRoadSearch.Init(fPropagator.get(), &fSetup, "psp", kFALSE));
+        }
+
+        void TearDown() override { std::remove(fFileName.Data()); }
+
+        void AddDetector(const char* name,
+                         EDetectorType type,
+                         const TVector3& pos,
+                         Double_t rotY,
+                         Double_t halfWidth,
+                         Double_t resolution)
+        {
+            fPars.emplace_back(new R3BTGeoPar(TString::Format("%sGeoPar", name)));
+            fPars.back()->SetPosXYZ(pos.X(), pos.Y(), pos.Z());
+            fPars.back()->SetRotXYZ(0., rotY, 0.);
+            fPars.back()->SetDimXYZ(halfWidth, 10., 0.01);
+
+            fSetup.AddDetector(name, type, fPars.back()->GetName());
+            R3BTrackingDetector* det = fSetup.GetArray().back();
+            det->fGeo = fPars.back().get();
+            det->res_x = resolution;
+            det->Init();
+        }
+
+        static Double_t Momentum(Double_t mass) { return mass * kBeta / TMath::Sqrt(1. - kBeta * kBeta); }
+
+        // True tracks over the mass range with the vertex spread by the target resolution and PSP hits
+        // up to 25 % beyond its half width, measured with the resolutions truncated at 3 sigma
+        std::vector<Track> MakeTracks(Int_t n)
+        {
+            std::mt19937 gen(4357);
+            std::uniform_real_distribution<Double_t> uniform(0., 1.);
+            std::normal_distribution<Double_t> normal(0., 1.);
+            auto gaus3 = [&]() {
+                Double_t r;
+                do
+                {
+                    r = normal(gen);
+                } while (TMath::Abs(r) > 3.);
+                return r;
+            };
+
+            const auto& dets = fSetup.GetArray();
+            std::vector<Track> tracks;
+            while ((Int_t)tracks.size() < n)
+            {
+                const Double_t mass = kMassMin + (kMassMax - kMassMin) * uniform(gen);
+                Track track;
+                track.xPspTrue = 1.25 * kPspHalfWidth * (2. * uniform(gen) - 1.);
+
+                TVector3 vertex;
+                TVector3 posPsp;
+                dets[0]->LocalToGlobal(vertex, dets[0]->res_x * gaus3(), dets[0]->res_x * gaus3());
+                dets[1]->LocalToGlobal(posPsp, track.xPspTrue, 2. * uniform(gen) - 1.);
+                const TVector3 mom = Momentum(mass) * (posPsp - vertex).Unit();
+                R3BTrackingParticle particle(
+                    kCharge, vertex.X(), vertex.Y(), vertex.Z(), mom.X(), mom.Y(), mom.Z(), kBeta, mass);
+
+                Bool_t ok = kTRUE;
+                for (auto const& det : dets)
+                {
+                    Double_t x = 0.;
+                    Double_t y = 0.;
+                    if (kTarget != det->section)
+                    {
+                        ok = ok && fPropagator->PropagateToDetector(&particle, det);
+                    }
+                    det->GlobalToLocal(particle.GetPosition(), x, y);
+                    track.x.push_back(x + det->res_x * gaus3());
+                }
+                if (ok)
+                {
+                    tracks.push_back(track);
+                }
+            }
+            return tracks;
+        }
+
+        // Does the road search keep the combination of the PSP hit of track a with the hits behind GLAD of b?
+        Bool_t IsKept(const Track& a, const Track& b) const
+        {
+            const Int_t bin = fRoadSearch.GetBin(a.x[1]);
+            for (Int_t i = 2; i < 6; i++)
+            {
+                if (!fRoadSearch.IsInWindow(bin, i, b.x[i]))
+                {
+                    return kFALSE;
+                }
+            }
+            return fRoadSearch.IsOnLine(2, b.x[2], 3, b.x[3], 4, b.x[4]) &&
+                   fRoadSearch.IsOnLine(3, b.x[3], 4, b.x[4], 5, b.x[5]);
+        }
+
+        TString fFileName;
+        R3BGladFieldMap fGlad;
+        std::unique_ptr<R3BTPropagator> fPropagator;
+        std::vector<std::unique_ptr<R3BTGeoPar>> fPars;
+        R3BTrackingSetup fSetup;
+        R3BFragmentRoadSearch fRoadSearch;
+    };
+
+    TEST_F(testRoadSearch, keepsAllTrueCombinations)
+    {
+        const std::vector<Track> tracks = MakeTracks(2000);
+
+        Int_t nPruned = 0;
+        Int_t nOutside = 0;
+        for (auto const& track : tracks)
+        {
+            if (!IsKept(track, track))
+            {
+                nPruned++;
+            }
+            if (TMath::Abs(track.xPspTrue) > kPspHalfWidth)
+            {
+                nOutside++;
+            }
+        }
+        EXPECT_EQ(0, nPruned);
+        EXPECT_GT(nOutside, 100);
+    }
+
+    TEST_F(testRoadSearch, opensTheWindowOutsideTheAcceptance)
+    {
+        EXPECT_EQ(-1, fRoadSearch.GetBin(-kPspHalfWidth - 0.01));
+        EXPECT_EQ(-1, fRoadSearch.GetBin(kPspHalfWidth + 0.01));
+        EXPECT_EQ(0, fRoadSearch.GetBin(-kPspHalfWidth));
+        EXPECT_EQ(199, fRoadSearch.GetBin(kPspHalfWidth));
+        for (Int_t i = 2; i < 6; i++)
+        {
+            EXPECT_TRUE(fRoadSearch.IsInWindow(-1, i, 1e3));
+        }
+    }
+
+    TEST_F(testRoadSearch, prunesWrongCombinations)
+    {
+        const std::vector<Track> tracks = MakeTracks(500);
+
+        Int_t nWrong = 0;
+        Int_t nKept = 0;
+        for (size_t i = 0; i + 1 < tracks.size(); i++)
+        {
+            // PSP hit of one track with the hits behind GLAD of another, both well inside the acceptance
+            const Track& a = tracks[i];
+            const Track& b = tracks[i + 1];
+            if (TMath::Abs(a.x[1]) > kPspHalfWidth || TMath::Abs(b.x[1]) > kPspHalfWidth ||
+                TMath::Abs(a.x[1] - b.x[1]) < 0.5)
+            {
+                continue;
+            }
+            nWrong++;
+            if (IsKept(a, b))
+            {
+                nKept++;
+            }
+        }
+        ASSERT_GT(nWrong, 100);
+        EXPECT_LT(nKept, nWrong / 10);
+    }
+} // namespace
@@ -0,0 +1,174 @@
+/******************************************************************************
+ *   Copyright (C) 2019 GSI Helmholtzzentrum für Schwerionenforschung GmbH    *
+ *   Copyright (C) 2019 Members of R3B Collaboration                          *
+ *                                                                            *
+ *             This software is distributed under the terms of the            *
+ *                 GNU General Public Licence (GPL) version 3,                *
+ *                    copied verbatim in the file "LICENSE".                  *
+ *                                                                            *
+ * In applying this license GSI does not waive the privileges and immunities  *
+ * granted to it by virtue of its status as an Intergovernmental Organization *
+ * or submit itself to any jurisdiction.                                      *
+ ******************************************************************************/
+
+#include "GladTestMap.h"
+#include "R3BGladFieldMap.h"
+#include "R3BTRungeKutta.h"
+#include "R3BTrackingParticle.h"
+#include "TMath.h"
+#include "TString.h"
+#include "TVector3.h"
+#include "gtest/gtest.h"
+
+#include <cstdio>
+#include <random>
+#include <vector>
+
+// In a uniform field, R3BTRungeKutta has to follow the analytic helix onto the plane.
+
+namespace
+{
+    const Double_t kField = 1.5;                     // By [T]
+    const Double_t kCentre = 163.4;                  // z of the map centre, see R3BGladFieldMap::Init
+    const Double_t kStart = kCentre - 70.;           // z of the start plane
+    const Double_t kPlane = kCentre + 70.;           // z of the target plane
+    const Double_t kNormal[3] = { 0., 0., 1. };
+
+    // Position and direction after the path length s on the helix around y, starting from state.
+    // With du/ds = kappa u x B, the direction turns in the x-z plane with omega = kappa By.
+    void Helix(const Double_t* state, Double_t omega, Double_t s, Double_t* out)
+    {
+        const Double_t c = TMath::Cos(omega * s);
+        const Double_t sn = TMath::Sin(omega * s);
+        out[0] = state[0] + (state[3] * sn + state[5] * (c - 1.)) / omega;
+        out[1] = state[1] + state[4] * s;
+        out[2] = state[2] + (state[5] * sn + state[3] * (1. - c)) / omega;
+        out[3] = state[3] * c - state[5] * sn;
+        out[4] = state[4];
+        out[5] = state[5] * c + state[3] * sn;
+    }
+
+    // Path length from state to the plane z = kPlane, by Newton iteration
+    Double_t HelixLength(const Double_t* state, Double_t omega)
+    {
+        Double_t s = (kPlane - state[2]) / state[5];
+        Double_t out[6];
+        for (Int_t i = 0; i < 50; i++)
+        {
+            Helix(state, omega, s, out);
+            const Double_t ds = (kPlane - out[2]) / out[5];
+            s += ds;
+            if (TMath::Abs(ds) < 1e-13)
+            {
+                break;
+            }
+        }
+        return s;
+    }
+
+    class testRungeKutta : public testing::Test
+    {
+      protected:
+        void SetUp() override
+        {
+            fFieldFile = GladTestMap::WriteUniform("testRungeKutta", kField);
+            fGlad.SetFileName(fFieldFile);
+            fGlad.Init();
+
+            // Charge over momentum between 0.1 and 0.3 GeV/c of either sign, slopes up to 0.05
+            std::mt19937 gen(5);
+            std::uniform_real_distribution<Double_t> uniform(-1., 1.);
+            for (Int_t i = 0; i < 200; i++)
+            {
+                const TVector3 dir = TVector3(0.05 * uniform(gen), 0.05 * uniform(gen), 1.).Unit();
+                const Double_t qp = (uniform(gen) > 0. ? 1. : -1.) * (0.2 + 0.1 * uniform(gen));
+                fStates.push_back({ uniform(gen), uniform(gen), kStart, dir.X(), dir.Y(), dir.Z() });
+                fQP.push_back(qp);
+            }
+        }
+
+        void TearDown() override { std::remove(fFieldFile.Data()); }
+
+        // Largest deviation from the helix in position [cm], direction and path length [cm]
+        void MaxDeviation(const R3BTRungeKutta& rk, Double_t* dmax)
+        {
+            const Double_t point[3] = { 0., 0., kPlane };
+            dmax[0] = dmax[1] = dmax[2] = 0.;
+            for (size_t i = 0; i < fStates.size(); i++)
+            {
+                const Double_t kappa = R3BTRungeKutta::kC * fQP[i];
+                const Double_t omega = kappa * 10. * kField;
+                const Double_t s = HelixLength(fStates[i].data(), omega);
+                Double_t expected[6];
+                Helix(fStates[i].data(), omega, s, expected);
+
+                std::vector<Double_t> state = fStates[i];
+                Double_t length = 0.;
+                ASSERT_TRUE(rk.PropagateToPlane(kappa, state.data(), point, kNormal, length));
+                for (Int_t k = 0; k < 3; k++)
+                {
+                    dmax[0] = TMath::Max(dmax[0], TMath::Abs(state[k] - expected[k]));
+                    dmax[1] = TMath::Max(dmax[1], TMath::Abs(state[k + 3] - expected[k + 3]));
+                }
+                dmax[2] = TMath::Max(dmax[2], TMath::Abs(length - s));
+            }
+        }
+
+        TString fFieldFile;
+        R3BGladFieldMap fGlad;
+        std::vector<std::vector<Double_t>> fStates;
+        std::vector<Double_t> fQP;
+    };
+
+    TEST_F(testRungeKutta, followsTheHelix)
+    {
+        R3BTRungeKutta rk(&fGlad);
+        Double_t dmax[3];
+        MaxDeviation(rk, dmax);
+        EXPECT_LT(dmax[0], 1e-5);
+        EXPECT_LT(dmax[1], 1e-7);
+        EXPECT_LT(dmax[2], 1e-6);
+    }
+
+    TEST_F(testRungeKutta, convergesWithTheTolerance)
+    {
+        R3BTRungeKutta rk(&fGlad);
+        rk.SetTolerance(1e-3);
+        Double_t coarse[3];
+        MaxDeviation(rk, coarse);
+
+        rk.SetTolerance(1e-8);
+        Double_t fine[3];
+        MaxDeviation(rk, fine);
+
+        EXPECT_LT(fine[0], 1e-6);
+        EXPECT_LT(fine[0], coarse[0]);
+        EXPECT_LT(fine[1], coarse[1]);
+    }
+
+    // The particle interface adds the path length and keeps the momentum
+    TEST_F(testRungeKutta, propagatesTheParticle)
+    {
+        R3BTRungeKutta rk(&fGlad);
+        const Double_t* state = fStates[0].data();
+        const Double_t p = 50. / TMath::Abs(fQP[0]);
+        const Double_t charge = fQP[0] > 0. ? 50. : -50.;
+        R3BTrackingParticle particle(
+            charge, state[0], state[1], state[2], p * state[3], p * state[4], p * state[5], 0.8, 120.);
+        particle.AddStep(10.);
+
+        ASSERT_TRUE(rk.PropagateToPlane(&particle, TVector3(0., 0., kPlane), TVector3(0., 0., 1.)));
+
+        const Double_t omega = R3BTRungeKutta::kC * fQP[0] * 10. * kField;
+        const Double_t s = HelixLength(state, omega);
+        Double_t expected[6];
+        Helix(state, omega, s, expected);
+        for (Int_t k = 0; k < 3; k++)
+        {
+            EXPECT_NEAR(particle.GetPosition()[k], expected[k], 1e-4);
+            EXPECT_NEAR(particle.GetMomentum()[k] / p, expected[k + 3], 1e-6);
+        }
+        EXPECT_NEAR(particle.GetMomentum().Mag(), p, 1e-9 * p);
+        EXPECT_NEAR(particle.GetLength(), 10. + s, 1e-4);
+    }
+} // namespace
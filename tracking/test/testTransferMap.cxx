@@ -0,0 +1,292 @@
+/******************************************************************************
+ *   Copyright (C) 2019 GSI Helmholtzzentrum für Schwerionenforschung GmbH    *
+ *   Copyright (C) 2019 Members of R3B Collaboration                          *
+ *                                                                            *
+ *             This software is distributed under the terms of the            *
+ *                 GNU General Public Licence (GPL) version 3,                *
+ *                    copied verbatim in the file "LICENSE".                  *
+ *                                                                            *
+ * In applying this license GSI does not waive the privileges and immunities  *
+ * granted to it by virtue of its status as an Intergovernmental Organization *
+ * or submit itself to any jurisdiction.                                      *
+ ******************************************************************************/
+
+#include "GladTestMap.h"
+#include "R3BGladFieldMap.h"
+#include "R3BTPropagator.h"
+#include "R3BTrackingParticle.h"
+#include "R3BTransferMap.h"
+#include "TMath.h"
+#include "TString.h"
+#include "TVector3.h"
+#include "gtest/gtest.h"
+
+#include <cstdio>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace
+{
+    const Double_t kLow[R3BTransferMap::kNIn] = { -10., -5., -0.1, -0.05, 0.2 };
+    const Double_t kHigh[R3BTransferMap::kNIn] = { 10., 5., 0.1, 0.05, 0.3 };
+
+    // Polynomial of total degree 3 in the inputs, exactly representable by a map of order 3
+    void Polynomial(const Double_t* in, Double_t* out)
+    {
+        const Double_t x = in[0], y = in[1], tx = in[2], ty = in[3], qp = in[4];
+        out[0] = 1. + 2. * x - 0.5 * y + 30. * tx + 4. * x * tx - 8. * qp * x * x;
+        out[1] = y + 100. * ty - 2. * y * ty * qp + 0.01 * y * y * y;
+        out[2] = tx - 0.4 * qp + 0.3 * qp * qp * qp + 0.001 * x * qp;
+        out[3] = ty + 0.002 * y * qp - 0.5 * ty * tx * tx;
+        out[4] = 100. + 0.5 * x * tx + 20. * tx * tx + 3. * qp * qp;
+    }
+
+    void MakeInput(std::mt19937& gen, Double_t* in)
+    {
+        std::uniform_real_distribution<Double_t> uniform(0., 1.);
+        for (Int_t i = 0; i < R3BTransferMap::kNIn; i++)
+        {
+            in[i] = kLow[i] + (kHigh[i] - kLow[i]) * uniform(gen);
+        }
+    }
+
+    // Map of order 3 between the planes z = 0 and z = 100, fitted to the polynomial
+    R3BTransferMap FitPolynomial()
+    {
+        R3BTransferMap::Frame in;
+        in.origin = TVector3(0., 0., 0.);
+        in.ex = TVector3(1., 0., 0.);
+        in.ey = TVector3(0., 1., 0.);
+        in.ez = TVector3(0., 0., 1.);
+        R3BTransferMap::Frame out = in;
+        out.origin = TVector3(0., 0., 100.);
+
+        R3BTransferMap map;
+        map.SetFrames(in, out);
+        map.SetDomain(kLow, kHigh);
+        map.SetOrder(3);
+        map.SetScale(0.8);
+
+        std::mt19937 gen(1);
+        std::vector<Double_t> vin(R3BTransferMap::kNIn);
+        std::vector<Double_t> vout(R3BTransferMap::kNOut);
+        std::vector<Double_t> samplesIn;
+        std::vector<Double_t> samplesOut;
+        for (Int_t s = 0; s < 2000; s++)
+        {
+            MakeInput(gen, vin.data());
+            Polynomial(vin.data(), vout.data());
+            samplesIn.insert(samplesIn.end(), vin.begin(), vin.end());
+            samplesOut.insert(samplesOut.end(), vout.begin(), vout.end());
+        }
+        map.Fit(samplesIn, samplesOut);
+        return map;
+    }
+
+    TEST(testTransferMap, fitsAPolynomial)
+    {
+        const R3BTransferMap map = FitPolynomial();
+        ASSERT_TRUE(map.IsValid());
+
+        std::mt19937 gen(2);
+        Double_t in[R3BTransferMap::kNIn];
+        Double_t expected[R3BTransferMap::kNOut];
+        Double_t out[R3BTransferMap::kNOut];
+        for (Int_t s = 0; s < 1000; s++)
+        {
+            MakeInput(gen, in);
+            Polynomial(in, expected);
+            map.Eval(in, out);
+            for (Int_t o = 0; o < R3BTransferMap::kNOut; o++)
+            {
+                EXPECT_NEAR(expected[o], out[o], 1e-9 * (1. + TMath::Abs(expected[o])));
+            }
+        }
+    }
+
+    TEST(testTransferMap, refusesTooFewSamples)
+    {
+        R3BTransferMap map;
+        map.SetDomain(kLow, kHigh);
+        map.SetOrder(3);
+        const std::vector<Double_t> in(10 * R3BTransferMap::kNIn, 0.);
+        const std::vector<Double_t> out(10 * R3BTransferMap::kNOut, 0.);
+        EXPECT_FALSE(map.Fit(in, out));
+        EXPECT_FALSE(map.IsValid());
+    }
+
+    TEST(testTransferMap, checksTheDomain)
+    {
+        const R3BTransferMap map = FitPolynomial();
+
+        Double_t in[R3BTransferMap::kNIn];
+        for (Int_t i = 0; i < R3BTransferMap::kNIn; i++)
+        {
+            in[i] = 0.5 * (kLow[i] + kHigh[i]);
+        }
+        EXPECT_TRUE(map.InDomain(in));
+
+        for (Int_t i = 0; i < R3BTransferMap::kNIn; i++)
+        {
+            const Double_t centre = in[i];
+            const Double_t eps = 1e-6 * (kHigh[i] - kLow[i]);
+            in[i] = kLow[i];
+            EXPECT_TRUE(map.InDomain(in));
+            in[i] = kHigh[i];
+            EXPECT_TRUE(map.InDomain(in));
+            in[i] = kLow[i] - eps;
+            EXPECT_FALSE(map.InDomain(in));
+            in[i] = kHigh[i] + eps;
+            EXPECT_FALSE(map.InDomain(in));
+            in[i] = centre;
+        }
+    }
+
+    TEST(testTransferMap, transportsOnlyInsideTheDomain)
+    {
+        const R3BTransferMap map = FitPolynomial();
+
+        // x = 1, y = 2, tx = 0.05, ty = -0.02, q/p = 0.25 on the entrance plane
+        const Double_t in[R3BTransferMap::kNIn] = { 1., 2., 0.05, -0.02, 0.25 };
+        Double_t out[R3BTransferMap::kNOut];
+        Polynomial(in, out);
+        const TVector3 mom = 4. * TVector3(0.05, -0.02, 1.).Unit();
+        R3BTrackingParticle particle(1., 1., 2., 0., mom.X(), mom.Y(), mom.Z(), 0.5, 1.);
+        ASSERT_TRUE(map.Transport(&particle));
+        EXPECT_NEAR(out[0], particle.GetPosition().X(), 1e-9);
+        EXPECT_NEAR(out[1], particle.GetPosition().Y(), 1e-9);
+        EXPECT_NEAR(100., particle.GetPosition().Z(), 1e-9);
+        EXPECT_NEAR(out[2], particle.GetMomentum().X() / particle.GetMomentum().Z(), 1e-9);
+        EXPECT_NEAR(out[3], particle.GetMomentum().Y() / particle.GetMomentum().Z(), 1e-9);
+        EXPECT_NEAR(4., particle.GetMomentum().Mag(), 1e-9);
+        EXPECT_NEAR(out[4], particle.GetLength(), 1e-9);
+
+        // q/p outside of the domain: the particle is left untouched
+        R3BTrackingParticle outside(1., 1., 2., 0., 2. * mom.X(), 2. * mom.Y(), 2. * mom.Z(), 0.5, 1.);
+        EXPECT_FALSE(map.Transport(&outside));
+        EXPECT_EQ(0., outside.GetPosition().Z());
+        EXPECT_EQ(0., outside.GetLength());
+    }
+
+    TEST(testTransferMap, survivesWriteAndRead)
+    {
+        const R3BTransferMap map = FitPolynomial();
+        std::stringstream stream;
+        ASSERT_TRUE(map.Write(stream));
+
+        R3BTransferMap copy;
+        ASSERT_TRUE(copy.Read(stream));
+        EXPECT_TRUE(copy.IsValid());
+        EXPECT_EQ(map.GetOrder(), copy.GetOrder());
+        EXPECT_EQ(map.GetScale(), copy.GetScale());
+        EXPECT_EQ(map.GetOutFrame().origin.Z(), copy.GetOutFrame().origin.Z());
+        for (Int_t i = 0; i < R3BTransferMap::kNIn; i++)
+        {
+            EXPECT_EQ(map.GetLow(i), copy.GetLow(i));
+            EXPECT_EQ(map.GetHigh(i), copy.GetHigh(i));
+        }
+
+        std::mt19937 gen(3);
+        Double_t in[R3BTransferMap::kNIn];
+        Double_t out[R3BTransferMap::kNOut];
+        Double_t outCopy[R3BTransferMap::kNOut];
+        for (Int_t s = 0; s < 100; s++)
+        {
+            MakeInput(gen, in);
+            map.Eval(in, out);
+            copy.Eval(in, outCopy);
+            for (Int_t o = 0; o < R3BTransferMap::kNOut; o++)
+            {
+                EXPECT_EQ(out[o], outCopy[o]);
+            }
+        }
+    }
+
+    TEST(testTransferMap, refusesUnknownFormat)
+    {
+        std::stringstream stream("R3BTransferMap 2\n");
+        R3BTransferMap map;
+        EXPECT_FALSE(map.Read(stream));
+        EXPECT_FALSE(map.IsValid());
+    }
+
+    TEST(testTransferMap, refusesInconsistentOrderAndExponents)
+    {
+        std::stringstream stream;
+        ASSERT_TRUE(FitPolynomial().Write(stream));
+        std::vector<std::string> tokens;
+        for (std::string token; stream >> token;)
+        {
+            tokens.push_back(token);
+        }
+
+        // Tag and version, order and scale, two frames of four vectors, the domain and the number of terms
+        const size_t iOrder = 2;
+        const size_t iFirstExponent = iOrder + 2 + 2 * 4 * 3 + 2 * R3BTransferMap::kNIn + 1;
+        auto read = [&](size_t index, const std::string& value) {
+            std::vector<std::string> changed = tokens;
+            changed[index] = value;
+            std::stringstream in;
+            for (const auto& token : changed)
+            {
+                in << token << " ";
+            }
+            R3BTransferMap map;
+            return map.Read(in) && map.IsValid();
+        };
+
+        ASSERT_EQ(tokens[iOrder], "3");
+        EXPECT_TRUE(read(iFirstExponent, tokens[iFirstExponent]));
+        EXPECT_FALSE(read(iOrder, "0"));
+        EXPECT_FALSE(read(iOrder, "-1"));
+        EXPECT_FALSE(read(iFirstExponent, "4"));
+        EXPECT_FALSE(read(iFirstExponent, "-1"));
+    }
+
+    // Maps that deviate from the RK propagation beyond the tolerance are dropped, the propagator stays with RK
+    TEST(testTransferMap, propagatorDropsInaccurateMaps)
+    {
+        const TString fieldFile = GladTestMap::Write("testTransferMap");
+        R3BGladFieldMap glad;
+        glad.SetFileName(fieldFile);
+        glad.Init();
+
+        // Entrance domain small enough for the tracks to stay inside the small map
+        const Double_t qpMin = 1. / 4.5;
+        const Double_t qpMax = 1. / 3.5;
+        R3BTPropagator propagator(&glad);
+        propagator.SetTransferMapAcceptance(5., 5., 0.02, 0.02);
+        ASSERT_TRUE(propagator.GenerateTransferMaps(qpMin, qpMax, 4, 2000));
+        EXPECT_TRUE(propagator.HasTransferMaps());
+
+        const TString mapFile = TString::Format("%s.maps", fieldFile.Data());
+        ASSERT_TRUE(propagator.WriteTransferMaps(mapFile));
+
+        R3BTPropagator strict(&glad);
+        strict.SetTransferMapAcceptance(5., 5., 0.02, 0.02);
+        strict.SetTransferMapTolerance(1e-6, 1e-9, 1e-6);
+        EXPECT_FALSE(strict.ReadTransferMaps(mapFile));
+        EXPECT_FALSE(strict.HasTransferMaps());
+
+        // Each component is checked on its own
+        strict.SetTransferMapTolerance(1., 1., 1e-6);
+        EXPECT_FALSE(strict.ReadTransferMaps(mapFile));
+        strict.SetTransferMapTolerance(1., 1e-9, 1.);
+        EXPECT_FALSE(strict.ReadTransferMaps(mapFile));
+        strict.SetTransferMapTolerance(1., 1., 1.);
+        EXPECT_TRUE(strict.ReadTransferMaps(mapFile));
+        strict.SetTransferMapTolerance(1e-6, 1e-9, 1e-6);
+        EXPECT_FALSE(strict.GenerateTransferMaps(qpMin, qpMax, 4, 2000));
+        EXPECT_FALSE(strict.HasTransferMaps());
+
+        // A failed generation also drops maps made before
+        propagator.SetTransferMapTolerance(1e-6, 1e-9, 1e-6);
+        EXPECT_FALSE(propagator.GenerateTransferMaps(qpMin, qpMax, 4, 2000));
+        EXPECT_FALSE(propagator.HasTransferMaps());
+
+        std::remove(mapFile.Data());
+        std::remove(fieldFile.Data());
+    }
+} // namespace